@@ -116,6 +116,9 @@ PACKAGE_BUILD_NUMBER ?= 0
 # Implement coroutines on top of (POSIX) threads
 THREADED_COROUTINES ?= 0
 
+# Back coroutine stacks with transparent huge pages where possible
+CORO_STACK_HUGE_PAGES ?= 0
+
 # Require MacOS package to be signed with a developer certificate
 REQUIRE_SIGNED ?= 0
 OSX_SIGNATURE_NAME ?= Developer ID Installer: Hexagram 49, Inc. (99WDWQ7WDJ)
@@ -141,6 +144,7 @@ BTREE_DEBUG ?= 0
 SERIALIZER_DEBUG ?= 0
 NO_EVENTFD ?= 0
 NO_EPOLL ?= 0
+NO_IO_URING ?= 0
 LEGACY_PROC_STAT ?= 0
 UNIT_TEST_FILTER ?= *
 PACKAGE_FOR_SUSE_10 ?= 0
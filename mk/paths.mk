@@ -46,6 +46,10 @@ ifeq ($(BUILD_DIR),)
     BUILD_DIR += noepoll
   endif
 
+  ifeq (1,$(NO_IO_URING))
+    BUILD_DIR += nouring
+  endif
+
   ifeq (1,$(VALGRIND))
     BUILD_DIR += valgrind
   endif
@@ -18,6 +18,7 @@
 #include "arch/runtime/runtime.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
@@ -49,11 +50,25 @@ public:
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
-        accounter(batch_factor),
+        accounter(batch_factor, stats),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        /* Pick the backend.  We prefer submitting I/O straight from the event loop
+        through io_uring, and only fall back to handing blocking calls to a thread
+        pool if the kernel doesn't let us. */
+        if (uring_diskmgr_t::is_supported()) {
+            uring_backend.init(new uring_diskmgr_t(queue, backend_stats.producer,
+                                                   max_concurrent_io_requests));
+            uring_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                                &backend_stats, ph::_1);
+        } else {
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                               &backend_stats, ph::_1);
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -62,8 +77,7 @@ public:
         conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
                                                  &accounter, ph::_1);
 
-        /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        /* Hook up everything's `done_fun`. (The backend's was set above.) */
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -77,8 +91,11 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit,
+                         int64_t latency_target_us) {
+        return new accounting_diskmgr_t::account_t(&accounter, pri,
+                                                   outstanding_requests_limit,
+                                                   latency_target_us);
     }
 
     void delayed_destroy(void *_account) {
@@ -127,6 +144,19 @@ public:
                                a));
     }
 
+    void submit_punch_hole(fd_t fd, int64_t offset, int64_t length,
+                           void *account, linux_iocallback_t *cb) {
+        threadnum_t calling_thread = get_thread_id();
+
+        action_t *a = new action_t(calling_thread, cb);
+        a->make_punch_hole(fd, offset, length);
+        a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
+
+        do_on_thread(home_thread(),
+                     std::bind(&linux_disk_manager_t::submit_action_to_stack_stats, this,
+                               a));
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined.  Did you include pool.hpp?"
 #elif USE_WRITEV
@@ -181,7 +211,9 @@ private:
     holding back operations that must be run after other, currently-running, operations.
     Then it goes to the account manager, which queues up running IO operations according
     to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    from the queue. The backend is either `uring_diskmgr_t`, which submits the
+    operations to the kernel directly from the event loop, or, where io_uring is
+    unavailable, `pool_diskmgr_t`, which runs blocking calls in a thread pool.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -194,7 +226,8 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
 
 
     intptr_t outstanding_txn;
@@ -257,6 +290,29 @@ void linux_file_t::set_file_size(int64_t size) {
     file_size = size;
 }
 
+void linux_file_t::punch_hole(int64_t offset, int64_t length) {
+    assert_thread();
+    rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
+    guarantee(offset >= 0 && length >= 0 && offset + length <= file_size);
+
+    struct ph_callback_t : public linux_iocallback_t {
+        void on_io_complete() {
+            delete this;
+        }
+
+        void on_io_failure(int errsv, int64_t offset, int64_t) {
+            crash("fallocate failed to punch a hole.  (%s) (offset = %" PRIi64 ")",
+                  errno_string(errsv).c_str(), offset);
+        }
+
+        auto_drainer_t::lock_t lock;
+    };
+    ph_callback_t *ph_callback = new ph_callback_t();
+    ph_callback->lock = file_size_ops_drainer.lock();
+    diskmgr->submit_punch_hole(fd.get(), offset, length, default_account->get_account(),
+                               ph_callback);
+}
+
 // For growing in large chunks at a time.
 int64_t chunk_factor(int64_t size) {
     // x is at most 6.25% of size.
@@ -358,9 +414,11 @@ bool linux_file_t::coop_lock_and_check() {
     return true;
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit,
+                                   int64_t latency_target_us) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(priority, outstanding_requests_limit,
+                                   latency_target_us);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -78,6 +78,10 @@ public:
     that gets truncated anymore. */
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size);
+    /* Like a resize, a hole punch blocks all other operations on the file until it's
+    done.  Only punch holes into space that no ongoing I/O operation wants to access
+    anymore. */
+    void punch_hole(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *cb);
     void write_async(int64_t offset, size_t length, const void *buf, file_account_t *account, linux_iocallback_t *cb,
@@ -89,7 +93,8 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    void *create_account(int priority, int outstanding_requests_limit,
+                         int64_t latency_target_us);
     void destroy_account(void *account);
 
     ~linux_file_t();
@@ -1,24 +1,44 @@
 #include "arch/io/disk/accounting.hpp"
 
 #include "containers/printf_buffer.hpp"
+#include "utils.hpp"
 
 /* Each account on the `accounting_diskmgr_t` has its own
    `unlimited_fifo_queue_t` associated with it. Operations for that account
    queue up on that queue while they wait for the `accounting_queue_t` on the
    `accounting_diskmgr_t` to draw from that account. */
-struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_t {
+struct accounting_diskmgr_eager_account_t
+    : public semaphore_available_callback_t,
+      public intrusive_priority_queue_node_t<accounting_diskmgr_eager_account_t> {
     typedef accounting_diskmgr_action_t action_t;
 
-    accounting_diskmgr_eager_account_t(accounting_diskmgr_t *par,
+    accounting_diskmgr_eager_account_t(accounting_diskmgr_t *_par,
                                        int pri,
-                                       int outstanding_requests_limit) :
+                                       int outstanding_requests_limit,
+                                       int64_t latency_target_us) :
+        par(_par),
+        latency_target(latency_target_us * 1000),
+        deadline(0),
+        in_deadline_accounts(false),
+        stats(par->get_stats(pri)),
+        num_waiting(0),
         outstanding_requests_limiter(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS ? SEMAPHORE_NO_LIMIT : outstanding_requests_limit),
         account(&par->queue, &queue, pri),
         accounter_lock(par->get_auto_drainer()) {
         rassert(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS || outstanding_requests_limit > 0);
+        rassert(latency_target_us >= 0);
+    }
+
+    ~accounting_diskmgr_eager_account_t() {
+        if (in_deadline_accounts) {
+            par->deadline_accounts.remove(this);
+        }
     }
 
     void push(action_t *action) {
+        action->enqueue_time = par->now_fun();
+        stats->queue_depth.record(num_waiting);
+        ++num_waiting;
         throttled_queue.push_back(action);
         outstanding_requests_limiter.lock(this, 1);
     }
@@ -26,12 +46,60 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
         action_t *action = throttled_queue.head();
         throttled_queue.pop_front();
         queue.push(action);
+        update_deadline();
     }
     co_semaphore_t *get_outstanding_requests_limiter() {
         return &outstanding_requests_limiter;
     }
+    void on_dispatch(action_t *action, ticks_t now) {
+        --num_waiting;
+        stats->record_wait(now - action->enqueue_time);
+        update_deadline();
+    }
+
+    // When the oldest request that's ready for the disk misses its latency target.
+    // Only meaningful while the account is in `par->deadline_accounts`.
+    ticks_t get_deadline() const {
+        return deadline;
+    }
+    action_t *pop_overdue() {
+        ++stats->promoted;
+        return queue.pop();
+    }
 
 private:
+    friend bool left_is_higher_priority(const accounting_diskmgr_eager_account_t *left,
+                                        const accounting_diskmgr_eager_account_t *right);
+
+    // Puts us into the right place in `par->deadline_accounts`, after the oldest
+    // request in `queue` changed.
+    void update_deadline() {
+        if (latency_target == 0) {
+            return;
+        }
+        if (queue.available->get()) {
+            deadline = queue.peek()->enqueue_time + latency_target;
+            if (in_deadline_accounts) {
+                par->deadline_accounts.update(this);
+            } else {
+                par->deadline_accounts.push(this);
+                in_deadline_accounts = true;
+            }
+        } else if (in_deadline_accounts) {
+            par->deadline_accounts.remove(this);
+            in_deadline_accounts = false;
+        }
+    }
+
+    accounting_diskmgr_t *par;
+    // Zero if the account doesn't have a latency target
+    const ticks_t latency_target;
+    ticks_t deadline;
+    bool in_deadline_accounts;
+    accounting_diskmgr_stats_t *stats;
+    // How many requests were pushed that haven't gone to the disk yet
+    int64_t num_waiting;
+
     // It would be nice if we could just use a limited_fifo_queue to
     // implement the limitation of outstanding requests.
     // However this part of the code must not rely on coroutines, therefore
@@ -47,11 +115,18 @@ private:
     DISABLE_COPYING(accounting_diskmgr_eager_account_t);
 };
 
+bool left_is_higher_priority(const accounting_diskmgr_eager_account_t *left,
+                             const accounting_diskmgr_eager_account_t *right) {
+    return left->deadline < right->deadline;
+}
+
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                                            int _pri,
-                                                           int _outstanding_requests_limit)
+                                                           int _outstanding_requests_limit,
+                                                           int64_t _latency_target_us)
         : par(_par), pri(_pri),
-          outstanding_requests_limit(_outstanding_requests_limit) { }
+          outstanding_requests_limit(_outstanding_requests_limit),
+          latency_target_us(_latency_target_us) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
     par->assert_thread();
@@ -80,10 +155,16 @@ co_semaphore_t *accounting_diskmgr_account_t::get_outstanding_requests_limiter()
     return eager_account->get_outstanding_requests_limiter();
 }
 
+void accounting_diskmgr_account_t::on_dispatch(action_t *action, ticks_t now) {
+    rassert(eager_account.has());
+    eager_account->on_dispatch(action, now);
+}
+
 void accounting_diskmgr_account_t::maybe_init(){
     if (!eager_account.has()) {
         par->assert_thread();
-        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit));
+        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit,
+                                               latency_target_us));
     }
 }
 
@@ -99,10 +180,68 @@ void debug_print(printf_buffer_t *buf,
 }
 
 
+accounting_diskmgr_stats_t::accounting_diskmgr_stats_t(perfmon_collection_t *parent,
+                                                       int pri)
+    : collection_membership(parent, &collection, strprintf("io_priority_%d", pri)),
+      queue_depth(secs_to_ticks(1), false),
+      wait_time(secs_to_ticks(1), false),
+      stats_membership(&collection,
+          &queue_depth, "queue_depth",
+          &wait_time, "wait_time",
+          &waits_under_1ms, "waits_under_1ms",
+          &waits_1ms_10ms, "waits_1ms_10ms",
+          &waits_10ms_100ms, "waits_10ms_100ms",
+          &waits_100ms_plus, "waits_100ms_plus",
+          &promoted, "promoted") { }
+
+void accounting_diskmgr_stats_t::record_wait(ticks_t ticks) {
+    const double ms = ticks_to_secs(ticks) * 1000;
+    wait_time.record(ms);
+    if (ms < 1) {
+        ++waits_under_1ms;
+    } else if (ms < 10) {
+        ++waits_1ms_10ms;
+    } else if (ms < 100) {
+        ++waits_10ms_100ms;
+    } else {
+        ++waits_100ms_plus;
+    }
+}
+
+accounting_diskmgr_t::accounting_diskmgr_t(int batch_factor,
+                                           perfmon_collection_t *_stats)
+    : now_fun(&get_ticks),
+      producer(&deadline_producer),
+      stats(_stats),
+      queue(batch_factor),
+      deadline_producer(this),
+      auto_drainer(new auto_drainer_t()) { }
+
 accounting_diskmgr_t::~accounting_diskmgr_t() {
     auto_drainer.reset();  // Make absolutely sure this happens first.
 }
 
+accounting_diskmgr_stats_t *accounting_diskmgr_t::get_stats(int pri) {
+    assert_thread();
+    scoped_ptr_t<accounting_diskmgr_stats_t> *ptr = &stats_by_priority[pri];
+    if (!ptr->has()) {
+        ptr->init(new accounting_diskmgr_stats_t(stats, pri));
+    }
+    return ptr->get();
+}
+
+accounting_payload_t *accounting_diskmgr_t::deadline_producer_t::produce_next_value() {
+    const ticks_t now = parent->now_fun();
+
+    // The account with the earliest deadline is the most overdue one, if any are.
+    eager_account_t *earliest = parent->deadline_accounts.peek();
+    action_t *a = earliest != NULL && now > earliest->get_deadline()
+        ? earliest->pop_overdue()
+        : parent->queue.pop();
+    a->account->on_dispatch(a, now);
+    return a;
+}
+
 void accounting_diskmgr_t::submit(action_t *a) {
     a->account->push(a);
 }
@@ -3,8 +3,10 @@
 #define ARCH_IO_DISK_ACCOUNTING_HPP_
 
 #include <functional>
+#include <map>
 
 #include "containers/intrusive_list.hpp"
+#include "containers/intrusive_priority_queue.hpp"
 #include "containers/scoped.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/queue/accounting.hpp"
@@ -12,27 +14,14 @@
 #include "concurrency/semaphore.hpp"
 #include "arch/io/disk.hpp"
 #include "arch/io/disk/stats_2.hpp"
-
-/* `casting_passive_producer_t` is useful when you have a
-`passive_producer_t<X>` but you need a `passive_producer_t<Y>`, where `X` can
-be cast to `Y`. */
-
-template <class input_t, class output_t>
-struct casting_passive_producer_t : public passive_producer_t<output_t> {
-    explicit casting_passive_producer_t(passive_producer_t<input_t> *_source) :
-        passive_producer_t<output_t>(_source->available), source(_source) { }
-
-    output_t produce_next_value() {
-        /* Implicit cast from `input_t` to `output_t` in return */
-        return source->pop();
-    }
-
-private:
-    passive_producer_t<input_t> *source;
-};
+#include "perfmon/perfmon.hpp"
+#include "time.hpp"
 
 /* `accounting_diskmgr_t` shares disk throughput proportionally between a
-number of different "accounts". */
+number of different "accounts".  An account can also have a latency target.  Once a
+request of such an account has waited longer than that, it gets sent to the disk
+ahead of everything else, no matter what the shares say.  That keeps background work
+with a big queue of requests (GC, backfills, ...) from delaying foreground reads. */
 
 typedef stats_diskmgr_2_t::action_t accounting_payload_t;
 
@@ -47,13 +36,16 @@ struct accounting_diskmgr_account_t {
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 int64_t _latency_target_us);
 
     ~accounting_diskmgr_account_t();
 
     void push(action_t *action);
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
+    // Called when `action` leaves the queue for the disk.
+    void on_dispatch(action_t *action, ticks_t now);
 
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
@@ -63,6 +55,7 @@ private:
     accounting_diskmgr_t *par;
     int pri;
     int outstanding_requests_limit;
+    int64_t latency_target_us;
     scoped_ptr_t<eager_account_t> eager_account;
     // A scoped pointer because we create the drainer lazily on first use.
     scoped_ptr_t<auto_drainer_t> requests_drainer;
@@ -75,18 +68,43 @@ struct accounting_diskmgr_action_t
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
     auto_drainer_t::lock_t account_acq;
+    // When the action got submitted to its account
+    ticks_t enqueue_time;
 };
 
 void debug_print(printf_buffer_t *buf,
                  const accounting_diskmgr_action_t &action);
 
+/* The stats of all the accounts with the same priority.  We don't have a better
+name for an account than its priority, and accounts with the same priority are used
+for the same kind of work. */
+struct accounting_diskmgr_stats_t {
+    accounting_diskmgr_stats_t(perfmon_collection_t *parent, int pri);
+
+    void record_wait(ticks_t wait_time);
+
+    perfmon_collection_t collection;
+    perfmon_membership_t collection_membership;
+
+    // How many requests of these accounts were waiting when another one came in
+    perfmon_sampler_t queue_depth;
+    // How long requests waited in the queue in milliseconds, as a distribution and
+    // as a histogram
+    perfmon_sampler_t wait_time;
+    perfmon_counter_t waits_under_1ms;
+    perfmon_counter_t waits_1ms_10ms;
+    perfmon_counter_t waits_10ms_100ms;
+    perfmon_counter_t waits_100ms_plus;
+    // How many requests jumped the queue because they missed their latency target
+    perfmon_counter_t promoted;
+    perfmon_multi_membership_t stats_membership;
+
+    DISABLE_COPYING(accounting_diskmgr_stats_t);
+};
+
 class accounting_diskmgr_t : public home_thread_mixin_t {
 public:
-    explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
-          queue(batch_factor),
-          caster(&queue),
-          auto_drainer(new auto_drainer_t()) { }
+    accounting_diskmgr_t(int batch_factor, perfmon_collection_t *_stats);
 
     ~accounting_diskmgr_t();
 
@@ -98,6 +116,9 @@ public:
 
     std::function<void (action_t *)> done_fun;
 
+    // Where the latency targets get their time from.  Tests swap in a fake clock.
+    std::function<ticks_t ()> now_fun;
+
     passive_producer_t<accounting_payload_t *> * const producer;
     void done(accounting_payload_t *p);
 
@@ -107,9 +128,30 @@ public:
 
 private:
     friend struct accounting_diskmgr_eager_account_t;
+    typedef accounting_diskmgr_eager_account_t eager_account_t;
+
+    /* Hands out the next request for the disk.  That's the one with the earliest
+    deadline, if any request is past its account's latency target, and otherwise
+    whatever `queue` picks. */
+    struct deadline_producer_t : public passive_producer_t<accounting_payload_t *> {
+        explicit deadline_producer_t(accounting_diskmgr_t *_parent)
+            : passive_producer_t<accounting_payload_t *>(_parent->queue.available),
+              parent(_parent) { }
+        accounting_payload_t *produce_next_value();
+        accounting_diskmgr_t *parent;
+    };
+
+    accounting_diskmgr_stats_t *get_stats(int pri);
+
+    perfmon_collection_t *stats;
+    std::map<int, scoped_ptr_t<accounting_diskmgr_stats_t> > stats_by_priority;
+
+    // The accounts with a latency target that have requests ready for the disk,
+    // ordered by the deadline of the oldest one
+    intrusive_priority_queue_t<eager_account_t> deadline_accounts;
 
     accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    deadline_producer_t deadline_producer;
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
@@ -165,6 +165,26 @@ void pool_diskmgr_t::action_t::run() {
             return;
         }
     } break;
+    case ACTION_PUNCH_HOLE: {
+#ifdef FALLOC_FL_PUNCH_HOLE
+        int res;
+        do {
+            res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            offset, punch_length);
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == 0
+            || get_errno() == EOPNOTSUPP
+            || get_errno() == ENOSYS) {
+            // If the file system can't punch holes, the space just stays allocated.
+            io_result = 0;
+        } else {
+            io_result = -get_errno();
+            return;
+        }
+#else
+        io_result = 0;
+#endif
+    } break;
     case ACTION_READ:
     case ACTION_WRITE: {
         // Copy the io vectors because perform_read_write will modify them
@@ -49,6 +49,16 @@ struct pool_diskmgr_action_t
         offset = _new_size;
     }
 
+    void make_punch_hole(fd_t _fd, int64_t _offset, int64_t _length) {
+        type = ACTION_PUNCH_HOLE;
+        wrap_in_datasyncs = false;
+        fd = _fd;
+        buf_and_count.iov_base = NULL;
+        buf_and_count.iov_len = 0;
+        offset = _offset;
+        punch_length = _length;
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined... but we are in pool.hpp.  Where is it?"
 #elif USE_WRITEV
@@ -73,7 +83,11 @@ struct pool_diskmgr_action_t
     }
 
     bool get_is_write() const { return type == ACTION_WRITE; }
-    bool get_is_resize() const { return type == ACTION_RESIZE; }
+    // Hole punches are handled like resizes: they block out all other operations on
+    // the file while they run, and they never go through io_uring.
+    bool get_is_resize() const {
+        return type == ACTION_RESIZE || type == ACTION_PUNCH_HOLE;
+    }
     bool get_is_read() const { return type == ACTION_READ; }
     fd_t get_fd() const { return fd; }
     void get_bufs(iovec **iovecs_out, size_t *iovecs_len_out) {
@@ -97,20 +111,24 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class uring_diskmgr_t;
     pool_diskmgr_t *parent;
 
-    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
+    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE, ACTION_PUNCH_HOLE};
     action_type_t type;
     bool wrap_in_datasyncs;
     fd_t fd;
 
-    // Either type is ACTION_RESIZE, or buf_and_count.iov_base is used, or iovecs
+    // Either type is ACTION_RESIZE or ACTION_PUNCH_HOLE, or buf_and_count.iov_base
+    // is used, or iovecs
     // is used (for writev).  If iovecs is used, then buf_and_count.iov_len is the
     // sum of the iovecs' iov_len fields.  Currently readv is not supported, but if
     // you need it, it should be easy to add.
     scoped_array_t<iovec> iovecs;
     iovec buf_and_count;
     int64_t offset;
+    // The length of the hole, for ACTION_PUNCH_HOLE
+    int64_t punch_length;
 
     // Helper functions for vectored reads/writes
     static size_t advance_vector(iovec **vecs, size_t *count, size_t bytes_done);
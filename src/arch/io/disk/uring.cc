@@ -0,0 +1,405 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#if USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "arch/io/io_utils.hpp"
+#include "arch/timer.hpp"
+#include "config/args.hpp"
+#include "errors.hpp"
+#include "logger.hpp"
+
+#if USE_IO_URING
+
+// Older C libraries don't know the io_uring system call numbers yet.  They are the
+// same on every architecture that uses the generic system call table.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* `ring_t` owns the ring file descriptor and the three shared memory regions that
+make up an io_uring instance.  It only knows how to hand out submission entries and
+how to walk the completion queue; what goes into the entries is up to
+`uring_diskmgr_t`. */
+class uring_diskmgr_t::ring_t {
+public:
+    explicit ring_t(unsigned requested_entries)
+        : sq_ptr(MAP_FAILED), sq_size(0), cq_ptr(MAP_FAILED), cq_size(0),
+          sqes(static_cast<io_uring_sqe *>(MAP_FAILED)), sqes_size(0),
+          sqe_tail(0), unsubmitted(0) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int res = sys_io_uring_setup(requested_entries, &params);
+        if (res < 0) {
+            return;
+        }
+        scoped_fd_t ring_fd(res);
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+
+        sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            return;
+        }
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                return;
+            }
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+            mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return;
+        }
+
+        char *sq = static_cast<char *>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+        sqe_tail = *sq_tail;
+
+        char *cq = static_cast<char *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        fd = std::move(ring_fd);
+    }
+
+    ~ring_t() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_size);
+        }
+    }
+
+    bool valid() { return fd.get() != INVALID_FD; }
+
+    unsigned capacity() const { return sq_entries; }
+
+    bool register_eventfd(fd_t eventfd) {
+        rassert(valid());
+        int32_t efd = eventfd;
+        return sys_io_uring_register(fd.get(), IORING_REGISTER_EVENTFD, &efd, 1) == 0;
+    }
+
+    // Returns a zeroed submission entry, or `NULL` if the submission queue is full.
+    io_uring_sqe *get_sqe() {
+        const unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (sqe_tail - head >= sq_entries) {
+            return NULL;
+        }
+        const unsigned index = sqe_tail & sq_mask;
+        sq_array[index] = index;
+        ++sqe_tail;
+        ++unsubmitted;
+        io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    bool has_unsubmitted() const { return unsubmitted > 0; }
+
+    // Publishes all entries handed out by `get_sqe()` and tells the kernel about
+    // them.  Returns false if the kernel is temporarily out of resources or its
+    // completion queue is full; the leftover entries then stay queued until the next
+    // call.
+    MUST_USE bool submit() {
+        __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+        while (unsubmitted > 0) {
+            int res = sys_io_uring_enter(fd.get(), unsubmitted, 0, 0);
+            if (res >= 0) {
+                rassert(static_cast<unsigned>(res) <= unsubmitted);
+                unsubmitted -= res;
+                if (res == 0) {
+                    return false;
+                }
+            } else if (get_errno() == EAGAIN || get_errno() == EBUSY) {
+                return false;
+            } else {
+                guarantee_err(get_errno() == EINTR, "io_uring_enter failed");
+            }
+        }
+        return true;
+    }
+
+    // Moves all available completions into `out` and releases their slots in
+    // the completion queue.
+    void take_completions(std::vector<io_uring_cqe> *out) {
+        unsigned head = *cq_head;
+        const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            out->push_back(cqes[head & cq_mask]);
+            ++head;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    scoped_fd_t fd;
+
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe *cqes;
+
+    // Our private copy of the submission tail; it gets published in `submit()`.
+    unsigned sqe_tail;
+    unsigned unsubmitted;
+
+    DISABLE_COPYING(ring_t);
+};
+
+#else  // USE_IO_URING
+
+// Without io_uring support the ring can never be set up, so `is_supported()` will
+// always steer `linux_disk_manager_t` towards `pool_diskmgr_t`.
+class uring_diskmgr_t::ring_t {
+public:
+    explicit ring_t(unsigned) { }
+    bool valid() const { return false; }
+    unsigned capacity() const { return 0; }
+    bool register_eventfd(fd_t) { return false; }
+    io_uring_sqe *get_sqe() { return NULL; }
+    bool has_unsubmitted() const { return false; }
+    bool submit() { return true; }
+};
+
+#endif  // USE_IO_URING
+
+struct uring_diskmgr_t::blocking_job_t : public blocker_pool_t::job_t {
+    blocking_job_t(uring_diskmgr_t *_parent, action_t *_action)
+        : parent(_parent), action(_action) { }
+
+    void run() {
+        action->run();
+    }
+    void done() {
+        parent->on_blocking_job_done(this);
+    }
+
+    uring_diskmgr_t *const parent;
+    action_t *const action;
+};
+
+bool uring_diskmgr_t::is_supported() {
+    ring_t probe(2);
+    if (!probe.valid()) {
+        return false;
+    }
+    // Registering an eventfd needs a newer kernel than setting up the ring, so we
+    // have to check it separately.
+    system_event_t probe_event;
+    return probe.register_eventfd(probe_event.get_notify_fd());
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      source(_source),
+      queue_depth(std::min<int>(max_concurrent_io_requests,
+                                URING_DISKMGR_MAX_QUEUE_DEPTH)),
+      ring(new ring_t(queue_depth)),
+      blocker_pool(URING_DISKMGR_BLOCKER_THREADS, _queue),
+      resubmit_timer(NULL),
+      n_pending(0) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(ring->valid(), "Could not set up an io_uring instance.");
+    guarantee(ring->capacity() >= static_cast<unsigned>(queue_depth));
+    guarantee(ring->register_eventfd(completion_event.get_notify_fd()),
+              "Could not register an eventfd with io_uring.");
+
+    queue->watch_resource(completion_event.get_notify_fd(), poll_event_in, this);
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    if (resubmit_timer != NULL) {
+        cancel_timer(resubmit_timer);
+    }
+    source->available->unset_callback();
+    queue->forget_resource(completion_event.get_notify_fd(), this);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+    reap_completions();
+    // Reaping made room in the completion queue, so entries that the kernel turned
+    // away before may go through now.
+    pump();
+}
+
+void uring_diskmgr_t::on_timer() {
+    assert_thread();
+    resubmit_timer = NULL;
+    reap_completions();
+    pump();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+        if (!prepare_sqe(a)) {
+            run_blocking(a);
+        }
+    }
+    if (ring->has_unsubmitted() && !ring->submit() && resubmit_timer == NULL) {
+        // If nothing is in flight in the ring, no completion will come along to
+        // make us try again, so we have to set up a timer for that.
+        resubmit_timer = fire_timer_once(URING_DISKMGR_RESUBMIT_DELAY_MS, this);
+    }
+}
+
+#if USE_IO_URING
+bool uring_diskmgr_t::prepare_sqe(action_t *a) {
+    // io_uring can't truncate files on the kernels we care about, and chaining
+    // datasyncs around a write would need linked entries with three completions per
+    // action.  Both are rare enough (resizes and metablock writes) that a blocker
+    // thread is good enough for them.
+    if (a->get_is_resize() || a->wrap_in_datasyncs) {
+        return false;
+    }
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+    if (vecs_len > IOV_MAX) {
+        return false;
+    }
+
+    io_uring_sqe *sqe = ring->get_sqe();
+    // `n_pending` never exceeds `queue_depth`, which fits in the ring.
+    guarantee(sqe != NULL);
+    sqe->opcode = a->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = a->get_fd();
+    sqe->off = a->get_offset();
+    sqe->addr = reinterpret_cast<uintptr_t>(vecs);
+    sqe->len = vecs_len;
+    sqe->user_data = reinterpret_cast<uintptr_t>(a);
+    return true;
+}
+
+void uring_diskmgr_t::reap_completions() {
+    assert_thread();
+    std::vector<io_uring_cqe> completions;
+    ring->take_completions(&completions);
+
+    for (auto it = completions.begin(); it != completions.end(); ++it) {
+        action_t *a = reinterpret_cast<action_t *>(it->user_data);
+        const int64_t res = it->res;
+        if (res == static_cast<int64_t>(a->get_count())) {
+            finish(a, res);
+        } else if (res >= 0 || res == -EAGAIN || res == -EINTR) {
+            // A short transfer or a transient failure.  Reads and writes at a
+            // fixed offset are idempotent, so we simply let a blocker thread redo
+            // the whole operation; it knows how to loop over partial transfers.
+            run_blocking(a);
+        } else {
+            finish(a, res);
+        }
+    }
+}
+#else  // USE_IO_URING
+bool uring_diskmgr_t::prepare_sqe(action_t *) {
+    unreachable("io_uring support was not compiled in.");
+}
+
+void uring_diskmgr_t::reap_completions() {
+    unreachable("io_uring support was not compiled in.");
+}
+#endif  // USE_IO_URING
+
+void uring_diskmgr_t::run_blocking(action_t *a) {
+    blocker_pool.do_job(new blocking_job_t(this, a));
+}
+
+void uring_diskmgr_t::on_blocking_job_done(blocking_job_t *job) {
+    assert_thread();
+    action_t *a = job->action;
+    delete job;
+    n_pending--;
+    pump();
+    done_fun(a);
+}
+
+void uring_diskmgr_t::finish(action_t *a, int64_t io_result) {
+    a->io_result = io_result;
+    n_pending--;
+    pump();
+    done_fun(a);
+}
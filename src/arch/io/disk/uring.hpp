@@ -0,0 +1,91 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include <sys/uio.h>
+
+#include <functional>
+#include <vector>
+
+#include "arch/io/blocker_pool.hpp"
+#include "arch/io/disk/pool.hpp"
+#include "arch/timer.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+
+#if defined(__linux) && !defined(LEGACY_LINUX) && !defined(NO_IO_URING) && !defined(NO_EVENTFD)
+#define USE_IO_URING 1
+#else
+#define USE_IO_URING 0
+#endif
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* The uring disk manager submits reads and writes straight from the event loop
+through the kernel's io_uring interface, so a cache miss does not cost a handoff
+to a blocker thread and back.  Completions are signalled through an eventfd that is
+registered with the ring and watched by our event queue.
+
+It is a drop-in replacement for `pool_diskmgr_t` and works on the same actions.
+The operations that io_uring cannot express on every kernel we support (resizes,
+writes wrapped in datasyncs, and the rare short transfer that has to be finished
+off) are handed to a small internal `blocker_pool_t` instead.
+
+Use `uring_diskmgr_t::is_supported()` to find out whether the running kernel (and
+seccomp policy) lets us set up a ring at all; if it doesn't, use `pool_diskmgr_t`. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        private timer_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    static bool is_supported();
+
+    /* Like `pool_diskmgr_t`, draws actions to run from `source` and calls
+    `done_fun` on each one when it's done. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    class ring_t;
+    struct blocking_job_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+    void on_timer();
+
+    // Fills submission queue entries for as many actions as we may have in flight,
+    // then tells the kernel about them with a single `io_uring_enter` call.
+    void pump();
+    bool prepare_sqe(action_t *a);
+    void reap_completions();
+
+    void run_blocking(action_t *a);
+    void on_blocking_job_done(blocking_job_t *job);
+    void finish(action_t *a, int64_t io_result);
+
+    linux_event_queue_t *const queue;
+    passive_producer_t<action_t *> *const source;
+    const int queue_depth;
+
+    scoped_ptr_t<ring_t> ring;
+    system_event_t completion_event;
+    blocker_pool_t blocker_pool;
+
+    // Set while we wait to retry a submission that the kernel turned away.
+    timer_token_t *resubmit_timer;
+
+    // Number of actions popped from `source` that haven't completed yet, both in the
+    // ring and in `blocker_pool`.
+    int n_pending;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif /* ARCH_IO_DISK_URING_HPP_ */
@@ -100,6 +100,8 @@ linux_tcp_conn_t::linux_tcp_conn_t(const ip_address_t &peer,
         write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
         write_coro_pool(1, &write_queue, &write_handler),
         current_write_buffer(get_write_buffer()),
+        is_corked(false),
+        cork_failed(false),
         drainer(new auto_drainer_t) {
     guarantee_err(fcntl(sock.get(), F_SETFL, O_NONBLOCK) == 0, "Could not make socket non-blocking");
 
@@ -152,6 +154,8 @@ linux_tcp_conn_t::linux_tcp_conn_t(fd_t s) :
     write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
     write_coro_pool(1, &write_queue, &write_handler),
     current_write_buffer(get_write_buffer()),
+    is_corked(false),
+    cork_failed(false),
     drainer(new auto_drainer_t)
 {
     rassert(sock.get() != INVALID_FD);
@@ -337,20 +341,55 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != NULL) {
-        parent->perform_write(operation->buffer, operation->size);
-        if (operation->dealloc != NULL) {
-            parent->release_write_buffer(operation->dealloc);
-            parent->write_queue_limiter.unlock(operation->size);
+    std::vector<write_queue_op_t *> *batch = &parent->write_batch;
+    std::vector<iovec> *iovecs = &parent->write_batch_iovecs;
+    rassert(batch->empty());
+    batch->push_back(operation);
+
+    for (;;) {
+        /* Take whatever else is queued up, so that it all goes out with one
+        `writev()`. */
+        while (batch->size() < WRITE_BATCH_MAX_OPS
+               && parent->write_queue.available->get()) {
+            batch->push_back(parent->write_queue.pop());
         }
-    }
 
-    if (operation->cond != NULL) {
-        operation->cond->pulse();
-    }
-    if (operation->dealloc != NULL) {
-        parent->release_write_queue_op(operation);
+        iovecs->clear();
+        for (write_queue_op_t *op : *batch) {
+            if (op->buffer != NULL && op->size > 0) {
+                iovec iov;
+                iov.iov_base = const_cast<void *>(op->buffer);
+                iov.iov_len = op->size;
+                iovecs->push_back(iov);
+            }
+        }
+        parent->perform_write(iovecs->data(), iovecs->size());
+
+        for (write_queue_op_t *op : *batch) {
+            if (op->dealloc != NULL) {
+                rassert(op->cond == NULL);
+                parent->release_write_buffer(op->dealloc);
+                parent->write_queue_limiter.unlock(op->size);
+                parent->release_write_queue_op(op);
+            } else if (op->cond != NULL) {
+                /* `op` belongs to whoever waits on the cond, so we must not touch it
+                after this. */
+                op->cond->pulse();
+            }
+        }
+        batch->clear();
+
+        if (!parent->write_queue.available->get()) {
+            break;
+        }
+        /* More writes came in while we were writing. Hold back partial segments
+        until we're through with them too. */
+        parent->set_corked(true);
+        batch->push_back(parent->write_queue.pop());
     }
+
+    /* The queue is empty, so send whatever the kernel is still holding back. */
+    parent->set_corked(false);
 }
 
 void linux_tcp_conn_t::internal_flush_write_buffer() {
@@ -376,7 +415,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     write_queue.push(op);
 }
 
-void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
+void linux_tcp_conn_t::perform_write(iovec *iov, size_t iovcnt) {
     assert_thread();
 
     if (write_closed.is_pulsed()) {
@@ -386,8 +425,8 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         return;
     }
 
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    while (iovcnt > 0) {
+        ssize_t res = ::writev(sock.get(), iov, iovcnt);
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -420,21 +459,51 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         } else if (res == 0) {
             /* This should never happen either, but it's better to write an error message than to
                crash completely. */
-            logERR("Didn't expect write() to return 0.");
+            logERR("Didn't expect writev() to return 0.");
             on_shutdown_write();
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) write_perfmon->record(res);
+
+            /* Skip the buffers that were written completely, and the part of the
+            next one that was. */
+            size_t written = res;
+            while (iovcnt > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (written > 0) {
+                rassert(iovcnt > 0);
+                iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
         }
     }
 }
 
-void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
-    write_op_wrapper_t sentry(this, closer);
+void linux_tcp_conn_t::set_corked(bool corked) {
+    assert_thread();
+#ifdef TCP_CORK
+    if (corked == is_corked || cork_failed || write_closed.is_pulsed()) {
+        return;
+    }
+    int optval = corked ? 1 : 0;
+    int res = setsockopt(sock.get(), IPPROTO_TCP, TCP_CORK, &optval, sizeof(optval));
+    if (res == 0) {
+        is_corked = corked;
+    } else {
+        cork_failed = true;
+    }
+#else
+    (void)corked;
+#endif
+}
+
+void linux_tcp_conn_t::internal_write_unbuffered(const void *buf, size_t size) {
+    assert_thread();
+    rassert(write_in_progress);
 
     write_queue_op_t op;
     cond_t to_signal_when_done;
@@ -456,6 +525,12 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     is closed before or during our write, then `perform_write()` will turn into a
     no-op, so the cond will still get pulsed. */
     to_signal_when_done.wait();
+}
+
+void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    internal_write_unbuffered(buf, size);
 
     if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
 }
@@ -463,6 +538,15 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
+    /* Copying a big write into the buffers costs more than waiting for it, which
+    `write_queue_limiter` would mostly make us do anyway. So we write it straight
+    from the caller's memory. */
+    if (size >= WRITE_ZERO_COPY_MIN_SIZE) {
+        internal_write_unbuffered(vbuf, size);
+        if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
+        return;
+    }
+
     /* Convert to `char` for ease of pointer arithmetic */
     const char *buf = reinterpret_cast<const char *>(vbuf);
 
@@ -980,6 +1064,194 @@ int linux_tcp_listener_t::get_port() const {
     return listener->get_port();
 }
 
+#ifdef EVENT_QUEUE_HAS_EXCLUSIVE_WATCH
+class linux_threaded_tcp_listener_t::shared_acceptor_t {
+public:
+    shared_acceptor_t(
+            const scoped_array_t<scoped_fd_t> &socks,
+            const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &_callback) :
+        callback(_callback),
+        watches(socks.size()),
+        got_event(false),
+        waiter(NULL),
+        log_next_error(true)
+    {
+        for (size_t i = 0; i < socks.size(); ++i) {
+            watches[i].init(new socket_watch_t(socks[i].get(), this));
+        }
+        coro_t::spawn_sometime(std::bind(&shared_acceptor_t::accept_loop, this,
+                                         auto_drainer_t::lock_t(&drainer)));
+    }
+
+private:
+    // Wakes up the accept loop when a socket has connections to accept.
+    class socket_watch_t : public linux_event_callback_t {
+    public:
+        socket_watch_t(fd_t _sock, shared_acceptor_t *_parent) :
+            sock(_sock), parent(_parent) {
+            linux_thread_pool_t::get_thread()->queue.watch_resource_exclusively(
+                sock, poll_event_in, this);
+        }
+        ~socket_watch_t() {
+            linux_thread_pool_t::get_thread()->queue.forget_resource(sock, this);
+        }
+        fd_t get() const {
+            return sock;
+        }
+    private:
+        void on_event(int) {
+            parent->on_socket_event();
+        }
+        const fd_t sock;
+        shared_acceptor_t *const parent;
+        DISABLE_COPYING(socket_watch_t);
+    };
+
+    void on_socket_event() {
+        got_event = true;
+        if (waiter != NULL) {
+            waiter->pulse_if_not_already_pulsed();
+        }
+    }
+
+    void accept_loop(auto_drainer_t::lock_t lock) {
+        static const int initial_backoff_delay_ms = 10;   // Milliseconds
+        static const int max_backoff_delay_ms = 160;
+        int backoff_delay_ms = initial_backoff_delay_ms;
+
+        while (!lock.get_drain_signal()->is_pulsed()) {
+            got_event = false;
+            // The watches are edge-triggered, and the kernel doesn't wake us up for
+            // connections that were already waiting, so we accept all of them.
+            bool failed = false;
+            for (size_t i = 0; i < watches.size() && !failed; ++i) {
+                for (;;) {
+                    fd_t new_sock = accept(watches[i]->get(), NULL, NULL);
+                    if (new_sock != INVALID_FD) {
+                        coro_t::spawn_now_dangerously(
+                            std::bind(&shared_acceptor_t::handle, this, new_sock));
+                        if (backoff_delay_ms > initial_backoff_delay_ms) backoff_delay_ms /= 2;
+                        log_next_error = true;
+                    } else if (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK) {
+                        // Another thread may have taken the connection.
+                        break;
+                    } else if (get_errno() == EINTR) {
+                        /* Harmless error; just try again. */
+                    } else {
+                        if (log_next_error) {
+                            logERR("accept() failed: %s.",
+                                errno_string(get_errno()).c_str());
+                            log_next_error = false;
+                        }
+                        failed = true;
+                        break;
+                    }
+                }
+            }
+
+            if (failed) {
+                // The connection is still waiting, so we retry without waiting for
+                // another event.
+                try {
+                    nap(backoff_delay_ms, lock.get_drain_signal());
+                } catch (const interrupted_exc_t &) {
+                    return;
+                }
+                if (backoff_delay_ms < max_backoff_delay_ms) backoff_delay_ms *= 2;
+            } else if (!got_event) {
+                cond_t event_cond;
+                waiter = &event_cond;
+                wait_any_t waiter_or_drain(&event_cond, lock.get_drain_signal());
+                waiter_or_drain.wait_lazily_unordered();
+                waiter = NULL;
+            }
+        }
+    }
+
+    void handle(fd_t sock) {
+        scoped_ptr_t<linux_tcp_conn_descriptor_t> nconn(
+            new linux_tcp_conn_descriptor_t(sock));
+        callback(nconn);
+    }
+
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> callback;
+
+    scoped_array_t<scoped_ptr_t<socket_watch_t> > watches;
+
+    // Set when a socket got a connection since the accept loop last looked at them.
+    bool got_event;
+    cond_t *waiter;
+
+    bool log_next_error;
+
+    // Destroyed first, so that the accept loop stops before the watches go away
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(shared_acceptor_t);
+};
+#else
+// Never gets created; only the home thread accepts connections.
+class linux_threaded_tcp_listener_t::shared_acceptor_t { };
+#endif
+
+linux_threaded_tcp_listener_t::linux_threaded_tcp_listener_t(
+    const std::set<ip_address_t> &bind_addresses, int _port,
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &,
+                             auto_drainer_t::lock_t)> &_callback) :
+        callback(_callback),
+        port(_port),
+        accept_threads(get_num_threads())
+{
+    // This thread listens, and the others accept connections on its sockets.
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> handler
+        = std::bind(&linux_threaded_tcp_listener_t::handle, this, ph::_1);
+    accept_threads[home_thread().threadnum].init(new accept_thread_t);
+    accept_thread_t *home = accept_threads[home_thread().threadnum].get();
+    home->listener.init(
+        new linux_nonthrowing_tcp_listener_t(bind_addresses, port, handler));
+    if (!home->listener->begin_listening()) {
+        accept_threads[home_thread().threadnum].reset();
+        throw address_in_use_exc_t("localhost", port);
+    }
+    port = home->listener->get_port();
+
+#ifdef EVENT_QUEUE_HAS_EXCLUSIVE_WATCH
+    for (int i = 0; i < get_num_threads(); ++i) {
+        if (i == home_thread().threadnum) {
+            continue;
+        }
+        on_thread_t thread_switcher((threadnum_t(i)));
+        accept_threads[i].init(new accept_thread_t);
+        accept_threads[i]->acceptor.init(
+            new shared_acceptor_t(home->listener->socks, handler));
+    }
+#endif
+}
+
+linux_threaded_tcp_listener_t::~linux_threaded_tcp_listener_t() {
+    // The other threads accept on the home thread's sockets, so they have to stop
+    // before the sockets get closed.
+    for (int i = 0; i < get_num_threads(); ++i) {
+        if (i != home_thread().threadnum && accept_threads[i].has()) {
+            on_thread_t thread_switcher((threadnum_t(i)));
+            accept_threads[i].reset();
+        }
+    }
+    on_thread_t thread_switcher(home_thread());
+    accept_threads[home_thread().threadnum].reset();
+}
+
+int linux_threaded_tcp_listener_t::get_port() const {
+    return port;
+}
+
+void linux_threaded_tcp_listener_t::handle(
+        scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn) {
+    callback(nconn,
+             auto_drainer_t::lock_t(
+                 &accept_threads[get_thread_id().threadnum]->drainer));
+}
+
 linux_repeated_nonthrowing_tcp_listener_t::linux_repeated_nonthrowing_tcp_listener_t(
     const std::set<ip_address_t> &bind_addresses,
     int port,
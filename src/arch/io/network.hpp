@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <ifaddrs.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -16,6 +17,7 @@
 #include <vector>
 
 #include "config/args.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/scoped.hpp"
 #include "arch/address.hpp"
@@ -30,6 +32,8 @@
 #include "containers/intrusive_list.hpp"
 #include "perfmon/types.hpp"
 
+namespace unittest { class tcp_conn_tester_t; }
+
 /* linux_tcp_conn_t provides a disgusting wrapper around a TCP network connection. */
 
 class linux_tcp_conn_t :
@@ -37,6 +41,7 @@ class linux_tcp_conn_t :
     private linux_event_callback_t {
 public:
     friend class linux_tcp_conn_descriptor_t;
+    friend class unittest::tcp_conn_tester_t;
 
     void enable_keepalive();
 
@@ -232,6 +237,10 @@ private:
 
     static const size_t WRITE_QUEUE_MAX_SIZE = 128 * KILOBYTE;
     static const size_t WRITE_CHUNK_SIZE = 8 * KILOBYTE;
+    /* `write_buffered()` doesn't copy writes that are at least this big. */
+    static const size_t WRITE_ZERO_COPY_MIN_SIZE = WRITE_QUEUE_MAX_SIZE / 2;
+    /* How many queued operations the write coroutine hands to a single `writev()`. */
+    static const size_t WRITE_BATCH_MAX_OPS = 64;
 
     /* Structs to avoid over-using dynamic allocation */
     struct write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
@@ -247,6 +256,8 @@ private:
         auto_drainer_t::lock_t keepalive;
     };
 
+    /* Takes the operations off `write_queue`, and writes as many of them as it can
+    with each system call. */
     class write_handler_t : public coro_pool_callback_t<write_queue_op_t*> {
     public:
         explicit write_handler_t(linux_tcp_conn_t *_parent);
@@ -282,6 +293,9 @@ private:
     data to be completely written. */
     void internal_flush_write_buffer();
 
+    /* Queues up a write straight from `buffer`, and blocks until it's done. */
+    void internal_write_unbuffered(const void *buffer, size_t size);
+
     /* Used to queue up buffers to write. The functions in `write_queue` will all be
     `std::bind()`s of the `perform_write()` function below. */
     unlimited_fifo_queue_t<write_queue_op_t*, intrusive_list_t<write_queue_op_t> > write_queue;
@@ -297,9 +311,22 @@ private:
     certain size, we push it onto `write_queue`. */
     scoped_ptr_t<write_buffer_t> current_write_buffer;
 
-    /* Used to actually perform a write. If the write end of the connection is open, then writes
-    `size` bytes from `buffer` to the socket. */
-    void perform_write(const void *buffer, size_t size);
+    /* The operations that `write_handler` is writing at once, and their buffers. Only
+    the write coroutine touches these; they're members so that they keep their
+    memory. */
+    std::vector<write_queue_op_t *> write_batch;
+    std::vector<iovec> write_batch_iovecs;
+
+    /* While the write queue keeps refilling, we set `TCP_CORK` on the socket, so that
+    the kernel sends full segments rather than one per `writev()`.  Sockets that
+    aren't TCP don't have the option; once setting it failed, we don't try again. */
+    bool is_corked;
+    bool cork_failed;
+    void set_corked(bool corked);
+
+    /* Used to actually perform a write. If the write end of the connection is open, then
+    writes the `iovcnt` buffers in `iov` to the socket. Modifies `iov`. */
+    void perform_write(iovec *iov, size_t iovcnt);
 
     scoped_ptr_t<auto_drainer_t> drainer;
 };
@@ -316,6 +343,7 @@ public:
 
 private:
     friend class linux_nonthrowing_tcp_listener_t;
+    friend class linux_threaded_tcp_listener_t;
 
     explicit linux_tcp_conn_descriptor_t(fd_t fd);
 
@@ -343,6 +371,7 @@ public:
 protected:
     friend class linux_tcp_listener_t;
     friend class linux_tcp_bound_socket_t;
+    friend class linux_threaded_tcp_listener_t;
 
     MUST_USE bool bind_sockets();
 
@@ -412,6 +441,50 @@ private:
     scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
 };
 
+/* Listens on a port and accepts connections on every thread, so that accepting
+connections isn't left to a single thread.  The thread that creates the listener owns
+the sockets, and the other threads watch them with `EPOLLEXCLUSIVE`, so that the
+kernel wakes only one of them for each connection.  Where the event queue can't do
+that, only the thread that creates the listener accepts connections.
+
+The callback gets called on the thread that accepted the connection, with a lock on a
+drainer of that thread.  The destructor waits for all the callbacks to return. */
+class linux_threaded_tcp_listener_t : public home_thread_mixin_t {
+public:
+    // Throws `address_in_use_exc_t` if the port is taken.
+    linux_threaded_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &,
+                                 auto_drainer_t::lock_t)> &callback);
+    ~linux_threaded_tcp_listener_t();
+
+    int get_port() const;
+
+private:
+    // Accepts connections on the sockets of the home thread's listener.
+    class shared_acceptor_t;
+
+    struct accept_thread_t {
+        auto_drainer_t drainer;
+        // Destroyed first, so that no callbacks get started while draining.  The home
+        // thread has the listener, and the other threads have acceptors.
+        scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
+        scoped_ptr_t<shared_acceptor_t> acceptor;
+    };
+
+    void handle(scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn);
+
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &,
+                             auto_drainer_t::lock_t)> callback;
+    int port;
+
+    // One per thread; empty on threads that don't accept connections.  Each one gets
+    // created and destroyed on its own thread, the home thread's one last, since it
+    // owns the sockets.
+    scoped_array_t<scoped_ptr_t<accept_thread_t> > accept_threads;
+
+    DISABLE_COPYING(linux_threaded_tcp_listener_t);
+};
+
 /* Like a linux tcp listener but repeatedly tries to bind to its port until successful */
 class linux_repeated_nonthrowing_tcp_listener_t {
 public:
@@ -0,0 +1,27 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/runtime/busy_poller.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+static int64_t busy_poll_limit_us = 0;
+
+void set_busy_poll_limit(int64_t microseconds) {
+    guarantee(microseconds >= 0 && microseconds <= MAX_BUSY_POLL_LIMIT_US);
+    busy_poll_limit_us = microseconds;
+}
+
+busy_poller_t::busy_poller_t()
+    : limit(busy_poll_limit_us * THOUSAND), current_spin(limit) { }
+
+void busy_poller_t::record_spin(bool hit, ticks_t duration) {
+    ++stats.spins;
+    stats.spin_ticks += duration;
+    if (hit) {
+        ++stats.hits;
+        current_spin = std::min(limit, current_spin * 2);
+    } else {
+        current_spin = std::max(limit / BUSY_POLL_MIN_SPIN_DIVISOR, current_spin / 2);
+    }
+}
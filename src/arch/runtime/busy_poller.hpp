@@ -0,0 +1,69 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_BUSY_POLLER_HPP_
+#define ARCH_RUNTIME_BUSY_POLLER_HPP_
+
+#include "errors.hpp"
+#include "time.hpp"
+
+// Sets how long, at most, event queues spin looking for new events before they go to
+// sleep (see `busy_poller_t`).  Zero, the default, turns busy polling off.  Must be
+// called before the thread pool starts.
+void set_busy_poll_limit(int64_t microseconds);
+
+/* Instead of going to sleep as soon as it runs out of events, an event queue can spin
+for a while, polling for new events without blocking.  That burns CPU, but when an
+event shows up during the spin, the thread doesn't go to sleep in `epoll_wait()` and
+doesn't have to be woken up, which saves the scheduler's wakeup latency.  Senders
+still notify the thread as usual, so spinning doesn't save them anything.
+
+`busy_poller_t` decides how long the event queue of one thread spins.  The spin time
+doubles, up to the limit, whenever spinning finds an event, and halves, down to a
+fraction of the limit, whenever it doesn't, so that a thread that's idle for long
+periods doesn't waste much. */
+class busy_poller_t {
+public:
+    struct stats_t {
+        stats_t() : spins(0), hits(0), spin_ticks(0) { }
+        int64_t spins;
+        // How many spins found an event
+        int64_t hits;
+        ticks_t spin_ticks;
+    };
+
+    busy_poller_t();
+
+    bool enabled() const { return limit > 0; }
+
+    // Calls `poll()` until it returns something other than zero, or until the spin
+    // time is up, and returns its last result.  Returns zero right away if busy
+    // polling is off.
+    template <class callable_t>
+    int spin(const callable_t &poll) {
+        if (!enabled()) {
+            return 0;
+        }
+        const ticks_t start = get_ticks();
+        const ticks_t deadline = start + current_spin;
+        int res;
+        ticks_t now;
+        do {
+            res = poll();
+            now = get_ticks();
+        } while (res == 0 && now < deadline);
+        record_spin(res != 0, now - start);
+        return res;
+    }
+
+    const stats_t &get_stats() const { return stats; }
+
+private:
+    void record_spin(bool hit, ticks_t duration);
+
+    const ticks_t limit;
+    ticks_t current_spin;
+    stats_t stats;
+
+    DISABLE_COPYING(busy_poller_t);
+};
+
+#endif  // ARCH_RUNTIME_BUSY_POLLER_HPP_
@@ -2,9 +2,12 @@
 #include "arch/runtime/context_switching.hpp"
 
 #include <pthread.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #ifndef NDEBUG
 #include <cxxabi.h>   // For __cxa_current_exception_type (see below)
 #endif
@@ -16,9 +19,11 @@
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/concurrency.hpp"
+#include "config/args.hpp"
 #include "containers/scoped.hpp"
 #include "errors.hpp"
 #include "math.hpp"
+#include "thread_local.hpp"
 #include "utils.hpp"
 
 /* We have a custom implementation of `swapcontext()` that doesn't swap the
@@ -38,25 +43,163 @@ bool artificial_stack_context_ref_t::is_nil() {
     return pointer == NULL;
 }
 
-artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
-    : stack_size(_stack_size) {
-    /* Allocate the stack */
-    stack = malloc_aligned(stack_size, getpagesize());
+TLS_with_init(coro_stack_pool_t *, coro_stack_pool, NULL);
+
+coro_stack_pool_t::coro_stack_pool_t() : window_start(get_ticks()) {
+    rassert(TLS_get_coro_stack_pool() == NULL);
+    TLS_set_coro_stack_pool(this);
+}
+
+coro_stack_pool_t::~coro_stack_pool_t() {
+    rassert(TLS_get_coro_stack_pool() == this);
+    TLS_set_coro_stack_pool(NULL);
+
+    for (auto it = size_classes.begin(); it != size_classes.end(); ++it) {
+        rassert(it->second.in_use == 0, "Some coroutine stacks were never released.");
+    }
+    for (auto it = slabs.begin(); it != slabs.end(); ++it) {
+        int res = munmap(it->first, it->second);
+        guarantee_err(res == 0, "Could not unmap coroutine stacks");
+    }
+}
+
+coro_stack_pool_t *coro_stack_pool_t::get_thread_pool() {
+    return TLS_get_coro_stack_pool();
+}
+
+size_t coro_stack_pool_t::size_class_t::wanted_warm_stacks() const {
+    return std::max(window_peak, last_window_peak) - in_use;
+}
+
+void *coro_stack_pool_t::acquire(size_t stack_size) {
+    size_class_t *size_class = &size_classes[stack_size];
+    if (size_class->warm_stacks.empty() && size_class->cold_stacks.empty()) {
+        map_slab(stack_size, size_class);
+    }
+
+    void *stack;
+    if (!size_class->warm_stacks.empty()) {
+        stack = size_class->warm_stacks.back();
+        size_class->warm_stacks.pop_back();
+    } else {
+        stack = size_class->cold_stacks.back();
+        size_class->cold_stacks.pop_back();
+    }
+    ++size_class->in_use;
+    size_class->window_peak = std::max(size_class->window_peak, size_class->in_use);
+    return stack;
+}
+
+void coro_stack_pool_t::release(void *stack, size_t stack_size) {
+    maybe_start_new_window();
+
+    auto it = size_classes.find(stack_size);
+    guarantee(it != size_classes.end());
+    size_class_t *size_class = &it->second;
+    rassert(size_class->in_use > 0);
+    --size_class->in_use;
+    if (size_class->warm_stacks.size() < size_class->wanted_warm_stacks()) {
+        size_class->warm_stacks.push_back(stack);
+    } else {
+        cool_down(stack, stack_size, size_class);
+    }
+}
 
-    /* Tell the operating system that it can unmap the stack space
-    (except for the first page, which we are definitely going to need).
-    This is an optimization to keep memory consumption in check. */
+void coro_stack_pool_t::map_slab(size_t stack_size, size_class_t *size_class) {
+    // Bursts of new coroutines get bigger slabs, so they need fewer system calls.
+    const size_t num_stacks = clamp<size_t>(size_class->in_use / 2,
+                                            COROUTINE_STACK_SLAB_MIN_STACKS,
+                                            COROUTINE_STACK_SLAB_MAX_STACKS);
+    const size_t slab_size = num_stacks * stack_size;
+    void *slab = mmap(NULL, slab_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    guarantee_err(slab != MAP_FAILED, "Could not map memory for coroutine stacks");
+    slabs.push_back(std::make_pair(slab, slab_size));
+
+#if defined(CORO_STACK_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+    madvise(slab, slab_size, MADV_HUGEPAGE);
+#endif
+
+    // The stacks haven't been touched yet, so they aren't in memory.  We push them in
+    // reverse, so that they get handed out from the lowest address up.
+    for (size_t i = num_stacks; i-- > 0;) {
+        char *stack = static_cast<char *>(slab) + i * stack_size;
+        /* Protect the end of the stack so that we crash when we get a stack
+        overflow instead of corrupting memory. */
+        int res = mprotect(stack, getpagesize(), PROT_NONE);
+        guarantee_err(res == 0, "Could not protect coroutine stack");
+        size_class->cold_stacks.push_back(stack);
+    }
+}
+
+void coro_stack_pool_t::cool_down(void *stack, size_t stack_size,
+                                  size_class_t *size_class) {
+    /* Return the memory to the operating system, but keep the address space and the
+    guard page. */
+    char *usable = static_cast<char *>(stack) + getpagesize();
+#ifdef __MACH__
+    madvise(usable, stack_size - getpagesize(), MADV_FREE);
+#else
+    madvise(usable, stack_size - getpagesize(), MADV_DONTNEED);
+#endif
+    size_class->cold_stacks.push_back(stack);
+}
+
+void coro_stack_pool_t::maybe_start_new_window() {
+    const ticks_t now = get_ticks();
+    if (now - window_start < static_cast<ticks_t>(COROUTINE_STACK_POOL_WINDOW_MS)
+                             * MILLION) {
+        return;
+    }
+    window_start = now;
+    for (auto it = size_classes.begin(); it != size_classes.end(); ++it) {
+        size_class_t *size_class = &it->second;
+        size_class->last_window_peak = size_class->window_peak;
+        size_class->window_peak = size_class->in_use;
+        // The peak may have gone down, so we might be keeping too many stacks around.
+        while (size_class->warm_stacks.size() > size_class->wanted_warm_stacks()) {
+            void *stack = size_class->warm_stacks.back();
+            size_class->warm_stacks.pop_back();
+            cool_down(stack, it->first, size_class);
+        }
+    }
+}
+
+artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
+    : stack_size(_stack_size),
+#ifndef THREADED_COROUTINES
+      pool(coro_stack_pool_t::get_thread_pool()) {
+#else
+      /* The stacks of threaded coroutines never get used, and they can get
+      destroyed on other threads than the pool's. */
+      pool(NULL) {
+#endif
     guarantee(stack_size >= static_cast<size_t>(getpagesize()));
-    madvise(stack, stack_size - getpagesize(), MADV_DONTNEED);
+    const size_t stack_remainder = stack_size % getpagesize();
+    guarantee(stack_remainder == 0);
+
+    if (pool != NULL) {
+        /* The pool has protected the end of the stack already. */
+        stack = pool->acquire(stack_size);
+    } else {
+        /* Allocate the stack */
+        stack = malloc_aligned(stack_size, getpagesize());
+
+        /* Tell the operating system that it can unmap the stack space
+        (except for the first page, which we are definitely going to need).
+        This is an optimization to keep memory consumption in check. */
+        madvise(stack, stack_size - getpagesize(), MADV_DONTNEED);
 
-    /* Protect the end of the stack so that we crash when we get a stack
-    overflow instead of corrupting memory. */
+        /* Protect the end of the stack so that we crash when we get a stack
+        overflow instead of corrupting memory. */
 #ifndef THREADED_COROUTINES
-    mprotect(stack, getpagesize(), PROT_NONE);
+        mprotect(stack, getpagesize(), PROT_NONE);
 #else
-    /* Instruments hangs when running with mprotect and having object identification enabled.
-    We don't need it for THREADED_COROUTINES anyway, so don't use it then. */
+        /* Instruments hangs when running with mprotect and having object identification
+        enabled.  We don't need it for THREADED_COROUTINES anyway, so don't use it
+        then. */
 #endif
+    }
 
     /* Register our stack with Valgrind so that it understands what's going on
     and doesn't create spurious errors */
@@ -146,6 +289,13 @@ artificial_stack_t::~artificial_stack_t() {
 #endif
 #endif
 
+    if (pool != NULL) {
+        /* Stacks go back to the pool of the thread they were allocated on. */
+        rassert(pool == coro_stack_pool_t::get_thread_pool());
+        pool->release(stack, stack_size);
+        return;
+    }
+
     /* Undo protections changes */
 #ifndef THREADED_COROUTINES
     mprotect(stack, getpagesize(), PROT_READ | PROT_WRITE);
@@ -167,6 +317,34 @@ artificial_stack_t::~artificial_stack_t() {
     free(stack);
 }
 
+#ifdef ENABLE_CORO_PROFILER
+size_t artificial_stack_t::take_stack_usage() {
+    char here;
+    rassert(address_in_stack(&here));
+
+    /* Stacks start out zeroed, and grow down, so the lowest non-zero word above the
+    guard page is as deep as the stack ever got. */
+    uintptr_t *lowest_used =
+        reinterpret_cast<uintptr_t *>(static_cast<char *>(stack) + getpagesize());
+    uintptr_t *const top = reinterpret_cast<uintptr_t *>(
+        floor_aligned(reinterpret_cast<uintptr_t>(&here), sizeof(uintptr_t)));
+    while (lowest_used < top && *lowest_used == 0) {
+        ++lowest_used;
+    }
+    const size_t usage = static_cast<char *>(get_stack_base())
+        - reinterpret_cast<char *>(lowest_used);
+
+    /* Clear what got used below us, but leave a page for our own stack frame and the
+    ones of `memset()`. */
+    char *const clear_end = &here - getpagesize();
+    char *const clear_start = reinterpret_cast<char *>(lowest_used);
+    if (clear_start < clear_end) {
+        memset(clear_start, 0, clear_end - clear_start);
+    }
+    return usage;
+}
+#endif
+
 bool artificial_stack_t::address_in_stack(void *addr) {
     return reinterpret_cast<uintptr_t>(addr) >=
             reinterpret_cast<uintptr_t>(get_stack_bound())
@@ -4,10 +4,15 @@
 
 #include <pthread.h>
 
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "errors.hpp"
 
 #include "arch/io/concurrency.hpp"
 #include "containers/scoped.hpp"
+#include "time.hpp"
 
 
 /* Note that `artificial_stack_context_ref_t` is not a POD type. We could make it a POD type, but
@@ -40,6 +45,61 @@ private:
     DISABLE_COPYING(artificial_stack_context_ref_t);
 };
 
+/* `coro_stack_pool_t` hands out the memory for the coroutine stacks of one thread.
+Allocating every stack on its own and protecting its guard page takes several system
+calls, and a burst of thousands of new coroutines turns into a storm of them.  The
+pool instead maps the stacks in slabs, protects their guard pages once, and keeps
+the stacks around when they are released.
+
+Released stacks stay in memory as long as the number of stacks in use was that high
+recently; the others get returned to the operating system, but keep their address
+space and guard pages for the next burst.  If RethinkDB is built with
+`CORO_STACK_HUGE_PAGES`, the slabs are backed by transparent huge pages where
+possible.  Guard pages and released stacks split huge pages, so this pays off
+mostly for big stacks. */
+class coro_stack_pool_t {
+public:
+    /* Makes this the pool of the current thread. */
+    coro_stack_pool_t();
+    ~coro_stack_pool_t();
+
+    /* Returns the pool of the current thread, or `NULL` if it doesn't have one. */
+    static coro_stack_pool_t *get_thread_pool();
+
+    /* Returns the lowest address of a stack of `stack_size` bytes, whose lowest page
+    is protected already. */
+    void *acquire(size_t stack_size);
+    void release(void *stack, size_t stack_size);
+
+private:
+    struct size_class_t {
+        size_class_t() : in_use(0), window_peak(0), last_window_peak(0) { }
+
+        // The number of unused stacks we keep in memory
+        size_t wanted_warm_stacks() const;
+
+        // Unused stacks that are in memory, and ones that were returned to the
+        // operating system.  We hand out the former ones first.
+        std::vector<void *> warm_stacks;
+        std::vector<void *> cold_stacks;
+
+        size_t in_use;
+        // The highest `in_use` of the current window, and of the one before.
+        size_t window_peak;
+        size_t last_window_peak;
+    };
+
+    void map_slab(size_t stack_size, size_class_t *size_class);
+    static void cool_down(void *stack, size_t stack_size, size_class_t *size_class);
+    void maybe_start_new_window();
+
+    std::map<size_t, size_class_t> size_classes;
+    std::vector<std::pair<void *, size_t> > slabs;
+    ticks_t window_start;
+
+    DISABLE_COPYING(coro_stack_pool_t);
+};
+
 class artificial_stack_t {
 public:
 
@@ -65,9 +125,18 @@ public:
     /* Returns the end of the stack */
     void *get_stack_bound() { return stack; }
 
+#ifdef ENABLE_CORO_PROFILER
+    /* Returns how many bytes of the stack were used since the last call, and clears
+    them for the next one.  Must be called on this stack.  The frames of the caller
+    and a bit below it don't get cleared, so they always count as used. */
+    size_t take_stack_usage();
+#endif
+
 private:
     void *stack;
     size_t stack_size;
+    // The pool `stack` came from, or `NULL` if we allocated it ourselves.
+    coro_stack_pool_t *pool;
 #ifdef VALGRIND
     int valgrind_stack_id;
 #endif
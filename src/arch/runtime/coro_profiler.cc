@@ -125,6 +125,31 @@ void coro_profiler_t::record_coro_yield(size_t levels_to_strip_from_backtrace) {
     record_sample(1 + levels_to_strip_from_backtrace);
 }
 
+void coro_profiler_t::record_coro_stack_usage(size_t bytes) {
+    rassert(coro_t::self());
+
+    per_thread_samples_t &thread_samples = per_thread_samples[get_thread_id().threadnum].value;
+    const spinlock_acq_t thread_lock(&thread_samples.spinlock);
+    stack_usage_t &usage = thread_samples.stack_usage[get_current_coro_type()];
+    ++usage.num_samples;
+    usage.total_bytes += bytes;
+    usage.max_bytes = std::max(usage.max_bytes, bytes);
+}
+
+void coro_profiler_t::stack_usage_t::add(const stack_usage_t &other) {
+    num_samples += other.num_samples;
+    total_bytes += other.total_bytes;
+    max_bytes = std::max(max_bytes, other.max_bytes);
+}
+
+std::string coro_profiler_t::get_current_coro_type() {
+#ifndef NDEBUG
+    return coro_t::self()->get_coroutine_type();
+#else
+    return "?";
+#endif
+}
+
 coro_profiler_t::coro_execution_point_key_t coro_profiler_t::get_current_execution_point(
     size_t levels_to_strip_from_backtrace) {
 
@@ -149,15 +174,12 @@ coro_profiler_t::coro_execution_point_key_t coro_profiler_t::get_current_executi
     }
     delete[] stack_frames;
 
-#ifndef NDEBUG
-    return coro_execution_point_key_t(coro_t::self()->get_coroutine_type(), trace);
-#else
-    return coro_execution_point_key_t("?", trace);
-#endif
+    return coro_execution_point_key_t(get_current_coro_type(), trace);
 }
 
 void coro_profiler_t::generate_report() {
     std::map<coro_execution_point_key_t, per_execution_point_collected_report_t> execution_point_reports;
+    std::map<std::string, stack_usage_t> stack_usage_reports;
 
     // We assume that the global report_interval_spinlock has already been locked by our caller.
     {
@@ -198,6 +220,14 @@ void coro_profiler_t::generate_report() {
                     execution_point_samples->second.samples.clear();
                 }
             }
+
+            // Collect stack usage
+            for (auto usage = thread_samples->value.stack_usage.begin();
+                 usage != thread_samples->value.stack_usage.end();
+                 ++usage) {
+                stack_usage_reports[usage->first].add(usage->second);
+            }
+            thread_samples->value.stack_usage.clear();
         }
 
         // Release per-thread locks
@@ -212,6 +242,7 @@ void coro_profiler_t::generate_report() {
 
     if (reql_output_file != nullptr) {
         print_to_reql(execution_point_reports);
+        print_stack_usage_to_reql(stack_usage_reports);
     }
 }
 
@@ -322,6 +353,32 @@ void coro_profiler_t::print_to_reql(
     }
 }
 
+void coro_profiler_t::print_stack_usage_to_reql(
+    const std::map<std::string, stack_usage_t> &stack_usage_reports) {
+    guarantee(reql_output_file != nullptr);
+
+    const double time = ticks_to_secs(get_ticks());
+
+    for (auto report = stack_usage_reports.begin(); report != stack_usage_reports.end(); ++report) {
+        fprintf(reql_output_file,
+                "print t.insert({\n"
+                "\t\t'time': %.10f,\n", time);
+        fprintf(reql_output_file,
+                "\t\t'coro_type': '%s',\n",
+                report->first.c_str());
+        fprintf(reql_output_file,
+                "\t\t'num_samples': %zu,\n",
+                report->second.num_samples);
+        fprintf(reql_output_file,
+                "\t\t'stack_usage': {'mean': %.1f, 'max': %zu}\n",
+                static_cast<double>(report->second.total_bytes)
+                / static_cast<double>(report->second.num_samples),
+                report->second.max_bytes);
+        fprintf(reql_output_file,
+                "\t}).run(conn, durability='soft')\n");
+    }
+}
+
 std::string coro_profiler_t::trace_to_array_str(const small_trace_t &trace) {
     std::string trace_array_str = "[";
     for (size_t i = 0; i < CORO_PROFILER_BACKTRACE_DEPTH; ++i) {
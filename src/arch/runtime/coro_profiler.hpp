@@ -61,6 +61,9 @@
  * identify an "execution point". Data is recorded and reported for each such
  * execution point.
  *
+ * Whenever a coroutine finishes, the profiler also records how deep its stack got,
+ * and reports the mean and maximum of that per coro_type.
+ *
  * The aggregated data is written to the file "coro_profiler_out.py" in the working
  * directory. Data is written every `CORO_PROFILER_REPORTING_INTERVAL` ticks.
  */
@@ -79,6 +82,8 @@ public:
     void record_coro_resume();
     // coroutine execution yields
     void record_coro_yield(size_t levels_to_strip_from_backtrace);
+    // coroutine finished, after having used `bytes` of its stack
+    void record_coro_stack_usage(size_t bytes);
 
 private:
     typedef std::array<void *, CORO_PROFILER_BACKTRACE_DEPTH> small_trace_t;
@@ -100,9 +105,18 @@ private:
         int num_samples_total;
         std::vector<coro_sample_t> samples;
     };
+    struct stack_usage_t {
+        stack_usage_t() : num_samples(0), total_bytes(0), max_bytes(0) { }
+        void add(const stack_usage_t &other);
+        size_t num_samples;
+        size_t total_bytes;
+        size_t max_bytes;
+    };
     struct per_thread_samples_t {
         per_thread_samples_t() : ticks_at_last_report(get_ticks()) { }
         std::map<coro_execution_point_key_t, per_execution_point_samples_t> per_execution_point_samples;
+        // Keyed by coro_type
+        std::map<std::string, stack_usage_t> stack_usage;
         spinlock_t spinlock;
         // This field is a duplicate of the global `ticks_at_last_report` in
         // `coro_profiler_t`. We copy it in each thread in order to avoid having
@@ -141,11 +155,14 @@ private:
     void generate_report();
     void print_to_reql(const std::map<coro_execution_point_key_t,
                        per_execution_point_collected_report_t> &execution_point_reports);
+    void print_stack_usage_to_reql(
+        const std::map<std::string, stack_usage_t> &stack_usage_reports);
     void write_reql_header();
     std::string distribution_to_object_str(const data_distribution_t &distribution);
     std::string trace_to_array_str(const small_trace_t &trace);
     const std::string &get_frame_description(void *addr);
     coro_execution_point_key_t get_current_execution_point(size_t levels_to_strip_from_backtrace);
+    static std::string get_current_coro_type();
 
     // Would be nice if we could use one_per_thread here. However
     // that makes the construction order tricky.
@@ -184,6 +201,12 @@ private:
 #define PROFILER_RECORD_SAMPLE coro_profiler_t::get_global_profiler().record_sample()
 #define PROFILER_CORO_RESUME coro_profiler_t::get_global_profiler().record_coro_resume()
 #define PROFILER_CORO_YIELD(STRIP_FRAMES) coro_profiler_t::get_global_profiler().record_coro_yield(STRIP_FRAMES)
+// The stacks of threaded coroutines are real thread stacks, which we can't measure.
+#ifndef THREADED_COROUTINES
+#define PROFILER_CORO_STACK_USAGE(STACK) coro_profiler_t::get_global_profiler().record_coro_stack_usage((STACK)->take_stack_usage())
+#else
+#define PROFILER_CORO_STACK_USAGE(STACK) do {} while(0)
+#endif
 
 #else /* ENABLE_CORO_PROFILER */
 
@@ -191,6 +214,7 @@ private:
 #define PROFILER_RECORD_SAMPLE do {} while(0)
 #define PROFILER_CORO_RESUME do {} while(0)
 #define PROFILER_CORO_YIELD(STRIP_FRAMES) do {} while(0)
+#define PROFILER_CORO_STACK_USAGE(STACK) do {} while(0)
 
 #endif /* not ENABLE_CORO_PROFILER */
 
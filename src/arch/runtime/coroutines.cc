@@ -31,6 +31,10 @@ it in `cglobals`. */
 
 struct coro_globals_t {
 
+    /* Where the stacks of this thread's coroutines come from.  It has to outlive the
+    coroutines, so it comes first. */
+    coro_stack_pool_t stack_pool;
+
     /* The coroutine we're currently in, if any. NULL if we are in the main context. */
     coro_t *current_coro;
 
@@ -195,6 +199,7 @@ void coro_t::run() {
         PROFILER_CORO_RESUME;
         coro->action_wrapper.run();
         PROFILER_CORO_YIELD(0);
+        PROFILER_CORO_STACK_USAGE(&coro->stack);
 #ifndef NDEBUG
         TLS_get_cglobals()->running_coroutine_counts[coro->coroutine_type]--;
         TLS_get_cglobals()->active_coroutines.erase(coro);
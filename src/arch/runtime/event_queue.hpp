@@ -46,6 +46,11 @@ typedef poll_event_queue_t linux_event_queue_t;
 #include "arch/runtime/event_queue/epoll.hpp"
 typedef epoll_event_queue_t linux_event_queue_t;
 
+#ifdef EPOLLEXCLUSIVE
+// Several threads can watch the same resource without all of them waking up for it.
+#define EVENT_QUEUE_HAS_EXCLUSIVE_WATCH
+#endif
+
 #endif
 
 #endif // ARCH_RUNTIME_EVENT_QUEUE_HPP_
@@ -45,6 +45,46 @@ int epoll_to_user(int mode) {
     return out_mode;
 }
 
+/* The `busy_poll` stats: how often the event queues spun looking for events, how
+often that found one, and how long they spent spinning, summed over all threads. */
+class pm_busy_poll_t
+    : public perfmon_perthread_t<busy_poller_t::stats_t, busy_poller_t::stats_t> {
+private:
+    typedef busy_poller_t::stats_t stats_t;
+
+    void get_thread_stat(stats_t *stat) {
+        *stat = linux_thread_pool_t::get_thread()->queue.get_busy_poll_stats();
+    }
+    stats_t combine_stats(const stats_t *stats) {
+        stats_t combined;
+        for (int i = 0; i < get_num_threads(); ++i) {
+            combined.spins += stats[i].spins;
+            combined.hits += stats[i].hits;
+            combined.spin_ticks += stats[i].spin_ticks;
+        }
+        return combined;
+    }
+    ql::datum_t output_stat(const stats_t &stats) {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("spins", ql::datum_t(static_cast<double>(stats.spins)));
+        builder.overwrite("hits", ql::datum_t(static_cast<double>(stats.hits)));
+        builder.overwrite("hit_rate",
+                          stats.spins > 0
+                          ? ql::datum_t(static_cast<double>(stats.hits) / stats.spins)
+                          : ql::datum_t::null());
+        builder.overwrite("spin_secs", ql::datum_t(ticks_to_secs(stats.spin_ticks)));
+        return std::move(builder).to_datum();
+    }
+};
+
+struct pm_busy_poll_singleton_t {
+    static void get() {
+        static pm_busy_poll_t pm_busy_poll;
+        static perfmon_membership_t pm_busy_poll_membership(
+            &get_global_perfmon_collection(), &pm_busy_poll, "busy_poll");
+    }
+};
+
 epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
     : parent(_parent) {
     // Create a poll fd
@@ -53,13 +93,39 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
     guarantee_err(epoll_fd >= 0, "Could not create epoll fd");
 }
 
+int epoll_event_queue_t::poll_events(int *round) {
+    ++*round;
+    if (*round % BUSY_POLL_KERNEL_INTERVAL != 0 && !parent->has_incoming_messages()) {
+#if defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+#endif
+        return 0;
+    }
+    int res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, 0);
+    if (res == -1 && get_errno() == EINTR) {
+        res = 0;
+    }
+    guarantee_err(res != -1, "Polling for epoll events failed");
+    return res;
+}
+
 void epoll_event_queue_t::run() {
     int res;
 
+    if (busy_poller.enabled()) {
+        pm_busy_poll_singleton_t::get();
+    }
+
     // Now, start the loop
     while (!parent->should_shut_down()) {
+        // Before we go to sleep, spin for a while if busy polling is on.
+        int round = 0;
+        res = busy_poller.spin([&]() { return poll_events(&round); });
+
         // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        if (res == 0) {
+            res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        }
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
@@ -140,6 +206,22 @@ void epoll_event_queue_t::watch_resource(fd_t resource, int watch_mode, linux_ev
     DEBUG_ONLY_CODE(events_requested[cb] = watch_mode);
 }
 
+#ifdef EPOLLEXCLUSIVE
+void epoll_event_queue_t::watch_resource_exclusively(fd_t resource, int watch_mode,
+                                                     linux_event_callback_t *cb) {
+    rassert(cb);
+    epoll_event event;
+
+    event.events = EPOLLET | EPOLLEXCLUSIVE | user_to_epoll(watch_mode);
+    event.data.ptr = cb;
+
+    int res = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, resource, &event);
+    guarantee_err(res == 0, "Could not watch resource exclusively");
+
+    DEBUG_ONLY_CODE(events_requested[cb] = watch_mode);
+}
+#endif
+
 void epoll_event_queue_t::adjust_resource(fd_t resource, int watch_mode, linux_event_callback_t *cb) {
     rassert(cb);
     epoll_event event;
@@ -8,6 +8,7 @@
 #include <map>
 #endif
 
+#include "arch/runtime/busy_poller.hpp"
 #include "arch/runtime/event_queue_types.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "config/args.hpp"
@@ -25,11 +26,29 @@ public:
     void adjust_resource(fd_t resource, int events, linux_event_callback_t *cb);
     void forget_resource(fd_t resource, linux_event_callback_t *cb);
 
+#ifdef EPOLLEXCLUSIVE
+    // Like `watch_resource()`, but of the threads that watch the same resource this
+    // way, the kernel wakes only one for each event.  The watch can't be adjusted.
+    void watch_resource_exclusively(fd_t resource, int events,
+                                    linux_event_callback_t *cb);
+#endif
+
+    const busy_poller_t::stats_t &get_busy_poll_stats() const {
+        return busy_poller.get_stats();
+    }
+
 private:
+    // Looks for events without blocking.  We don't want to make a system call in every
+    // round of busy polling, so we only ask the kernel every so often, or when
+    // another thread has sent us messages.
+    int poll_events(int *round);
+
     linux_queue_parent_t *parent;
 
     fd_t epoll_fd;
 
+    busy_poller_t busy_poller;
+
     // We store this as a class member because forget_resource needs
     // to go through the events and remove queued messages for
     // resources that are being destroyed.
@@ -15,6 +15,9 @@ struct linux_event_callback_t {
 struct linux_queue_parent_t {
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+    // Whether other threads sent us messages that we haven't looked at yet.  This must
+    // not make any system calls, because busy polling calls it in a loop.
+    virtual bool has_incoming_messages() = 0;
     virtual ~linux_queue_parent_t() {}
 };
 
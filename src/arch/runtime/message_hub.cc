@@ -8,6 +8,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
+#include "perfmon/perfmon.hpp"
 #include "utils.hpp"
 
 // Set this to 1 if you would like some "unordered" messages to be unordered.
@@ -15,12 +16,61 @@
 #define RDB_RELOOP_MESSAGES 0
 #endif
 
+/* The `message_hub` stats: how many messages each thread went through per second, and
+how many milliseconds they had waited in its incoming queues. */
+class pm_message_hub_t
+    : public perfmon_perthread_t<linux_message_hub_t::stats_t,
+                                 std::vector<linux_message_hub_t::stats_t> > {
+private:
+    typedef linux_message_hub_t::stats_t stats_t;
+
+    void get_thread_stat(stats_t *stat) {
+        *stat = linux_thread_pool_t::get_thread()->message_hub.get_stats();
+    }
+    std::vector<stats_t> combine_stats(const stats_t *stats) {
+        return std::vector<stats_t>(stats, stats + get_num_threads());
+    }
+    ql::datum_t output_stat(const std::vector<stats_t> &stats) {
+        ql::datum_object_builder_t builder;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            ql::datum_object_builder_t thread_builder;
+            thread_builder.overwrite("messages_per_sec",
+                                     ql::datum_t(static_cast<double>(stats[i].messages)));
+            if (stats[i].messages > 0) {
+                thread_builder.overwrite(
+                    "queue_latency_avg_ms",
+                    ql::datum_t(ticks_to_secs(stats[i].latency_sum) * 1000
+                                / stats[i].messages));
+                thread_builder.overwrite(
+                    "queue_latency_max_ms",
+                    ql::datum_t(ticks_to_secs(stats[i].latency_max) * 1000));
+            } else {
+                thread_builder.overwrite("queue_latency_avg_ms", ql::datum_t::null());
+                thread_builder.overwrite("queue_latency_max_ms", ql::datum_t::null());
+            }
+            builder.overwrite(strprintf("thread_%zu", i).c_str(),
+                              std::move(thread_builder).to_datum());
+        }
+        return std::move(builder).to_datum();
+    }
+};
+
+struct pm_message_hub_singleton_t {
+    static void get() {
+        static pm_message_hub_t pm_message_hub;
+        static perfmon_membership_t pm_message_hub_membership(
+            &get_global_perfmon_collection(), &pm_message_hub, "message_hub");
+    }
+};
+
 linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          linux_thread_pool_t *thread_pool,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
       is_woken_up_(false),
+      backlog_(0),
+      stats_interval_(get_ticks() / secs_to_ticks(1)),
       current_thread_(current_thread) {
 
 #ifndef NDEBUG
@@ -31,6 +81,9 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
 #endif
 
     queue_->watch_resource(event_.get_notify_fd(), poll_event_in, this);
+
+    // Make sure the stats get registered.
+    pm_message_hub_singleton_t::get();
 }
 
 linux_message_hub_t::~linux_message_hub_t() {
@@ -43,8 +96,57 @@ linux_message_hub_t::~linux_message_hub_t() {
 
         guarantee(get_priority_msg_list(p).empty());
     }
+}
+
+linux_message_hub_t::incoming_queue_t::incoming_queue_t() : head_(&stub_), tail_(&stub_) { }
+
+linux_message_hub_t::incoming_queue_t::~incoming_queue_t() {
+    guarantee(head_.value == &stub_ && tail_ == &stub_);
+}
+
+void linux_message_hub_t::incoming_queue_t::push(linux_thread_message_t *first,
+                                                 linux_thread_message_t *last) {
+    last->incoming_next = NULL;
+    // From here on, `last` is where the next push links its messages to.  Until we
+    // set `prev->incoming_next`, `pop()` can't get to `first` yet.
+    linux_thread_message_t *prev = __atomic_exchange_n(&tail_, last, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->incoming_next, first, __ATOMIC_RELEASE);
+}
+
+linux_thread_message_t *linux_message_hub_t::incoming_queue_t::pop() {
+    linux_thread_message_t *head = head_.value;
+    linux_thread_message_t *next = __atomic_load_n(&head->incoming_next, __ATOMIC_ACQUIRE);
+    if (head == &stub_) {
+        if (next == NULL) {
+            return NULL;
+        }
+        head_.value = next;
+        head = next;
+        next = __atomic_load_n(&head->incoming_next, __ATOMIC_ACQUIRE);
+    }
+    if (next != NULL) {
+        head_.value = next;
+        return head;
+    }
 
-    guarantee(incoming_messages_.empty());
+    if (head != __atomic_load_n(&tail_, __ATOMIC_ACQUIRE)) {
+        // Somebody is in the middle of pushing after `head`.
+        return NULL;
+    }
+
+    // `head` is the last message.  We can only take it once something else is
+    // behind it, so we push the stub.
+    push(&stub_, &stub_);
+    next = __atomic_load_n(&head->incoming_next, __ATOMIC_ACQUIRE);
+    if (next != NULL) {
+        head_.value = next;
+        return head;
+    }
+    return NULL;
+}
+
+void linux_message_hub_t::incoming_queue_t::stub_message_t::on_thread_switch() {
+    crash("The stub of an incoming message queue was delivered");
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -91,19 +193,58 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+    msg_list_t msgs;
+    msgs.push_back(msg);
+    deliver_messages(this, &msgs);
+}
+
+void linux_message_hub_t::deliver_messages(linux_message_hub_t *hub, msg_list_t *msgs) {
+    const ticks_t now = get_ticks();
+
+    // Split the messages up by the queue they go onto, keeping their order.
+    linux_thread_message_t *firsts[NUM_SCHEDULER_PRIORITIES] = { };
+    linux_thread_message_t *lasts[NUM_SCHEDULER_PRIORITIES] = { };
+    while (linux_thread_message_t *m = msgs->head()) {
+        msgs->remove(m);
+        m->enqueue_time = now;
+        // Ordered messages are treated as if they had priority
+        // MESSAGE_SCHEDULER_ORDERED_PRIORITY.  This ensures that they can never bypass
+        // another ordered message.
+        const int effective_priority
+            = m->is_ordered ? MESSAGE_SCHEDULER_ORDERED_PRIORITY : m->priority;
+        rassert(effective_priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
+        rassert(effective_priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
+        const int i = effective_priority - MESSAGE_SCHEDULER_MIN_PRIORITY;
+        if (firsts[i] == NULL) {
+            firsts[i] = m;
+        } else {
+            lasts[i]->incoming_next = m;
+        }
+        lasts[i] = m;
     }
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
-        event_.wakey_wakey();
+    for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
+        if (firsts[i] != NULL) {
+            hub->incoming_queues_[i].push(firsts[i], lasts[i]);
+        }
+    }
+
+    // We only need to do a wake up if we're the first ones to do one since the hub
+    // last looked at its queues.
+    if (!__atomic_exchange_n(&hub->is_woken_up_, true, __ATOMIC_SEQ_CST)) {
+        // Wakey wakey eggs and bakey
+        hub->event_.wakey_wakey();
     }
 }
 
+bool linux_message_hub_t::has_incoming_messages() const {
+    return __atomic_load_n(&is_woken_up_, __ATOMIC_ACQUIRE);
+}
+
+size_t linux_message_hub_t::backlog() const {
+    return __atomic_load_n(&backlog_, __ATOMIC_RELAXED);
+}
+
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
     rassert(priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
     rassert(priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
@@ -119,8 +260,10 @@ void linux_message_hub_t::on_event(int events) {
     // up and so that poll-based event triggering doesn't infinite-loop.
     event_.consume_wakey_wakeys();
 
-    // Sort incoming messages into the respective priority_msg_lists_
-    sort_incoming_messages_by_priority();
+    // Move incoming messages into the respective priority_msg_lists_
+    pull_incoming_messages();
+    const ticks_t now = get_ticks();
+    update_stats(now);
 
     // Compute how many messages of MESSAGE_SCHEDULER_MAX_PRIORITY we process
     // before we check the incoming queues for new messages.
@@ -130,6 +273,7 @@ void linux_message_hub_t::on_event(int events) {
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
         total_pending_msgs += priority_msg_lists_[i].size();
     }
+    __atomic_store_n(&backlog_, total_pending_msgs, __ATOMIC_RELAXED);
     const size_t effective_granularity = std::min(total_pending_msgs,
                                                   static_cast<size_t>(MESSAGE_SCHEDULER_GRANULARITY));
 
@@ -156,6 +300,11 @@ void linux_message_hub_t::on_event(int events) {
             get_priority_msg_list(current_priority).remove(m);
             --to_process_from_priority;
 
+            const ticks_t latency = now > m->enqueue_time ? now - m->enqueue_time : 0;
+            ++current_stats_.messages;
+            current_stats_.latency_sum += latency;
+            current_stats_.latency_max = std::max(current_stats_.latency_max, latency);
+
 #ifndef NDEBUG
             if (m->reloop_count_ > 0) {
                 --m->reloop_count_;
@@ -168,88 +317,63 @@ void linux_message_hub_t::on_event(int events) {
         }
     }
 
-    // We might have left some messages unprocessed.
-    // Check if that is the case, and if yes, make sure we are called again.
+    // We might have left some messages unprocessed.  Whatever is left is the backlog
+    // until we get called again, which doesn't happen while the thread is idle.
+    size_t remaining_msgs = 0;
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
-        if (!priority_msg_lists_[i].empty()) {
-            // Place wakey_wakey and then yield to the event processing.
-            // It will wake us up again immediately, but can handle a few
-            // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
-            break;
+        remaining_msgs += priority_msg_lists_[i].size();
+    }
+    __atomic_store_n(&backlog_, remaining_msgs, __ATOMIC_RELAXED);
+
+    // If some are left, make sure we are called again.
+    if (remaining_msgs > 0) {
+        // Place wakey_wakey and then yield to the event processing.
+        // It will wake us up again immediately, but can handle a few
+        // OS events (such as timers, network messages etc.) in the meantime.
+        if (!__atomic_exchange_n(&is_woken_up_, true, __ATOMIC_SEQ_CST)) {
+            event_.wakey_wakey();
         }
     }
 }
 
-void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
-    }
+void linux_message_hub_t::pull_incoming_messages() {
+    // Anybody who pushes from here on wakes us up again, so we don't miss messages
+    // that are still being pushed while we look.
+    __atomic_store_n(&is_woken_up_, false, __ATOMIC_SEQ_CST);
 
-    // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
-        int effective_priority = m->priority;
-        if (m->is_ordered) {
-            // Ordered messages are treated as if they had
-            // priority MESSAGE_SCHEDULER_ORDERED_PRIORITY.
-            // This ensures that they can never bypass another
-            // ordered message.
-            effective_priority = MESSAGE_SCHEDULER_ORDERED_PRIORITY;
+    for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
+        while (linux_thread_message_t *m = incoming_queues_[i].pop()) {
             m->is_ordered = false;
+            priority_msg_lists_[i].push_back(m);
         }
-        get_priority_msg_list(effective_priority).push_back(m);
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+void linux_message_hub_t::update_stats(ticks_t now) {
+    const int64_t interval = now / secs_to_ticks(1);
+    if (interval == stats_interval_) {
+        return;
+    }
+    // If a whole second went by without us looking, nothing happened in it.
+    last_stats_ = interval == stats_interval_ + 1 ? current_stats_ : stats_t();
+    current_stats_ = stats_t();
+    stats_interval_ = interval;
+}
+
+linux_message_hub_t::stats_t linux_message_hub_t::get_stats() {
+    update_stats(get_ticks());
+    return last_stats_;
 }
 
-// Pushes messages collected locally global lists available to all
-// threads.
+// Pushes messages collected locally onto the incoming queues of the threads they
+// are for.
 void linux_message_hub_t::push_messages() {
     for (int i = 0; i < thread_pool_->n_threads; i++) {
-        // Append the local list for ith thread to that thread's global
-        // message list.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            deliver_messages(&thread_pool_->threads[i]->message_hub,
+                             &queue->msg_local_list);
         }
     }
 }
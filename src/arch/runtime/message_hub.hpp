@@ -8,7 +8,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
+#include "concurrency/cache_line_padded.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
 #include "threading.hpp"
@@ -33,8 +33,8 @@ public:
     linux_message_hub_t(linux_event_queue_t *queue, linux_thread_pool_t *thread_pool,
                         threadnum_t current_thread);
 
-    /* For each thread, transfer messages from our msg_local_list for that thread to our
-    msg_global_list for that thread */
+    /* For each thread, transfer messages from our msg_local_list for that thread to
+    that thread's incoming queues */
     void push_messages();
 
     /* Schedules the given message to be sent to the given thread by pushing it onto our
@@ -49,16 +49,72 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    // Whether other threads pushed messages that we haven't pulled yet, or we still
+    // have some left over.  Only looks at memory, so it's cheap enough to spin on.
+    bool has_incoming_messages() const;
+
+    // How many messages are waiting for this thread, as of when it last started or
+    // finished going through its messages; zero for a thread that is idle.  A thread
+    // that is kept busy lets its messages pile up, so this tells how loaded it is.
+    // Can be called from any thread.
+    size_t backlog() const;
+
+    // How many messages this thread went through, and how long they had waited in its
+    // incoming queues, over the last full second.
+    struct stats_t {
+        stats_t() : messages(0), latency_sum(0), latency_max(0) { }
+        int64_t messages;
+        ticks_t latency_sum;
+        ticks_t latency_max;
+    };
+    // Must be called on this hub's thread.
+    stats_t get_stats();
+
     ~linux_message_hub_t();
 
 private:
+    /* A lock-free queue that any thread can push messages onto, and only the hub's own
+    thread pops them from.  The messages are linked through their `incoming_next`
+    field.  This is Dmitry Vyukov's intrusive MPSC queue: a push takes a single atomic
+    exchange, no matter how many messages it pushes, and a pop takes none. */
+    class incoming_queue_t {
+    public:
+        incoming_queue_t();
+        ~incoming_queue_t();
+
+        // Pushes the messages from `first` to `last`, which must already be linked
+        // together.  Can be called from any thread.
+        void push(linux_thread_message_t *first, linux_thread_message_t *last);
+
+        // Returns NULL if the queue is empty, or if the next message is still being
+        // pushed.  In that case, the pushing thread wakes us up again once it's done.
+        linux_thread_message_t *pop();
+
+    private:
+        class stub_message_t : public linux_thread_message_t {
+            void on_thread_switch();
+        };
+
+        cache_line_padded_t<linux_thread_message_t *> head_;
+        linux_thread_message_t *tail_;
+        stub_message_t stub_;
+
+        DISABLE_COPYING(incoming_queue_t);
+    };
+
+    // Pushes the messages in `msgs` onto the incoming queues of `hub`, and wakes it up
+    // if it isn't awake already.  Can be called from any thread.
+    static void deliver_messages(linux_message_hub_t *hub, msg_list_t *msgs);
+
+    void update_stats(ticks_t now);
+
     // Does store_message or store_message_sometime, only without setting the reloop_count_ in
     // debug mode.
     void do_store_message(threadnum_t nthread, linux_thread_message_t *msg);
 
-    // Moves messages from incoming_messages_ into the respective entries of
-    // priority_msg_lists, depending on the messages' priorities.
-    void sort_incoming_messages_by_priority();
+    // Moves messages from incoming_queues_ into the respective entries of
+    // priority_msg_lists_.
+    void pull_incoming_messages();
 
     msg_list_t &get_priority_msg_list(int priority);
 
@@ -69,18 +125,22 @@ private:
     struct thread_queue_t {
         //TODO this doesn't need to be a class anymore
 
-        /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        /* Messages are cached here before being pushed to the other thread's incoming
+        queues, so that we push them in batches */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
+    // Messages from other threads, one queue per priority.  Ordered messages go onto
+    // the one for MESSAGE_SCHEDULER_ORDERED_PRIORITY, so that they can't overtake
+    // each other.
+    incoming_queue_t incoming_queues_[NUM_SCHEDULER_PRIORITIES];
+
+    // Set by whoever wakes us up, and cleared when we look at our incoming queues.
+    // Only the push that sets it writes to `event_`, so we get woken up once per batch
+    // of messages rather than once per message.  Accessed atomically.
     bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
 
-    // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
+    // Use `pull_incoming_messages()` to move messages from incoming_queues_ into
     // these lists.
     // Use `get_priority_msg_list()` to get the list for a given priority.
     // Each list contains messages of the respective priority.
@@ -88,12 +148,19 @@ private:
     // MESSAGE_SCHEDULER_ORDERED_PRIORITY)
     msg_list_t priority_msg_lists_[NUM_SCHEDULER_PRIORITIES];
 
+    // Written by this thread only, and read with `backlog()` by any thread.
+    size_t backlog_;
+
     void on_event(int events);
 
     // The eventfd (or pipe-based alternative) notified after the first incoming
-    // message is put onto incoming_messages_.
+    // message is put onto incoming_queues_.
     system_event_t event_;
 
+    // Only accessed on this hub's thread.
+    stats_t current_stats_, last_stats_;
+    int64_t stats_interval_;
+
     /* The thread that we queue messages originating from. (Recall that there is one
     message_hub_t per thread.) */
     const threadnum_t current_thread_;
@@ -2,6 +2,8 @@
 #ifndef ARCH_RUNTIME_RUNTIME_HPP_
 #define ARCH_RUNTIME_RUNTIME_HPP_
 
+#include <stddef.h>
+
 #include "threading.hpp"
 
 class linux_thread_message_t;
@@ -11,6 +13,10 @@ threadnum_t get_thread_id();
 
 int get_num_threads();
 
+// How many messages were waiting for the given thread when it last went through its
+// message queue.  Can be called from any thread.
+size_t get_thread_backlog(threadnum_t thread);
+
 #ifndef NDEBUG
 void assert_good_thread_id(threadnum_t thread);
 #else
@@ -7,6 +7,7 @@
 
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "time.hpp"
 
 typedef int fd_t;
 #define INVALID_FD fd_t(-1)
@@ -15,14 +16,18 @@ class linux_thread_message_t : public intrusive_list_node_t<linux_thread_message
 public:
     explicit linux_thread_message_t(int _priority)
         : priority(_priority),
-        is_ordered(false)
+        is_ordered(false),
+        incoming_next(NULL),
+        enqueue_time(0)
 #ifndef NDEBUG
         , reloop_count_(0)
 #endif
         { }
     linux_thread_message_t()
         : priority(MESSAGE_SCHEDULER_DEFAULT_PRIORITY),
-        is_ordered(false)
+        is_ordered(false),
+        incoming_next(NULL),
+        enqueue_time(0)
 #ifndef NDEBUG
         , reloop_count_(0)
 #endif
@@ -37,6 +42,10 @@ private:
     friend class linux_message_hub_t;
     int priority;
     bool is_ordered; // Used internally by the message hub
+    // Links the message into the receiving message hub's incoming queue
+    linux_thread_message_t *incoming_next;
+    // When the message was handed to the receiving message hub
+    ticks_t enqueue_time;
 #ifndef NDEBUG
     int reloop_count_;
 #endif
@@ -409,6 +409,10 @@ void linux_thread_t::pump() {
     message_hub.push_messages();
 }
 
+bool linux_thread_t::has_incoming_messages() {
+    return message_hub.has_incoming_messages();
+}
+
 void linux_thread_t::on_event(int events) {
     // No-op. This is just to make sure that the event queue wakes up
     // so it can shut down.
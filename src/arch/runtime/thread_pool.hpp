@@ -13,6 +13,7 @@
 #include "arch/runtime/message_hub.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/timer.hpp"
 
@@ -170,6 +171,7 @@ public:
 
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    bool has_incoming_messages();   // Called by the event queue
 #ifndef NDEBUG
     void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
 #else
@@ -15,9 +15,11 @@ address_in_use_exc_t::address_in_use_exc_t(const char* hostname, int port) throw
     }
 }
 
-file_account_t::file_account_t(file_t *par, int pri, int outstanding_requests_limit) :
+file_account_t::file_account_t(file_t *par, int pri, int outstanding_requests_limit,
+                               int64_t latency_target_us) :
     parent(par),
-    account(parent->create_account(pri, outstanding_requests_limit)) { }
+    account(parent->create_account(pri, outstanding_requests_limit,
+                                   latency_target_us)) { }
 
 file_account_t::~file_account_t() {
     parent->destroy_account(account);
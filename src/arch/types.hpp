@@ -14,6 +14,7 @@ struct iovec;
 
 #define DEFAULT_DISK_ACCOUNT (static_cast<file_account_t *>(0))
 #define UNLIMITED_OUTSTANDING_REQUESTS (-1)
+#define NO_IO_LATENCY_TARGET 0
 
 // TODO: Remove this from this header.
 
@@ -87,6 +88,9 @@ typedef linux_nonthrowing_tcp_listener_t non_throwing_tcp_listener_t;
 class linux_tcp_listener_t;
 typedef linux_tcp_listener_t tcp_listener_t;
 
+class linux_threaded_tcp_listener_t;
+typedef linux_threaded_tcp_listener_t threaded_tcp_listener_t;
+
 class linux_repeated_nonthrowing_tcp_listener_t;
 typedef linux_repeated_nonthrowing_tcp_listener_t repeated_nonthrowing_tcp_listener_t;
 
@@ -126,6 +130,10 @@ public:
     virtual int64_t get_file_size() = 0;
     virtual void set_file_size(int64_t size) = 0;
     virtual void set_file_size_at_least(int64_t size) = 0;
+    // Gives the disk space of [offset, offset + length) back to the file system
+    // without changing the file size, if the file system supports that.  Reads from
+    // the range return zeros afterwards.
+    virtual void punch_hole(int64_t offset, int64_t length) = 0;
 
     virtual void read_async(int64_t offset, size_t length, void *buf,
                             file_account_t *account, linux_iocallback_t *cb) = 0;
@@ -136,7 +144,8 @@ public:
     virtual void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                               file_account_t *account, linux_iocallback_t *cb) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    virtual void *create_account(int priority, int outstanding_requests_limit,
+                                 int64_t latency_target_us) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
@@ -147,7 +156,11 @@ private:
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    // Once a request of the account has waited longer than `latency_target_us` to go
+    // to the disk, it goes ahead of the requests of all other accounts.
+    file_account_t(file_t *f, int p,
+                   int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS,
+                   int64_t latency_target_us = NO_IO_LATENCY_TARGET);
     ~file_account_t();
     void *get_account() { return account; }
 
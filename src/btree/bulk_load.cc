@@ -0,0 +1,303 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "btree/bulk_load.hpp"
+
+#include <algorithm>
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/disk_backed_queue.hpp"
+
+btree_bulk_loader_t::btree_bulk_loader_t(value_sizer_t *sizer)
+    : sizer_(sizer), population_change_(0) { }
+
+btree_bulk_loader_t::~btree_bulk_loader_t() {
+    guarantee(leaf_.empty(), "finish_chunk() wasn't called after the last append()");
+}
+
+void btree_bulk_loader_t::append(superblock_t *superblock, const btree_key_t *key,
+                                 const void *value, repli_timestamp_t tstamp) {
+    if (right_edge_.empty()) {
+        guarantee(superblock->get_root_block_id() == NULL_BLOCK_ID,
+                  "Bulk loading into a btree that isn't empty");
+        leaf_ = buf_lock_t(superblock->expose_buf(), alt_create_t::create);
+        buf_write_t write(&leaf_);
+        leaf::init(sizer_, static_cast<leaf_node_t *>(write.get_data_write()));
+        right_edge_.push_back(leaf_.block_id());
+        insert_root(leaf_.block_id(), superblock);
+    } else {
+        guarantee(btree_key_cmp(last_key_.btree_key(), key) < 0,
+                  "Bulk loaded keys must come in ascending order");
+        if (leaf_.empty()) {
+            leaf_ = buf_lock_t(superblock->expose_buf(), right_edge_[0],
+                               access_t::write);
+        }
+    }
+
+    ++population_change_;
+    {
+        buf_write_t write(&leaf_);
+        leaf_node_t *node = static_cast<leaf_node_t *>(write.get_data_write());
+        if (!leaf::is_full(sizer_, node, key, value)) {
+            leaf::insert(sizer_, node, key, value, tstamp,
+                         key_modification_proof_t::real_proof());
+            last_key_.assign(key);
+            return;
+        }
+    }
+
+    // The rightmost leaf is full, so the pair starts a new one.
+    buf_lock_t new_leaf(superblock->expose_buf(), alt_create_t::create);
+    {
+        buf_write_t write(&new_leaf);
+        leaf_node_t *node = static_cast<leaf_node_t *>(write.get_data_write());
+        leaf::init(sizer_, node);
+        leaf::insert(sizer_, node, key, value, tstamp,
+                     key_modification_proof_t::real_proof());
+    }
+    const block_id_t new_leaf_id = new_leaf.block_id();
+    leaf_ = std::move(new_leaf);
+    append_child(superblock, 1, new_leaf_id, last_key_.btree_key());
+    right_edge_[0] = new_leaf_id;
+    last_key_.assign(key);
+}
+
+void btree_bulk_loader_t::append_child(superblock_t *superblock, size_t height,
+                                       block_id_t child,
+                                       const btree_key_t *separator) {
+    const block_size_t block_size = sizer_->block_size();
+
+    if (height == right_edge_.size()) {
+        // The previous rightmost node at `height - 1` was the root.  The tree grows by
+        // one level.
+        buf_lock_t root(superblock->expose_buf(), alt_create_t::create);
+        {
+            buf_write_t write(&root);
+            internal_node_t *node = static_cast<internal_node_t *>(write.get_data_write());
+            internal_node::init(block_size, node);
+            internal_node::insert(node, separator, right_edge_[height - 1], child);
+        }
+        right_edge_.push_back(root.block_id());
+        insert_root(root.block_id(), superblock);
+        return;
+    }
+
+    buf_lock_t parent(superblock->expose_buf(), right_edge_[height], access_t::write);
+    buf_write_t parent_write(&parent);
+    internal_node_t *parent_node
+        = static_cast<internal_node_t *>(parent_write.get_data_write());
+    if (internal_node::insert(parent_node, separator, right_edge_[height - 1], child)) {
+        return;
+    }
+
+    // The parent is full.  Internal nodes need at least two children, so we move its
+    // rightmost child over into a new parent, next to `child`.
+    rassert(parent_node->npairs > 2);
+    store_key_t parent_separator(
+        &internal_node::get_pair_by_index(parent_node, parent_node->npairs - 2)->key);
+    internal_node::remove(block_size, parent_node, separator);
+
+    buf_lock_t new_parent(superblock->expose_buf(), alt_create_t::create);
+    {
+        buf_write_t write(&new_parent);
+        internal_node_t *node = static_cast<internal_node_t *>(write.get_data_write());
+        internal_node::init(block_size, node);
+        internal_node::insert(node, separator, right_edge_[height - 1], child);
+    }
+    const block_id_t new_parent_id = new_parent.block_id();
+    append_child(superblock, height + 1, new_parent_id, parent_separator.btree_key());
+    right_edge_[height] = new_parent_id;
+}
+
+void btree_bulk_loader_t::finish_chunk(superblock_t *superblock) {
+    leaf_.reset_buf_lock();
+
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id != NULL_BLOCK_ID && population_change_ != 0) {
+        buf_lock_t stat_block(superblock->expose_buf(), stat_block_id, access_t::write);
+        buf_write_t write(&stat_block);
+        static_cast<btree_statblock_t *>(write.get_data_write(BTREE_STATBLOCK_SIZE))
+            ->population += population_change_;
+    }
+    population_change_ = 0;
+}
+
+// How many pairs we write into a run with one transaction.
+const size_t RUN_WRITE_BATCH_SIZE = 1000;
+
+// How many runs get merged into one at a time.  Each of them has its own small cache.
+const size_t RUN_MERGE_FAN_IN = 16;
+
+class bulk_load_sorter_t::run_t {
+public:
+    run_t(io_backender_t *io_backender, const serializer_filepath_t &filename,
+          perfmon_collection_t *stats)
+        : queue_(io_backender, filename, stats), has_head_(false) { }
+
+    void push(const bulk_load_pair_t *pairs, size_t count) {
+        scoped_array_t<write_message_t> wms(count);
+        for (size_t i = 0; i < count; ++i) {
+            serialize<cluster_version_t::LATEST_OVERALL>(&wms[i], pairs[i]);
+        }
+        queue_.push(wms);
+    }
+
+    // The smallest pair that hasn't been popped yet, if there is one.
+    const bulk_load_pair_t *head() {
+        if (!has_head_ && queue_.size() > 0) {
+            deserializing_viewer_t<bulk_load_pair_t> viewer(&head_);
+            queue_.pop(&viewer);
+            has_head_ = true;
+        }
+        return has_head_ ? &head_ : NULL;
+    }
+
+    void pop(bulk_load_pair_t *pair_out) {
+        guarantee(head() != NULL);
+        *pair_out = std::move(head_);
+        has_head_ = false;
+    }
+
+private:
+    internal_disk_backed_queue_t queue_;
+    bool has_head_;
+    bulk_load_pair_t head_;
+};
+
+bulk_load_sorter_t::bulk_load_sorter_t(io_backender_t *io_backender,
+                                       const base_path_t &base_path,
+                                       const std::string &file_prefix,
+                                       perfmon_collection_t *stats,
+                                       size_t memory_limit)
+    : io_backender_(io_backender), base_path_(base_path), file_prefix_(file_prefix),
+      stats_(stats), memory_limit_(memory_limit), next_run_number_(0),
+      buffer_size_(0), merging_(false), buffer_pos_(0) { }
+
+bulk_load_sorter_t::~bulk_load_sorter_t() { }
+
+bool pair_key_less(const bulk_load_pair_t &a, const bulk_load_pair_t &b) {
+    return a.first < b.first;
+}
+
+void bulk_load_sorter_t::push(bulk_load_pair_t &&pair) {
+    guarantee(!merging_);
+    // Pushes wait while we spill, so that we don't use more than `memory_limit_`.
+    mutex_t::acq_t acq(&mutex_);
+    buffer_size_ += sizeof(bulk_load_pair_t) + pair.first.size() + pair.second.size();
+    buffer_.push_back(std::move(pair));
+    if (buffer_size_ >= memory_limit_) {
+        spill();
+    }
+}
+
+void bulk_load_sorter_t::spill() {
+    std::sort(buffer_.begin(), buffer_.end(), &pair_key_less);
+
+    scoped_ptr_t<run_t> run(new run_t(
+        io_backender_,
+        serializer_filepath_t(base_path_,
+                              strprintf("%s_run_%d", file_prefix_.c_str(),
+                                        next_run_number_++)),
+        stats_));
+    for (size_t i = 0; i < buffer_.size(); i += RUN_WRITE_BATCH_SIZE) {
+        run->push(buffer_.data() + i,
+                  std::min(RUN_WRITE_BATCH_SIZE, buffer_.size() - i));
+    }
+    buffer_.clear();
+    buffer_size_ = 0;
+
+    if (runs_.empty()) {
+        runs_.resize(1);
+    }
+    runs_[0].push_back(std::move(run));
+    for (size_t level = 0; runs_[level].size() >= RUN_MERGE_FAN_IN; ++level) {
+        merge_runs(level);
+    }
+}
+
+bulk_load_sorter_t::run_t *bulk_load_sorter_t::smallest_head(
+        const std::vector<scoped_ptr_t<run_t> > &runs) {
+    run_t *ret = NULL;
+    for (const auto &run : runs) {
+        if (run->head() != NULL
+            && (ret == NULL || run->head()->first < ret->head()->first)) {
+            ret = run.get();
+        }
+    }
+    return ret;
+}
+
+void bulk_load_sorter_t::merge_runs(size_t level) {
+    scoped_ptr_t<run_t> merged(new run_t(
+        io_backender_,
+        serializer_filepath_t(base_path_,
+                              strprintf("%s_run_%d", file_prefix_.c_str(),
+                                        next_run_number_++)),
+        stats_));
+
+    std::vector<scoped_ptr_t<run_t> > sources = std::move(runs_[level]);
+    runs_[level].clear();
+    std::vector<bulk_load_pair_t> batch;
+    batch.reserve(RUN_WRITE_BATCH_SIZE);
+    while (run_t *source = smallest_head(sources)) {
+        batch.resize(batch.size() + 1);
+        source->pop(&batch.back());
+        if (batch.size() == RUN_WRITE_BATCH_SIZE) {
+            merged->push(batch.data(), batch.size());
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) {
+        merged->push(batch.data(), batch.size());
+    }
+
+    if (runs_.size() == level + 1) {
+        runs_.resize(level + 2);
+    }
+    runs_[level + 1].push_back(std::move(merged));
+}
+
+void bulk_load_sorter_t::start_merging() {
+    mutex_t::acq_t acq(&mutex_);
+    merging_ = true;
+    std::sort(buffer_.begin(), buffer_.end(), &pair_key_less);
+
+    // Merge the runs down until the final merge has few enough sources.
+    size_t num_runs = 0;
+    for (const auto &level : runs_) {
+        num_runs += level.size();
+    }
+    for (size_t level = 0; num_runs > RUN_MERGE_FAN_IN; ++level) {
+        if (runs_[level].size() > 1) {
+            num_runs -= runs_[level].size() - 1;
+            merge_runs(level);
+        }
+    }
+    for (auto &level : runs_) {
+        for (auto &run : level) {
+            final_runs_.push_back(std::move(run));
+        }
+    }
+    runs_.clear();
+}
+
+bool bulk_load_sorter_t::pop(bulk_load_pair_t *pair_out) {
+    if (!merging_) {
+        start_merging();
+    }
+
+    run_t *source = smallest_head(final_runs_);
+    if (buffer_pos_ < buffer_.size()
+        && (source == NULL || buffer_[buffer_pos_].first < source->head()->first)) {
+        *pair_out = std::move(buffer_[buffer_pos_]);
+        ++buffer_pos_;
+        return true;
+    }
+    if (source == NULL) {
+        return false;
+    }
+    source->pop(pair_out);
+    return true;
+}
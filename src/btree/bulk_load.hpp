@@ -0,0 +1,119 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BTREE_BULK_LOAD_HPP_
+#define BTREE_BULK_LOAD_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "buffer_cache/alt.hpp"
+#include "concurrency/mutex.hpp"
+#include "containers/scoped.hpp"
+#include "repli_timestamp.hpp"
+#include "utils.hpp"
+
+class internal_disk_backed_queue_t;
+class io_backender_t;
+class perfmon_collection_t;
+class superblock_t;
+class value_sizer_t;
+
+/* Builds a btree bottom-up, out of key/value pairs that arrive in ascending key order.
+Inserting the pairs one at a time would walk the tree from the root for every key, and
+split every leaf once it is full, which leaves the leaves half empty.  The bulk loader
+instead fills each leaf and each internal node up completely before it starts the next
+one, and only ever touches the right edge of the tree.
+
+The tree must be empty when the loader starts, and nobody else may change it until the
+loader is done.  The pairs can be appended over any number of transactions.  In between
+them, the tree is a valid btree that holds all pairs appended so far, so an abandoned
+load can get cleaned up like any other tree. */
+class btree_bulk_loader_t {
+public:
+    explicit btree_bulk_loader_t(value_sizer_t *sizer);
+    ~btree_bulk_loader_t();
+
+    // Appends a pair to the tree under `superblock`.  `key` must be greater than every
+    // key appended before.
+    void append(superblock_t *superblock, const btree_key_t *key, const void *value,
+                repli_timestamp_t tstamp);
+
+    // Releases the leaf the loader keeps acquired between appends, and updates the
+    // stat block.  Must be called before the transaction of `superblock` ends.
+    void finish_chunk(superblock_t *superblock);
+
+private:
+    // Makes `child` the new rightmost node at height `height - 1`, right after the
+    // previous one, whose keys are all at most `separator`.
+    void append_child(superblock_t *superblock, size_t height, block_id_t child,
+                      const btree_key_t *separator);
+
+    value_sizer_t *const sizer_;
+
+    // The right edge of the tree: `right_edge_[0]` is the rightmost leaf, and
+    // `right_edge_[i]` the rightmost internal node at height `i`.  The last one is the
+    // root.
+    std::vector<block_id_t> right_edge_;
+    buf_lock_t leaf_;
+    store_key_t last_key_;
+    int64_t population_change_;
+
+    DISABLE_COPYING(btree_bulk_loader_t);
+};
+
+typedef std::pair<store_key_t, std::vector<char> > bulk_load_pair_t;
+
+/* Sorts the pairs for a bulk load.  They are collected in memory, and whenever they use
+up `memory_limit`, they get sorted and spilled into a disk backed queue.  Those sorted
+runs are merged in the end, and every so often in between so that there are never too
+many of them. */
+class bulk_load_sorter_t {
+public:
+    // The runs get spilled into unlinked files in `base_path` whose names start with
+    // `file_prefix`.
+    bulk_load_sorter_t(io_backender_t *io_backender, const base_path_t &base_path,
+                       const std::string &file_prefix, perfmon_collection_t *stats,
+                       size_t memory_limit);
+    ~bulk_load_sorter_t();
+
+    void push(bulk_load_pair_t &&pair);
+
+    // After the last `push()`, returns the pairs in ascending key order, one at a
+    // time.  Returns false when there are no more.
+    bool pop(bulk_load_pair_t *pair_out);
+
+private:
+    class run_t;
+
+    // Returns the run with the smallest head, or `NULL` if they're all empty.
+    static run_t *smallest_head(const std::vector<scoped_ptr_t<run_t> > &runs);
+
+    void spill();
+    void merge_runs(size_t level);
+    void start_merging();
+
+    io_backender_t *const io_backender_;
+    const base_path_t base_path_;
+    const std::string file_prefix_;
+    perfmon_collection_t *const stats_;
+    const size_t memory_limit_;
+    int next_run_number_;
+
+    mutex_t mutex_;
+    std::vector<bulk_load_pair_t> buffer_;
+    size_t buffer_size_;
+
+    // `runs_[i]` holds the runs that were merged `i` times.
+    std::vector<std::vector<scoped_ptr_t<run_t> > > runs_;
+
+    // The sources of the final merge: all remaining runs, and what's left in
+    // `buffer_`, from `buffer_pos_` on.
+    bool merging_;
+    std::vector<scoped_ptr_t<run_t> > final_runs_;
+    size_t buffer_pos_;
+
+    DISABLE_COPYING(bulk_load_sorter_t);
+};
+
+#endif  // BTREE_BULK_LOAD_HPP_
@@ -56,6 +56,42 @@ void scoped_key_value_t::reset() {
 }
 
 
+// A traversal counts as a sequential scan once it has gone through this many leaves
+// of the same internal node in a row.
+const int SEQUENTIAL_LEAF_THRESHOLD = 2;
+// Bounds on how many leaves a sequential scan loads ahead of itself.
+const int MIN_LEAF_PREFETCH_WINDOW = 2;
+const int MAX_LEAF_PREFETCH_WINDOW = 64;
+
+/* Keeps track of how far a traversal prefetches leaves ahead of itself.  Once the
+traversal walks through leaves one after the other, it asks the cache to load the
+next few leaves before it gets to them.  The window doubles every time the traversal
+has got halfway through the leaves it prefetched, so it grows with the scan rate, up
+to what the cache's prefetch budget allows. */
+class leaf_prefetcher_t {
+public:
+    leaf_prefetcher_t() : last_node_was_leaf_(false), window_(0) { }
+
+    void on_leaf() { last_node_was_leaf_ = true; }
+    void on_internal_node() { last_node_was_leaf_ = false; }
+    // Tells whether the subtree the traversal just finished was a single leaf.
+    bool last_node_was_leaf() const { return last_node_was_leaf_; }
+
+    int window() const { return window_; }
+    int grow_window(size_t budget) {
+        window_ = std::min(std::max(window_ * 2, MIN_LEAF_PREFETCH_WINDOW),
+                           MAX_LEAF_PREFETCH_WINDOW);
+        window_ = std::min<size_t>(window_, budget);
+        return window_;
+    }
+
+private:
+    bool last_node_was_leaf_;
+    int window_;
+
+    DISABLE_COPYING(leaf_prefetcher_t);
+};
+
 /* Returns `true` if we reached the end of the subtree or range, and `false` if
 `cb->handle_value()` returned `false`. */
 bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
@@ -63,7 +99,8 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
                                  depth_first_traversal_callback_t *cb,
                                  direction_t direction,
                                  const btree_key_t *left_excl_or_null,
-                                 const btree_key_t *right_incl_or_null);
+                                 const btree_key_t *right_incl_or_null,
+                                 leaf_prefetcher_t *prefetcher);
 
 bool btree_depth_first_traversal(superblock_t *superblock,
                                  const key_range_t &range,
@@ -94,8 +131,9 @@ bool btree_depth_first_traversal(superblock_t *superblock,
             // profiling information is correct.
             root_block->read_acq_signal()->wait();
         }
+        leaf_prefetcher_t prefetcher;
         return btree_depth_first_traversal(std::move(root_block), range, cb,
-                                           direction, NULL, NULL);
+                                           direction, NULL, NULL, &prefetcher);
     }
 }
 
@@ -127,7 +165,8 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
                                  depth_first_traversal_callback_t *cb,
                                  direction_t direction,
                                  const btree_key_t *left_excl_or_null,
-                                 const btree_key_t *right_incl_or_null) {
+                                 const btree_key_t *right_incl_or_null,
+                                 leaf_prefetcher_t *prefetcher) {
     auto read = make_counted<counted_buf_read_t>(block.get());
     const node_t *node = static_cast<const node_t *>(read->get_data_read());
     if (node::is_internal(node)) {
@@ -141,7 +180,13 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
-        for (int i = 0; i < end_index - start_index; ++i) {
+        // The number of leaves among the children we just went through
+        int leaf_run = 0;
+        // We have asked the cache to load the children before this position (counted
+        // in traversal order)
+        int prefetched_end = 0;
+        const int num_children = end_index - start_index;
+        for (int i = 0; i < num_children; ++i) {
             int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
             const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
 
@@ -153,6 +198,29 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
                                 &child_left_excl_or_null, &child_right_incl_or_null);
 
             if (cb->is_range_interesting(child_left_excl_or_null, child_right_incl_or_null)) {
+                // A scan that was already sequential in the previous node only has
+                // to see one leaf here to keep going.
+                const int threshold =
+                    prefetcher->window() > 0 ? 1 : SEQUENTIAL_LEAF_THRESHOLD;
+                if (leaf_run >= threshold
+                    && i + prefetcher->window() / 2 >= prefetched_end) {
+                    int window = prefetcher->grow_window(block->prefetch_budget());
+                    int prefetch_end = std::min(num_children, i + 1 + window);
+                    for (int j = std::max(i + 1, prefetched_end); j < prefetch_end; ++j) {
+                        int index = (direction == FORWARD ? start_index + j : (end_index - 1) - j);
+                        const btree_key_t *left;
+                        const btree_key_t *right;
+                        get_child_key_range(inode, index,
+                                            left_excl_or_null, right_incl_or_null,
+                                            &left, &right);
+                        if (cb->is_range_interesting(left, right)) {
+                            block->prefetch_child(
+                                internal_node::get_pair_by_index(inode, index)->lnode);
+                        }
+                    }
+                    prefetched_end = std::max(prefetched_end, prefetch_end);
+                }
+
                 counted_t<counted_buf_lock_t> lock;
                 {
                     profile::starter_t starter("Acquire block for read.", cb->get_trace());
@@ -162,15 +230,19 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
                 if (!btree_depth_first_traversal(std::move(lock),
                                                  range, cb, direction,
                                                  child_left_excl_or_null,
-                                                 child_right_incl_or_null)) {
+                                                 child_right_incl_or_null,
+                                                 prefetcher)) {
                     return false;
                 }
+                leaf_run = prefetcher->last_node_was_leaf() ? leaf_run + 1 : 0;
             }
         }
+        prefetcher->on_internal_node();
         return true;
     } else {
         const leaf_node_t *lnode = reinterpret_cast<const leaf_node_t *>(node);
         const btree_key_t *key;
+        prefetcher->on_leaf();
 
         if (direction == FORWARD) {
             for (auto it = leaf::inclusive_lower_bound(range.left.btree_key(), *lnode);
@@ -357,7 +357,34 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
 }
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    // The last pair's key is special, so we don't look at it.
+    const int num_keys = node->npairs - 1;
+    if (num_keys <= 0) {
+        return 0;
+    }
+
+    // As in `leaf::find_key()`, all the keys share the prefix of the first and the last
+    // key, so we only need to look at it once.
+    const btree_key_t *first_key = &get_pair_by_index(node, 0)->key;
+    const btree_key_t *last_key = &get_pair_by_index(node, num_keys - 1)->key;
+    const int prefix_size = btree_key_common_prefix_size(first_key, last_key);
+    if (btree_key_common_prefix_size(key, first_key) < prefix_size) {
+        return btree_key_cmp(key, first_key) < 0 ? 0 : num_keys;
+    }
+
+    // Find the first key that is not less than `key`.
+    int beg = 0;
+    int end = num_keys;
+    while (beg < end) {
+        const int test_point = beg + (end - beg) / 2;
+        const btree_key_t *test_key = &get_pair_by_index(node, test_point)->key;
+        if (btree_key_cmp_after_prefix(test_key, key, prefix_size) < 0) {
+            beg = test_point + 1;
+        } else {
+            end = test_point;
+        }
+    }
+    return beg;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
@@ -1,6 +1,10 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/keys.hpp"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "debug.hpp"
 #include "utils.hpp"
 
@@ -15,6 +19,52 @@ int sized_strcmp(const uint8_t *str1, int len1, const uint8_t *str2, int len2) {
     return res;
 }
 
+int btree_key_common_prefix_size(const btree_key_t *left, const btree_key_t *right) {
+    const int min_size = std::min(left->size, right->size);
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= min_size; i += 16) {
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(left->contents + i));
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(right->contents + i));
+        const int equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(l, r));
+        if (equal_mask != 0xffff) {
+            return i + __builtin_ctz(~equal_mask);
+        }
+    }
+#endif
+    while (i < min_size && left->contents[i] == right->contents[i]) {
+        ++i;
+    }
+    return i;
+}
+
+// The (up to) eight bytes of `key` that follow `offset`, zero-padded.  The padding
+// doesn't change the order: where a padding byte meets a real byte of the other key,
+// the words only differ if the real byte is nonzero, and then the shorter key is
+// indeed the smaller one.
+static uint64_t key_word_at(const btree_key_t *key, int offset) {
+    uint8_t bytes[sizeof(uint64_t)] = { 0 };
+    memcpy(bytes, key->contents + offset,
+           std::min<int>(sizeof(uint64_t), key->size - offset));
+    uint64_t word = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        word = (word << 8) | bytes[i];
+    }
+    return word;
+}
+
+int btree_key_cmp_after_prefix(const btree_key_t *left, const btree_key_t *right,
+                               int prefix_size) {
+    rassert(prefix_size <= left->size && prefix_size <= right->size);
+    const uint64_t left_word = key_word_at(left, prefix_size);
+    const uint64_t right_word = key_word_at(right, prefix_size);
+    if (left_word != right_word) {
+        return left_word < right_word ? -1 : 1;
+    }
+    return sized_strcmp(left->contents + prefix_size, left->size - prefix_size,
+                        right->contents + prefix_size, right->size - prefix_size);
+}
+
 bool unescaped_str_to_key(const char *str, int len, store_key_t *buf) {
     if (len <= MAX_KEY_SIZE) {
         memcpy(buf->contents(), str, len);
@@ -42,6 +42,16 @@ inline int btree_key_cmp(const btree_key_t *left, const btree_key_t *right) {
     return sized_strcmp(left->contents, left->size, right->contents, right->size);
 }
 
+// The number of leading bytes that `left` and `right` have in common.
+int btree_key_common_prefix_size(const btree_key_t *left, const btree_key_t *right);
+
+/* Like `btree_key_cmp()`, for keys that are both known to start with the same
+`prefix_size` bytes.  The bytes after the prefix are first compared eight at a time
+as a big-endian word, which settles most comparisons between keys that share a long
+prefix (such as UUID primary keys in the same node) without a call to memcmp. */
+int btree_key_cmp_after_prefix(const btree_key_t *left, const btree_key_t *right,
+                               int prefix_size);
+
 struct store_key_t {
 public:
     store_key_t() {
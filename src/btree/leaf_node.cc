@@ -1154,6 +1154,24 @@ bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_
 // for the key, or to the index the key would have if it were
 // inserted.  Returns true if the key at said index is actually equal.
 bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
+    if (node->num_pairs == 0) {
+        *index_out = 0;
+        return false;
+    }
+
+    // All the keys in the node lie between the first and the last one, so they all
+    // start with the prefix those two have in common.  We check `key` against that
+    // prefix once, and then only compare what comes after it.
+    const btree_key_t *first_key = entry_key(get_entry(node, node->pair_offsets[0]));
+    const btree_key_t *last_key
+        = entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1]));
+    const int prefix_size = btree_key_common_prefix_size(first_key, last_key);
+    if (btree_key_common_prefix_size(key, first_key) < prefix_size) {
+        // `key` doesn't have the prefix, so it's either before or after all keys.
+        *index_out = btree_key_cmp(key, first_key) < 0 ? 0 : node->num_pairs;
+        return false;
+    }
+
     int beg = 0;
     int end = node->num_pairs;
 
@@ -1166,7 +1184,7 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
 
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int res = btree_key_cmp_after_prefix(key, ek, prefix_size);
 
         if (res < 0) {
             // key < *test_point.
@@ -41,8 +41,12 @@ btree_sindex_block_magic_t<cluster_version_t::v1_15>::value
     = { { 's', 'i', 'n', 'f' } };
 template <>
 const block_magic_t
-btree_sindex_block_magic_t<cluster_version_t::v1_16_is_latest_disk>::value
+btree_sindex_block_magic_t<cluster_version_t::v1_16>::value
     = { { 's', 'i', 'n', 'g' } };
+template <>
+const block_magic_t
+btree_sindex_block_magic_t<cluster_version_t::v1_17_is_latest_disk>::value
+    = { { 's', 'i', 'n', 'h' } };
 
 cluster_version_t sindex_block_version(const btree_sindex_block_t *data) {
     if (data->magic
@@ -55,8 +59,11 @@ cluster_version_t sindex_block_version(const btree_sindex_block_t *data) {
                == btree_sindex_block_magic_t<cluster_version_t::v1_15>::value) {
         return cluster_version_t::v1_15;
     } else if (data->magic
-               == btree_sindex_block_magic_t<cluster_version_t::v1_16_is_latest_disk>::value) {
-        return cluster_version_t::v1_16_is_latest_disk;
+               == btree_sindex_block_magic_t<cluster_version_t::v1_16>::value) {
+        return cluster_version_t::v1_16;
+    } else if (data->magic
+               == btree_sindex_block_magic_t<cluster_version_t::v1_17_is_latest_disk>::value) {
+        return cluster_version_t::v1_17_is_latest_disk;
     } else {
         crash("Unexpected magic in btree_sindex_block_t.");
     }
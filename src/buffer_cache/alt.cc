@@ -6,6 +6,8 @@
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/stats.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/signal.hpp"
 #include "utils.hpp"
 
 #define ALT_DEBUG 0
@@ -22,6 +24,9 @@ const int64_t MINIMUM_SOFT_UNWRITTEN_CHANGES_LIMIT = 1;
 const int64_t SOFT_UNWRITTEN_CHANGES_LIMIT = 4000;
 const double SOFT_UNWRITTEN_CHANGES_MEMORY_FRACTION = 0.5;
 
+// How many blocks `cache_t::warm_up()` loads at a time.
+const int64_t CACHE_WARM_UP_CONCURRENCY = 16;
+
 // There are very few ASSERT_NO_CORO_WAITING calls (instead we have
 // ASSERT_FINITE_CORO_WAITING) because most of the time we're at the mercy of the
 // page cache, which often may need to load or evict blocks, which may involve a
@@ -97,6 +102,31 @@ cache_account_t cache_t::create_cache_account(int priority) {
     return page_cache_.create_cache_account(priority);
 }
 
+void cache_t::set_cache_share(double min_share, double max_share) {
+    assert_thread();
+    page_cache_.evicter().set_cache_share(min_share, max_share);
+}
+
+std::vector<block_id_t> cache_t::hot_block_ids() {
+    assert_thread();
+    return page_cache_.hot_block_ids();
+}
+
+void cache_t::warm_up(const std::vector<block_id_t> &block_ids,
+                      cache_account_t *account,
+                      signal_t *interruptor) {
+    assert_thread();
+    // We load the coldest blocks first, so that the hottest ones are the most
+    // recently accessed once we're done, and so that the evicter throws out the
+    // coldest ones if the list doesn't fit in the cache anymore.
+    const int64_t count = block_ids.size();
+    throttled_pmap(count, [&](int64_t i) {
+        if (!interruptor->is_pulsed()) {
+            page_cache_.warm_up_block(block_ids[count - 1 - i], account);
+        }
+    }, CACHE_WARM_UP_CONCURRENCY);
+}
+
 alt_snapshot_node_t *
 cache_t::matching_snapshot_node_or_null(block_id_t block_id,
                                         block_version_t block_version) {
@@ -501,6 +531,29 @@ buf_lock_t::buf_lock_t(buf_parent_t parent,
     help_construct(parent, block_id, create);
 }
 
+void buf_lock_t::prefetch_child(block_id_t child_id) {
+    guarantee(!empty());
+    cache()->assert_thread();
+    cache()->page_cache_.prefetch_block(child_id);
+}
+
+void buf_lock_t::prefetch_children(const std::vector<block_id_t> &child_ids) {
+    guarantee(!empty());
+    cache()->assert_thread();
+    const size_t budget = prefetch_budget();
+    if (child_ids.size() <= budget) {
+        cache()->page_cache_.prefetch_blocks(child_ids);
+    } else {
+        cache()->page_cache_.prefetch_blocks(
+            std::vector<block_id_t>(child_ids.begin(), child_ids.begin() + budget));
+    }
+}
+
+size_t buf_lock_t::prefetch_budget() const {
+    guarantee(!empty());
+    return cache()->page_cache_.prefetch_budget();
+}
+
 void buf_lock_t::mark_deleted() {
     ASSERT_FINITE_CORO_WAITING;
 #if ALT_DEBUG
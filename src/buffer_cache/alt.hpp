@@ -54,6 +54,19 @@ public:
     // might consider supporting a mem_cap paremeter.
     cache_account_t create_cache_account(int priority);
 
+    // Bounds the fraction of the total cache size that the cache balancer gives
+    // this cache.  See `evicter_t::set_cache_share()`.
+    void set_cache_share(double min_share, double max_share);
+
+    // The ids of the blocks that are in memory, most recently used first.
+    std::vector<block_id_t> hot_block_ids();
+
+    // Loads the given blocks into the cache through `account`, so that they end up
+    // in the same recency order as `hot_block_ids()` returned them.  Stops early if
+    // `interruptor` gets pulsed (without throwing).
+    void warm_up(const std::vector<block_id_t> &block_ids, cache_account_t *account,
+                 signal_t *interruptor);
+
 private:
     friend class txn_t;
     friend class buf_read_t;
@@ -192,6 +205,17 @@ public:
 
     void detach_child(block_id_t child_id);
 
+    // Starts loading the child block `child_id` into the cache without acquiring it,
+    // so that acquiring it later doesn't have to wait for the disk.  This loads the
+    // current version of the block, so snapshotted readers of a block that has
+    // changed since won't benefit.
+    void prefetch_child(block_id_t child_id);
+    // Prefetches up to `prefetch_budget()` of `child_ids` at once, reading the ones
+    // that lie next to each other on disk together.
+    void prefetch_children(const std::vector<block_id_t> &child_ids);
+    // How many children it's reasonable to prefetch ahead of time.
+    size_t prefetch_budget() const;
+
     block_id_t block_id() const {
         guarantee(txn_ != NULL);
         return current_page_acq()->block_id();
@@ -291,6 +315,12 @@ public:
         }
     }
 
+    void prefetch_children(const std::vector<block_id_t> &child_ids) {
+        if (lock_or_null_ != NULL) {
+            lock_or_null_->prefetch_children(child_ids);
+        }
+    }
+
     bool empty() const {
         return txn_ == NULL;
     }
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <limits>
+#include <vector>
 
 #include "buffer_cache/alt.hpp"
 #include "concurrency/pmap.hpp"
@@ -360,6 +361,26 @@ void blob_t::expose_all(buf_parent_t parent, access_t mode,
     expose_region(parent, mode, 0, valuesize(), buffer_group_out, acq_group_out);
 }
 
+bool blob_t::read_in_one_piece(buf_parent_t parent,
+                               const std::function<void(const char *, int64_t)> &fn) {
+    if (blob::is_small(ref_, maxreflen_)) {
+        fn(blob::small_buffer(ref_, maxreflen_), blob::small_size(ref_, maxreflen_));
+        return true;
+    }
+
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+    const int64_t size = valuesize();
+    if (blob::ref_info(block_size, ref_, maxreflen_).levels != 1
+        || size > blob::leaf_size(block_size)) {
+        return false;
+    }
+
+    buf_lock_t lock(parent, blob::block_ids(ref_, maxreflen_)[0], access_t::read);
+    buf_read_t read(&lock);
+    fn(blob::leaf_node_data(read.get_data_read()), size);
+    return true;
+}
+
 namespace blob {
 
 struct region_tree_filler_t {
@@ -422,6 +443,14 @@ make_tree_from_block_ids(buf_parent_t parent, access_t mode, int levels,
 
     filler.nodes = new temporary_acq_tree_node_t[filler.hi - filler.lo];
 
+    if (levels == 1 && mode == access_t::read && filler.hi - filler.lo > 1) {
+        // Start loading all the leaves at once, so that the serializer can read the
+        // ones that were written next to each other with a single read, instead of
+        // us reading them one at a time below.
+        parent.prefetch_children(
+            std::vector<block_id_t>(block_ids + filler.lo, block_ids + filler.hi));
+    }
+
     throttled_pmap(filler.hi - filler.lo, filler, choose_concurrency(levels));
 
     return filler.nodes;
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <utility>
@@ -184,6 +185,13 @@ public:
                     buffer_group_t *buffer_group_out,
                     blob_acq_t *acq_group_out);
 
+    // If the value is stored in one piece -- in the ref itself, or in a single leaf
+    // block -- this acquires it for reading, calls `fn` with its bytes, and returns
+    // true.  Otherwise it returns false without acquiring anything.  It's a cheaper
+    // way to read small values than `expose_all()`.
+    bool read_in_one_piece(buf_parent_t root,
+                           const std::function<void(const char *, int64_t)> &fn);
+
     // Appends size bytes of garbage data to the blob.
     void append_region(buf_parent_t root, int64_t size);
 
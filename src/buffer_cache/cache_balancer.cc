@@ -5,6 +5,7 @@
 #include "buffer_cache/evicter.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "concurrency/pmap.hpp"
+#include "math.hpp"
 
 const uint64_t alt_cache_balancer_t::rebalance_check_interval_ms = 20;
 const uint64_t alt_cache_balancer_t::rebalance_access_count_threshold = 100;
@@ -17,11 +18,19 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     new_size(0),
     old_size(evicter->memory_limit()),
     bytes_loaded(evicter->get_clamped_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    ghost_hits(evicter->ghost_hits_since_rebalance()),
+    load_time_us(evicter->average_load_time_us()),
+    min_share(evicter->min_cache_share()),
+    max_share(evicter->max_cache_share()),
+    min_size(0),
+    max_size(0) { }
 
 alt_cache_balancer_t::alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_balancer_policy_t _policy) :
     total_cache_size_watchable(_total_cache_size_watchable),
+    policy(_policy),
     rebalance_timer(make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this)),
     rebalance_timer_state(rebalance_timer_state_t::normal),
     last_rebalance_time(0),
@@ -113,16 +122,20 @@ void alt_cache_balancer_t::coro_pool_callback(alt_cache_balancer_dummy_value_t,
                    this, ph::_1, &cache_data, &zero_access_counts));
 
     bool all_zero_access_counts = true;
-    // Sum up the number of evicters, bytes loaded, and access counts
+    // Sum up the number of evicters, bytes loaded, access counts, and (for the
+    // miss_cost policy) the load time each evicter could have saved
     size_t total_evicters = 0;
     uint64_t total_bytes_loaded = 0;
     uint64_t total_access_count = 0;
+    double total_miss_cost = 0;
     for (size_t i = 0; i < num_threads; ++i) {
         total_evicters += cache_data[i].size();
         all_zero_access_counts &= zero_access_counts[i];
         for (size_t j = 0; j < cache_data[i].size(); ++j) {
             total_bytes_loaded += cache_data[i][j].bytes_loaded;
             total_access_count += cache_data[i][j].access_count;
+            total_miss_cost += cache_data[i][j].ghost_hits
+                * cache_data[i][j].load_time_us;
         }
     }
 
@@ -148,8 +161,13 @@ void alt_cache_balancer_t::coro_pool_callback(alt_cache_balancer_dummy_value_t,
 
     // Calculate new cache sizes
     if (total_cache_size > 0 && total_evicters > 0) {
+        const bool use_miss_cost =
+            policy == cache_balancer_policy_t::miss_cost && total_miss_cost > 0;
         uint64_t total_new_sizes = 0;
 
+        // Every cache gives up a share of the bytes loaded since the last rebalance
+        // in proportion to its size, and those bytes are handed out again by the
+        // policy's measure of who needs them most.
         for (size_t i = 0; i < cache_data.size(); ++i) {
             for (size_t j = 0; j < cache_data[i].size(); ++j) {
                 cache_data_t *data = &cache_data[i][j];
@@ -158,37 +176,38 @@ void alt_cache_balancer_t::coro_pool_callback(alt_cache_balancer_dummy_value_t,
                 temp /= static_cast<double>(total_cache_size);
                 temp *= static_cast<double>(total_bytes_loaded);
 
-                int64_t new_size = data->bytes_loaded;
+                int64_t new_size;
+                if (use_miss_cost) {
+                    double gain = data->ghost_hits * data->load_time_us;
+                    gain /= total_miss_cost;
+                    gain *= static_cast<double>(total_bytes_loaded);
+                    new_size = static_cast<int64_t>(gain);
+                } else {
+                    new_size = data->bytes_loaded;
+                }
                 new_size -= static_cast<int64_t>(temp);
                 new_size += data->old_size;
                 new_size = std::max<int64_t>(new_size, 0);
 
+                // Keep the cache within the share its table was configured with
+                data->min_size = static_cast<uint64_t>(
+                    data->min_share * total_cache_size);
+                data->max_size = std::max(data->min_size, static_cast<uint64_t>(
+                    data->max_share * total_cache_size));
+                new_size = clamp<int64_t>(new_size, data->min_size, data->max_size);
+
                 data->new_size = new_size;
                 total_new_sizes += new_size;
             }
         }
 
-        // Distribute any rounding error across shards
+        // Distribute any rounding error across shards.  If the minimum shares add up
+        // to more than the whole cache, some of them have to give.  If the maximum
+        // shares add up to less, the rest of the cache stays unused.
         int64_t extra_bytes = total_cache_size - total_new_sizes;
-        while (extra_bytes != 0) {
-            int64_t delta = extra_bytes / static_cast<int64_t>(total_evicters);
-            if (delta == 0) {
-                delta = ((extra_bytes < 0) ? -1 : 1);
-            }
-            for (size_t i = 0; i < cache_data.size() && extra_bytes != 0; ++i) {
-                for (size_t j = 0; j < cache_data[i].size() && extra_bytes != 0; ++j) {
-                    cache_data_t *data = &cache_data[i][j];
-
-                    // Avoid underflow
-                    if (static_cast<int64_t>(data->new_size) + delta >= 0) {
-                        data->new_size += delta;
-                        extra_bytes -= delta;
-                    } else {
-                        extra_bytes += data->new_size;
-                        data->new_size = 0;
-                    }
-                }
-            }
+        extra_bytes = distribute_extra_bytes(extra_bytes, true, &cache_data);
+        if (extra_bytes < 0) {
+            distribute_extra_bytes(extra_bytes, false, &cache_data);
         }
 
         // Send new cache sizes to each thread
@@ -209,6 +228,50 @@ void alt_cache_balancer_t::coro_pool_callback(alt_cache_balancer_dummy_value_t,
     }
 }
 
+int64_t alt_cache_balancer_t::distribute_extra_bytes(
+        int64_t extra_bytes,
+        bool respect_bounds,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data) {
+    while (extra_bytes != 0) {
+        // Count the caches that can still take (or give up) bytes
+        int64_t num_open = 0;
+        for (size_t i = 0; i < cache_data->size(); ++i) {
+            for (size_t j = 0; j < (*cache_data)[i].size(); ++j) {
+                const cache_data_t *data = &(*cache_data)[i][j];
+                if (extra_bytes > 0) {
+                    num_open += (!respect_bounds || data->new_size < data->max_size);
+                } else {
+                    num_open += (data->new_size > (respect_bounds ? data->min_size : 0));
+                }
+            }
+        }
+        if (num_open == 0) {
+            break;
+        }
+
+        int64_t delta = extra_bytes / num_open;
+        if (delta == 0) {
+            delta = ((extra_bytes < 0) ? -1 : 1);
+        }
+        for (size_t i = 0; i < cache_data->size() && extra_bytes != 0; ++i) {
+            for (size_t j = 0; j < (*cache_data)[i].size() && extra_bytes != 0; ++j) {
+                cache_data_t *data = &(*cache_data)[i][j];
+
+                int64_t lower = respect_bounds ? data->min_size : 0;
+                int64_t upper = respect_bounds
+                    ? data->max_size
+                    : std::numeric_limits<int64_t>::max();
+                int64_t old_size = data->new_size;
+                // Avoid underflow, and overshooting the bounds
+                int64_t new_size = clamp<int64_t>(old_size + delta, lower, upper);
+                data->new_size = new_size;
+                extra_bytes -= new_size - old_size;
+            }
+        }
+    }
+    return extra_bytes;
+}
+
 void alt_cache_balancer_t::collect_stats_from_thread(
         int index,
         scoped_array_t<std::vector<cache_data_t> > *data_out,
@@ -247,6 +310,7 @@ void alt_cache_balancer_t::apply_rebalance_to_thread(int index,
             it->evicter->update_memory_limit(it->new_size,
                                              it->bytes_loaded,
                                              it->access_count,
+                                             it->ghost_hits,
                                              new_read_ahead_ok);
         }
     }
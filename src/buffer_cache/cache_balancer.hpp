@@ -88,13 +88,26 @@ private:
 
 class alt_cache_balancer_dummy_value_t { };
 
+// How `alt_cache_balancer_t` decides which caches get more memory.
+enum class cache_balancer_policy_t {
+    // Each cache gets memory in proportion to how many bytes it loaded since the
+    // last rebalance.
+    bytes_loaded,
+    // Each cache gets memory in proportion to the load time more memory would have
+    // saved it: the number of times it reloaded a recently evicted block (see
+    // `evicter_t::ghost_hit_count()`) times how long its loads take on average.
+    // Falls back to `bytes_loaded` while no cache has any ghost hits.
+    miss_cost
+};
+
 class alt_cache_balancer_t final :
     public cache_balancer_t,
     public coro_pool_callback_t<alt_cache_balancer_dummy_value_t>,
     public repeating_timer_callback_t {
 public:
     explicit alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable);
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_balancer_policy_t _policy = cache_balancer_policy_t::miss_cost);
     ~alt_cache_balancer_t();
 
     uint64_t base_mem_per_store() const final {
@@ -148,8 +161,25 @@ private:
         uint64_t old_size;
         uint64_t bytes_loaded;
         uint64_t access_count;
+        uint64_t ghost_hits;
+        // The evicter's average load time, in microseconds
+        double load_time_us;
+        // The fractions of the total cache size this evicter must get at least and
+        // may get at most (see `evicter_t::set_cache_share()`)
+        double min_share;
+        double max_share;
+        // `min_share` and `max_share`, applied to the total cache size
+        uint64_t min_size;
+        uint64_t max_size;
     };
 
+    // Spreads `extra_bytes`, which may be negative, across the caches.  If
+    // `respect_bounds` is true, no cache is pushed past its `min_size` or
+    // `max_size`.  Returns how many bytes could not be spread.
+    static int64_t distribute_extra_bytes(
+        int64_t extra_bytes,
+        bool respect_bounds,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data);
     // Helper function to collect stats from each thread so we don't need
     //  atomic variables slowing down normal operations
     void collect_stats_from_thread(int index,
@@ -161,6 +191,7 @@ private:
                                    bool new_read_ahead_ok);
 
     clone_ptr_t<watchable_t<uint64_t> > total_cache_size_watchable;
+    const cache_balancer_policy_t policy;
     scoped_ptr_t<repeating_timer_t> rebalance_timer;
     enum class rebalance_timer_state_t {
         // Normal operating condition: there is a timer, and it'll ping soon.  Can
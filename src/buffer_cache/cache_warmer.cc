@@ -0,0 +1,168 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "buffer_cache/cache_warmer.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arch/io/disk.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/types.hpp"
+#include "buffer_cache/alt.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+#include "utils.hpp"
+
+// The file starts with this header, followed by `count` block ids.
+struct warm_list_header_t {
+    static const uint64_t expected_magic = 0x324d5241574244;  // "DBWARM2"
+    uint64_t magic;
+    // Which data file the list belongs to, and the block size of that file
+    uint64_t file_identity;
+    uint64_t block_size;
+    uint64_t count;
+};
+
+cache_warmer_t::cache_warmer_t(cache_t *cache, const std::string &path,
+                               uint64_t file_identity)
+    : cache_(cache),
+      path_(path),
+      file_identity_(file_identity),
+      account_(cache->create_cache_account(CACHE_WARM_UP_CACHE_PRIORITY)),
+      warmed_up_(false),
+      saving_(false) {
+    coro_t::spawn_sometime(std::bind(&cache_warmer_t::warm_up, this,
+                                     drainer_.lock()));
+    timer_.init(new repeating_timer_t(CACHE_WARM_LIST_SAVE_INTERVAL_MS, this));
+}
+
+cache_warmer_t::~cache_warmer_t() {
+    assert_thread();
+    timer_.reset();
+    drainer_.drain();
+}
+
+void cache_warmer_t::remove_file(const std::string &path) {
+    const std::string paths[] = { path, path + ".tmp" };
+    for (const std::string &p : paths) {
+        const int res = ::unlink(p.c_str());
+        guarantee_err(res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", p.c_str());
+    }
+}
+
+void cache_warmer_t::on_ring() {
+    if (warmed_up_ && !saving_) {
+        coro_t::spawn_sometime(std::bind(&cache_warmer_t::save, this,
+                                         drainer_.lock()));
+    }
+}
+
+void cache_warmer_t::warm_up(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    std::vector<block_id_t> block_ids;
+    bool ok;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        ok = read_file(path_, file_identity_, cache_->max_block_size(), &block_ids);
+    });
+    if (ok && !block_ids.empty()) {
+        cache_->warm_up(block_ids, &account_, keepalive.get_drain_signal());
+    }
+    if (!keepalive.get_drain_signal()->is_pulsed()) {
+        warmed_up_ = true;
+    }
+}
+
+void cache_warmer_t::save(auto_drainer_t::lock_t) {
+    assert_thread();
+    if (saving_) {
+        return;
+    }
+    saving_ = true;
+    const std::vector<block_id_t> block_ids = cache_->hot_block_ids();
+    bool ok;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        ok = write_file(path_, file_identity_, cache_->max_block_size(), block_ids);
+    });
+    if (!ok) {
+        logWRN("Could not save the list of cached blocks to \"%s\".  The cache will "
+               "start out cold after a restart.", path_.c_str());
+    }
+    saving_ = false;
+}
+
+bool cache_warmer_t::read_file(const std::string &path, uint64_t file_identity,
+                               max_block_size_t block_size,
+                               std::vector<block_id_t> *out) {
+    std::string contents;
+    if (!blocking_read_file(path.c_str(), &contents)) {
+        return false;
+    }
+    warm_list_header_t header;
+    if (contents.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != warm_list_header_t::expected_magic
+        || header.file_identity != file_identity
+        || header.block_size != block_size.value()
+        || header.count != (contents.size() - sizeof(header)) / sizeof(block_id_t)
+        || (contents.size() - sizeof(header)) % sizeof(block_id_t) != 0) {
+        return false;
+    }
+    out->resize(header.count);
+    memcpy(out->data(), contents.data() + sizeof(header),
+           header.count * sizeof(block_id_t));
+    return true;
+}
+
+bool cache_warmer_t::write_file(const std::string &path, uint64_t file_identity,
+                                max_block_size_t block_size,
+                                const std::vector<block_id_t> &block_ids) {
+    warm_list_header_t header;
+    header.magic = warm_list_header_t::expected_magic;
+    header.file_identity = file_identity;
+    header.block_size = block_size.value();
+    header.count = block_ids.size();
+    std::string contents(reinterpret_cast<const char *>(&header), sizeof(header));
+    contents.append(reinterpret_cast<const char *>(block_ids.data()),
+                    block_ids.size() * sizeof(block_id_t));
+
+    // We write to a temporary file and move it into place once it's on disk, so
+    // that a crash never leaves a half-written or empty list behind.
+    const std::string temporary_path = path + ".tmp";
+    {
+        scoped_fd_t fd;
+        int res;
+        do {
+            res = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == -1) {
+            return false;
+        }
+        fd.reset(res);
+
+        size_t offset = 0;
+        while (offset < contents.size()) {
+            ssize_t written;
+            do {
+                written = ::write(fd.get(), contents.data() + offset,
+                                  contents.size() - offset);
+            } while (written == -1 && get_errno() == EINTR);
+            if (written == -1) {
+                return false;
+            }
+            offset += written;
+        }
+        if (fsync(fd.get()) != 0) {
+            return false;
+        }
+    }
+    if (::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+    return fsync_parent_directory(path.c_str()) == 0;
+}
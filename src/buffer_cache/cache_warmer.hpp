@@ -0,0 +1,67 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_CACHE_WARMER_HPP_
+#define BUFFER_CACHE_CACHE_WARMER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "buffer_cache/cache_account.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+
+class cache_t;
+
+/* Saves the list of blocks that a cache holds in memory to a file next to the
+table's data file every now and then, and loads those blocks back into the cache in
+the background when it's constructed again, so that a restarted server doesn't have
+to serve its working set from disk one cache miss at a time.
+
+The warm-up runs through its own low priority cache account, so it doesn't get in
+the way of real queries.  The list is only a hint: blocks that have since been
+deleted are skipped, and a missing or garbled file is ignored, as is a list that was
+saved for a different data file.  The list only gets saved periodically, so that
+shutting down doesn't have to wait for it. */
+class cache_warmer_t : public home_thread_mixin_t,
+                       private repeating_timer_callback_t {
+public:
+    // `file_identity` tells the data file apart from others that might show up at
+    // the same path later, such as the serializer's creation timestamp.
+    cache_warmer_t(cache_t *cache, const std::string &path, uint64_t file_identity);
+    ~cache_warmer_t();
+
+    // Removes the file that a cache_warmer_t with the same path would use.
+    static void remove_file(const std::string &path);
+
+    // Blocking calls that load and save the list at `path`.  `read_file` returns
+    // false if there is no usable list for the given identity and block size.
+    static bool read_file(const std::string &path, uint64_t file_identity,
+                          max_block_size_t block_size, std::vector<block_id_t> *out);
+    static bool write_file(const std::string &path, uint64_t file_identity,
+                           max_block_size_t block_size,
+                           const std::vector<block_id_t> &block_ids);
+
+private:
+    void on_ring();
+
+    void warm_up(auto_drainer_t::lock_t keepalive);
+    void save(auto_drainer_t::lock_t keepalive);
+
+    cache_t *const cache_;
+    const std::string path_;
+    const uint64_t file_identity_;
+    cache_account_t account_;
+
+    // We don't save the list until we are done loading the previous one, because
+    // we'd overwrite it with a shorter one.
+    bool warmed_up_;
+    bool saving_;
+
+    auto_drainer_t drainer_;
+    scoped_ptr_t<repeating_timer_t> timer_;
+
+    DISABLE_COPYING(cache_warmer_t);
+};
+
+#endif  // BUFFER_CACHE_CACHE_WARMER_HPP_
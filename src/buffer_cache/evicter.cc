@@ -7,16 +7,44 @@
 
 namespace alt {
 
+// With `eviction_policy_t::sampled_2q`, a page becomes protected once it has been
+// acquired this many times since it was loaded.
+const uint32_t PROTECTED_ACCESS_COUNT = 2;
+
+// Probationary pages are evicted before protected ones as long as they use more
+// than 1/PROBATIONARY_SHARE_DIVISOR of the memory limit.  (This is the 25% "Kin"
+// suggested by the 2Q paper.)
+const uint64_t PROBATIONARY_SHARE_DIVISOR = 4;
+
+// We remember as many evicted block ids as half the number of blocks that fit in
+// the memory limit (the 2Q paper's "Kout").
+const uint64_t GHOST_LIST_SHARE_DIVISOR = 2;
+
+// The ghost list remembers at least this many block ids, even if the memory limit
+// is tiny.  Otherwise a cache that the balancer has shrunk to nothing could never
+// show that it needs memory back.
+const size_t MIN_GHOST_LIST_CAPACITY = 64;
+
+// The weight of each new load time in the evicter's average load time.
+const double LOAD_TIME_AVERAGE_WEIGHT = 0.05;
+
 evicter_t::evicter_t()
     : initialized_(false),
+      policy_(eviction_policy_t::sampled_lru),
       page_cache_(nullptr),
       balancer_(nullptr),
       balancer_notify_activity_boolean_(nullptr),
       throttler_(nullptr),
       bytes_loaded_counter_(0),
       access_count_counter_(0),
+      ghost_hits_counter_(0),
+      average_load_time_us_(0),
+      min_cache_share_(0),
+      max_cache_share_(1),
       access_time_counter_(INITIAL_ACCESS_TIME),
-      evict_if_necessary_active_(false) { }
+      evict_if_necessary_active_(false),
+      ghost_hits_(0),
+      misses_(0) { }
 
 evicter_t::~evicter_t() {
     assert_thread();
@@ -29,10 +57,12 @@ evicter_t::~evicter_t() {
 
 void evicter_t::initialize(page_cache_t *page_cache,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler) {
+                           alt_txn_throttler_t *throttler,
+                           eviction_policy_t policy) {
     assert_thread();
     guarantee(balancer != nullptr);
     initialized_ = true;  // Can you really say this class is 'initialized_'?
+    policy_ = policy;
     page_cache_ = page_cache;
     memory_limit_ = balancer->base_mem_per_store();
     page_cache_ = page_cache;
@@ -48,6 +78,7 @@ void evicter_t::initialize(page_cache_t *page_cache,
 void evicter_t::update_memory_limit(uint64_t new_memory_limit,
                                     uint64_t bytes_loaded_accounted_for,
                                     uint64_t access_count_accounted_for,
+                                    uint64_t ghost_hits_accounted_for,
                                     bool read_ahead_ok) {
     assert_thread();
     guarantee(initialized_);
@@ -58,6 +89,7 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
 
     bytes_loaded_counter_ -= bytes_loaded_accounted_for;
     access_count_counter_ -= access_count_accounted_for;
+    ghost_hits_counter_ -= ghost_hits_accounted_for;
     memory_limit_ = new_memory_limit;
     evict_if_necessary();
 
@@ -71,6 +103,25 @@ uint64_t evicter_t::get_clamped_bytes_loaded() const {
     return std::max<int64_t>(bytes_loaded_counter_, 0);
 }
 
+uint64_t evicter_t::ghost_hits_since_rebalance() const {
+    assert_thread();
+    guarantee(initialized_);
+    return ghost_hits_counter_;
+}
+
+double evicter_t::average_load_time_us() const {
+    assert_thread();
+    guarantee(initialized_);
+    return average_load_time_us_;
+}
+
+void evicter_t::set_cache_share(double min_share, double max_share) {
+    assert_thread();
+    guarantee(0 <= min_share && min_share <= max_share && max_share <= 1);
+    min_cache_share_ = min_share;
+    max_cache_share_ = max_share;
+}
+
 uint64_t evicter_t::memory_limit() const {
     assert_thread();
     guarantee(initialized_);
@@ -107,6 +158,7 @@ void evicter_t::add_deferred_loaded(page_t *page) {
     assert_thread();
     guarantee(initialized_);
     evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
+    check_ghost_hit(page);
 }
 
 void evicter_t::catch_up_deferred_load(page_t *page) {
@@ -120,6 +172,7 @@ void evicter_t::add_not_yet_loaded(page_t *page) {
     assert_thread();
     guarantee(initialized_);
     unevictable_.add(page, page->hypothetical_memory_usage(page_cache_));
+    check_ghost_hit(page);
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -127,9 +180,53 @@ void evicter_t::add_not_yet_loaded(page_t *page) {
 void evicter_t::reloading_page(page_t *page) {
     assert_thread();
     guarantee(initialized_);
+    check_ghost_hit(page);
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
+void evicter_t::record_access(page_t *page, eviction_bag_t *bag) {
+    assert_thread();
+    guarantee(initialized_);
+    // The page has a waiter now, so it's unevictable and we may touch its access
+    // count without confusing the bag bookkeeping.
+    rassert(unevictable_.has_page(page));
+    if (page->is_loaded()) {
+        bag->record_hit();
+    } else {
+        ++misses_;
+    }
+    page->bump_access_count();
+}
+
+void evicter_t::record_load_time(ticks_t load_time) {
+    assert_thread();
+    guarantee(initialized_);
+    const double load_time_us = ticks_to_secs(load_time) * MILLION;
+    if (average_load_time_us_ == 0) {
+        average_load_time_us_ = load_time_us;
+    } else {
+        average_load_time_us_ += LOAD_TIME_AVERAGE_WEIGHT
+            * (load_time_us - average_load_time_us_);
+    }
+}
+
+void evicter_t::check_ghost_hit(page_t *page) {
+    if (ghosts_.remove(page->block_id())) {
+        ++ghost_hits_;
+        ++ghost_hits_counter_;
+        if (policy_ == eviction_policy_t::sampled_2q) {
+            // It was needed again soon after we evicted it, so it's part of the
+            // working set.  (The pending acquisition will bump it past the limit.)
+            page->set_access_count(PROTECTED_ACCESS_COUNT - 1);
+        }
+    }
+}
+
+size_t evicter_t::ghost_list_capacity() const {
+    return std::max<size_t>(MIN_GHOST_LIST_CAPACITY, memory_limit_
+        / (page_cache_->max_block_size().ser_value() * GHOST_LIST_SHARE_DIVISOR));
+}
+
 bool evicter_t::page_is_in_unevictable_bag(page_t *page) const {
     assert_thread();
     guarantee(initialized_);
@@ -165,6 +262,7 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
     rassert(new_bag == &evictable_disk_backed_
+            || new_bag == &evictable_protected_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -189,6 +287,10 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
+        if (policy_ == eviction_policy_t::sampled_2q
+            && page->access_count() >= PROTECTED_ACCESS_COUNT) {
+            return &evictable_protected_;
+        }
         return &evictable_disk_backed_;
     } else {
         return &evictable_unbacked_;
@@ -209,9 +311,25 @@ uint64_t evicter_t::in_memory_size() const {
     guarantee(initialized_);
     return unevictable_.size()
         + evictable_disk_backed_.size()
+        + evictable_protected_.size()
         + evictable_unbacked_.size();
 }
 
+eviction_bag_t *evicter_t::choose_eviction_bag() {
+    if (evictable_disk_backed_.size() == 0 && evictable_protected_.size() == 0) {
+        return NULL;
+    }
+    // Under `sampled_lru` the protected bag is always empty, so this picks
+    // `evictable_disk_backed_`.
+    if (evictable_protected_.size() == 0
+        || evictable_disk_backed_.size() > memory_limit_ / PROBATIONARY_SHARE_DIVISOR) {
+        return evictable_disk_backed_.size() != 0
+            ? &evictable_disk_backed_
+            : &evictable_protected_;
+    }
+    return &evictable_protected_;
+}
+
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
     assert_thread();
     guarantee(initialized_);
@@ -229,11 +347,15 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
 
     evict_if_necessary_active_ = true;
     page_t *page;
+    eviction_bag_t *bag;
     while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
-                                                   page_cache_)) {
+           && (bag = choose_eviction_bag()) != NULL
+           && bag->remove_oldish(&page, access_time_counter_, page_cache_)) {
         evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
         page->evict_self(page_cache_);
+        // Once evicted, the page has to earn its place in the protected bag again.
+        page->set_access_count(0);
+        ghosts_.add(page->block_id(), ghost_list_capacity());
         page_cache_->consider_evicting_current_page(page->block_id());
     }
     evict_if_necessary_active_ = false;
@@ -10,6 +10,7 @@
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
 #include "threading.hpp"
+#include "time.hpp"
 
 class cache_balancer_t;
 class alt_txn_throttler_t;
@@ -18,6 +19,18 @@ namespace alt {
 
 class page_cache_t;
 
+// How the evicter picks pages to throw out of memory.
+enum class eviction_policy_t {
+    // Evicts the least recently used of a few randomly sampled pages.
+    sampled_lru,
+    // A sampled variant of 2Q: pages that have been acquired only once live in a
+    // probationary bag, and pages acquired again (or reloaded shortly after being
+    // evicted) get promoted to a protected bag.  The probationary pages get evicted
+    // first, as long as they take up more than a quarter of the memory limit.  This
+    // keeps a single large scan from flushing the hot working set out of the cache.
+    sampled_2q
+};
+
 class evicter_t : public home_thread_mixin_debug_only_t {
 public:
     void add_not_yet_loaded(page_t *page);
@@ -35,29 +48,60 @@ public:
     void remove_page(page_t *page);
     void reloading_page(page_t *page);
 
+    // Called when a page gets acquired; `bag` is the bag the page was in before
+    // that.  Updates the hit counters and the page's access count.
+    void record_access(page_t *page, eviction_bag_t *bag);
+
+    // Called when a page has been read from the serializer; `load_time` is how long
+    // that took, including the trips to and from the serializer's thread.
+    void record_load_time(ticks_t load_time);
+
     // Evicter will be unusable until initialize is called
     evicter_t();
     ~evicter_t();
 
     void initialize(page_cache_t *page_cache,
                     cache_balancer_t *balancer,
-                    alt_txn_throttler_t *throttler);
+                    alt_txn_throttler_t *throttler,
+                    eviction_policy_t policy);
     void update_memory_limit(uint64_t new_memory_limit,
                              uint64_t bytes_loaded_accounted_for,
                              uint64_t access_count_accounted_for,
+                             uint64_t ghost_hits_accounted_for,
                              bool read_ahead_ok);
 
+    // Bounds the fraction of the total cache size that the balancer gives this
+    // evicter.  The default is [0, 1], i.e. no bounds.
+    void set_cache_share(double min_share, double max_share);
+    double min_cache_share() const { return min_cache_share_; }
+    double max_cache_share() const { return max_cache_share_; }
+
     uint64_t next_access_time() {
         guarantee(initialized_);
         return ++access_time_counter_;
     }
+    uint64_t current_access_time() const { return access_time_counter_; }
 
     uint64_t memory_limit() const;
     uint64_t access_count() const;
     uint64_t get_clamped_bytes_loaded() const;
+    uint64_t ghost_hits_since_rebalance() const;
+    // A moving average of the times passed to `record_load_time()`
+    double average_load_time_us() const;
 
     uint64_t in_memory_size() const;
 
+    eviction_policy_t policy() const { return policy_; }
+
+    // Hit counters for each in-memory bag, and the number of loads of pages that
+    // were recently evicted.  These are cumulative.
+    uint64_t unevictable_hits() const { return unevictable_.hit_count(); }
+    uint64_t unbacked_hits() const { return evictable_unbacked_.hit_count(); }
+    uint64_t probationary_hits() const { return evictable_disk_backed_.hit_count(); }
+    uint64_t protected_hits() const { return evictable_protected_.hit_count(); }
+    uint64_t miss_count() const { return misses_; }
+    uint64_t ghost_hit_count() const { return ghost_hits_; }
+
     // This is decremented past UINT64_MAX to force code to be aware of access time
     // rollovers.
     static const uint64_t INITIAL_ACCESS_TIME = UINT64_MAX - 100;
@@ -71,7 +115,16 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // Returns the bag we should take the next victim from, or NULL if there are no
+    // evictable disk backed pages.
+    eviction_bag_t *choose_eviction_bag();
+
+    // Called when a page is (re)loaded from disk.  Promotes it if it's a ghost hit.
+    void check_ghost_hit(page_t *page);
+    size_t ghost_list_capacity() const;
+
     bool initialized_;
+    eviction_policy_t policy_;
     page_cache_t *page_cache_;
     cache_balancer_t *balancer_;
     bool *balancer_notify_activity_boolean_;
@@ -85,6 +138,12 @@ private:
     // negative, if you keep deleting blocks or suddenly drop a snapshot.
     int64_t bytes_loaded_counter_;
     uint64_t access_count_counter_;
+    uint64_t ghost_hits_counter_;
+
+    double average_load_time_us_;
+
+    double min_cache_share_;
+    double max_cache_share_;
 
     // This gets incremented every time a page is accessed.
     uint64_t access_time_counter_;
@@ -93,12 +152,23 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // These track every page's eviction status.  With `eviction_policy_t::sampled_2q`,
+    // loaded disk backed pages that have been accessed repeatedly are kept in
+    // `evictable_protected_` instead of `evictable_disk_backed_`; otherwise
+    // `evictable_protected_` stays empty.
     eviction_bag_t unevictable_;
     eviction_bag_t evictable_disk_backed_;
+    eviction_bag_t evictable_protected_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
+    // The ids of recently evicted blocks, and how often one of them got loaded
+    // again.
+    ghost_list_t ghosts_;
+    uint64_t ghost_hits_;
+    // Acquisitions of pages that weren't in memory.
+    uint64_t misses_;
+
     auto_drainer_t drainer_;
 
     DISABLE_COPYING(evicter_t);
@@ -8,7 +8,7 @@
 namespace alt {
 
 eviction_bag_t::eviction_bag_t()
-    : bag_(), size_(0) { }
+    : bag_(), size_(0), hits_(0) { }
 
 eviction_bag_t::~eviction_bag_t() {
     guarantee(bag_.size() == 0);
@@ -60,5 +60,26 @@ bool eviction_bag_t::remove_oldish(page_t **page_out, uint64_t access_time_offse
     }
 }
 
+ghost_list_t::ghost_list_t() : next_sequence_number_(0) { }
+
+void ghost_list_t::add(block_id_t block_id, size_t capacity) {
+    const uint64_t sequence_number = next_sequence_number_++;
+    ids_[block_id] = sequence_number;
+    fifo_.push_back(std::make_pair(block_id, sequence_number));
+    // Drop the oldest entries, and any stale ones we come across on the way, so
+    // that `fifo_` can't grow much beyond `ids_`.
+    while (!fifo_.empty()
+           && (ids_.size() > capacity || fifo_.size() > 2 * capacity + 1)) {
+        auto it = ids_.find(fifo_.front().first);
+        if (it != ids_.end() && it->second == fifo_.front().second) {
+            ids_.erase(it);
+        }
+        fifo_.pop_front();
+    }
+}
+
+bool ghost_list_t::remove(block_id_t block_id) {
+    return ids_.erase(block_id) != 0;
+}
 
 }  // namespace alt
@@ -3,7 +3,12 @@
 
 #include <stdint.h>
 
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
 #include "containers/backindex_bag.hpp"
+#include "serializer/types.hpp"
 
 namespace alt {
 
@@ -33,14 +38,44 @@ public:
     bool remove_oldish(page_t **page_out, uint64_t access_time_offset,
                        page_cache_t *page_cache);
 
+    // Counts acquisitions of pages that were in this bag and already in memory.
+    void record_hit() { ++hits_; }
+    uint64_t hit_count() const { return hits_; }
+
 private:
     backindex_bag_t<page_t *> bag_;
     // The size in memory.
     uint64_t size_;
+    uint64_t hits_;
 
     DISABLE_COPYING(eviction_bag_t);
 };
 
+// Remembers the block ids of the most recently evicted pages, so that we can tell
+// when a page comes back shortly after we threw it out of memory (a "ghost hit").
+// Only the ids are kept, in FIFO order.  This is the "A1out" queue of 2Q.
+class ghost_list_t {
+public:
+    ghost_list_t();
+
+    // Records an evicted block id, forgetting the oldest ones beyond `capacity`.
+    void add(block_id_t block_id, size_t capacity);
+
+    // Returns true and forgets the block id if it was in the list.
+    bool remove(block_id_t block_id);
+
+    size_t size() const { return ids_.size(); }
+
+private:
+    // Entries of `fifo_` whose sequence number doesn't match the one in `ids_` are
+    // stale, either because the id was removed or because it was re-added later.
+    std::deque<std::pair<block_id_t, uint64_t> > fifo_;
+    std::unordered_map<block_id_t, uint64_t> ids_;
+    uint64_t next_sequence_number_;
+
+    DISABLE_COPYING(ghost_list_t);
+};
+
 
 }  // namespace alt
 
@@ -56,6 +56,7 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      access_count_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +71,7 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
     : block_id_(block_id),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      access_count_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -80,12 +82,27 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
                                             account));
 }
 
+page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
+               page_group_load_t *group)
+    : block_id_(block_id),
+      loader_(NULL),
+      access_time_(page_cache->evicter().next_access_time()),
+      access_count_(0),
+      snapshot_refcount_(0) {
+    page_cache->evicter().add_not_yet_loaded(this);
+
+    loader_ = new instant_page_loader_t();
+    group->pages_.push_back(this);
+    group->loaders_.push_back(loader_);
+}
+
 page_t::page_t(block_id_t block_id, buf_ptr_t buf,
                page_cache_t *page_cache)
     : block_id_(block_id),
       loader_(NULL),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      access_count_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +117,7 @@ page_t::page_t(block_id_t block_id,
       buf_(std::move(buf)),
       block_token_(block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      access_count_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +127,7 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      access_count_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -261,6 +280,7 @@ void page_t::catch_up_with_deferred_load(
     // Before blocking, tell the evicter to put us in the right category.
     page_cache->evicter().catch_up_deferred_load(page);
 
+    const ticks_t start_time = get_ticks();
     buf_ptr_t buf;
     {
         serializer_t *const serializer = page_cache->serializer();
@@ -279,6 +299,7 @@ void page_t::catch_up_with_deferred_load(
     if (our_loader.abandon_page()) {
         return;
     }
+    page_cache->evicter().record_load_time(get_ticks() - start_time);
 
     page_t::finish_load_with_block_id(page, page_cache,
                                       std::move(block_token_ptr->token),
@@ -346,6 +367,7 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
 
     auto_drainer_t::lock_t lock = page_cache->drainer_lock();
 
+    const ticks_t start_time = get_ticks();
     buf_ptr_t buf;
     counted_t<standard_block_token_t> block_token;
 
@@ -362,12 +384,69 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
     if (loader.abandon_page()) {
         return;
     }
+    page_cache->evicter().record_load_time(get_ticks() - start_time);
 
     page_t::finish_load_with_block_id(page, page_cache,
                                       std::move(block_token),
                                       std::move(buf));
 }
 
+page_group_load_t::~page_group_load_t() {
+    for (page_loader_t *loader : loaders_) {
+        delete loader;
+    }
+}
+
+void page_t::start_group_load(page_group_load_t *group, page_cache_t *page_cache,
+                              cache_account_t *account) {
+    if (group->empty()) {
+        delete group;
+        return;
+    }
+    coro_t::spawn_now_dangerously(std::bind(&page_t::load_group,
+                                            group,
+                                            page_cache,
+                                            account));
+}
+
+void page_t::load_group(page_group_load_t *group,
+                        page_cache_t *page_cache,
+                        cache_account_t *account) {
+    scoped_ptr_t<page_group_load_t> group_ptr(group);
+
+    auto_drainer_t::lock_t lock = page_cache->drainer_lock();
+
+    const ticks_t start_time = get_ticks();
+    std::vector<counted_t<standard_block_token_t> > block_tokens;
+    std::vector<buf_ptr_t> bufs;
+
+    {
+        serializer_t *const serializer = page_cache->serializer();
+        on_thread_t th(serializer->home_thread());
+        block_tokens.reserve(group->pages_.size());
+        for (page_t *page : group->pages_) {
+            block_tokens.push_back(serializer->index_read(page->block_id_));
+            rassert(block_tokens.back().has());
+        }
+        bufs = serializer->block_reads(block_tokens, account->get());
+    }
+
+    ASSERT_FINITE_CORO_WAITING;
+    // The loads shared one trip to disk, so each of them gets its share of the time.
+    const ticks_t load_time = (get_ticks() - start_time) / group->pages_.size();
+    for (size_t i = 0; i < group->pages_.size(); ++i) {
+        if (group->loaders_[i]->abandon_page()) {
+            continue;
+        }
+        page_t *page = group->pages_[i];
+        rassert(page->loader_ == group->loaders_[i]);
+        page_cache->evicter().record_load_time(load_time);
+        page_t::finish_load_with_block_id(page, page_cache,
+                                          std::move(block_tokens[i]),
+                                          std::move(bufs[i]));
+    }
+}
+
 void page_t::add_snapshotter() {
     // This may not block, because it's called at the beginning of
     // page_t::load_from_copyee.
@@ -415,6 +494,7 @@ void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    acq->page_cache()->evicter().record_access(this, old_bag);
     if (buf_.has()) {
         acq->buf_ready_signal_.pulse();
     } else if (loader_ != NULL) {
@@ -445,6 +525,7 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     counted_t<standard_block_token_t> block_token = page->block_token_;
     rassert(block_token.has());
 
+    const ticks_t start_time = get_ticks();
     buf_ptr_t buf;
     {
         serializer_t *const serializer = page_cache->serializer();
@@ -458,6 +539,7 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     if (loader.abandon_page()) {
         return;
     }
+    page_cache->evicter().record_load_time(get_ticks() - start_time);
 
     rassert(page->block_token_.get() == block_token.get());
     rassert(!page->buf_.has());
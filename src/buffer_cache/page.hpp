@@ -1,6 +1,8 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include <vector>
+
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
@@ -18,6 +20,7 @@ class page_acq_t;
 class page_loader_t;
 class deferred_page_loader_t;
 class deferred_block_token_t;
+class page_group_load_t;
 
 // A page_t represents a page (a byte buffer of a specific size), having a definite
 // value known at the construction of the page_t (and possibly later modified
@@ -29,6 +32,9 @@ public:
     page_t(block_id_t block_id, page_cache_t *page_cache);
     // Loads the block for the given block id.
     page_t(block_id_t block_id, page_cache_t *page_cache, cache_account_t *account);
+    // Loads the block for the given block id together with the other pages in
+    // `group`, once the group gets started with `start_group_load()`.
+    page_t(block_id_t block_id, page_cache_t *page_cache, page_group_load_t *group);
 
     page_t(block_id_t block_id, buf_ptr_t buf, page_cache_t *page_cache);
     page_t(block_id_t block_id, buf_ptr_t buf,
@@ -56,6 +62,15 @@ public:
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
 
+    // How many times the page has been acquired since it was last loaded into
+    // memory (saturating).  Only change this while the page is in a bag that
+    // doesn't depend on it, i.e. while it's unevictable or evicted.
+    uint32_t access_count() const { return access_count_; }
+    void bump_access_count() {
+        if (access_count_ < UINT32_MAX) { ++access_count_; }
+    }
+    void set_access_count(uint32_t access_count) { access_count_ = access_count; }
+
     bool is_loading() const {
         return loader_ != NULL && page_t::loader_is_loading(loader_);
     }
@@ -80,6 +95,11 @@ public:
     void init_block_token(counted_t<standard_block_token_t> token,
                           page_cache_t *page_cache);
 
+    // Loads the pages in `group` with a single serializer call.  Takes ownership of
+    // `group`.
+    static void start_group_load(page_group_load_t *group, page_cache_t *page_cache,
+                                 cache_account_t *account);
+
 private:
     friend class page_ptr_t;
     friend class deferred_page_loader_t;
@@ -110,6 +130,10 @@ private:
                                    page_cache_t *page_cache,
                                    cache_account_t *account);
 
+    static void load_group(page_group_load_t *group,
+                           page_cache_t *page_cache,
+                           cache_account_t *account);
+
     static void load_from_copyee(page_t *page, page_t *copyee,
                                  page_cache_t *page_cache,
                                  cache_account_t *account);
@@ -131,6 +155,7 @@ private:
     counted_t<standard_block_token_t> block_token_;
 
     uint64_t access_time_;
+    uint32_t access_count_;
 
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
@@ -158,6 +183,26 @@ private:
     DISABLE_COPYING(page_t);
 };
 
+// A set of pages that get loaded together, so that the serializer can read blocks
+// that lie next to each other on disk with one large read instead of one read per
+// block.
+class page_group_load_t {
+public:
+    page_group_load_t() { }
+    ~page_group_load_t();
+
+    bool empty() const { return pages_.empty(); }
+
+private:
+    friend class page_t;
+
+    std::vector<page_t *> pages_;
+    // The loaders of `pages_`, in the same order
+    std::vector<page_loader_t *> loaders_;
+
+    DISABLE_COPYING(page_group_load_t);
+};
+
 inline backindex_bag_index_t *access_backindex(page_t *page) {
     return &page->eviction_index_;
 }
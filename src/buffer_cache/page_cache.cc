@@ -30,6 +30,9 @@ cache_conn_t::~cache_conn_t() {
 
 namespace alt {
 
+// A reader may prefetch up to 1/PREFETCH_BUDGET_DIVISOR of the cache's memory limit.
+const uint64_t PREFETCH_BUDGET_DIVISOR = 16;
+
 class current_page_help_t {
 public:
     current_page_help_t(block_id_t _block_id, page_cache_t *_page_cache)
@@ -193,7 +196,8 @@ public:
 
 page_cache_t::page_cache_t(serializer_t *serializer,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler)
+                           alt_txn_throttler_t *throttler,
+                           eviction_policy_t eviction_policy)
     : max_block_size_(serializer->max_block_size()),
       serializer_(serializer),
       free_list_(serializer),
@@ -213,7 +217,10 @@ page_cache_t::page_cache_t(serializer_t *serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(serializer, this);
         }
         default_reads_account_.init(serializer->home_thread(),
-                                    serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    serializer->make_io_account(
+                                        CACHE_READS_IO_PRIORITY,
+                                        UNLIMITED_OUTSTANDING_REQUESTS,
+                                        CACHE_READS_IO_LATENCY_TARGET_US));
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = serializer->get_all_recencies();
     }
@@ -225,7 +232,7 @@ page_cache_t::page_cache_t(serializer_t *serializer,
     // initialize the read_ahead_cb_ after the evicter_ because that way reentrant
     // usage by the balancer (before page_cache_t construction completes) would be
     // more likely to trip an assertion.
-    evicter_.initialize(this, balancer, throttler);
+    evicter_.initialize(this, balancer, throttler, eviction_policy);
     read_ahead_cb_ = local_read_ahead_cb;
 }
 
@@ -341,6 +348,106 @@ current_page_t *page_cache_t::page_for_block_id(block_id_t block_id) {
     return current_pages_[block_id];
 }
 
+current_page_t *page_cache_t::current_page_to_load(block_id_t block_id) {
+    assert_thread();
+
+    // The block might have been deleted since the caller saw its id.
+    if (recency_for_block_id(block_id) == repli_timestamp_t::invalid) {
+        return NULL;
+    }
+
+    resize_current_pages_to_id(block_id);
+    current_page_t *current_page = current_pages_[block_id];
+    if (current_page == NULL) {
+        current_page = new current_page_t(block_id);
+        current_pages_[block_id] = current_page;
+    } else if (current_page->is_deleted() || current_page->page_.has()) {
+        // The page is already loaded or being loaded, or somebody else knows more
+        // about this block than the serializer does.
+        return NULL;
+    }
+    return current_page;
+}
+
+page_t *page_cache_t::start_loading_block(block_id_t block_id,
+                                          cache_account_t *account) {
+    current_page_t *current_page = current_page_to_load(block_id);
+    if (current_page == NULL) {
+        return NULL;
+    }
+    current_page->convert_from_serializer_if_necessary(
+        current_page_help_t(block_id, this), account);
+    return current_page->page_.get_page_for_read();
+}
+
+void page_cache_t::prefetch_block(block_id_t block_id) {
+    start_loading_block(block_id, &default_reads_account_);
+}
+
+void page_cache_t::prefetch_blocks(const std::vector<block_id_t> &block_ids) {
+    ASSERT_NO_CORO_WAITING;
+    page_group_load_t *group = new page_group_load_t();
+    for (block_id_t block_id : block_ids) {
+        current_page_t *current_page = current_page_to_load(block_id);
+        if (current_page != NULL) {
+            current_page->page_.init(new page_t(block_id, this, group));
+        }
+    }
+    page_t::start_group_load(group, this, &default_reads_account_);
+}
+
+void page_cache_t::warm_up_block(block_id_t block_id, cache_account_t *account) {
+    page_t *page = start_loading_block(block_id, account);
+    if (page == NULL) {
+        return;
+    }
+
+    // Hold on to the page so that it can't go away while we wait for it.
+    page_ptr_t page_ptr(page);
+    {
+        page_acq_t acq;
+        acq.init(page, this, account);
+        acq.buf_ready_signal()->wait();
+    }
+    page_ptr.reset_page_ptr(this);
+    consider_evicting_current_page(block_id);
+}
+
+std::vector<block_id_t> page_cache_t::hot_block_ids() {
+    assert_thread();
+    ASSERT_NO_CORO_WAITING;
+
+    // Pairs of (how long ago the page was accessed, block id)
+    std::vector<std::pair<uint64_t, block_id_t> > pages;
+    const uint64_t now = evicter_.current_access_time();
+    for (block_id_t block_id = 0; block_id < current_pages_.size(); ++block_id) {
+        current_page_t *current_page = current_pages_[block_id];
+        if (current_page == NULL
+            || current_page->is_deleted()
+            || !current_page->page_.has()) {
+            continue;
+        }
+        const page_t *page = current_page->page_.get_page_for_read();
+        if (page->is_loaded()) {
+            pages.push_back(std::make_pair(now - page->access_time(), block_id));
+        }
+    }
+    std::sort(pages.begin(), pages.end());
+
+    std::vector<block_id_t> ret;
+    ret.reserve(pages.size());
+    for (const auto &pair : pages) {
+        ret.push_back(pair.second);
+    }
+    return ret;
+}
+
+size_t page_cache_t::prefetch_budget() {
+    assert_thread();
+    return evicter_.memory_limit()
+        / (max_block_size_.ser_value() * PREFETCH_BUDGET_DIVISOR);
+}
+
 current_page_t *page_cache_t::page_for_new_block_id(block_id_t *block_id_out) {
     assert_thread();
     block_id_t block_id = free_list_.acquire_block_id();
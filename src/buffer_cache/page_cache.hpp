@@ -311,7 +311,8 @@ class page_cache_t : public home_thread_mixin_t {
 public:
     page_cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler);
+                 alt_txn_throttler_t *throttler,
+                 eviction_policy_t eviction_policy = eviction_policy_t::sampled_2q);
     ~page_cache_t();
 
     // Takes a txn to be flushed.  Calls on_flush_complete() (which resets the
@@ -337,6 +338,29 @@ public:
         return &default_reads_account_;
     }
 
+    // Starts loading `block_id` from the serializer, unless the page cache already
+    // has (or had, since it was last evicted) a current page for it.  Returns
+    // immediately.  This is a hint for range scans that are about to read the block.
+    // It uses the default reads account, because the caller's account might not
+    // outlive the load.
+    void prefetch_block(block_id_t block_id);
+
+    // Like `prefetch_block()` for each of `block_ids`, but the blocks get loaded with
+    // a single serializer call, which reads the ones that lie next to each other on
+    // disk together.  Used for the leaf blocks of large blobs.
+    void prefetch_blocks(const std::vector<block_id_t> &block_ids);
+
+    // Loads `block_id` like `prefetch_block()`, but through `account`, and waits for
+    // the load to finish.  Used to warm up the cache after a restart.
+    void warm_up_block(block_id_t block_id, cache_account_t *account);
+
+    // Returns the ids of the blocks that are in memory, most recently used first.
+    std::vector<block_id_t> hot_block_ids();
+
+    // How many blocks a single reader should prefetch ahead of itself at most, given
+    // the memory the cache balancer currently gives this cache.
+    size_t prefetch_budget();
+
     // Considers wiping out the current_page_t (and its page_t pointee) for a
     // particular block id, to save memory, if the right conditions are met.  (This
     // should only be called by things "outside" of current_page_t, like
@@ -353,6 +377,14 @@ public:
     serializer_t *serializer() { return serializer_; }
 
 private:
+    // Returns the current page for `block_id`, creating it if necessary, if the block
+    // exists and the current page has no page yet.  Otherwise returns NULL.
+    current_page_t *current_page_to_load(block_id_t block_id);
+
+    // Creates a page for `block_id` and starts loading it, unless there's a current
+    // page for it already.  Returns the new page, or NULL if it did nothing.
+    page_t *start_loading_block(block_id_t block_id, cache_account_t *account);
+
     friend class page_read_ahead_cb_t;
     void add_read_ahead_buf(block_id_t block_id,
                             ser_buffer_t *buf,
@@ -8,13 +8,30 @@ alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
     page_cache(_page_cache),
     cache_collection(),
     cache_membership(parent, &cache_collection, "cache"),
-    in_use_bytes(this),
+    in_use_bytes(this, &alt::evicter_t::in_memory_size),
     in_use_bytes_membership(&cache_collection,
                             &in_use_bytes, "in_use_bytes"),
+    unevictable_hits(this, &alt::evicter_t::unevictable_hits),
+    unevictable_hits_membership(&cache_collection,
+                                &unevictable_hits, "unevictable_hits"),
+    unbacked_hits(this, &alt::evicter_t::unbacked_hits),
+    unbacked_hits_membership(&cache_collection,
+                             &unbacked_hits, "unbacked_hits"),
+    probationary_hits(this, &alt::evicter_t::probationary_hits),
+    probationary_hits_membership(&cache_collection,
+                                 &probationary_hits, "probationary_hits"),
+    protected_hits(this, &alt::evicter_t::protected_hits),
+    protected_hits_membership(&cache_collection,
+                              &protected_hits, "protected_hits"),
+    misses(this, &alt::evicter_t::miss_count),
+    misses_membership(&cache_collection, &misses, "misses"),
+    ghost_hits(this, &alt::evicter_t::ghost_hit_count),
+    ghost_hits_membership(&cache_collection, &ghost_hits, "ghost_hits"),
     cache_collection_membership(&cache_collection) { }
 
-alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
-    parent(_parent) { }
+alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent,
+                                                    getter_t _getter) :
+    parent(_parent), getter(_getter) { }
 
 void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
     return new uint64_t;
@@ -23,7 +40,7 @@ void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
 void alt_cache_stats_t::perfmon_value_t::visit_stats(void *ptr) {
     if (get_thread_id() == parent->home_thread()) {
         uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-        *value = parent->page_cache->evicter().in_memory_size();
+        *value = (parent->page_cache->evicter().*getter)();
     }
 }
 
@@ -15,19 +15,38 @@ public:
     perfmon_collection_t cache_collection;
     perfmon_membership_t cache_membership;
 
+    // Reports the value of one of the evicter's getters, read on the cache's home
+    // thread.
     class perfmon_value_t : public perfmon_t {
     public:
-        explicit perfmon_value_t(alt_cache_stats_t *_parent);
+        typedef uint64_t (alt::evicter_t::*getter_t)() const;
+        perfmon_value_t(alt_cache_stats_t *_parent, getter_t _getter);
         void *begin_stats();
         void visit_stats(void *);
         ql::datum_t end_stats(void *);
     private:
         alt_cache_stats_t *parent;
+        getter_t getter;
         DISABLE_COPYING(perfmon_value_t);
     };
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
 
+    // Cumulative hit counters for each of the evicter's in-memory bags, plus the
+    // misses and the misses on recently evicted blocks.
+    perfmon_value_t unevictable_hits;
+    perfmon_membership_t unevictable_hits_membership;
+    perfmon_value_t unbacked_hits;
+    perfmon_membership_t unbacked_hits_membership;
+    perfmon_value_t probationary_hits;
+    perfmon_membership_t probationary_hits_membership;
+    perfmon_value_t protected_hits;
+    perfmon_membership_t protected_hits_membership;
+    perfmon_value_t misses;
+    perfmon_membership_t misses_membership;
+    perfmon_value_t ghost_hits;
+    perfmon_membership_t ghost_hits_membership;
+
 
     perfmon_multi_membership_t cache_collection_membership;
 };
@@ -221,10 +221,18 @@ ifeq ($(NO_EPOLL),1)
   RT_CXXFLAGS += -DNO_EPOLL
 endif
 
+ifeq ($(NO_IO_URING),1)
+  RT_CXXFLAGS += -DNO_IO_URING
+endif
+
 ifeq ($(THREADED_COROUTINES),1)
   RT_CXXFLAGS += -DTHREADED_COROUTINES
 endif
 
+ifeq ($(CORO_STACK_HUGE_PAGES),1)
+  RT_CXXFLAGS += -DCORO_STACK_HUGE_PAGES
+endif
+
 ifeq ($(VALGRIND),1)
   ifneq (system,$(ALLOCATOR))
     $(error cannot build with VALGRIND=1 when using a custom allocator)
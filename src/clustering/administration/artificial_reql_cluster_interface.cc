@@ -63,15 +63,16 @@ bool artificial_reql_cluster_interface_t::db_config(
 bool artificial_reql_cluster_interface_t::table_create(
         const name_string_t &name, counted_t<const ql::db_t> db,
         const table_generate_config_params_t &config_params,
-        const std::string &primary_key, signal_t *interruptor,
+        const std::string &primary_key, uint32_t block_size,
+        const boost::optional<block_codec_t> &block_codec, signal_t *interruptor,
         ql::datum_t *result_out, std::string *error_out) {
     if (db->name == database) {
         *error_out = strprintf("Database `%s` is special; you can't create new tables "
             "in it.", database.c_str());
         return false;
     }
-    return next->table_create(name, db, config_params, primary_key,
-        interruptor, result_out, error_out);
+    return next->table_create(name, db, config_params, primary_key, block_size,
+        block_codec, interruptor, result_out, error_out);
 }
 
 bool artificial_reql_cluster_interface_t::table_drop(const name_string_t &name,
@@ -68,7 +68,9 @@ public:
 
     bool table_create(const name_string_t &name, counted_t<const ql::db_t> db,
             const table_generate_config_params_t &config_params,
-            const std::string &primary_key, signal_t *interruptor,
+            const std::string &primary_key, uint32_t block_size,
+            const boost::optional<block_codec_t> &block_codec,
+            signal_t *interruptor,
             ql::datum_t *result_out, std::string *error_out);
     bool table_drop(const name_string_t &name, counted_t<const ql::db_t> db,
             signal_t *interruptor, ql::datum_t *result_out, std::string *error_out);
@@ -18,6 +18,9 @@ const uuid_u jobs_manager_t::base_sindex_id =
 const uuid_u jobs_manager_t::base_disk_compaction_id =
     str_to_uuid("b8766ece-d15c-4f96-bee5-c0edacf10c9c");
 
+const uuid_u jobs_manager_t::base_disk_scrub_id =
+    str_to_uuid("3f0c7a52-86b1-4d3e-9c2f-5e1d8a6b4c97");
+
 const uuid_u jobs_manager_t::base_backfill_id =
     str_to_uuid("a5e1b38d-c712-42d7-ab4c-f177a3fb0d20");
 
@@ -121,6 +124,18 @@ void jobs_manager_t::on_get_job_reports(
             job_reports.emplace_back(id, "disk_compaction", -1);
         }
 
+        for (auto const &scrub : reactor_driver->get_scrub_progress()) {
+            uuid_u id = uuid_u::from_hash(
+                base_disk_scrub_id,
+                uuid_to_str(server_id) + uuid_to_str(scrub.first));
+
+            // Like `disk_compaction` jobs, `disk_scrub` jobs don't have a duration.
+            job_report_t job_report(id, "disk_scrub", -1, scrub.first);
+            job_report.progress_numerator = scrub.second;
+            job_report.progress_denominator = 1;
+            job_reports.push_back(std::move(job_report));
+        }
+
         for (auto const &report : reactor_driver->get_backfill_progress()) {
             // Only report the duration of backfills still in progress.
             double duration = report.second.is_ready
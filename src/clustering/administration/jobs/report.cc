@@ -120,6 +120,9 @@ bool job_report_t::to_datum(
             convert_string_to_datum(client_addr_port.ip().to_string()));
         info_builder.overwrite("client_port",
             convert_port_to_datum(client_addr_port.port().value()));
+    } else if (type == "disk_scrub") {
+        info_builder.overwrite("progress",
+            ql::datum_t(progress_numerator / progress_denominator));
     } else if (type == "backfill") {
         info_builder.overwrite("progress",
             ql::datum_t(progress_numerator / progress_denominator));
@@ -43,7 +43,7 @@ public:
             peer_id_t const &source_peer,
             server_id_t const &destination_server);
 
-    // For `"disk_compation"` and `"index_construction"` jobs
+    // For `"disk_compation"`, `"disk_scrub"`, and `"index_construction"` jobs
     job_report_t(
             uuid_u const &id,
             std::string const &type,
@@ -26,6 +26,7 @@
 
 #include "arch/io/disk.hpp"
 #include "arch/os_signal.hpp"
+#include "arch/runtime/busy_poller.hpp"
 #include "arch/runtime/starter.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "clustering/administration/main/cache_size.hpp"
@@ -930,6 +931,37 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--block-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--block-compression none|zlib-fast|zlib-best", "how to compress the data "
+             "blocks that get written to the files of tables that weren't created with "
+             "a block_compression of their own");
+    options_out->push_back(options::option_t(options::names_t("--group-commit-window"),
+                                             options::OPTIONAL,
+                                             strprintf("%d", MERGER_SERIALIZER_DEFAULT_GROUP_COMMIT_WINDOW_MS)));
+    help.add("--group-commit-window ms", "how long a table file may hold a commit back "
+             "so that concurrent writes can share it (0 commits right away)");
+    return help;
+}
+
+options::help_section_t get_storage_tier_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Storage tier options");
+    options_out->push_back(options::option_t(options::names_t("--storage-tier"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--storage-tier name=path", "add a directory that table files can be "
+             "stored in besides the data directory");
+    options_out->push_back(options::option_t(options::names_t("--table-placement"),
+                                             options::OPTIONAL,
+                                             "default"));
+    help.add("--table-placement default|spread", "put the files of new tables into "
+             "the data directory, or spread them over the data directory and all "
+             "storage tiers");
+    options_out->push_back(options::option_t(options::names_t("--table-tier"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--table-tier table_id=name", "keep the file of the table with the given "
+             "UUID in the given storage tier (\"default\" is the data directory), "
+             "moving it there when the table is opened");
     return help;
 }
 
@@ -984,6 +1016,72 @@ std::set<name_string_t> parse_server_tag_options(
     return server_tag_names;
 }
 
+// Splits a `name=value` option value.
+std::pair<std::string, std::string> split_assignment_option(const std::string &source,
+                                                            const std::string &option_name,
+                                                            const std::string &value) {
+    const size_t pos = value.find('=');
+    if (pos == std::string::npos) {
+        throw options::value_error_t(source, option_name,
+                                     strprintf("Expected name=value, got '%s'",
+                                               value.c_str()));
+    }
+    return std::make_pair(value.substr(0, pos), value.substr(pos + 1));
+}
+
+storage_tiers_t parse_storage_tier_options(
+        const std::map<std::string, options::values_t> &opts) {
+    storage_tiers_t storage_tiers;
+
+    std::string source;
+    for (const std::string &tier : all_options(opts, "--storage-tier", &source)) {
+        std::pair<std::string, std::string> name_and_path
+            = split_assignment_option(source, "--storage-tier", tier);
+        storage_tiers.add_tier(name_and_path.first,
+                               base_path_t(name_and_path.second));
+    }
+
+    const std::string placement = get_single_option(opts, "--table-placement", &source);
+    if (placement == "default") {
+        storage_tiers.set_placement(storage_tiers_t::placement_t::data_directory);
+    } else if (placement == "spread") {
+        storage_tiers.set_placement(storage_tiers_t::placement_t::spread);
+    } else {
+        throw options::value_error_t(source, "--table-placement",
+                                     strprintf("Expected 'default' or 'spread', got '%s'",
+                                               placement.c_str()));
+    }
+
+    for (const std::string &table : all_options(opts, "--table-tier", &source)) {
+        std::pair<std::string, std::string> id_and_tier
+            = split_assignment_option(source, "--table-tier", table);
+        namespace_id_t table_id;
+        if (!str_to_uuid(id_and_tier.first, &table_id)) {
+            throw options::value_error_t(source, "--table-tier",
+                                         strprintf("Invalid table UUID '%s'",
+                                                   id_and_tier.first.c_str()));
+        }
+        storage_tiers.assign_table(table_id, id_and_tier.second);
+    }
+    return storage_tiers;
+}
+
+// Locks the directories of the storage tiers like the data directory, and clears out
+// their temporary directories.  The data directory must be locked already.
+void lock_storage_tiers(const storage_tiers_t &storage_tiers,
+                        const base_path_t &base_path,
+                        std::vector<scoped_ptr_t<directory_lock_t> > *locks_out) {
+    const std::vector<base_path_t> directories = storage_tiers.all_directories(base_path);
+    // The first one is the data directory.
+    for (size_t i = 1; i < directories.size(); ++i) {
+        bool is_new_directory = false;
+        locks_out->push_back(make_scoped<directory_lock_t>(directories[i], false,
+                                                           &is_new_directory));
+        guarantee(!is_new_directory);
+        recreate_temporary_directory(directories[i]);
+    }
+}
+
 std::string get_reql_http_proxy_option(const std::map<std::string, options::values_t> &opts) {
     std::string source;
     boost::optional<std::string> proxy = get_optional_option(opts, "--reql-http-proxy", &source);
@@ -1104,6 +1202,11 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--busy-poll"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--busy-poll usecs", "how long each thread keeps looking for work before "
+             "it goes to sleep; trades CPU time for lower latency (default 0, off)");
     return help;
 }
 
@@ -1118,6 +1221,17 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+MUST_USE bool parse_busy_poll_option(const std::map<std::string, options::values_t> &opts) {
+    int busy_poll_us = get_single_int(opts, "--busy-poll");
+    if (busy_poll_us < 0 || busy_poll_us > MAX_BUSY_POLL_LIMIT_US) {
+        fprintf(stderr, "ERROR: busy-poll must be between 0 and %d\n",
+                MAX_BUSY_POLL_LIMIT_US);
+        return false;
+    }
+    set_busy_poll_limit(busy_poll_us);
+    return true;
+}
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -1165,6 +1279,7 @@ void get_rethinkdb_create_options(std::vector<options::help_section_t> *help_out
 void get_rethinkdb_serve_options(std::vector<options::help_section_t> *help_out,
                                  std::vector<options::option_t> *options_out) {
     help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_storage_tier_options(options_out));
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
@@ -1189,6 +1304,7 @@ void get_rethinkdb_proxy_options(std::vector<options::help_section_t> *help_out,
 void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_out,
                                      std::vector<options::option_t> *options_out) {
     help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_storage_tier_options(options_out));
     help_out->push_back(get_server_options(options_out));
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
@@ -1283,6 +1399,36 @@ file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, op
         file_direct_io_mode_t::buffered_desired;
 }
 
+log_serializer_dynamic_config_t parse_table_serializer_options(
+        const std::map<std::string, options::values_t> &opts) {
+    log_serializer_dynamic_config_t config;
+
+    std::string source;
+    const std::string codec = get_single_option(opts, "--block-compression", &source);
+    if (!block_codec_from_name(codec, &config.block_codec)) {
+        throw options::value_error_t(source, "--block-compression",
+                                     strprintf("Expected 'none', 'zlib-fast' or "
+                                               "'zlib-best', got '%s'", codec.c_str()));
+    }
+    return config;
+}
+
+int64_t parse_group_commit_window_option(
+        const std::map<std::string, options::values_t> &opts) {
+    std::string source;
+    const std::string window_str = get_single_option(opts, "--group-commit-window", &source);
+    int64_t window_ms;
+    if (!strtoi64_strict(window_str, 10, &window_ms)
+        || window_ms < 0 || window_ms > MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS) {
+        throw options::value_error_t(source, "--group-commit-window",
+                                     strprintf("Expected a number of milliseconds "
+                                               "between 0 and %d, got '%s'",
+                                               MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS,
+                                               window_str.c_str()));
+    }
+    return window_ms;
+}
+
 int main_rethinkdb_create(int argc, char *argv[]) {
     std::vector<options::option_t> options;
     std::vector<options::help_section_t> help;
@@ -1422,6 +1568,10 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        if (!parse_busy_poll_option(opts)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1442,6 +1592,13 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         base_path.make_absolute();
         initialize_logfile(opts, base_path);
 
+        // Relative tier paths are relative to where we were started, so this has to
+        // happen before daemonizing changes the working directory.
+        storage_tiers_t storage_tiers = parse_storage_tier_options(opts);
+        std::vector<scoped_ptr_t<directory_lock_t> > storage_tier_locks;
+        lock_storage_tiers(storage_tiers, base_path, &storage_tier_locks);
+        storage_tiers.check_for_duplicate_table_files(base_path);
+
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
         }
@@ -1463,7 +1620,10 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 do_update_checking,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                std::move(storage_tiers),
+                                parse_table_serializer_options(opts),
+                                parse_group_commit_window_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -1546,7 +1706,10 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 update_check_t::do_not_perform,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                storage_tiers_t(),
+                                log_serializer_dynamic_config_t(),
+                                MERGER_SERIALIZER_DEFAULT_GROUP_COMMIT_WINDOW_MS);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_proxy, &serve_info, &result),
@@ -1652,6 +1815,10 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        if (!parse_busy_poll_option(opts)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1689,6 +1856,13 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         boost::optional<boost::optional<uint64_t> > total_cache_size =
             parse_total_cache_size_option(opts);
 
+        // Relative tier paths are relative to where we were started, so this has to
+        // happen before daemonizing changes the working directory.
+        storage_tiers_t storage_tiers = parse_storage_tier_options(opts);
+        std::vector<scoped_ptr_t<directory_lock_t> > storage_tier_locks;
+        lock_storage_tiers(storage_tiers, base_path, &storage_tier_locks);
+        storage_tiers.check_for_duplicate_table_files(base_path);
+
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
         }
@@ -1713,7 +1887,10 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 do_update_checking,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                std::move(storage_tiers),
+                                parse_table_serializer_options(opts),
+                                parse_group_commit_window_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
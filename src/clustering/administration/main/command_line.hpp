@@ -2,6 +2,13 @@
 #ifndef CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_
 #define CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include "clustering/administration/main/options.hpp"
+#include "clustering/administration/main/storage_tiers.hpp"
+
 void print_version_message();
 
 int main_rethinkdb_create(int argc, char *argv[]);
@@ -24,4 +31,9 @@ void help_rethinkdb_dump();
 void help_rethinkdb_restore();
 void help_rethinkdb_index_rebuild();
 
+// These are only exposed for the unittests.
+options::help_section_t get_storage_tier_options(std::vector<options::option_t> *options_out);
+storage_tiers_t parse_storage_tier_options(
+        const std::map<std::string, options::values_t> &opts);
+
 #endif /* CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_ */
@@ -4,12 +4,15 @@
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "arch/runtime/thread_pool.hpp"
+#include "buffer_cache/cache_warmer.hpp"
 #include "clustering/immediate_consistency/branch/multistore.hpp"
 #include "clustering/reactor/reactor.hpp"
 #include "rdb_protocol/store.hpp"
 #include "serializer/config.hpp"
 #include "serializer/translator.hpp"
 #include "serializer/merger.hpp"
+#include "logger.hpp"
 #include "utils.hpp"
 
 /* This object serves mostly as a container for arguments to the
@@ -23,11 +26,13 @@ struct store_args_t {
                  perfmon_collection_t *_serializers_perfmon_collection,
                  rdb_context_t *_ctx,
                  outdated_index_issue_tracker_t *_outdated_index_tracker,
-                 namespace_id_t _ns_id)
+                 namespace_id_t _ns_id,
+                 const std::string &_serializer_path)
         : io_backender(_io_backender), base_path(_base_path),
           namespace_id(_namespace_id), balancer(_balancer),
           serializers_perfmon_collection(_serializers_perfmon_collection),
-          ctx(_ctx), outdated_index_tracker(_outdated_index_tracker), ns_id(_ns_id)
+          ctx(_ctx), outdated_index_tracker(_outdated_index_tracker), ns_id(_ns_id),
+          serializer_path(_serializer_path)
     { }
 
     io_backender_t *io_backender;
@@ -38,12 +43,20 @@ struct store_args_t {
     rdb_context_t *ctx;
     outdated_index_issue_tracker_t *outdated_index_tracker;
     namespace_id_t ns_id;
+    std::string serializer_path;
 };
 
 std::string hash_shard_perfmon_name(int hash_shard_number) {
     return strprintf("shard_%d", hash_shard_number);
 }
 
+// The file that the cache warmer of the given hash shard keeps its list of hot
+// blocks in.
+std::string cache_warm_list_path(const std::string &serializer_path,
+                                 int hash_shard_number) {
+    return strprintf("%s.warm_%d", serializer_path.c_str(), hash_shard_number);
+}
+
 void do_construct_existing_store(
     const std::vector<threadnum_t> &threads,
     int thread_offset,
@@ -71,6 +84,9 @@ void do_construct_existing_store(
         index_report, store_args.ns_id);
     (*stores_out_stores)[thread_offset].init(store);
     store_views[thread_offset] = store;
+    store->start_cache_warming(
+        cache_warm_list_path(store_args.serializer_path, thread_offset),
+        multiplexer->creation_timestamp);
 }
 
 void do_create_new_store(
@@ -97,12 +113,17 @@ void do_create_new_store(
         index_report, store_args.ns_id);
     (*stores_out_stores)[thread_offset].init(store);
     store_views[thread_offset] = store;
+    store->start_cache_warming(
+        cache_warm_list_path(store_args.serializer_path, thread_offset),
+        multiplexer->creation_timestamp);
 }
 
 void
 file_based_svs_by_namespace_t::get_svs(
             perfmon_collection_t *serializers_perfmon_collection,
             namespace_id_t namespace_id,
+            uint32_t block_size,
+            const boost::optional<block_codec_t> &block_codec,
             stores_lifetimer_t *stores_out,
             scoped_ptr_t<multistore_ptr_t> *svs_out,
             rdb_context_t *ctx) {
@@ -118,6 +139,12 @@ file_based_svs_by_namespace_t::get_svs(
     // TODO: We should use N slices on M serializers, not N slices
     // on N serializers.
 
+    // The table's own codec wins over the server's.
+    log_serializer_dynamic_config_t serializer_config = serializer_config_;
+    if (block_codec) {
+        serializer_config.block_codec = *block_codec;
+    }
+
     const int num_stores = CPU_SHARDING_FACTOR;
     scoped_array_t<scoped_ptr_t<store_t> > *stores_out_stores
         = stores_out->stores();
@@ -136,12 +163,14 @@ file_based_svs_by_namespace_t::get_svs(
         on_thread_t th(serializer_thread);
         scoped_array_t<store_view_t *> store_views(num_stores);
 
+        move_to_assigned_tier(namespace_id);
         const serializer_filepath_t serializer_filepath = file_name_for(namespace_id);
         int res = access(serializer_filepath.permanent_path().c_str(), R_OK | W_OK);
         store_args_t store_args(io_backender_, base_path_,
                                 namespace_id, balancer_,
                                 serializers_perfmon_collection, ctx,
-                                &outdated_index_tracker, namespace_id);
+                                &outdated_index_tracker, namespace_id,
+                                serializer_filepath.permanent_path());
         filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
         if (res == 0) {
             // TODO: Could we handle failure when loading the serializer?  Right
@@ -150,11 +179,15 @@ file_based_svs_by_namespace_t::get_svs(
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
-                ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                ser = make_scoped<merger_serializer_t>(
+                    std::move(ser),
+                    MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                    MERGER_SERIALIZER_MAX_ACTIVE_BLOCK_WRITES,
+                    group_commit_window_ms_,
+                    serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
@@ -171,16 +204,23 @@ file_based_svs_by_namespace_t::get_svs(
                                          stores_out_stores, store_views.data()));
             mptr.init(new multistore_ptr_t(store_views.data(), num_stores));
         } else {
-            standard_serializer_t::create(&file_opener,
-                                          standard_serializer_t::static_config_t());
+            standard_serializer_t::static_config_t static_config;
+            if (block_size != 0) {
+                static_config.block_size_ = block_size;
+            }
+            standard_serializer_t::create(&file_opener, static_config);
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
-                ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                ser = make_scoped<merger_serializer_t>(
+                    std::move(ser),
+                    MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                    MERGER_SERIALIZER_MAX_ACTIVE_BLOCK_WRITES,
+                    group_commit_window_ms_,
+                    serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
@@ -227,14 +267,102 @@ file_based_svs_by_namespace_t::get_svs(
 void file_based_svs_by_namespace_t::destroy_svs(namespace_id_t namespace_id) {
     // TODO: Handle errors?  It seems like we can't really handle the error so
     // let's just ignore it?
-    const std::string filepath = file_name_for(namespace_id).permanent_path();
-    const int res = ::unlink(filepath.c_str());
-    guarantee_err(res == 0 || get_errno() == ENOENT,
-                  "unlink failed for file %s", filepath.c_str());
+    // We look in all the storage tiers, in case moving the file between them left a
+    // copy behind.
+    for (const base_path_t &directory : storage_tiers_.all_directories(base_path_)) {
+        const std::string filepath
+            = serializer_filepath_t(directory, uuid_to_str(namespace_id)).permanent_path();
+        const int res = ::unlink(filepath.c_str());
+        guarantee_err(res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", filepath.c_str());
+        for (int i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+            cache_warmer_t::remove_file(cache_warm_list_path(filepath, i));
+        }
+    }
 }
 
 serializer_filepath_t file_based_svs_by_namespace_t::file_name_for(namespace_id_t namespace_id) {
-    return serializer_filepath_t(base_path_, uuid_to_str(namespace_id));
+    const std::string file_name = uuid_to_str(namespace_id);
+    if (boost::optional<base_path_t> assigned
+            = storage_tiers_.assigned_directory(namespace_id, base_path_)) {
+        const serializer_filepath_t filepath(*assigned, file_name);
+        if (access(filepath.permanent_path().c_str(), F_OK) == 0) {
+            return filepath;
+        }
+    }
+    // If the file couldn't be moved into its assigned tier, we keep using it where
+    // it is, rather than creating a new table file.
+    if (boost::optional<base_path_t> existing = existing_file_directory(namespace_id)) {
+        return serializer_filepath_t(*existing, file_name);
+    }
+    return serializer_filepath_t(
+        storage_tiers_.new_table_directory(namespace_id, base_path_), file_name);
+}
+
+boost::optional<base_path_t>
+file_based_svs_by_namespace_t::existing_file_directory(namespace_id_t namespace_id) {
+    for (const base_path_t &directory : storage_tiers_.all_directories(base_path_)) {
+        const serializer_filepath_t filepath(directory, uuid_to_str(namespace_id));
+        if (access(filepath.permanent_path().c_str(), F_OK) == 0) {
+            return directory;
+        }
+    }
+    return boost::none;
+}
+
+void file_based_svs_by_namespace_t::move_to_assigned_tier(namespace_id_t namespace_id) {
+    boost::optional<base_path_t> assigned
+        = storage_tiers_.assigned_directory(namespace_id, base_path_);
+    if (!assigned) {
+        return;
+    }
+    const serializer_filepath_t target(*assigned, uuid_to_str(namespace_id));
+    if (access(target.permanent_path().c_str(), F_OK) == 0) {
+        return;
+    }
+    boost::optional<base_path_t> existing = existing_file_directory(namespace_id);
+    if (!existing) {
+        return;
+    }
+
+    const std::string source
+        = serializer_filepath_t(*existing, uuid_to_str(namespace_id)).permanent_path();
+    logNTC("Moving the file of table %s from '%s' to '%s'.\n",
+           uuid_to_str(namespace_id).c_str(), source.c_str(),
+           target.permanent_path().c_str());
+    move_file_result_t result = move_file_result_t::failed;
+    std::string error;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        result = move_file_blocking(source, target.permanent_path(),
+                                    target.temporary_path(), &error);
+    });
+    switch (result) {
+    case move_file_result_t::moved:
+        break;
+    case move_file_result_t::original_remains:
+        // The table uses the new file from now on.  The server won't start again
+        // while the old one is still around, because we couldn't tell them apart.
+        logERR("Moved the file of table %s to its storage tier, but the original "
+               "is still there: %s\nRemove '%s' before restarting the server.\n",
+               uuid_to_str(namespace_id).c_str(), error.c_str(), source.c_str());
+        break;
+    case move_file_result_t::failed:
+        logERR("Failed to move the file of table %s to its storage tier: %s\n",
+               uuid_to_str(namespace_id).c_str(), error.c_str());
+        return;
+    default:
+        unreachable();
+    }
+
+    // The lists of hot blocks refer to the old file's blocks, which are the same in
+    // the new one, so they move along.
+    for (int i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        const std::string warm_list = cache_warm_list_path(source, i);
+        if (rename(warm_list.c_str(), cache_warm_list_path(target.permanent_path(),
+                                                           i).c_str()) != 0) {
+            cache_warmer_t::remove_file(warm_list);
+        }
+    }
 }
 
 threadnum_t file_based_svs_by_namespace_t::next_thread(int num_db_threads) {
@@ -6,6 +6,8 @@
 
 #include "clustering/administration/reactor_driver.hpp"
 #include "clustering/administration/issues/outdated_index.hpp"
+#include "clustering/administration/main/storage_tiers.hpp"
+#include "serializer/log/config.hpp"
 
 class cache_balancer_t;
 class rdb_context_t;
@@ -15,13 +17,20 @@ public:
     file_based_svs_by_namespace_t(io_backender_t *io_backender,
                                   cache_balancer_t *balancer,
                                   const base_path_t& base_path,
+                                  const storage_tiers_t &storage_tiers,
+                                  const log_serializer_dynamic_config_t &serializer_config,
+                                  int64_t group_commit_window_ms,
                                   local_issue_aggregator_t *local_issue_aggregator)
         : io_backender_(io_backender), balancer_(balancer),
-          base_path_(base_path), thread_counter_(0),
+          base_path_(base_path), storage_tiers_(storage_tiers),
+          serializer_config_(serializer_config),
+          group_commit_window_ms_(group_commit_window_ms), thread_counter_(0),
           outdated_index_tracker(local_issue_aggregator) { }
 
     void get_svs(perfmon_collection_t *serializers_perfmon_collection,
                  namespace_id_t namespace_id,
+                 uint32_t block_size,
+                 const boost::optional<block_codec_t> &block_codec,
                  stores_lifetimer_t *stores_out,
                  scoped_ptr_t<multistore_ptr_t> *svs_out,
                  rdb_context_t *);
@@ -31,9 +40,19 @@ public:
     serializer_filepath_t file_name_for(namespace_id_t namespace_id);
 
 private:
+    // The directory that already has the table's file, if any.  There is only ever
+    // one, `storage_tiers_t::check_for_duplicate_table_files` saw to that at startup.
+    boost::optional<base_path_t> existing_file_directory(namespace_id_t namespace_id);
+    // Moves the table's file into the storage tier it's assigned to, if it isn't
+    // there yet.
+    void move_to_assigned_tier(namespace_id_t namespace_id);
+
     io_backender_t *io_backender_;
     cache_balancer_t *balancer_;
     const base_path_t base_path_;
+    const storage_tiers_t storage_tiers_;
+    const log_serializer_dynamic_config_t serializer_config_;
+    const int64_t group_commit_window_ms_;
 
     threadnum_t next_thread(int num_db_threads);
     int thread_counter_; // should only be used by `next_thread`
@@ -331,7 +331,8 @@ bool do_serve(io_backender_t *io_backender,
             if (i_am_a_server) {
                 rdb_svs_source.init(new file_based_svs_by_namespace_t(
                     io_backender, cache_balancer.get(), base_path,
-                    &local_issue_aggregator));
+                    serve_info.storage_tiers, serve_info.table_serializer_config,
+                    serve_info.group_commit_window_ms, &local_issue_aggregator));
                 rdb_reactor_driver.init(new reactor_driver_t(
                         base_path,
                         io_backender,
@@ -9,7 +9,9 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist.hpp"
+#include "clustering/administration/main/storage_tiers.hpp"
 #include "clustering/administration/main/version_check.hpp"
+#include "serializer/log/config.hpp"
 #include "arch/address.hpp"
 
 class os_signal_cond_t;
@@ -95,14 +97,20 @@ public:
                  update_check_t _do_version_checking,
                  service_address_ports_t _ports,
                  boost::optional<std::string> _config_file,
-                 std::vector<std::string> &&_argv) :
+                 std::vector<std::string> &&_argv,
+                 storage_tiers_t &&_storage_tiers,
+                 const log_serializer_dynamic_config_t &_table_serializer_config,
+                 int64_t _group_commit_window_ms) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
         do_version_checking(_do_version_checking),
         ports(_ports),
         config_file(_config_file),
-        argv(std::move(_argv))
+        argv(std::move(_argv)),
+        storage_tiers(std::move(_storage_tiers)),
+        table_serializer_config(_table_serializer_config),
+        group_commit_window_ms(_group_commit_window_ms)
     { }
 
     void look_up_peers() {
@@ -119,6 +127,12 @@ public:
     /* The original arguments, so we can display them in `server_status`. All the
     argument parsing has already been completed at this point. */
     std::vector<std::string> argv;
+    /* Where table files go, besides the data directory. */
+    storage_tiers_t storage_tiers;
+    /* How the serializers of table files get set up. */
+    log_serializer_dynamic_config_t table_serializer_config;
+    /* How long table files wait for concurrent index writes to join a commit. */
+    int64_t group_commit_window_ms;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -0,0 +1,252 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "clustering/administration/main/storage_tiers.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/io/io_utils.hpp"
+#include "containers/scoped.hpp"
+
+const char *const storage_tiers_t::DEFAULT_TIER_NAME = "default";
+
+// How much of a table file we copy at a time when moving it between file systems.
+const size_t MOVE_FILE_CHUNK_SIZE = 1024 * 1024;
+
+storage_tiers_t::storage_tiers_t() : placement_(placement_t::data_directory) { }
+
+void storage_tiers_t::add_tier(const std::string &name, const base_path_t &path) {
+    if (name.empty() || name == DEFAULT_TIER_NAME) {
+        throw std::runtime_error(strprintf("Invalid storage tier name '%s'.",
+                                           name.c_str()));
+    }
+    for (const auto &tier : tiers_) {
+        if (tier.first == name) {
+            throw std::runtime_error(strprintf("Storage tier '%s' was given twice.",
+                                               name.c_str()));
+        }
+    }
+
+    struct stat st;
+    if (stat(path.path().c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        throw std::runtime_error(strprintf("The directory '%s' of storage tier '%s' "
+                                           "does not exist.",
+                                           path.path().c_str(), name.c_str()));
+    }
+
+    base_path_t absolute_path = path;
+    absolute_path.make_absolute();
+    tiers_.push_back(std::make_pair(name, absolute_path));
+}
+
+void storage_tiers_t::assign_table(namespace_id_t table_id,
+                                   const std::string &tier_name) {
+    bool found = tier_name == DEFAULT_TIER_NAME;
+    for (const auto &tier : tiers_) {
+        found = found || tier.first == tier_name;
+    }
+    if (!found) {
+        throw std::runtime_error(strprintf("Table %s is assigned to the unknown "
+                                           "storage tier '%s'.",
+                                           uuid_to_str(table_id).c_str(),
+                                           tier_name.c_str()));
+    }
+    assigned_tiers_[table_id] = tier_name;
+}
+
+std::vector<base_path_t> storage_tiers_t::all_directories(
+        const base_path_t &data_directory) const {
+    std::vector<base_path_t> ret;
+    ret.push_back(data_directory);
+    for (const auto &tier : tiers_) {
+        ret.push_back(tier.second);
+    }
+    return ret;
+}
+
+boost::optional<base_path_t> storage_tiers_t::assigned_directory(
+        namespace_id_t table_id, const base_path_t &data_directory) const {
+    auto it = assigned_tiers_.find(table_id);
+    if (it == assigned_tiers_.end()) {
+        return boost::none;
+    }
+    return tier_path(it->second, data_directory);
+}
+
+base_path_t storage_tiers_t::new_table_directory(
+        namespace_id_t table_id, const base_path_t &data_directory) const {
+    if (boost::optional<base_path_t> assigned
+            = assigned_directory(table_id, data_directory)) {
+        return *assigned;
+    }
+    if (placement_ == placement_t::data_directory || tiers_.empty()) {
+        return data_directory;
+    }
+
+    // Spread the tables evenly over the data directory and the tiers, in a way that
+    // doesn't depend on the order in which they get created.
+    uint64_t hash = 0;
+    for (const uint8_t *p = table_id.data(); p < table_id.data() + table_id.static_size();
+         ++p) {
+        hash = hash * 31 + *p;
+    }
+    const size_t index = hash % (tiers_.size() + 1);
+    return index == 0 ? data_directory : tiers_[index - 1].second;
+}
+
+base_path_t storage_tiers_t::tier_path(const std::string &name,
+                                       const base_path_t &data_directory) const {
+    for (const auto &tier : tiers_) {
+        if (tier.first == name) {
+            return tier.second;
+        }
+    }
+    guarantee(name == DEFAULT_TIER_NAME);
+    return data_directory;
+}
+
+void storage_tiers_t::check_for_duplicate_table_files(
+        const base_path_t &data_directory) const {
+    // The file names of the tables we've seen, and where we saw them.
+    std::map<std::string, std::string> seen;
+    for (const base_path_t &directory : all_directories(data_directory)) {
+        DIR *dp = opendir(directory.path().c_str());
+        if (dp == NULL) {
+            throw std::runtime_error(strprintf("Could not read directory '%s': %s",
+                                               directory.path().c_str(),
+                                               errno_string(get_errno()).c_str()));
+        }
+        std::vector<std::string> names;
+        struct dirent *ep;
+        // See `check_dir_emptiness` about readdir.
+        while ((ep = readdir(dp)) != NULL) {  // NOLINT(runtime/threadsafe_fn)
+            names.push_back(ep->d_name);
+        }
+        closedir(dp);
+
+        for (const std::string &name : names) {
+            namespace_id_t table_id;
+            if (!str_to_uuid(name, &table_id)) {
+                continue;
+            }
+            const std::string path
+                = serializer_filepath_t(directory, name).permanent_path();
+            auto res = seen.insert(std::make_pair(name, path));
+            if (!res.second) {
+                throw std::runtime_error(strprintf(
+                    "The file of table %s is both at '%s' and at '%s'.  Moving it "
+                    "between storage tiers must have failed to remove the original.  "
+                    "Remove the copy that is out of date, then start the server again.",
+                    name.c_str(), res.first->second.c_str(), path.c_str()));
+            }
+        }
+    }
+}
+
+bool copy_file_blocking(const std::string &from, const std::string &to,
+                        std::string *error_out) {
+    scoped_fd_t from_fd;
+    do {
+        from_fd.reset(open(from.c_str(), O_RDONLY));
+    } while (from_fd.get() == INVALID_FD && get_errno() == EINTR);
+    if (from_fd.get() == INVALID_FD) {
+        *error_out = strprintf("Could not open '%s': %s", from.c_str(),
+                               errno_string(get_errno()).c_str());
+        return false;
+    }
+
+    scoped_fd_t to_fd;
+    do {
+        to_fd.reset(open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    } while (to_fd.get() == INVALID_FD && get_errno() == EINTR);
+    if (to_fd.get() == INVALID_FD) {
+        *error_out = strprintf("Could not create '%s': %s", to.c_str(),
+                               errno_string(get_errno()).c_str());
+        return false;
+    }
+
+    scoped_array_t<char> buf(MOVE_FILE_CHUNK_SIZE);
+    for (;;) {
+        ssize_t res;
+        do {
+            res = read(from_fd.get(), buf.data(), buf.size());
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == -1) {
+            *error_out = strprintf("Could not read '%s': %s", from.c_str(),
+                                   errno_string(get_errno()).c_str());
+            return false;
+        }
+        if (res == 0) {
+            break;
+        }
+
+        for (ssize_t written = 0; written < res;) {
+            ssize_t write_res;
+            do {
+                write_res = write(to_fd.get(), buf.data() + written, res - written);
+            } while (write_res == -1 && get_errno() == EINTR);
+            if (write_res == -1) {
+                *error_out = strprintf("Could not write '%s': %s", to.c_str(),
+                                       errno_string(get_errno()).c_str());
+                return false;
+            }
+            written += write_res;
+        }
+    }
+
+    if (fsync(to_fd.get()) != 0) {
+        *error_out = strprintf("Could not fsync '%s': %s", to.c_str(),
+                               errno_string(get_errno()).c_str());
+        return false;
+    }
+    return true;
+}
+
+move_file_result_t move_file_blocking(const std::string &from, const std::string &to,
+                                      const std::string &temporary_path,
+                                      std::string *error_out) {
+    if (rename(from.c_str(), to.c_str()) == 0) {
+        warn_fsync_parent_directory(to.c_str());
+        return move_file_result_t::moved;
+    }
+    if (get_errno() != EXDEV) {
+        *error_out = strprintf("Could not move '%s' to '%s': %s", from.c_str(),
+                               to.c_str(), errno_string(get_errno()).c_str());
+        return move_file_result_t::failed;
+    }
+    return copy_file_to_device_blocking(from, to, temporary_path, error_out);
+}
+
+move_file_result_t copy_file_to_device_blocking(const std::string &from,
+                                                const std::string &to,
+                                                const std::string &temporary_path,
+                                                std::string *error_out) {
+    // We copy the file to the temporary directory there first, so that a crash can't
+    // leave a partial copy behind in place of the file.
+    if (!copy_file_blocking(from, temporary_path, error_out)) {
+        unlink(temporary_path.c_str());
+        return move_file_result_t::failed;
+    }
+    if (rename(temporary_path.c_str(), to.c_str()) != 0) {
+        *error_out = strprintf("Could not move '%s' to '%s': %s",
+                               temporary_path.c_str(), to.c_str(),
+                               errno_string(get_errno()).c_str());
+        unlink(temporary_path.c_str());
+        return move_file_result_t::failed;
+    }
+    warn_fsync_parent_directory(to.c_str());
+
+    // From here on the file is at `to`, whether or not we get rid of the original.
+    if (unlink(from.c_str()) != 0) {
+        *error_out = strprintf("Could not remove '%s' after copying it to '%s': %s",
+                               from.c_str(), to.c_str(),
+                               errno_string(get_errno()).c_str());
+        return move_file_result_t::original_remains;
+    }
+    return move_file_result_t::moved;
+}
@@ -0,0 +1,84 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_MAIN_STORAGE_TIERS_HPP_
+#define CLUSTERING_ADMINISTRATION_MAIN_STORAGE_TIERS_HPP_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "containers/uuid.hpp"
+#include "utils.hpp"
+
+/* Besides the data directory, table files can be kept in any number of other
+directories, the storage tiers.  That lets a server spread the I/O of its tables over
+several devices, or keep some tables on cheaper disks.  The data directory itself is
+the tier named "default".
+
+A table's file stays in whatever tier it is in, unless the table is assigned to a
+tier explicitly.  Then the file gets moved into that tier the next time the table is
+opened.  New tables go into the data directory, or are spread over all the tiers. */
+class storage_tiers_t {
+public:
+    enum class placement_t { data_directory, spread };
+
+    static const char *const DEFAULT_TIER_NAME;
+
+    storage_tiers_t();
+
+    // These throw `std::runtime_error` if the arguments don't make sense.  Tiers
+    // must exist.  Their paths get made absolute, relative to the current working
+    // directory.
+    void add_tier(const std::string &name, const base_path_t &path);
+    void assign_table(namespace_id_t table_id, const std::string &tier_name);
+    void set_placement(placement_t placement) { placement_ = placement; }
+
+    // All the directories a table's file could be in, the data directory first.
+    std::vector<base_path_t> all_directories(const base_path_t &data_directory) const;
+
+    // The directory the table's file is assigned to explicitly, if it is.
+    boost::optional<base_path_t> assigned_directory(
+        namespace_id_t table_id, const base_path_t &data_directory) const;
+
+    // The directory a new table's file goes into.
+    base_path_t new_table_directory(namespace_id_t table_id,
+                                    const base_path_t &data_directory) const;
+
+    // Throws `std::runtime_error` if the file of some table is in more than one of
+    // the directories.  That happens when moving it between tiers couldn't remove the
+    // original, and we can't tell which copy is the right one.
+    void check_for_duplicate_table_files(const base_path_t &data_directory) const;
+
+private:
+    base_path_t tier_path(const std::string &name,
+                          const base_path_t &data_directory) const;
+
+    std::vector<std::pair<std::string, base_path_t> > tiers_;
+    std::map<namespace_id_t, std::string> assigned_tiers_;
+    placement_t placement_;
+};
+
+enum class move_file_result_t {
+    moved,
+    // The file is at its new place, but the original is still there as well.
+    original_remains,
+    failed
+};
+
+// Moves the file at `from` to `to`, copying it if they are on different file systems.
+// `temporary_path` must be on the same file system as `to`.  Sets `*error_out` unless
+// the result is `moved`.  Blocks the thread, not just the coroutine.
+move_file_result_t move_file_blocking(const std::string &from, const std::string &to,
+                                      const std::string &temporary_path,
+                                      std::string *error_out);
+
+// The part of `move_file_blocking` that copies the file to another file system.
+move_file_result_t copy_file_to_device_blocking(const std::string &from,
+                                                const std::string &to,
+                                                const std::string &temporary_path,
+                                                std::string *error_out);
+
+#endif  // CLUSTERING_ADMINISTRATION_MAIN_STORAGE_TIERS_HPP_
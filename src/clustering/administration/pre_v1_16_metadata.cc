@@ -249,6 +249,9 @@ namespace_semilattice_metadata_t migrate_table(
     new_md.name = migrate_vclock(old_md.name);
     new_md.database = migrate_vclock(old_md.database);
     new_md.primary_key = migrate_vclock(old_md.primary_key);
+    // Tables from before v1.16 all use the default block size.
+    new_md.block_size = versioned_t<uint32_t>(0);
+    new_md.block_codec = versioned_t<boost::optional<block_codec_t> >(boost::none);
 
     /* Extract the table and database name for error message purposes */
     name_string_t table_name = new_md.name.get_ref();
@@ -8,6 +8,7 @@
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "buffer_cache/alt.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/servers/server_id_to_peer_id.hpp"
@@ -15,6 +16,8 @@
 #include "clustering/reactor/blueprint.hpp"
 #include "clustering/reactor/reactor.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
+#include "concurrency/mutex.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/watchable.hpp"
 #include "containers/incremental_lenses.hpp"
 #include "rdb_protocol/store.hpp"
@@ -85,6 +88,28 @@ bool stores_lifetimer_t::is_gc_active() const {
     }
 }
 
+bool stores_lifetimer_t::get_scrub_progress(double *progress_out) const {
+    if (serializer_.has()) {
+        return serializer_->get_scrub_progress(progress_out);
+    } else {
+        return false;
+    }
+}
+
+void stores_lifetimer_t::set_cache_share(const cache_share_config_t &cache_share) {
+    if (!stores_.has()) {
+        return;
+    }
+    const double num_stores = stores_.size();
+    pmap(stores_.size(), [&](int64_t i) {
+        if (stores_[i].has()) {
+            on_thread_t th(stores_[i]->home_thread());
+            stores_[i]->cache->set_cache_share(cache_share.min / num_stores,
+                                               cache_share.max / num_stores);
+        }
+    });
+}
+
 stores_lifetimer_t::sindex_jobs_t stores_lifetimer_t::get_sindex_jobs() const {
     stores_lifetimer_t::sindex_jobs_t sindex_jobs;
 
@@ -232,6 +257,8 @@ public:
                             io_backender_t *io_backender,
                             reactor_driver_t *parent,
                             namespace_id_t namespace_id,
+                            uint32_t block_size,
+                            const boost::optional<block_codec_t> &block_codec,
                             const blueprint_t &blueprint,
                             const table_replication_info_t &repli_info,
                             const servers_semilattice_metadata_t &server_md,
@@ -243,11 +270,14 @@ public:
         ctx(_ctx),
         parent_(parent),
         namespace_id_(namespace_id),
+        block_size_(block_size),
+        block_codec_(block_codec),
         svs_by_namespace_(svs_by_namespace),
         write_ack_config_var(write_ack_config_checker_t(repli_info.config, server_md)),
         write_durability_var(repli_info.config.durability),
         write_ack_config_cross_threader(write_ack_config_var.get_watchable()),
-        write_durability_cross_threader(write_durability_var.get_watchable())
+        write_durability_cross_threader(write_durability_var.get_watchable()),
+        cache_share_(repli_info.config.cache_share)
     {
         coro_t::spawn_sometime(boost::bind(&watchable_and_reactor_t::initialize_reactor, this, io_backender));
     }
@@ -284,6 +314,11 @@ public:
         write_ack_config_var.set_value_no_equals(
             write_ack_config_checker_t(repli_info.config, server_md));
         write_durability_var.set_value(repli_info.config.durability);
+        if (!(cache_share_ == repli_info.config.cache_share)) {
+            cache_share_ = repli_info.config.cache_share;
+            coro_t::spawn_sometime(std::bind(&watchable_and_reactor_t::apply_cache_share,
+                                             this, drainer_.lock()));
+        }
     }
 
     bool is_acceptable_ack_set(const std::set<server_id_t> &acks) const {
@@ -303,6 +338,10 @@ public:
         return stores_lifetimer_.is_gc_active();
     }
 
+    bool get_scrub_progress(double *progress_out) const {
+        return stores_lifetimer_.get_scrub_progress(progress_out);
+    }
+
     stores_lifetimer_t::sindex_jobs_t get_sindex_jobs() const {
         return stores_lifetimer_.get_sindex_jobs();
     }
@@ -324,13 +363,22 @@ public:
     }
 
 private:
+    /* Tells the stores about the latest `cache_share_`. The mutex keeps an older value
+    from overwriting a newer one when this runs more than once at a time. */
+    void apply_cache_share(UNUSED auto_drainer_t::lock_t keepalive) {
+        mutex_t::acq_t acq(&cache_share_mutex_);
+        stores_lifetimer_.set_cache_share(cache_share_);
+    }
+
     void initialize_reactor(io_backender_t *io_backender) {
         perfmon_collection_repo_t::collections_t *perfmon_collections = parent_->perfmon_collection_repo->get_perfmon_collections_for_namespace(namespace_id_);
         perfmon_collection_t *namespace_collection = &perfmon_collections->namespace_collection;
         perfmon_collection_t *serializers_collection = &perfmon_collections->serializers_collection;
 
         // TODO: We probably shouldn't have to pass in this perfmon collection.
-        svs_by_namespace_->get_svs(serializers_collection, namespace_id_, &stores_lifetimer_, &svs_, ctx);
+        svs_by_namespace_->get_svs(serializers_collection, namespace_id_, block_size_,
+                                   block_codec_, &stores_lifetimer_, &svs_, ctx);
+        apply_cache_share(drainer_.lock());
 
         reactor_.init(new reactor_t(
             base_path,
@@ -366,6 +414,10 @@ private:
 
     reactor_driver_t *const parent_;
     const namespace_id_t namespace_id_;
+    // The block size to create the table's files with, or 0 for the default.
+    const uint32_t block_size_;
+    // How to compress the table's blocks, or `boost::none` for the server's default.
+    const boost::optional<block_codec_t> block_codec_;
     svs_by_namespace_t *const svs_by_namespace_;
 
     watchable_variable_t<write_ack_config_checker_t> write_ack_config_var;
@@ -382,6 +434,11 @@ private:
     scoped_ptr_t<watchable_map_entry_copier_t<
         namespace_id_t, namespace_directory_metadata_t> > directory_exporter_;
 
+    cache_share_config_t cache_share_;
+    mutex_t cache_share_mutex_;
+    /* Destroyed first, so that `apply_cache_share()` can still reach the stores. */
+    auto_drainer_t drainer_;
+
     DISABLE_COPYING(watchable_and_reactor_t);
 };
 
@@ -453,6 +510,21 @@ bool reactor_driver_t::is_gc_active() {
     return false;
 }
 
+reactor_driver_t::scrub_progress_t reactor_driver_t::get_scrub_progress() {
+    rwlock_acq_t lock(&reactor_data_rwlock, access_t::read);
+
+    reactor_driver_t::scrub_progress_t scrub_progress;
+
+    for (auto const &reactor : reactor_data) {
+        double progress;
+        if (reactor.second.has() && reactor.second->get_scrub_progress(&progress)) {
+            scrub_progress.insert(std::make_pair(reactor.first, progress));
+        }
+    }
+
+    return scrub_progress;
+}
+
 reactor_driver_t::sindex_jobs_t reactor_driver_t::get_sindex_jobs() {
     rwlock_acq_t lock(&reactor_data_rwlock, access_t::read);
 
@@ -557,7 +629,9 @@ void reactor_driver_t::on_change() {
                     namespace_id_t tmp = it->first;
                     reactor_data.insert(std::make_pair(tmp,
                         make_scoped<watchable_and_reactor_t>(
-                            base_path, io_backender, this, it->first, bp,
+                            base_path, io_backender, this, it->first,
+                            it->second.get_ref().block_size.get_ref(),
+                            it->second.get_ref().block_codec.get_ref(), bp,
                             *repli_info, md.servers, svs_by_namespace, ctx)));
                 } else {
                     reactor_data.find(it->first)->second->update_repli_info(
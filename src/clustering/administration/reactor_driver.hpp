@@ -66,6 +66,11 @@ public:
     scoped_array_t<scoped_ptr_t<store_t> > *stores() { return &stores_; }
 
     bool is_gc_active() const;
+    bool get_scrub_progress(double *progress_out) const;
+
+    /* Bounds the share of the server's cache that the stores get, splitting
+    `cache_share` evenly between them. Blocks while it visits each store's thread. */
+    void set_cache_share(const cache_share_config_t &cache_share);
 
     typedef std::multimap<std::pair<uuid_u, std::string>, microtime_t> sindex_jobs_t;
     sindex_jobs_t get_sindex_jobs() const;
@@ -80,7 +85,12 @@ private:
 
 class svs_by_namespace_t {
 public:
+    /* `block_size` is the block size to create the table's files with if they don't
+    exist yet, or 0 for the default.  `block_codec` is how to compress the blocks that
+    get written to them, or `boost::none` for the server's default. */
     virtual void get_svs(perfmon_collection_t *perfmon_collection, namespace_id_t namespace_id,
+                         uint32_t block_size,
+                         const boost::optional<block_codec_t> &block_codec,
                          stores_lifetimer_t *stores_out,
                          scoped_ptr_t<multistore_ptr_t> *svs_out,
                          rdb_context_t *) = 0;
@@ -120,6 +130,10 @@ public:
 
     bool is_gc_active();
 
+    // The progress of the scrubbers that are running, by table.
+    typedef std::map<namespace_id_t, double> scrub_progress_t;
+    scrub_progress_t get_scrub_progress();
+
     typedef std::multimap<std::pair<uuid_u, std::string>, microtime_t> sindex_jobs_t;
     sindex_jobs_t get_sindex_jobs();
 
@@ -193,6 +193,8 @@ bool real_reql_cluster_interface_t::table_create(const name_string_t &name,
         counted_t<const ql::db_t> db,
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
+        uint32_t block_size,
+        const boost::optional<block_codec_t> &block_codec,
         signal_t *interruptor, ql::datum_t *result_out, std::string *error_out) {
     guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
         "real_reql_cluster_interface_t should never get queries for system tables");
@@ -252,6 +254,9 @@ bool real_reql_cluster_interface_t::table_create(const name_string_t &name,
         table_metadata.name = versioned_t<name_string_t>(name);
         table_metadata.database = versioned_t<database_id_t>(db->id);
         table_metadata.primary_key = versioned_t<std::string>(primary_key);
+        table_metadata.block_size = versioned_t<uint32_t>(block_size);
+        table_metadata.block_codec =
+            versioned_t<boost::optional<block_codec_t> >(block_codec);
         table_metadata.replication_info =
             versioned_t<table_replication_info_t>(repli_info);
 
@@ -734,6 +739,9 @@ bool real_reql_cluster_interface_t::reconfigure_internal(
 
     new_repli_info.config.write_ack_config.mode = write_ack_config_t::mode_t::majority;
     new_repli_info.config.durability = write_durability_t::HARD;
+    /* The cache share has nothing to do with how the table is sharded, so keep it. */
+    new_repli_info.config.cache_share =
+        table_md->replication_info.get_ref().config.cache_share;
 
     if (!dry_run) {
         /* Commit the change */
@@ -188,6 +188,67 @@ bool convert_durability_from_datum(
     return true;
 }
 
+ql::datum_t convert_cache_share_to_datum(
+        const cache_share_config_t &cache_share) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("min", ql::datum_t(cache_share.min));
+    builder.overwrite("max", ql::datum_t(cache_share.max));
+    return std::move(builder).to_datum();
+}
+
+bool convert_cache_share_fraction_from_datum(
+        const ql::datum_t &datum,
+        double *fraction_out,
+        std::string *error_out) {
+    if (datum.get_type() != ql::datum_t::R_NUM) {
+        *error_out = "Expected a number, got " + datum.print();
+        return false;
+    }
+    *fraction_out = datum.as_num();
+    if (!(*fraction_out >= 0 && *fraction_out <= 1)) {
+        *error_out = "Expected a number between 0 and 1, got " + datum.print();
+        return false;
+    }
+    return true;
+}
+
+bool convert_cache_share_from_datum(
+        const ql::datum_t &datum,
+        cache_share_config_t *cache_share_out,
+        std::string *error_out) {
+    converter_from_datum_object_t converter;
+    if (!converter.init(datum, error_out)) {
+        return false;
+    }
+
+    ql::datum_t min_datum, max_datum;
+    if (!converter.get("min", &min_datum, error_out)) {
+        return false;
+    }
+    if (!convert_cache_share_fraction_from_datum(min_datum, &cache_share_out->min,
+            error_out)) {
+        *error_out = "In `min`: " + *error_out;
+        return false;
+    }
+    if (!converter.get("max", &max_datum, error_out)) {
+        return false;
+    }
+    if (!convert_cache_share_fraction_from_datum(max_datum, &cache_share_out->max,
+            error_out)) {
+        *error_out = "In `max`: " + *error_out;
+        return false;
+    }
+    if (cache_share_out->min > cache_share_out->max) {
+        *error_out = "`min` must not be greater than `max`.";
+        return false;
+    }
+
+    if (!converter.check_no_extra_keys(error_out)) {
+        return false;
+    }
+    return true;
+}
+
 ql::datum_t convert_table_config_shard_to_datum(
         const table_config_t::shard_t &shard,
         admin_identifier_format_t identifier_format,
@@ -297,6 +358,8 @@ ql::datum_t convert_table_config_to_datum(
             config.write_ack_config, identifier_format, server_config_client));
     builder.overwrite("durability",
         convert_durability_to_datum(config.durability));
+    builder.overwrite("cache_share",
+        convert_cache_share_to_datum(config.cache_share));
     return std::move(builder).to_datum();
 }
 
@@ -441,6 +504,20 @@ bool convert_table_config_and_name_from_datum(
         config_out->durability = write_durability_t::HARD;
     }
 
+    if (existed_before || converter.has("cache_share")) {
+        ql::datum_t cache_share_datum;
+        if (!converter.get("cache_share", &cache_share_datum, error_out)) {
+            return false;
+        }
+        if (!convert_cache_share_from_datum(cache_share_datum, &config_out->cache_share,
+                error_out)) {
+            *error_out = "In `cache_share`: " + *error_out;
+            return false;
+        }
+    } else {
+        config_out->cache_share = cache_share_config_t();
+    }
+
     write_ack_config_checker_t ack_checker(*config_out, all_metadata.servers);
     for (const table_config_t::shard_t &shard : config_out->shards) {
         std::set<server_id_t> replicas;
@@ -612,6 +689,9 @@ bool table_config_artificial_table_backend_t::write_row(
             table_md.name = versioned_t<name_string_t>(new_table_name);
             table_md.database = versioned_t<database_id_t>(db_id);
             table_md.primary_key = versioned_t<std::string>(new_primary_key);
+            table_md.block_size = versioned_t<uint32_t>(0);
+            table_md.block_codec =
+                versioned_t<boost::optional<block_codec_t> >(boost::none);
             table_md.replication_info =
                 versioned_t<table_replication_info_t>(replication_info);
             md_change.get()->namespaces[table_id] =
@@ -15,14 +15,44 @@ RDB_IMPL_EQUALITY_COMPARABLE_2(write_ack_config_t::req_t, replicas, mode);
 RDB_IMPL_SERIALIZABLE_2_SINCE_v1_16(write_ack_config_t, mode, complex_reqs);
 RDB_IMPL_EQUALITY_COMPARABLE_2(write_ack_config_t, mode, complex_reqs);
 
+RDB_IMPL_SERIALIZABLE_2(cache_share_config_t, min, max);
+INSTANTIATE_SERIALIZABLE_SINCE_v1_17(cache_share_config_t);
+RDB_IMPL_EQUALITY_COMPARABLE_2(cache_share_config_t, min, max);
+
 RDB_IMPL_SERIALIZABLE_2_SINCE_v1_16(table_config_t::shard_t,
                                     replicas, primary_replica);
 RDB_IMPL_EQUALITY_COMPARABLE_2(table_config_t::shard_t,
                                replicas, primary_replica);
 
-RDB_IMPL_SERIALIZABLE_3_SINCE_v1_16(table_config_t,
-                                    shards, write_ack_config, durability);
-RDB_IMPL_EQUALITY_COMPARABLE_3(table_config_t, shards, write_ack_config, durability);
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const table_config_t &config) {
+    serialize<W>(wm, config.shards);
+    serialize<W>(wm, config.write_ack_config);
+    serialize<W>(wm, config.durability);
+    serialize<W>(wm, config.cache_share);
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, table_config_t *config) {
+    archive_result_t res = deserialize<W>(s, &config->shards);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &config->write_ack_config);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &config->durability);
+    if (bad(res)) { return res; }
+    if (W == cluster_version_t::v1_16) {
+        // Tables from v1.16 don't have a cache share, so they get the default one.
+        config->cache_share = cache_share_config_t();
+    } else {
+        res = deserialize<cluster_version_t::v1_17_is_latest>(s, &config->cache_share);
+        if (bad(res)) { return res; }
+    }
+    return res;
+}
+
+INSTANTIATE_SERIALIZABLE_SINCE_v1_16(table_config_t);
+RDB_IMPL_EQUALITY_COMPARABLE_4(table_config_t,
+                               shards, write_ack_config, durability, cache_share);
 
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_16(table_shard_scheme_t, split_points);
 RDB_IMPL_EQUALITY_COMPARABLE_1(table_shard_scheme_t, split_points);
@@ -32,15 +62,48 @@ RDB_IMPL_SERIALIZABLE_2_SINCE_v1_16(table_replication_info_t,
 RDB_IMPL_EQUALITY_COMPARABLE_2(table_replication_info_t,
                                config, shard_scheme);
 
-RDB_IMPL_SERIALIZABLE_4_SINCE_v1_16(namespace_semilattice_metadata_t,
-                                    name, database, primary_key, replication_info);
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const namespace_semilattice_metadata_t &md) {
+    serialize<W>(wm, md.name);
+    serialize<W>(wm, md.database);
+    serialize<W>(wm, md.primary_key);
+    serialize<W>(wm, md.block_size);
+    serialize<W>(wm, md.block_codec);
+    serialize<W>(wm, md.replication_info);
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, namespace_semilattice_metadata_t *md) {
+    archive_result_t res = deserialize<W>(s, &md->name);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &md->database);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &md->primary_key);
+    if (bad(res)) { return res; }
+    if (W == cluster_version_t::v1_16) {
+        // Tables from v1.16 don't have a block size or codec, so they use the
+        // defaults.
+        md->block_size = versioned_t<uint32_t>(0);
+        md->block_codec = versioned_t<boost::optional<block_codec_t> >(boost::none);
+    } else {
+        res = deserialize<W>(s, &md->block_size);
+        if (bad(res)) { return res; }
+        res = deserialize<W>(s, &md->block_codec);
+        if (bad(res)) { return res; }
+    }
+    res = deserialize<W>(s, &md->replication_info);
+    if (bad(res)) { return res; }
+    return res;
+}
+
+INSTANTIATE_SERIALIZABLE_SINCE_v1_16(namespace_semilattice_metadata_t);
 
-RDB_IMPL_SEMILATTICE_JOINABLE_4(
+RDB_IMPL_SEMILATTICE_JOINABLE_6(
         namespace_semilattice_metadata_t,
-        name, database, primary_key, replication_info);
-RDB_IMPL_EQUALITY_COMPARABLE_4(
+        name, database, primary_key, block_size, block_codec, replication_info);
+RDB_IMPL_EQUALITY_COMPARABLE_6(
         namespace_semilattice_metadata_t,
-        name, database, primary_key, replication_info);
+        name, database, primary_key, block_size, block_codec, replication_info);
 
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_16(namespaces_semilattice_metadata_t, namespaces);
 RDB_IMPL_SEMILATTICE_JOINABLE_1(namespaces_semilattice_metadata_t, namespaces);
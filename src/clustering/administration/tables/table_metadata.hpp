@@ -8,6 +8,9 @@
 #include <utility>
 #include <vector>
 
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
 #include "clustering/administration/servers/server_metadata.hpp"
 #include "clustering/administration/tables/database_metadata.hpp"
 #include "clustering/generic/nonoverlapping_regions.hpp"
@@ -22,6 +25,7 @@
 #include "rpc/semilattice/joins/map.hpp"
 #include "rpc/semilattice/joins/versioned.hpp"
 #include "rpc/serialize_macros.hpp"
+#include "serializer/log/block_codec.hpp"
 
 /* This is the metadata for a single table. */
 
@@ -48,6 +52,18 @@ RDB_DECLARE_EQUALITY_COMPARABLE(write_ack_config_t::req_t);
 RDB_DECLARE_SERIALIZABLE(write_ack_config_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(write_ack_config_t);
 
+/* `cache_share_config_t` bounds the fraction of each server's cache that the cache
+balancer gives the table's shards on that server. The default is no bounds. */
+class cache_share_config_t {
+public:
+    cache_share_config_t() : min(0), max(1) { }
+    double min;
+    double max;
+};
+
+RDB_DECLARE_SERIALIZABLE(cache_share_config_t);
+RDB_DECLARE_EQUALITY_COMPARABLE(cache_share_config_t);
+
 /* `table_config_t` describes the contents of the `rethinkdb.table_config` artificial
 table. */
 
@@ -61,6 +77,7 @@ public:
     std::vector<shard_t> shards;
     write_ack_config_t write_ack_config;
     write_durability_t durability;
+    cache_share_config_t cache_share;
 };
 
 RDB_DECLARE_SERIALIZABLE(table_config_t::shard_t);
@@ -127,6 +144,15 @@ public:
     versioned_t<database_id_t> database;   // TODO this should never actually change
     versioned_t<std::string> primary_key;   // TODO: This should never actually change
 
+    /* The block size the table's serializer files get created with, or 0 for
+    `DEFAULT_BTREE_BLOCK_SIZE`. Like `primary_key`, this never changes; files that
+    already exist keep the block size they were created with. */
+    versioned_t<uint32_t> block_size;
+
+    /* How to compress the data blocks of the table's files, or `boost::none` to leave
+    it to the `--block-compression` of each server. */
+    versioned_t<boost::optional<block_codec_t> > block_codec;
+
     versioned_t<table_replication_info_t> replication_info;
 };
 
@@ -52,6 +52,12 @@ struct unlimited_fifo_queue_t : public passive_producer_t<value_t> {
         return queue.size();
     }
 
+    // Returns the value that `pop()` would return next, without removing it.
+    value_t peek() const {
+        rassert(!queue.empty());
+        return unlimited_fifo_queue::get_front_of_list(queue);
+    }
+
 private:
     availability_control_t available_control;
     value_t produce_next_value() {
@@ -6,12 +6,14 @@
 
 
 throttled_committer_t::throttled_committer_t(const std::function<void()> &_commit_cb,
-                                             int _max_active_commits) :
+                                             int _max_active_commits,
+                                             const std::function<void()> &_gather_cb) :
     on_next_commit_complete(new counted_cond_t()),
     unhandled_commit_waiter_exists(false),
     num_active_commits(0),
     max_active_commits(_max_active_commits),
-    commit_cb(_commit_cb) { }
+    commit_cb(_commit_cb),
+    gather_cb(_gather_cb) { }
 
 throttled_committer_t::~throttled_committer_t() {
     assert_thread();
@@ -42,6 +44,10 @@ void throttled_committer_t::do_commit() {
     assert_thread();
     rassert(num_active_commits <= max_active_commits);
 
+    if (gather_cb) {
+        gather_cb();
+    }
+
     // Swap out the on_next_commit_complete signal so subsequent syncs
     // can be captured by the next round of do_commit().
     counted_t<counted_cond_t> sync_complete(new counted_cond_t());
@@ -22,8 +22,13 @@
 class throttled_committer_t : public home_thread_mixin_debug_only_t {
 public:
     // Unless _max_active_commits == 1, _commit_cb must be reentrant safe.
+    // `_gather_cb`, if given, is called at the start of every commit and may block
+    // to let more changes accumulate.  Syncs that come in while it runs are covered
+    // by the commit that called it.
     throttled_committer_t(const std::function<void()> &_commit_cb,
-                          int _max_active_commits);
+                          int _max_active_commits,
+                          const std::function<void()> &_gather_cb
+                              = std::function<void()>());
     ~throttled_committer_t();
 
     // Waits until the first commit completes that has been started after
@@ -45,6 +50,7 @@ private:
     int max_active_commits;
 
     std::function<void()> commit_cb;
+    std::function<void()> gather_cb;
 
     DISABLE_COPYING(throttled_committer_t);
 };
@@ -0,0 +1,105 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "concurrency/work_stealing.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/spinlock.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+
+class work_stealing_job_t {
+public:
+    explicit work_stealing_job_t(size_t _num_chunks)
+        : num_chunks(_num_chunks), next_chunk(0), failed(false), failed_chunk(0) { }
+
+    // Runs `worker` on the current thread, and records the failure if it throws.
+    void run(signal_t *interruptor,
+             const std::function<void(chunk_dispenser_t *, signal_t *)> &worker) {
+        chunk_dispenser_t dispenser(this);
+        try {
+            worker(&dispenser, interruptor);
+        } catch (...) {
+            // We must not switch coroutines in here.
+            spinlock_acq_t acq(&failure_lock);
+            if (!failed || dispenser.current_chunk < failed_chunk) {
+                failed_chunk = dispenser.current_chunk;
+                exception = std::current_exception();
+            }
+            __atomic_store_n(&failed, true, __ATOMIC_RELEASE);
+        }
+    }
+
+    const size_t num_chunks;
+
+    // These two are accessed atomically.
+    size_t next_chunk;
+    bool failed;
+
+    // Protects `failed_chunk` and `exception`, while the job is running
+    spinlock_t failure_lock;
+    size_t failed_chunk;
+    std::exception_ptr exception;
+};
+
+chunk_dispenser_t::chunk_dispenser_t(work_stealing_job_t *_job)
+    : job(_job), current_chunk(_job->num_chunks) { }
+
+bool chunk_dispenser_t::take(size_t *chunk_out) {
+    if (__atomic_load_n(&job->failed, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const size_t chunk = __sync_fetch_and_add(&job->next_chunk, 1);
+    if (chunk >= job->num_chunks) {
+        return false;
+    }
+    current_chunk = chunk;
+    *chunk_out = chunk;
+    return true;
+}
+
+// The db threads other than this one that look idle, the least busy ones first.
+std::vector<threadnum_t> idle_db_threads(size_t max_threads) {
+    std::vector<std::pair<size_t, int> > idle_threads;
+    for (int i = 0; i < get_num_db_threads(); ++i) {
+        if (i == get_thread_id().threadnum) {
+            continue;
+        }
+        const size_t backlog = get_thread_backlog(threadnum_t(i));
+        if (backlog <= WORK_STEALING_IDLE_BACKLOG) {
+            idle_threads.push_back(std::make_pair(backlog, i));
+        }
+    }
+    std::sort(idle_threads.begin(), idle_threads.end());
+
+    std::vector<threadnum_t> ret;
+    for (size_t i = 0; i < idle_threads.size() && i < max_threads; ++i) {
+        ret.push_back(threadnum_t(idle_threads[i].second));
+    }
+    return ret;
+}
+
+void steal_work(size_t num_chunks, signal_t *interruptor,
+                const std::function<void(chunk_dispenser_t *, signal_t *)> &worker) {
+    work_stealing_job_t job(num_chunks);
+    // There's no point in asking more threads than there are chunks to share.
+    const std::vector<threadnum_t> helpers
+        = num_chunks > 1 ? idle_db_threads(num_chunks - 1) : std::vector<threadnum_t>();
+
+    pmap(helpers.size() + 1, [&](int64_t i) {
+        if (i == 0) {
+            job.run(interruptor, worker);
+        } else {
+            cross_thread_signal_t helper_interruptor(interruptor, helpers[i - 1]);
+            on_thread_t thread_switcher(helpers[i - 1]);
+            job.run(&helper_interruptor, worker);
+        }
+    });
+
+    if (job.failed) {
+        std::rethrow_exception(job.exception);
+    }
+}
@@ -0,0 +1,49 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_WORK_STEALING_HPP_
+#define CONCURRENCY_WORK_STEALING_HPP_
+
+#include <exception>
+#include <functional>
+
+#include "errors.hpp"
+
+class signal_t;
+class work_stealing_job_t;
+
+/* Hands out the chunks of a `steal_work()` job, in ascending order, to the threads that
+work on it. */
+class chunk_dispenser_t {
+public:
+    // Returns false once all the chunks have been handed out, or once one of them
+    // failed.
+    MUST_USE bool take(size_t *chunk_out);
+
+private:
+    friend class work_stealing_job_t;
+
+    explicit chunk_dispenser_t(work_stealing_job_t *_job);
+
+    work_stealing_job_t *const job;
+
+    // The chunk we handed out last, which is the one that failed if the worker throws
+    size_t current_chunk;
+
+    DISABLE_COPYING(chunk_dispenser_t);
+};
+
+/* Spreads a CPU-heavy job over several db threads.  The job is made up of
+`num_chunks` chunks that don't depend on each other.  The calling coroutine works
+through the chunks itself, and db threads that look idle get invited to take chunks
+off it, so that a single expensive job can use several cores.  Busy threads don't get
+asked, and helpers that show up after all the chunks are gone don't get any.
+
+`worker` runs on every thread that helps, the calling one included, and takes chunks
+from the dispenser until there are none left.  It gets a copy of `interruptor` for
+its thread.  It must not touch anything that belongs to the calling thread, except
+through thread-safe objects, so it should set up what it needs on its own thread.  If
+it throws, no more chunks get handed out, and once all the threads are done,
+`steal_work()` rethrows the exception of the lowest chunk that failed. */
+void steal_work(size_t num_chunks, signal_t *interruptor,
+                const std::function<void(chunk_dispenser_t *, signal_t *)> &worker);
+
+#endif  // CONCURRENCY_WORK_STEALING_HPP_
@@ -51,6 +51,18 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// The io_uring disk backend (see arch/io/disk/uring.hpp) never lets more than this
+// many operations sit in its submission ring at once, regardless of --io-threads.
+#define URING_DISKMGR_MAX_QUEUE_DEPTH             4096
+
+// How many blocker threads the io_uring disk backend keeps around for the operations
+// that it cannot submit through the ring (file resizes and datasync-wrapped writes).
+#define URING_DISKMGR_BLOCKER_THREADS             2
+
+// How long the io_uring disk backend waits before it retries a submission that the
+// kernel turned away for lack of resources
+#define URING_DISKMGR_RESUBMIT_DELAY_MS           1
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -68,11 +80,36 @@
 // perspective) if they are soft-durability or noreply writes.
 #define CACHE_READS_IO_PRIORITY                   (512 / CPU_SHARDING_FACTOR)
 
+// Once a read of a cache's read account has waited this long (in microseconds) for
+// the disk, it goes ahead of the queued requests of background work like the GC,
+// backfills and secondary index construction, regardless of their priority.
+#define CACHE_READS_IO_LATENCY_TARGET_US          (20 * THOUSAND)
+
 // The cache priority to use for secondary index post construction
 // 100 = same priority as all other read operations in the cache together.
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// How much memory secondary index post construction may use per table to sort the
+// new index entries, before it spills them into files.  The hash shards of the table
+// and the indexes that get built together share it.
+#define SINDEX_POST_CONSTRUCTION_SORT_BUFFER_SIZE (64 * MEGABYTE)
+
+// How many secondary indexes post construction builds at the same time.  If there are
+// more, it traverses the primary btree again for each group of them.
+#define SINDEX_POST_CONSTRUCTION_MAX_SORTERS      4
+
+// How many index entries secondary index post construction writes per transaction
+#define SINDEX_POST_CONSTRUCTION_CHUNK_SIZE       1000
+
+// The cache priority to use for reloading the blocks that were hot before a restart
+// (see cache_warmer_t).  Same scale as SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY.
+#define CACHE_WARM_UP_CACHE_PRIORITY              5
+
+// How often (in milliseconds) each table shard saves the list of blocks it has in
+// its cache, so that they can be reloaded after a restart
+#define CACHE_WARM_LIST_SAVE_INTERVAL_MS          (60 * 1000)
+
 // Size of the buffer used to perform IO operations (in bytes).
 #define IO_BUFFER_SIZE                            (4 * KILOBYTE)
 
@@ -85,6 +122,11 @@
 // Size of each btree node (in bytes) on disk
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
 
+// The range of btree node sizes a table can be created with. Node offsets are 16 bits
+// wide, so the maximum can't go beyond 64 KB.
+#define MIN_BTREE_BLOCK_SIZE                      (4 * KILOBYTE)
+#define MAX_BTREE_BLOCK_SIZE                      (64 * KILOBYTE)
+
 // Size of each extent (in bytes)
 // This should not be too small, or garbage collection will become
 // inefficient (especially on rotational drives).
@@ -102,6 +144,22 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// How long (in milliseconds) the merger serializer holds a commit back by default to
+// let concurrent index writes join it, if the previous commit merged several of them
+// (see --group-commit-window).  0 commits right away.
+#define MERGER_SERIALIZER_DEFAULT_GROUP_COMMIT_WINDOW_MS 1
+#define MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS     1000
+
+// The number of block write batches that each merger serializer keeps in flight.
+// Block writes that come in while this many batches are being written get merged
+// into the next batch.
+#define MERGER_SERIALIZER_MAX_ACTIVE_BLOCK_WRITES 2
+
+// Once the block writes waiting for the next batch add up to this many bytes, the
+// merger serializer sends them off even if it already has the maximum number of
+// batches in flight.
+#define MERGER_SERIALIZER_BLOCK_WRITE_BATCH_SIZE  DEFAULT_EXTENT_SIZE
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
@@ -144,9 +202,31 @@
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
+// I/O priority for reading the LBA at startup. Nothing else is going on with the file
+// at that point, but the shards are read concurrently and should keep the disk busy.
+#define LBA_STARTUP_IO_PRIORITY                   CACHE_READS_IO_PRIORITY
+
+// I/O priority for the background scrubber that verifies block checksums
+#define SCRUB_IO_PRIORITY                         2
+
+// How long (in milliseconds) the scrubber waits between two passes over a data file.
+// The first pass starts this long after the file is opened.
+#define SCRUB_INTERVAL_MS                         (24 * 60 * 60 * 1000)
+
+// How many block ids the scrubber looks at at a time
+#define SCRUB_CHUNK_BLOCKS                        1024
+
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
+// How often (in milliseconds) the compactor checks whether a data file has enough
+// free space stuck in the middle to be worth compacting
+#define COMPACTION_CHECK_INTERVAL_MS              (10 * 60 * 1000)
+
+// How long (in milliseconds) the compactor pauses after moving an extent, so that
+// compacting a big file doesn't hog the disk
+#define COMPACTION_EXTENT_DELAY_MS                50
+
 // How many LBA structures to have for each file
 #define LBA_SHARD_FACTOR                          4
 
@@ -172,6 +252,16 @@
 // freed. This value is per thread.
 #define COROUTINE_FREE_LIST_SIZE                  64
 
+// Coroutine stacks are mapped in slabs of this many stacks, or of half as many as are
+// in use, if that's more, up to the maximum.  This value is per thread.
+#define COROUTINE_STACK_SLAB_MIN_STACKS           32
+#define COROUTINE_STACK_SLAB_MAX_STACKS           1024
+
+// Unused coroutine stacks stay in memory as long as the number of stacks in use reached
+// that many within the last one or two windows of this length.  The others get returned
+// to the operating system.
+#define COROUTINE_STACK_POOL_WINDOW_MS            10000
+
 #define MAX_COROS_PER_THREAD                      10000
 
 
@@ -211,6 +301,29 @@
 // 2^(MESSAGE_SCHEDULER_MAX_PRIORITY - MESSAGE_SCHEDULER_MIN_PRIORITY + 1)
 #define MESSAGE_SCHEDULER_GRANULARITY           32
 
+// A db thread counts as idle, and gets asked to help other threads with their work (see
+// `steal_work()`), if at most this many messages were waiting for it.
+#define WORK_STEALING_IDLE_BACKLOG              2
+
+// `map` and `filter` over a batch of at least PARALLEL_TRANSFORM_MIN_ELEMENTS get
+// evaluated in chunks of PARALLEL_TRANSFORM_CHUNK_SIZE elements, which idle db threads
+// can help with, if the first chunk suggests that the rest would take at least
+// PARALLEL_TRANSFORM_MIN_MS milliseconds.
+#define PARALLEL_TRANSFORM_MIN_ELEMENTS         256
+#define PARALLEL_TRANSFORM_CHUNK_SIZE           64
+#define PARALLEL_TRANSFORM_MIN_MS               2
+
+// The longest an event queue may spin looking for events before it goes to sleep, in
+// microseconds.  See `busy_poller_t`.
+#define MAX_BUSY_POLL_LIMIT_US                    100000
+
+// A busy poller never spins for less than its limit divided by this.
+#define BUSY_POLL_MIN_SPIN_DIVISOR                64
+
+// How many times a busy poller looks at the thread's incoming messages for every time
+// it asks the kernel for events.
+#define BUSY_POLL_KERNEL_INTERVAL                 16
+
 // Priorities for specific tasks
 #define CORO_PRIORITY_SINDEX_CONSTRUCTION       (-2)
 #define CORO_PRIORITY_BACKFILL_SENDER           (-2)
@@ -8,10 +8,10 @@ namespace archive_internal {
 
 // This is used to implement serialize_cluster_version and
 // deserialize_cluster_version.  (cluster_version_t conveniently has a contiguous set
-// of valid representation, from v1_13 to v1_16_is_latest).
+// of valid representation, from v1_13 to v1_17_is_latest).
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(cluster_version_t, int8_t,
                                       cluster_version_t::v1_13,
-                                      cluster_version_t::v1_16_is_latest);
+                                      cluster_version_t::v1_17_is_latest);
 
 class bogus_made_up_type_t;
 
@@ -66,8 +66,10 @@ archive_result_t deserialize_for_version(cluster_version_t version,
         return deserialize<cluster_version_t::v1_14>(s, thing);
     case cluster_version_t::v1_15:
         return deserialize<cluster_version_t::v1_15>(s, thing);
-    case cluster_version_t::v1_16_is_latest:
-        return deserialize<cluster_version_t::v1_16_is_latest>(s, thing);
+    case cluster_version_t::v1_16:
+        return deserialize<cluster_version_t::v1_16>(s, thing);
+    case cluster_version_t::v1_17_is_latest:
+        return deserialize<cluster_version_t::v1_17_is_latest>(s, thing);
     default:
         unreachable();
     }
@@ -91,8 +93,10 @@ size_t serialized_size_for_version(cluster_version_t version,
         return serialized_size<cluster_version_t::v1_14>(thing);
     case cluster_version_t::v1_15:
         return serialized_size<cluster_version_t::v1_15>(thing);
-    case cluster_version_t::v1_16_is_latest:
-        return serialized_size<cluster_version_t::v1_16_is_latest>(thing);
+    case cluster_version_t::v1_16:
+        return serialized_size<cluster_version_t::v1_16>(thing);
+    case cluster_version_t::v1_17_is_latest:
+        return serialized_size<cluster_version_t::v1_17_is_latest>(thing);
     default:
         unreachable();
     }
@@ -136,7 +140,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v1_15>(             \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v1_16_is_latest>(   \
+    template archive_result_t deserialize<cluster_version_t::v1_16>(             \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v1_17_is_latest>(   \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZED_SIZE_SINCE_v1_13(typ)                                  \
@@ -144,23 +150,38 @@ size_t serialized_size_for_version(cluster_version_t version,
     template size_t serialized_size<cluster_version_t::v1_13_2>(const typ &)          \
     template size_t serialized_size<cluster_version_t::v1_14>(const typ &)            \
     template size_t serialized_size<cluster_version_t::v1_15>(const typ &)            \
-    template size_t serialized_size<cluster_version_t::v1_16_is_latest>(const typ &)
+    template size_t serialized_size<cluster_version_t::v1_16>(const typ &)            \
+    template size_t serialized_size<cluster_version_t::v1_17_is_latest>(const typ &)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v1_13(typ)        \
     INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(typ);     \
     INSTANTIATE_DESERIALIZE_SINCE_v1_13(typ)
 
 #define INSTANTIATE_DESERIALIZE_SINCE_v1_16(typ)                                 \
-    template archive_result_t deserialize<cluster_version_t::v1_16_is_latest>(   \
+    template archive_result_t deserialize<cluster_version_t::v1_16>(             \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v1_17_is_latest>(   \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZED_SIZE_SINCE_v1_16(typ)                                  \
-    template size_t serialized_size<cluster_version_t::v1_16_is_latest>(const typ &)
+    template size_t serialized_size<cluster_version_t::v1_16>(const typ &)            \
+    template size_t serialized_size<cluster_version_t::v1_17_is_latest>(const typ &)
+
+#define INSTANTIATE_DESERIALIZE_SINCE_v1_17(typ)                                 \
+    template archive_result_t deserialize<cluster_version_t::v1_17_is_latest>(   \
+            read_stream_t *, typ *)
+
+#define INSTANTIATE_SERIALIZED_SIZE_SINCE_v1_17(typ)                                  \
+    template size_t serialized_size<cluster_version_t::v1_17_is_latest>(const typ &)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v1_16(typ)        \
     INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(typ);     \
     INSTANTIATE_DESERIALIZE_SINCE_v1_16(typ)
 
+#define INSTANTIATE_SERIALIZABLE_SINCE_v1_17(typ)        \
+    INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(typ);     \
+    INSTANTIATE_DESERIALIZE_SINCE_v1_17(typ)
+
 #define INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(typ)                      \
     INSTANTIATE_SERIALIZE_FOR_CLUSTER(typ);                            \
     template archive_result_t deserialize<cluster_version_t::CLUSTER>( \
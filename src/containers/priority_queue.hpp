@@ -54,6 +54,9 @@ public:
     void remove(entry_t *);
     T pop();
     void update(int);
+    // Restores the heap order after the ordering of the elements has changed as a
+    // whole (not just for individual entries, which update() is for).
+    void rebuild();
 public:
     void validate();
 
@@ -162,6 +162,7 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
         auth_metadata(_auth_metadata),
         shutting_down_conds(),
         pulse_sdc_on_shutdown(&main_shutting_down_cond),
+        connections_per_thread(get_num_db_threads(), 0),
         next_thread(0)
 {
     rassert(rdb_ctx != NULL);
@@ -172,9 +173,8 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
     }
 
     try {
-        tcp_listener.init(new tcp_listener_t(local_addresses, port,
-            std::bind(&query_server_t::handle_conn,
-                      this, ph::_1, auto_drainer_t::lock_t(&auto_drainer))));
+        tcp_listener.init(new threaded_tcp_listener_t(local_addresses, port,
+            std::bind(&query_server_t::handle_conn, this, ph::_1, ph::_2)));
     } catch (const address_in_use_exc_t &ex) {
         throw address_in_use_exc_t(strprintf("Could not bind to RDB protocol port: %s", ex.what()));
     }
@@ -217,13 +217,59 @@ auth_key_t query_server_t::read_auth_key(tcp_conn_t *conn,
     return ret;
 }
 
+threadnum_t choose_least_loaded_thread(int num_threads, int start,
+                                       const std::function<size_t(int)> &load) {
+    threadnum_t best_thread(start);
+    size_t best_load = std::numeric_limits<size_t>::max();
+    for (int i = 0; i < num_threads; ++i) {
+        const int thread = (start + i) % num_threads;
+        const size_t thread_load = load(thread);
+        if (thread_load < best_load) {
+            best_thread = threadnum_t(thread);
+            best_load = thread_load;
+        }
+    }
+    return best_thread;
+}
+
+threadnum_t query_server_t::choose_conn_thread() {
+    const int num_threads = get_num_db_threads();
+    const int start = __sync_fetch_and_add(&next_thread, 1) % num_threads;
+    return choose_least_loaded_thread(num_threads, start, [this](int thread) {
+        // Messages pile up for a thread that is busy, for example with a few heavy
+        // clients.  The connections count as well, so that new connections still
+        // spread out over threads that are idle.
+        return get_thread_backlog(threadnum_t(thread))
+            + __sync_fetch_and_add(&connections_per_thread[thread], 0);
+    });
+}
+
+// Counts a client connection against its thread for as long as it lives.
+class conn_thread_count_t {
+public:
+    explicit conn_thread_count_t(int *_count) : count(_count) {
+        __sync_add_and_fetch(count, 1);
+    }
+    ~conn_thread_count_t() {
+        __sync_sub_and_fetch(count, 1);
+    }
+private:
+    int *count;
+    DISABLE_COPYING(conn_thread_count_t);
+};
+
 void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                                  auto_drainer_t::lock_t keepalive) {
-    // This must be read here because of home threads and stuff
-    auth_key_t auth_key = auth_metadata->get().auth_key.get_ref();
+    // Connections get accepted on every thread, but the metadata lives on its home
+    // thread.
+    auth_key_t auth_key;
+    {
+        on_thread_t thread_switcher(auth_metadata->home_thread());
+        auth_key = auth_metadata->get().auth_key.get_ref();
+    }
 
-    threadnum_t chosen_thread = threadnum_t(next_thread);
-    next_thread = (next_thread + 1) % get_num_db_threads();
+    threadnum_t chosen_thread = choose_conn_thread();
+    conn_thread_count_t conn_count(&connections_per_thread[chosen_thread.threadnum]);
 
     cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
     on_thread_t rethreader(chosen_thread);
@@ -2,6 +2,7 @@
 #ifndef PROTOB_PROTOB_HPP_
 #define PROTOB_PROTOB_HPP_
 
+#include <functional>
 #include <set>
 #include <map>
 #include <string>
@@ -142,6 +143,11 @@ public:
                                    const std::string &info) = 0;
 };
 
+// Picks the one of `num_threads` threads that `load` is the smallest for.  The threads
+// get looked at from `start` on, and the first of several equally loaded ones wins.
+threadnum_t choose_least_loaded_thread(int num_threads, int start,
+                                       const std::function<size_t(int)> &load);
+
 class query_server_t : public http_app_t {
 public:
     query_server_t(rdb_context_t *rdb_ctx,
@@ -164,6 +170,10 @@ private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                      auto_drainer_t::lock_t);
 
+    // Picks the thread for a new client connection, the one that looks the least
+    // loaded.  Can be called from any thread.
+    threadnum_t choose_conn_thread();
+
     // This is templatized based on the wire protocol requested by the client
     template<class protocol_t>
     void connection_loop(tcp_conn_t *conn,
@@ -199,9 +209,15 @@ private:
 
     http_conn_cache_t http_conn_cache;
 
-    scoped_ptr_t<tcp_listener_t> tcp_listener;
+    scoped_ptr_t<threaded_tcp_listener_t> tcp_listener;
+
+    // How many client connections each thread has.  Updated atomically, because
+    // connections get accepted on every thread.
+    std::vector<int> connections_per_thread;
 
-    int next_thread;
+    // Where `choose_conn_thread()` starts looking, so that ties get broken
+    // round-robin.
+    uint32_t next_thread;
 };
 
 #endif /* PROTOB_PROTOB_HPP_ */
@@ -39,3 +39,9 @@ void rdb_blob_wrapper_t::expose_all(
         "Other blocks might be referencing this blob, it's invalid to modify it in place.");
     internal.expose_all(parent, mode, buffer_group_out, acq_group_out);
 }
+
+bool rdb_blob_wrapper_t::read_in_one_piece(
+        buf_parent_t parent,
+        const std::function<void(const char *, int64_t)> &fn) {
+    return internal.read_in_one_piece(parent, fn);
+}
@@ -29,6 +29,9 @@ public:
                     buffer_group_t *buffer_group_out,
                     blob_acq_t *acq_group_out);
 
+    bool read_in_one_piece(buf_parent_t parent,
+                           const std::function<void(const char *, int64_t)> &fn);
+
 private:
     blob_t internal;
 };
@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "btree/backfill.hpp"
+#include "btree/bulk_load.hpp"
 #include "btree/concurrent_traversal.hpp"
 #include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
@@ -33,6 +34,7 @@
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
+#include "stl_utils.hpp"
 
 #include "debug.hpp"
 
@@ -1264,7 +1266,8 @@ void deserialize_sindex_info(const std::vector<char> &data,
         break;
     case cluster_version_t::v1_14:
     case cluster_version_t::v1_15:
-    case cluster_version_t::v1_16_is_latest:
+    case cluster_version_t::v1_16:
+    case cluster_version_t::v1_17_is_latest:
         success = deserialize_for_version(
                 cluster_version,
                 &read_stream,
@@ -1555,84 +1558,32 @@ void rdb_update_sindexes(
     }
 }
 
+/* Computes the secondary index entries of every row in the primary btree, and hands
+them to the sorter of their index.  The indexes get built from the sorted entries
+afterwards, in `bulk_load_secondary_index()`. */
 class post_construct_traversal_helper_t : public btree_traversal_helper_t {
 public:
-    post_construct_traversal_helper_t(
-            store_t *store,
-            const std::set<uuid_u> &sindexes_to_post_construct,
-            cond_t *interrupt_myself,
-            signal_t *interruptor
-            )
-        : store_(store),
-          sindexes_to_post_construct_(sindexes_to_post_construct),
-          interrupt_myself_(interrupt_myself), interruptor_(interruptor)
-    { }
+    struct sindex_t {
+        sindex_disk_info_t info;
+        bulk_load_sorter_t *sorter;
+    };
+
+    post_construct_traversal_helper_t(store_t *store,
+                                      const std::vector<sindex_t> &sindexes)
+        : store_(store), sindexes_(sindexes) { }
 
     void process_a_leaf(buf_lock_t *leaf_node_buf,
                         const btree_key_t *, const btree_key_t *,
                         signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
-
-        scoped_ptr_t<txn_t> wtxn;
-        store_t::sindex_access_vector_t sindexes;
-
         buf_read_t leaf_read(leaf_node_buf);
         const leaf_node_t *leaf_node
             = static_cast<const leaf_node_t *>(leaf_read.get_data_read());
+        const max_block_size_t block_size = leaf_node_buf->cache()->max_block_size();
 
         // Number of key/value pairs we process before yielding
         const int MAX_CHUNK_SIZE = 10;
         int current_chunk_size = 0;
-        const rdb_post_construction_deletion_context_t deletion_context;
         for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
-            if (current_chunk_size == 0) {
-                // Start a write transaction and acquire the secondary index
-                // at the beginning of each chunk. We reset the transaction
-                // after each chunk because large write transactions can cause
-                // the cache to go into throttling, and that would interfere
-                // with other transactions on this table.
-                try {
-                    write_token_t token;
-                    store_->new_write_token(&token);
-
-                    scoped_ptr_t<real_superblock_t> superblock;
-
-                    // We use HARD durability because we want post construction
-                    // to be throttled if we insert data faster than it can
-                    // be written to disk. Otherwise we might exhaust the cache's
-                    // dirty page limit and bring down the whole table.
-                    // Other than that, the hard durability guarantee is not actually
-                    // needed here.
-                    store_->acquire_superblock_for_write(
-                            repli_timestamp_t::distant_past,
-                            2 + MAX_CHUNK_SIZE,
-                            write_durability_t::HARD,
-                            &token,
-                            &wtxn,
-                            &superblock,
-                            interruptor_);
-
-                    // Acquire the sindex block.
-                    const block_id_t sindex_block_id = superblock->get_sindex_block_id();
-
-                    buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
-                                            access_t::write);
-
-                    superblock.reset();
-
-                    store_->acquire_sindex_superblocks_for_write(
-                            sindexes_to_post_construct_,
-                            &sindex_block,
-                            &sindexes);
-
-                    if (sindexes.empty()) {
-                        interrupt_myself_->pulse_if_not_already_pulsed();
-                        return;
-                    }
-                } catch (const interrupted_exc_t &e) {
-                    return;
-                }
-            }
-
             store_->btree->stats.pm_keys_read.record();
             store_->btree->stats.pm_total_keys_read += 1;
 
@@ -1642,33 +1593,28 @@ public:
             guarantee(key);
 
             const store_key_t pk(key);
-            rdb_modification_report_t mod_report(pk);
             const rdb_value_t *rdb_value = static_cast<const rdb_value_t *>(value);
-            const max_block_size_t block_size = leaf_node_buf->cache()->max_block_size();
-            mod_report.info.added
-                = std::make_pair(
-                    get_data(rdb_value, buf_parent_t(leaf_node_buf)),
-                    std::vector<char>(rdb_value->value_ref(),
-                        rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-            rdb_update_sindexes(store_,
-                                sindexes,
-                                &mod_report,
-                                wtxn.get(),
-                                &deletion_context,
-                                NULL,
-                                NULL,
-                                NULL);
-            store_->btree->stats.pm_keys_set.record();
-            store_->btree->stats.pm_total_keys_set += 1;
+            const ql::datum_t doc = get_data(rdb_value, buf_parent_t(leaf_node_buf));
+            const std::vector<char> value_ref(
+                rdb_value->value_ref(),
+                rdb_value->value_ref() + rdb_value->inline_size(block_size));
+
+            for (const sindex_t &sindex : sindexes_) {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                try {
+                    compute_keys(pk, doc, sindex.info, &keys);
+                } catch (const ql::base_exc_t &) {
+                    // The row just isn't in the index.
+                    continue;
+                }
+                for (const auto &pair : keys) {
+                    sindex.sorter->push(std::make_pair(pair.first, value_ref));
+                }
+            }
 
             ++current_chunk_size;
             if (current_chunk_size >= MAX_CHUNK_SIZE) {
                 current_chunk_size = 0;
-                // Release the write transaction and yield.
-                // We continue later where we have left off.
-                sindexes.clear();
-                wtxn.reset();
                 coro_t::yield();
             }
         }
@@ -1689,28 +1635,112 @@ public:
     access_t btree_node_mode() { return access_t::read; }
 
     store_t *store_;
-    const std::set<uuid_u> &sindexes_to_post_construct_;
-    cond_t *interrupt_myself_;
-    signal_t *interruptor_;
+    const std::vector<sindex_t> &sindexes_;
 };
 
-void post_construct_secondary_indexes(
+/* Writes the sorted entries of a secondary index into its tree, which is still empty
+unless something else has filled it in the meantime, in which case they get inserted
+one by one.  Stops early if the index gets dropped. */
+void bulk_load_secondary_index(store_t *store,
+                               uuid_u sindex_id,
+                               bulk_load_sorter_t *sorter,
+                               signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    std::set<uuid_u> sindex_ids;
+    sindex_ids.insert(sindex_id);
+
+    rdb_value_sizer_t sizer(store->cache->max_block_size());
+    scoped_ptr_t<btree_bulk_loader_t> loader;
+    bool use_loader = true;
+    const rdb_post_construction_deletion_context_t deletion_context;
+
+    bulk_load_pair_t pair;
+    bool have_pair = sorter->pop(&pair);
+    while (have_pair) {
+        write_token_t token;
+        store->new_write_token(&token);
+
+        scoped_ptr_t<txn_t> wtxn;
+        scoped_ptr_t<real_superblock_t> superblock;
+
+        // We use HARD durability for the same reason as when draining the
+        // modification queue: it throttles us if we write faster than the disk.
+        store->acquire_superblock_for_write(
+                repli_timestamp_t::distant_past,
+                2 + SINDEX_POST_CONSTRUCTION_CHUNK_SIZE / 16,
+                write_durability_t::HARD,
+                &token,
+                &wtxn,
+                &superblock,
+                interruptor);
+
+        store_t::sindex_access_vector_t sindexes;
+        {
+            buf_lock_t sindex_block(superblock->expose_buf(),
+                                    superblock->get_sindex_block_id(),
+                                    access_t::write);
+            superblock.reset();
+            store->acquire_sindex_superblocks_for_write(sindex_ids, &sindex_block,
+                                                        &sindexes);
+        }
+        if (sindexes.empty() || sindexes[0]->sindex.being_deleted) {
+            return;
+        }
+        real_superblock_t *sindex_superblock = sindexes[0]->superblock.get();
+        btree_stats_t *stats = &sindexes[0]->btree->stats;
+
+        if (use_loader && !loader.has()) {
+            use_loader = sindex_superblock->get_root_block_id() == NULL_BLOCK_ID;
+            if (use_loader) {
+                loader.init(new btree_bulk_loader_t(&sizer));
+            }
+        }
+
+        for (int i = 0; i < SINDEX_POST_CONSTRUCTION_CHUNK_SIZE && have_pair; ++i) {
+            if (use_loader) {
+                loader->append(sindex_superblock, pair.first.btree_key(),
+                               pair.second.data(), repli_timestamp_t::distant_past);
+            } else {
+                promise_t<superblock_t *> pass_back_superblock;
+                keyvalue_location_t kv_location;
+                find_keyvalue_location_for_write(
+                    &sizer, sindex_superblock, pair.first.btree_key(),
+                    deletion_context.balancing_detacher(), &kv_location, stats,
+                    NULL, &pass_back_superblock);
+                kv_location_set(&kv_location, pair.first, pair.second,
+                                repli_timestamp_t::distant_past, &deletion_context);
+            }
+            stats->pm_keys_set.record();
+            stats->pm_total_keys_set += 1;
+
+            // A row's entries are unique, but let's not rely on it.
+            const store_key_t last_key = pair.first;
+            do {
+                have_pair = sorter->pop(&pair);
+            } while (have_pair && pair.first == last_key);
+        }
+        if (use_loader) {
+            loader->finish_chunk(sindex_superblock);
+        }
+
+        // Release the write transaction and yield.
+        sindexes.clear();
+        wtxn.reset();
+        coro_t::yield();
+    }
+}
+
+// Builds the given secondary indexes in a single traversal of the primary btree.
+void post_construct_secondary_index_batch(
         store_t *store,
         const std::set<uuid_u> &sindexes_to_post_construct,
         signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t) {
-    cond_t local_interruptor;
-
-    wait_any_t wait_any(&local_interruptor, interruptor);
-
-    post_construct_traversal_helper_t helper(store,
-            sindexes_to_post_construct, &local_interruptor, interruptor);
     /* Notice the ordering of progress_tracker and insertion_sentries matters.
      * insertion_sentries puts pointers in the progress tracker map. Once
      * insertion_sentries is destructed nothing has a reference to
      * progress_tracker so we know it's safe to destruct it. */
     parallel_traversal_progress_t progress_tracker;
-    helper.progress = &progress_tracker;
 
     std::vector<map_insertion_sentry_t<uuid_u, const parallel_traversal_progress_t *> >
         insertion_sentries(sindexes_to_post_construct.size());
@@ -1720,29 +1750,95 @@ void post_construct_secondary_indexes(
         store->add_progress_tracker(&*sentry, *it, &progress_tracker);
     }
 
-    read_token_t read_token;
-    store->new_read_token(&read_token);
-
-    // Mind the destructor ordering.
-    // The superblock must be released before txn (`btree_parallel_traversal`
-    // usually already takes care of that).
-    // The txn must be destructed before the cache_account.
-    cache_account_t cache_account;
-    scoped_ptr_t<txn_t> txn;
-    scoped_ptr_t<real_superblock_t> superblock;
-
-    store->acquire_superblock_for_read(
-        &read_token,
-        &txn,
-        &superblock,
-        interruptor,
-        true /* USE_SNAPSHOT */);
-
-    cache_account
-        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
-    txn->set_account(&cache_account);
-
-    btree_parallel_traversal(superblock.get(), &helper, &wait_any);
+    std::map<uuid_u, scoped_ptr_t<bulk_load_sorter_t> > sorters;
+    std::vector<post_construct_traversal_helper_t::sindex_t> sindexes;
+    {
+        read_token_t read_token;
+        store->new_read_token(&read_token);
+
+        // Mind the destructor ordering.
+        // The superblock must be released before txn (`btree_parallel_traversal`
+        // usually already takes care of that).
+        // The txn must be destructed before the cache_account.
+        cache_account_t cache_account;
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+
+        store->acquire_superblock_for_read(
+            &read_token,
+            &txn,
+            &superblock,
+            interruptor,
+            true /* USE_SNAPSHOT */);
+
+        cache_account
+            = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
+        txn->set_account(&cache_account);
+
+        {
+            buf_lock_t sindex_block(superblock->expose_buf(),
+                                    superblock->get_sindex_block_id(),
+                                    access_t::read);
+            std::map<sindex_name_t, secondary_index_t> all_sindexes;
+            get_secondary_indexes(&sindex_block, &all_sindexes);
+            for (const auto &pair : all_sindexes) {
+                if (pair.second.being_deleted
+                    || !std_contains(sindexes_to_post_construct, pair.second.id)) {
+                    continue;
+                }
+                post_construct_traversal_helper_t::sindex_t sindex;
+                try {
+                    deserialize_sindex_info(pair.second.opaque_definition, &sindex.info);
+                } catch (const archive_exc_t &e) {
+                    crash("%s", e.what());
+                }
+                // The table's hash shards and the indexes in the batch share the
+                // memory for sorting evenly.
+                scoped_ptr_t<bulk_load_sorter_t> sorter(new bulk_load_sorter_t(
+                    store->io_backender_,
+                    store->base_path_,
+                    "post_construction_sort_" + uuid_to_str(pair.second.id),
+                    &store->perfmon_collection,
+                    SINDEX_POST_CONSTRUCTION_SORT_BUFFER_SIZE / CPU_SHARDING_FACTOR
+                        / sindexes_to_post_construct.size()));
+                sindex.sorter = sorter.get();
+                sindexes.push_back(sindex);
+                sorters[pair.second.id] = std::move(sorter);
+            }
+        }
+        if (sindexes.empty()) {
+            return;
+        }
+
+        post_construct_traversal_helper_t helper(store, sindexes);
+        helper.progress = &progress_tracker;
+        btree_parallel_traversal(superblock.get(), &helper, interruptor);
+    }
+
+    for (auto &pair : sorters) {
+        bulk_load_secondary_index(store, pair.first, pair.second.get(), interruptor);
+    }
+}
+
+void post_construct_secondary_indexes(
+        store_t *store,
+        const std::set<uuid_u> &sindexes_to_post_construct,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    // Every index that's being built holds a sorter until the traversal is done.  So
+    // that the sorters' shares of the memory don't get too small, we build only a few
+    // indexes per traversal, and traverse the primary btree again for the rest.
+    std::set<uuid_u> batch;
+    for (const uuid_u &id : sindexes_to_post_construct) {
+        batch.insert(id);
+        if (batch.size() == SINDEX_POST_CONSTRUCTION_MAX_SORTERS) {
+            post_construct_secondary_index_batch(store, batch, interruptor);
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) {
+        post_construct_secondary_index_batch(store, batch, interruptor);
+    }
 }
 
 void noop_value_deleter_t::delete_value(buf_parent_t, const void *) const { }
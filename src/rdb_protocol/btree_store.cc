@@ -11,6 +11,7 @@
 #include "btree/slice.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "buffer_cache/cache_warmer.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
@@ -163,6 +164,12 @@ store_t::~store_t() {
     }
 }
 
+void store_t::start_cache_warming(const std::string &path, uint64_t file_identity) {
+    assert_thread();
+    guarantee(!cache_warmer.has());
+    cache_warmer.init(new cache_warmer_t(cache.get(), path, file_identity));
+}
+
 void store_t::read(
         DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
         const read_t &read,
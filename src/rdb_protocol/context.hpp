@@ -25,6 +25,7 @@
 #include "rdb_protocol/geo/lon_lat_types.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
+#include "serializer/log/block_codec.hpp"
 
 enum class return_changes_t {
     NO = 0,
@@ -178,7 +179,8 @@ public:
     /* `table_create()` won't return until the table is ready for reading */
     virtual bool table_create(const name_string_t &name, counted_t<const ql::db_t> db,
             const table_generate_config_params_t &config_params,
-            const std::string &primary_key,
+            const std::string &primary_key, uint32_t block_size,
+            const boost::optional<block_codec_t> &block_codec,
             signal_t *interruptor, ql::datum_t *result_out, std::string *error_out) = 0;
     virtual bool table_drop(const name_string_t &name, counted_t<const ql::db_t> db,
             signal_t *interruptor, ql::datum_t *result_out, std::string *error_out) = 0;
@@ -173,6 +173,22 @@ env_t::env_t(signal_t *_interruptor, reql_version_t reql_version)
     rassert(interruptor != NULL);
 }
 
+env_t::env_t(signal_t *_interruptor,
+             reql_version_t reql_version,
+             std::map<std::string, wire_func_t> optargs,
+             configured_limits_t limits)
+    : global_optargs_(std::move(optargs)),
+      limits_(limits),
+      reql_version_(reql_version),
+      cache_(LRU_CACHE_SIZE),
+      interruptor(_interruptor),
+      trace(NULL),
+      evals_since_yield_(0),
+      rdb_ctx_(NULL),
+      eval_callback_(NULL) {
+    rassert(interruptor != NULL);
+}
+
 profile_bool_t profile_bool_optarg(const protob_t<Query> &query) {
     rassert(query.has());
     datum_t profile_arg = static_optarg("profile", query);
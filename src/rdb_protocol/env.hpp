@@ -71,6 +71,14 @@ public:
     // should be a dummy cond.)
     explicit env_t(signal_t *interruptor, reql_version_t reql_version);
 
+    // Used by the threads that help evaluating deterministic functions in parallel
+    // for an env on another thread.  There is no rdb context, but the optargs and
+    // limits are those of the other env.
+    env_t(signal_t *interruptor,
+          reql_version_t reql_version,
+          std::map<std::string, wire_func_t> optargs,
+          configured_limits_t limits);
+
     ~env_t();
 
     // Will yield after EVALS_BEFORE_YIELD calls
@@ -2,6 +2,7 @@
 #include "rdb_protocol/lazy_json.hpp"
 
 #include "containers/archive/buffer_group_stream.hpp"
+#include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
 
@@ -12,13 +13,22 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
                             blob::btree_maxreflen);
 
     ql::datum_t data;
-
-    blob_acq_t acq_group;
-    buffer_group_t buffer_group;
-    blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
-    buffer_group_read_stream_t read_stream(const_view(&buffer_group));
-    archive_result_t res
-        = datum_deserialize(&read_stream, &data);
+    archive_result_t res = archive_result_t::SUCCESS;
+
+    // Most values fit into a single block, and then we deserialize them straight out
+    // of it, without setting up a buffer group.
+    const bool read = blob.read_in_one_piece(parent,
+        [&](const char *buf, int64_t size) {
+            buffer_read_stream_t read_stream(buf, size);
+            res = datum_deserialize(&read_stream, &data);
+        });
+    if (!read) {
+        blob_acq_t acq_group;
+        buffer_group_t buffer_group;
+        blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
+        buffer_group_read_stream_t read_stream(const_view(&buffer_group));
+        res = datum_deserialize(&read_stream, &data);
+    }
     guarantee_deserialization(res, "rdb value");
 
     return data;
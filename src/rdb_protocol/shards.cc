@@ -6,10 +6,15 @@
 #include "errors.hpp"
 #include <boost/variant.hpp>
 
+#include "concurrency/work_stealing.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "debug.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "time.hpp"
 
 bool reversed(sorting_t sorting) { return sorting == sorting_t::DESCENDING; }
 
@@ -882,6 +887,116 @@ private:
     protob_t<const Backtrace> bt;
 };
 
+typedef std::vector<counted_t<const func_t> > transform_funcs_t;
+
+// Transforms element `i` of a batch, using `funcs` in `env`.
+typedef std::function<void(env_t *env, const transform_funcs_t &funcs, size_t i)>
+    element_transform_t;
+
+// Runs `transform` over the elements from `begin` to `end`, with the help of idle db
+// threads.  The functions and the `env_t` can't be shared between threads, so every
+// helper compiles its own copies of the functions and makes its own `env_t`, with the
+// same optargs and limits.  The datums can be shared.
+void transform_in_parallel(env_t *env,
+                           const transform_funcs_t &funcs,
+                           size_t begin, size_t end,
+                           const element_transform_t &transform) {
+    write_message_t wm;
+    for (const auto &func : funcs) {
+        serialize<cluster_version_t::CLUSTER>(&wm, func.has());
+        if (func.has()) {
+            serialize<cluster_version_t::CLUSTER>(&wm, wire_func_t(func));
+        }
+    }
+    // The functions may look at the optargs, and build arrays up to the limits.
+    serialize<cluster_version_t::CLUSTER>(&wm, env->get_all_optargs());
+    serialize<cluster_version_t::CLUSTER>(&wm, env->limits());
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    int write_res = send_write_message(&stream, &wm);
+    guarantee(write_res == 0);
+    const std::vector<char> &serialized = stream.vector();
+
+    const threadnum_t home_thread = get_thread_id();
+    const reql_version_t reql_version = env->reql_version();
+    const size_t chunk_size = PARALLEL_TRANSFORM_CHUNK_SIZE;
+    const size_t num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    steal_work(num_chunks, env->interruptor,
+               [&](chunk_dispenser_t *chunks, signal_t *interruptor) {
+        env_t *local_env = env;
+        const transform_funcs_t *local_funcs = &funcs;
+        scoped_ptr_t<env_t> helper_env;
+        transform_funcs_t helper_funcs;
+        if (get_thread_id().threadnum != home_thread.threadnum) {
+            buffer_read_stream_t read_stream(serialized.data(),
+                                             serialized.size());
+            for (size_t i = 0; i < funcs.size(); ++i) {
+                bool has_func;
+                archive_result_t res
+                    = deserialize<cluster_version_t::CLUSTER>(&read_stream, &has_func);
+                guarantee_deserialization(res, "parallel transform function");
+                if (has_func) {
+                    wire_func_t func;
+                    res = deserialize<cluster_version_t::CLUSTER>(&read_stream, &func);
+                    guarantee_deserialization(res, "parallel transform function");
+                    helper_funcs.push_back(func.compile_wire_func());
+                } else {
+                    helper_funcs.push_back(counted_t<const func_t>());
+                }
+            }
+            std::map<std::string, wire_func_t> optargs;
+            archive_result_t res
+                = deserialize<cluster_version_t::CLUSTER>(&read_stream, &optargs);
+            guarantee_deserialization(res, "parallel transform optargs");
+            configured_limits_t limits;
+            res = deserialize<cluster_version_t::CLUSTER>(&read_stream, &limits);
+            guarantee_deserialization(res, "parallel transform limits");
+            helper_env.init(new env_t(interruptor, reql_version, std::move(optargs),
+                                      limits));
+            local_env = helper_env.get();
+            local_funcs = &helper_funcs;
+        }
+
+        size_t chunk;
+        while (chunks->take(&chunk)) {
+            const size_t chunk_end = std::min(end, begin + (chunk + 1) * chunk_size);
+            for (size_t i = begin + chunk * chunk_size; i < chunk_end; ++i) {
+                transform(local_env, *local_funcs, i);
+            }
+        }
+    });
+}
+
+// Runs `transform` over the `size` elements of a batch.  Big batches are spread over
+// idle db threads when evaluating the functions turns out to be expensive, which we
+// find out by timing the first chunk.  Only deterministic functions can run elsewhere,
+// and we stay on this thread while profiling, so that the trace stays complete.
+void transform_elements(env_t *env,
+                        const transform_funcs_t &funcs,
+                        size_t size,
+                        const element_transform_t &transform) {
+    bool parallelizable = size >= PARALLEL_TRANSFORM_MIN_ELEMENTS && env->trace == NULL;
+    for (const auto &func : funcs) {
+        parallelizable = parallelizable && (!func.has() || func->is_deterministic());
+    }
+
+    size_t i = 0;
+    if (parallelizable) {
+        const ticks_t start = get_ticks();
+        for (; i < PARALLEL_TRANSFORM_CHUNK_SIZE; ++i) {
+            transform(env, funcs, i);
+        }
+        const ticks_t projected = (get_ticks() - start) * (size - i) / i;
+        if (projected >= PARALLEL_TRANSFORM_MIN_MS * MILLION) {
+            transform_in_parallel(env, funcs, i, size, transform);
+            return;
+        }
+    }
+    for (; i < size; ++i) {
+        transform(env, funcs, i);
+    }
+}
+
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
@@ -890,9 +1005,12 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
-            }
+            const transform_funcs_t funcs = { f };
+            transform_elements(env, funcs, lst->size(),
+                               [lst](env_t *local_env, const transform_funcs_t &fs,
+                                     size_t i) {
+                (*lst)[i] = fs[0]->call(local_env, (*lst)[i])->as_datum();
+            });
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace().get(), 1);
         }
@@ -941,18 +1059,25 @@ public:
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
-        auto it = lst->begin();
-        auto loc = it;
+        // The elements get filtered in place once we know which ones to keep.
+        std::vector<char> keep(lst->size());
         try {
-            for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
-                    std::swap(*loc, *it);
-                    ++loc;
-                }
-            }
+            const transform_funcs_t funcs = { f, default_val };
+            transform_elements(env, funcs, lst->size(),
+                               [lst, &keep](env_t *local_env,
+                                            const transform_funcs_t &fs, size_t i) {
+                keep[i] = fs[0]->filter_call(local_env, (*lst)[i], fs[1]);
+            });
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace().get(), 1);
         }
+        auto loc = lst->begin();
+        for (size_t i = 0; i < lst->size(); ++i) {
+            if (keep[i]) {
+                std::swap(*loc, (*lst)[i]);
+                ++loc;
+            }
+        }
         lst->erase(loc, lst->end());
     }
     counted_t<const func_t> f, default_val;
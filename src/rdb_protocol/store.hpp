@@ -38,6 +38,7 @@ class real_superblock_t;
 class superblock_t;
 class txn_t;
 class cache_balancer_t;
+class cache_warmer_t;
 struct rdb_modification_report_t;
 
 class sindex_not_ready_exc_t : public std::exception {
@@ -395,6 +396,11 @@ public:
 
     namespace_id_t const &get_table_id() const;
 
+    // Starts reloading the blocks listed in the file at `path` into the cache, and
+    // keeps that file up to date with the blocks that are hot from then on.  Lists
+    // that weren't saved with the same `file_identity` get ignored.
+    void start_cache_warming(const std::string &path, uint64_t file_identity);
+
     typedef std::map<uuid_u, std::pair<microtime_t, std::string> > sindex_jobs_t;
     sindex_jobs_t *get_sindex_jobs();
 
@@ -407,6 +413,8 @@ public:
     scoped_ptr_t<cache_t> cache;
     scoped_ptr_t<cache_conn_t> general_cache_conn;
     scoped_ptr_t<btree_slice_t> btree;
+    // Destroyed before the cache, which it saves the hot block list of.
+    scoped_ptr_t<cache_warmer_t> cache_warmer;
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
@@ -123,7 +123,8 @@ class table_create_term_t : public meta_op_term_t {
 public:
     table_create_term_t(compile_env_t *env, const protob_t<const Term> &term) :
         meta_op_term_t(env, term, argspec_t(1, 2),
-            optargspec_t({"primary_key", "shards", "replicas", "primary_replica_tag"})) { }
+            optargspec_t({"primary_key", "shards", "replicas", "primary_replica_tag",
+                          "block_size", "block_compression"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
             scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -148,6 +149,31 @@ private:
             primary_key = v->as_str().to_std();
         }
 
+        // Parse the 'block_size' optarg. Zero means the default block size.
+        uint32_t block_size = 0;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "block_size")) {
+            const int64_t size = v->as_int();
+            rcheck_target(v.get(), size >= MIN_BTREE_BLOCK_SIZE && size <= MAX_BTREE_BLOCK_SIZE
+                             && (size & (size - 1)) == 0,
+                          base_exc_t::GENERIC,
+                          strprintf("`block_size` must be a power of two between %lld "
+                                    "and %lld.", MIN_BTREE_BLOCK_SIZE,
+                                    MAX_BTREE_BLOCK_SIZE));
+            block_size = size;
+        }
+
+        // Parse the 'block_compression' optarg.  Without it, every server compresses
+        // the table's files according to its own `--block-compression`.
+        boost::optional<block_codec_t> block_codec;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "block_compression")) {
+            block_codec_t codec;
+            rcheck_target(v.get(), block_codec_from_name(v->as_str().to_std(), &codec),
+                          base_exc_t::GENERIC,
+                          "`block_compression` must be \"none\", \"zlib-fast\" or "
+                          "\"zlib-best\".");
+            block_codec = codec;
+        }
+
         counted_t<const db_t> db;
         name_string_t tbl_name;
         if (args->num_args() == 1) {
@@ -164,7 +190,8 @@ private:
         std::string error;
         ql::datum_t result;
         if (!env->env->reql_cluster_interface()->table_create(tbl_name, db,
-                config_params, primary_key, env->env->interruptor, &result, &error)) {
+                config_params, primary_key, block_size, block_codec,
+                env->env->interruptor, &result, &error)) {
             rfail(base_exc_t::GENERIC, "%s", error.c_str());
         }
         return new_val(result);
@@ -12,7 +12,7 @@ void serialize(write_message_t *wm, repli_timestamp_t tstamp) {
     serialize<W>(wm, tstamp.longtime);
 }
 
-template void serialize<cluster_version_t::v1_16_is_latest>(write_message_t *wm,
+template void serialize<cluster_version_t::v1_17_is_latest>(write_message_t *wm,
                                                             repli_timestamp_t tstamp);
 
 template <cluster_version_t W>
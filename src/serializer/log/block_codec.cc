@@ -0,0 +1,191 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/block_codec.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "config/args.hpp"
+#include "math.hpp"
+
+static int zlib_level(block_codec_t codec) {
+    switch (codec) {
+    case block_codec_t::zlib_fast: return Z_BEST_SPEED;
+    case block_codec_t::zlib_best: return Z_BEST_COMPRESSION;
+    case block_codec_t::none:
+    default:
+        unreachable();
+    }
+}
+
+bool block_codec_from_name(const std::string &name, block_codec_t *codec_out) {
+    if (name == "none") {
+        *codec_out = block_codec_t::none;
+    } else if (name == "zlib-fast") {
+        *codec_out = block_codec_t::zlib_fast;
+    } else if (name == "zlib-best") {
+        *codec_out = block_codec_t::zlib_best;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+buf_ptr_t compress_block(block_codec_t codec, const ser_buffer_t *block,
+                         block_size_t block_size) {
+    if (codec == block_codec_t::none) {
+        return buf_ptr_t();
+    }
+
+    // Compressing is only worth it if the block ends up taking at least one device
+    // block less on disk.
+    const uint32_t overhead = sizeof(ls_buf_data_t) + sizeof(compressed_block_header_t);
+    const uint32_t aligned_size = ceil_aligned(block_size.ser_value(), DEVICE_BLOCK_SIZE);
+    if (aligned_size < DEVICE_BLOCK_SIZE + overhead) {
+        return buf_ptr_t();
+    }
+    const uint32_t max_compressed_size = aligned_size - DEVICE_BLOCK_SIZE;
+
+    scoped_malloc_t<ser_buffer_t> buf(malloc_aligned(max_compressed_size,
+                                                     DEVICE_BLOCK_SIZE));
+    buf->ser_header = block->ser_header;
+    compressed_block_header_t *header
+        = reinterpret_cast<compressed_block_header_t *>(buf->cache_data);
+    Bytef *payload = reinterpret_cast<Bytef *>(buf->cache_data)
+        + sizeof(compressed_block_header_t);
+
+    uLongf payload_size = max_compressed_size - overhead;
+    const int res = compress2(payload, &payload_size,
+                              reinterpret_cast<const Bytef *>(block->cache_data),
+                              block_size.value(), zlib_level(codec));
+    if (res == Z_BUF_ERROR) {
+        // It didn't fit, so it's not worth it.
+        return buf_ptr_t();
+    }
+    guarantee(res == Z_OK, "compress2 failed with error %d", res);
+
+    header->codec = static_cast<uint8_t>(codec);
+    memset(header->reserved, 0, sizeof(header->reserved));
+    header->payload_size = payload_size;
+
+    const uint32_t compressed_size = ceil_aligned(overhead + payload_size,
+                                                  DEVICE_BLOCK_SIZE);
+    memset(payload + payload_size, 0, compressed_size - overhead - payload_size);
+    return buf_ptr_t(block_size_t::unsafe_make(compressed_size), std::move(buf));
+}
+
+buf_ptr_t decompress_block(const ser_buffer_t *compressed,
+                           block_size_t compressed_block_size,
+                           block_size_t block_size) {
+    const uint32_t overhead = sizeof(ls_buf_data_t) + sizeof(compressed_block_header_t);
+    guarantee(compressed_block_size.ser_value() >= overhead);
+
+    const compressed_block_header_t *header
+        = reinterpret_cast<const compressed_block_header_t *>(compressed->cache_data);
+    const Bytef *payload = reinterpret_cast<const Bytef *>(compressed->cache_data)
+        + sizeof(compressed_block_header_t);
+    guarantee(header->payload_size <= compressed_block_size.ser_value() - overhead,
+              "Compressed block %" PR_BLOCK_ID " has a corrupted header.",
+              compressed->ser_header.block_id);
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header = compressed->ser_header;
+
+    switch (static_cast<block_codec_t>(header->codec)) {
+    case block_codec_t::zlib_fast:  // fallthrough
+    case block_codec_t::zlib_best: {
+        uLongf size = block_size.value();
+        const int res = uncompress(reinterpret_cast<Bytef *>(ret.cache_data()), &size,
+                                   payload, header->payload_size);
+        guarantee(res == Z_OK && size == block_size.value(),
+                  "Could not decompress block %" PR_BLOCK_ID " (error %d).",
+                  compressed->ser_header.block_id, res);
+    } break;
+    case block_codec_t::none:
+    default:
+        crash("Block %" PR_BLOCK_ID " was compressed with an unknown codec %u.",
+              compressed->ser_header.block_id, header->codec);
+    }
+
+    ret.fill_padding_zero();
+    return ret;
+}
+
+uint32_t block_checksum(const ser_buffer_t *block, block_size_t stored_block_size) {
+    const uint32_t crc = crc32c(0, block, stored_block_size.ser_value());
+    // A block whose CRC happens to be zero still gets checked, if a little less
+    // thoroughly.
+    return crc == NO_BLOCK_CHECKSUM ? 1 : crc;
+}
+
+bool block_checksum_matches(const ser_buffer_t *block, block_size_t stored_block_size,
+                            uint32_t checksum) {
+    return checksum == NO_BLOCK_CHECKSUM
+        || checksum == block_checksum(block, stored_block_size);
+}
+
+// The reflected Castagnoli polynomial.
+static const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+class crc32c_table_t {
+public:
+    crc32c_table_t() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLYNOMIAL : 0);
+            }
+            table_[i] = crc;
+        }
+    }
+    uint32_t operator[](uint8_t i) const { return table_[i]; }
+private:
+    uint32_t table_[256];
+};
+
+static uint32_t crc32c_portable(uint32_t crc, const uint8_t *data, size_t size) {
+    static const crc32c_table_t table;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[static_cast<uint8_t>(crc ^ data[i])] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((__target__("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *data, size_t size) {
+    uint64_t crc64 = crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += sizeof(uint64_t);
+    }
+    uint32_t crc32 = crc64;
+    for (; size > 0; --size) {
+        crc32 = _mm_crc32_u8(crc32, *data);
+        ++data;
+    }
+    return crc32;
+}
+
+static bool cpu_has_sse42() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+#if defined(__x86_64__)
+    static const bool has_sse42 = cpu_has_sse42();
+    if (has_sse42) {
+        return ~crc32c_sse42(crc, bytes, size);
+    }
+#endif
+    return ~crc32c_portable(crc, bytes, size);
+}
@@ -0,0 +1,73 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_CODEC_HPP_
+#define SERIALIZER_LOG_BLOCK_CODEC_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "containers/archive/archive.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+
+/* How the log serializer encodes data blocks on disk.  The codec is chosen per
+serializer through `log_serializer_dynamic_config_t`.  A table's file gets the codec
+the table was created with, or the server's `--block-compression` if it has none.  It
+only affects how new blocks get written.  Every compressed block records the codec it
+was written with, so changing the setting between runs is fine. */
+enum class block_codec_t : uint8_t {
+    // Store blocks as they are.
+    none = 0,
+    // zlib at its fastest level, for tables that see a lot of writes.
+    zlib_fast = 1,
+    // zlib at its best level, for cold tables that are mostly read.
+    zlib_best = 2
+};
+
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(block_codec_t, int8_t,
+                                      block_codec_t::none,
+                                      block_codec_t::zlib_best);
+
+/* The codecs' names for the user are "none", "zlib-fast" and "zlib-best".  Returns
+false if `name` isn't one of them. */
+bool block_codec_from_name(const std::string &name, block_codec_t *codec_out);
+
+/* A compressed block is laid out as the uncompressed `ls_buf_data_t` (so that the
+garbage collector and read-ahead can still tell which block it is), followed by this
+header, followed by the compressed cache data. */
+struct compressed_block_header_t {
+    uint8_t codec;
+    uint8_t reserved[3];
+    uint32_t payload_size;
+} __attribute__((__packed__));
+
+/* Tries to compress `block`, whose size is `block_size`.  Returns a buf whose
+block_size() is the size of the compressed block rounded up to a whole number of
+device blocks (the LBA doesn't record it more precisely), or an empty buf if `codec` is
+`none` or compressing the block wouldn't save at least one device block.  Everything
+after the payload is zeroed, so it can be written to disk as it is. */
+buf_ptr_t compress_block(block_codec_t codec, const ser_buffer_t *block,
+                         block_size_t block_size);
+
+/* Turns a block that `compress_block` produced back into the original, which has
+the size `block_size`.  Crashes if the block is corrupted. */
+buf_ptr_t decompress_block(const ser_buffer_t *compressed,
+                           block_size_t compressed_block_size,
+                           block_size_t block_size);
+
+/* The log serializer records a CRC32C of every block it writes, as the block is
+stored on disk (that is, of the compressed block if it's compressed), in the block's
+LBA entry.  Reads and the scrubber check blocks against it.  Blocks from files written
+before there were checksums have `NO_BLOCK_CHECKSUM` there and don't get checked.
+`stored_block_size` is the size of the block as it's written to disk. */
+static const uint32_t NO_BLOCK_CHECKSUM = 0;
+uint32_t block_checksum(const ser_buffer_t *block, block_size_t stored_block_size);
+bool block_checksum_matches(const ser_buffer_t *block, block_size_t stored_block_size,
+                            uint32_t checksum);
+
+/* Updates the CRC32C (Castagnoli) checksum `crc` with `size` bytes at `data`.  Uses
+the SSE 4.2 crc32 instruction if the CPU has it. */
+uint32_t crc32c(uint32_t crc, const void *data, size_t size);
+
+#endif  // SERIALIZER_LOG_BLOCK_CODEC_HPP_
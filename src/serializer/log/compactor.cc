@@ -0,0 +1,86 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/compactor.hpp"
+
+#include <functional>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "logger.hpp"
+#include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/extent_manager.hpp"
+#include "serializer/log/log_serializer.hpp"
+
+// We compact a file once at least this share of its extents is free...
+const double COMPACTION_MIN_FREE_RATIO = 0.25;
+// ... and at least this many of them.
+const size_t COMPACTION_MIN_FREE_EXTENTS = 32;
+
+// How many extents more than the ones in use we leave in the compacted file.  The
+// active extents and young extents can't be moved right away, and we don't want to
+// chase after them.
+const size_t COMPACTION_SLACK_EXTENTS = 8;
+
+file_compactor_t::file_compactor_t(log_serializer_t *serializer)
+    : serializer_(serializer), active_(false) {
+    coro_t::spawn_sometime(std::bind(&file_compactor_t::run, this, drainer_.lock()));
+}
+
+file_compactor_t::~file_compactor_t() {
+    assert_thread();
+    drainer_.drain();
+}
+
+void file_compactor_t::run(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    try {
+        for (;;) {
+            nap(COMPACTION_CHECK_INTERVAL_MS, keepalive.get_drain_signal());
+            if (should_compact()) {
+                compact(keepalive.get_drain_signal());
+            }
+        }
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+    active_ = false;
+}
+
+bool file_compactor_t::should_compact() const {
+    const size_t free_extents = serializer_->extent_manager->held_extents();
+    return free_extents >= COMPACTION_MIN_FREE_EXTENTS
+        && free_extents >= COMPACTION_MIN_FREE_RATIO
+                           * serializer_->extent_manager->num_extents();
+}
+
+void file_compactor_t::compact(signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    extent_manager_t *const extent_manager = serializer_->extent_manager;
+    const size_t extents_before = extent_manager->num_extents();
+    size_t moved_extents = 0;
+
+    active_ = true;
+    for (;;) {
+        // Everything in use would fit into the first `in_use` extents, so the extents
+        // after that (and some slack) are the ones we move.  There's always a free
+        // extent in front of that boundary for their blocks to go to.
+        const size_t in_use = extent_manager->num_extents()
+            - extent_manager->held_extents();
+        const int64_t min_offset
+            = (in_use + COMPACTION_SLACK_EXTENTS) * extent_manager->extent_size;
+        if (!serializer_->data_block_manager->compact_one_extent(min_offset)) {
+            break;
+        }
+        ++moved_extents;
+        nap(COMPACTION_EXTENT_DELAY_MS, interruptor);
+    }
+    const size_t punched_extents = extent_manager->punch_free_extents();
+    active_ = false;
+
+    if (moved_extents == 0 && punched_extents == 0) {
+        return;
+    }
+    logNTC("Compacted a data file from %zu to %zu extents, moving %zu of them.  "
+           "Punched %zu free extents out of the file.",
+           extents_before, extent_manager->num_extents(), moved_extents,
+           punched_extents);
+}
@@ -0,0 +1,50 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_COMPACTOR_HPP_
+#define SERIALIZER_LOG_COMPACTOR_HPP_
+
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/interruptor.hpp"
+#include "threading.hpp"
+
+class log_serializer_t;
+class signal_t;
+
+namespace unittest { class log_serializer_tester_t; }
+
+/* The extent manager hands out the free extent closest to the start of the file, and
+the file shrinks whenever the extents at its end become free.  After a lot of data
+has been deleted, that isn't enough: the remaining data is spread all over the file,
+so the file keeps its size.  The compactor notices when much of a data file is free,
+and then moves the data extents from the end of the file into the free space further
+up front, using the garbage collector's write path.  The extents it empties out at
+the end get truncated away.  Free extents that are still stuck in between extents in
+use afterwards (for example because an LBA extent sits behind them) get their disk
+space punched out of the file instead, where the file system supports that.
+
+While it's moving extents, the serializer reports its GC as active, which shows up
+as a `disk_compaction` job in `rethinkdb.jobs`. */
+class file_compactor_t : public home_thread_mixin_t {
+public:
+    // Must be constructed once `serializer` is ready, and destroyed before it shuts
+    // down.
+    explicit file_compactor_t(log_serializer_t *serializer);
+    ~file_compactor_t();
+
+    bool is_active() const { return active_; }
+
+private:
+    friend class unittest::log_serializer_tester_t;
+
+    void run(auto_drainer_t::lock_t keepalive);
+    bool should_compact() const;
+    void compact(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+    log_serializer_t *const serializer_;
+    bool active_;
+
+    auto_drainer_t drainer_;
+
+    DISABLE_COPYING(file_compactor_t);
+};
+
+#endif  // SERIALIZER_LOG_COMPACTOR_HPP_
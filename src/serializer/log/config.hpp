@@ -6,6 +6,7 @@
 
 #include "config/args.hpp"
 #include "containers/archive/archive.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
@@ -15,6 +16,7 @@ struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
         io_batch_factor = DEFAULT_IO_BATCH_FACTOR;
+        block_codec = block_codec_t::none;
     }
 
     /* The (minimal) batch size of i/o requests being taken from a single i/o account.
@@ -24,6 +26,10 @@ struct log_serializer_dynamic_config_t {
 
     /* Enable reading more data than requested to let the cache warmup more quickly esp. on rotational drives */
     bool read_ahead;
+
+    /* How to compress data blocks as they get written.  Blocks that don't compress
+    well enough to save disk space are stored as they are either way. */
+    block_codec_t block_codec;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <functional>
 
 #include "arch/arch.hpp"
@@ -13,6 +14,7 @@
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -51,6 +53,11 @@ const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
 const microtime_t GC_YOUNG_EXTENT_TIMELIMIT_MICROS = 50000;
 
+// How often the GC re-sorts its candidates by cost-benefit, in microseconds.
+// Extent ages are measured against a clock that only advances this often, so that
+// the order of `gc_pq` stays consistent in between.
+const microtime_t GC_COST_BENEFIT_CLOCK_INTERVAL_MICROS = 1000000;
+
 
 // Identifies an extent, the time we started writing to the
 // extent, whether it's the extent we're currently writing to, and
@@ -60,6 +67,8 @@ private:
     struct block_info_t {
         uint32_t relative_offset;
         block_size_t block_size;
+        // Smaller than block_size if the block is stored compressed.
+        block_size_t stored_block_size;
         bool token_referenced;
         bool index_referenced;
     };
@@ -70,6 +79,8 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->gen_extent()),
           timestamp(current_microtime()),
+          data_timestamp(timestamp),
+          holds_relocated_data(false),
           was_written(false),
           state(state_active),
           garbage_bytes_stat(_parent->static_config->extent_size()),
@@ -84,6 +95,8 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->reserve_extent(_offset)),
           timestamp(current_microtime()),
+          data_timestamp(timestamp),
+          holds_relocated_data(false),
           was_written(false),
           state(state_reconstructing),
           garbage_bytes_stat(_parent->static_config->extent_size()),
@@ -125,17 +138,24 @@ public:
         return block_infos.empty()
             ? 0
             : block_infos.back().relative_offset
-            + aligned_value(block_infos.back().block_size);
+            + aligned_value(block_infos.back().stored_block_size);
     }
 
-    // Returns the ostensible size of the block_index'th block.  Note that
-    // block_boundaries[i] + block_size(i) <= block_boundaries[i + 1].
+    // Returns the ostensible size of the block_index'th block.
     block_size_t block_size(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(block_index < block_infos.size());
         return block_infos[block_index].block_size;
     }
 
+    // Returns the size the block_index'th block takes up in the extent.  Note that
+    // block_boundaries[i] + stored_block_size(i) <= block_boundaries[i + 1].
+    block_size_t stored_block_size(unsigned int block_index) const {
+        guarantee(state != state_reconstructing);
+        guarantee(block_index < block_infos.size());
+        return block_infos[block_index].stored_block_size;
+    }
+
     // Returns block_boundaries()[block_index].
     uint32_t relative_offset(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
@@ -155,22 +175,24 @@ public:
     }
 
     bool new_offset(block_size_t block_size,
+                    block_size_t stored_block_size,
                     uint32_t *relative_offset_out,
                     unsigned int *block_index_out) {
         // Returns true if there's enough room at the end of the extent for the new
         // block.
         guarantee(state == state_active);
-        guarantee(block_size.ser_value() <= parent->static_config->extent_size());
+        guarantee(stored_block_size.ser_value() <= parent->static_config->extent_size());
 
         uint32_t offset = back_relative_offset();
         guarantee(offset <= parent->static_config->extent_size());
 
-        if (offset > parent->static_config->extent_size() - block_size.ser_value()) {
+        if (offset > parent->static_config->extent_size() - stored_block_size.ser_value()) {
             return false;
         } else {
             *relative_offset_out = offset;
             *block_index_out = block_infos.size();
-            block_infos.push_back(block_info_t{offset, block_size, false, false});
+            block_infos.push_back(block_info_t{offset, block_size, stored_block_size,
+                                               false, false});
             update_stats(NULL, &block_infos.back());
             return true;
         }
@@ -195,6 +217,34 @@ public:
         return garbage_bytes_stat;
     }
 
+    double cost_benefit() const {
+        const microtime_t clock = parent->gc_clock;
+        return gc_cost_benefit(garbage_bytes(), parent->static_config->extent_size(),
+                               clock > data_timestamp ? clock - data_timestamp : 0);
+    }
+
+    // Called when fresh blocks have been written to this extent at `now`.
+    void note_new_data(microtime_t now) {
+        if (!holds_relocated_data) {
+            data_timestamp = now;
+        }
+    }
+
+    // Called when the GC has moved blocks from an extent whose data was last
+    // written at `victim_data_timestamp` to this one.  The extent's data is as
+    // young as the youngest data that got moved in.
+    void note_relocated_data(microtime_t victim_data_timestamp) {
+        if (!holds_relocated_data) {
+            holds_relocated_data = true;
+            data_timestamp = victim_data_timestamp;
+        } else {
+            data_timestamp = std::max(data_timestamp, victim_data_timestamp);
+        }
+        if (state == state_old) {
+            our_pq_entry->update();
+        }
+    }
+
     bool block_is_garbage(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(block_index < block_infos.size());
@@ -221,7 +271,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->token_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->stored_block_size);
             }
         }
         return b;
@@ -235,22 +285,29 @@ public:
         return std::lower_bound(block_infos.begin(), block_infos.end(), relative_offset, &gc_entry_t::info_less);
     }
 
-    void mark_live_indexwise_with_offset(int64_t offset, block_size_t block_size) {
+    void mark_live_indexwise_with_offset(int64_t offset, block_size_t block_size,
+                                         block_size_t stored_block_size) {
         guarantee(offset >= extent_ref.offset() && offset < extent_ref.offset() + UINT32_MAX);
 
         uint32_t relative_offset = offset - extent_ref.offset();
 
         auto it = find_lower_bound_iter(relative_offset);
         if (it == block_infos.end()) {
-            block_infos.push_back(block_info_t{relative_offset, block_size, false, true});
+            block_infos.push_back(block_info_t{relative_offset, block_size,
+                                               stored_block_size, false, true});
             update_stats(NULL, &block_infos.back());
         } else if (it->relative_offset > relative_offset) {
-            guarantee(it->relative_offset >= relative_offset + aligned_value(block_size));
-            auto new_block = block_infos.insert(it, block_info_t{relative_offset, block_size, false, true});
+            guarantee(it->relative_offset
+                      >= relative_offset + aligned_value(stored_block_size));
+            auto new_block = block_infos.insert(it, block_info_t{relative_offset,
+                                                                 block_size,
+                                                                 stored_block_size,
+                                                                 false, true});
             update_stats(NULL, &*new_block);
         } else {
             guarantee(it->relative_offset == relative_offset);
             guarantee(it->block_size == block_size);
+            guarantee(it->stored_block_size == stored_block_size);
             const block_info_t old_info = *it;
             it->index_referenced = true;
             update_stats(&old_info, &*it);
@@ -274,7 +331,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->index_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->stored_block_size);
             }
         }
         return b;
@@ -291,7 +348,8 @@ public:
         for (auto it = block_infos.begin(); it != block_infos.end(); ++it) {
             ret += strprintf("%s[%" PRIi64 "..+%" PRIu32 ") %c%c",
                              it == block_infos.begin() ? "" : separator,
-                             offset + it->relative_offset, it->block_size.ser_value(),
+                             offset + it->relative_offset,
+                             it->stored_block_size.ser_value(),
                              it->token_referenced ? 'T' : ' ',
                              it->index_referenced ? 'I' : ' ');
         }
@@ -313,14 +371,14 @@ private:
             if (old_block->token_referenced || old_block->index_referenced) {
                 // Block is live
                 num_live_blocks_stat -= 1;
-                garbage_bytes_stat += aligned_value(old_block->block_size);
+                garbage_bytes_stat += aligned_value(old_block->stored_block_size);
             }
         }
         // Apply new_block
         if (new_block->token_referenced || new_block->index_referenced) {
             // Block is live
             num_live_blocks_stat += 1;
-            garbage_bytes_stat -= aligned_value(new_block->block_size);
+            garbage_bytes_stat -= aligned_value(new_block->stored_block_size);
         }
     }
 
@@ -342,6 +400,13 @@ public:
     // When we started writing to the extent (this time).
     const microtime_t timestamp;
 
+    // When the data in the extent was last written, or when we started up for
+    // extents we found on disk.  For extents that the GC has moved blocks into, it's
+    // when the youngest of those blocks was originally written, which is older than
+    // when it got moved.
+    microtime_t data_timestamp;
+    bool holds_relocated_data;
+
     // The PQ entry pointing to us.
     priority_queue_t<gc_entry_t *, gc_entry_less_t>::entry_t *our_pq_entry;
 
@@ -383,7 +448,8 @@ data_block_manager_t::data_block_manager_t(
         log_serializer_stats_t *_stats)
     : stats(_stats), shutdown_callback(NULL), state(state_unstarted),
       static_config(_static_config), extent_manager(em), serializer(_serializer),
-      gc_stats(stats)
+      active_extent(NULL), active_cold_extent(NULL),
+      gc_clock(current_microtime()), gc_stats(stats)
 {
     rassert(static_config != NULL);
     rassert(extent_manager != NULL);
@@ -406,7 +472,8 @@ void data_block_manager_t::start_reconstruct() {
 // gc_entry_t in the entries table.  (This is used when we start up, when
 // everything is presumed to be garbage, until we mark it as
 // non-garbage.)
-void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size) {
+void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size,
+                                     block_size_t stored_block_size) {
     uint64_t extent_id = static_config->extent_index(offset);
 
     if (entries.get(extent_id) == NULL) {
@@ -417,7 +484,7 @@ void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size
     }
 
     gc_entry_t *entry = entries.get(extent_id);
-    entry->mark_live_indexwise_with_offset(offset, ser_block_size);
+    entry->mark_live_indexwise_with_offset(offset, ser_block_size, stored_block_size);
 }
 
 void data_block_manager_t::end_reconstruct() {
@@ -455,6 +522,11 @@ void data_block_manager_t::start_existing(file_t *file,
         active_extent = NULL;
     }
 
+    /* The active cold extent isn't recorded in the metablock.  If it had any live
+    blocks, it was reconstructed like any other extent and becomes an old extent
+    below. */
+    active_cold_extent = NULL;
+
     /* Convert any extents that we found live blocks in, but that are not active
     extents, into old extents */
     while (gc_entry_t *entry = reconstructed_extents.head()) {
@@ -639,14 +711,31 @@ public:
                 }
 
                 const block_size_t block_size = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
-                buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                const block_size_t stored_block_size
+                    = block_size_t::unsafe_make(info.stored_block_size());
+                guarantee(stored_block_size.ser_value() <= *(lower_it + 1) - *lower_it);
+                if (!block_checksum_matches(
+                        reinterpret_cast<const ser_buffer_t *>(current_buf),
+                        stored_block_size, info.checksum)) {
+                    // Leave it to the regular read path to complain about it.
+                    continue;
+                }
+                buf_ptr_t buf;
+                if (stored_block_size != block_size) {
+                    buf = decompress_block(
+                        reinterpret_cast<const ser_buffer_t *>(current_buf),
+                        stored_block_size, block_size);
+                } else {
+                    buf = buf_ptr_t::alloc_uninitialized(block_size);
+                    memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                    buf.fill_padding_zero();
+                }
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               stored_block_size,
+                                                               info.checksum);
 
                 counted_t<standard_block_token_t> token
                     = to_standard_block_token(block_id, std::move(ls_token));
@@ -674,11 +763,103 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t stored_block_size,
+                                     uint32_t checksum,
+                                     file_account_t *io_account) {
+    guarantee(state == state_ready);
+    return decode_stored(read_stored(off_in, stored_block_size, io_account),
+                         off_in, block_size, stored_block_size, checksum);
+}
+
+buf_ptr_t data_block_manager_t::decode_stored(buf_ptr_t &&stored, int64_t off_in,
+                                              block_size_t block_size,
+                                              block_size_t stored_block_size,
+                                              uint32_t checksum) {
+    guarantee(block_checksum_matches(stored.ser_buffer(), stored_block_size, checksum),
+              "Block %" PR_BLOCK_ID " at offset %" PRIi64 " failed its checksum "
+              "check.  The data file is corrupted.",
+              stored.ser_buffer()->ser_header.block_id, off_in);
+    if (stored_block_size == block_size) {
+        return std::move(stored);
+    }
+    return decompress_block(stored.ser_buffer(), stored_block_size, block_size);
+}
+
+// Blocks that are at most this far apart get read together, wasting the bytes in
+// between...
+const int64_t READ_MANY_MAX_GAP = 16 * KILOBYTE;
+// ... as long as a single read doesn't get bigger than this.
+const int64_t READ_MANY_MAX_READ_SIZE = MEGABYTE;
+
+std::vector<buf_ptr_t>
+data_block_manager_t::read_many(
+        const std::vector<counted_t<ls_block_token_pointee_t> > &tokens,
+        file_account_t *io_account) {
     guarantee(state == state_ready);
+
+    std::vector<size_t> order(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+        return tokens[x]->offset() < tokens[y]->offset();
+    });
+
+    std::vector<buf_ptr_t> ret(tokens.size());
+    size_t run_begin = 0;
+    while (run_begin < order.size()) {
+        const int64_t begin_off = tokens[order[run_begin]]->offset();
+        const uint64_t extent_id = static_config->extent_index(begin_off);
+        int64_t end_off = begin_off
+            + tokens[order[run_begin]]->stored_block_size().ser_value();
+        size_t run_end = run_begin + 1;
+        for (; run_end < order.size(); ++run_end) {
+            const counted_t<ls_block_token_pointee_t> &token = tokens[order[run_end]];
+            const int64_t block_end = token->offset()
+                + token->stored_block_size().ser_value();
+            if (static_config->extent_index(token->offset()) != extent_id
+                || token->offset() > end_off + READ_MANY_MAX_GAP
+                || block_end - begin_off > READ_MANY_MAX_READ_SIZE) {
+                break;
+            }
+            end_off = std::max(end_off, block_end);
+        }
+
+        if (run_end - run_begin == 1) {
+            const counted_t<ls_block_token_pointee_t> &token = tokens[order[run_begin]];
+            ret[order[run_begin]] = read(token->offset(), token->block_size(),
+                                         token->stored_block_size(), token->checksum(),
+                                         io_account);
+        } else {
+            const int64_t floor_off = floor_aligned(begin_off, DEVICE_BLOCK_SIZE);
+            const int64_t ceil_end = ceil_aligned(end_off, DEVICE_BLOCK_SIZE);
+            scoped_malloc_t<char> buf(malloc_aligned(ceil_end - floor_off,
+                                                     DEVICE_BLOCK_SIZE));
+            co_read(dbfile, floor_off, ceil_end - floor_off, buf.get(), io_account);
+            stats->bytes_read(ceil_end - floor_off);
+
+            for (size_t i = run_begin; i < run_end; ++i) {
+                const counted_t<ls_block_token_pointee_t> &token = tokens[order[i]];
+                const block_size_t stored_block_size = token->stored_block_size();
+                buf_ptr_t stored = buf_ptr_t::alloc_uninitialized(stored_block_size);
+                memcpy(stored.ser_buffer(), buf.get() + (token->offset() - floor_off),
+                       stored_block_size.ser_value());
+                stored.fill_padding_zero();
+                ret[order[i]] = decode_stored(std::move(stored), token->offset(),
+                                              token->block_size(), stored_block_size,
+                                              token->checksum());
+            }
+        }
+        run_begin = run_end;
+    }
+    return ret;
+}
+
+buf_ptr_t data_block_manager_t::read_stored(int64_t off_in, block_size_t stored_block_size,
+                                            file_account_t *io_account) {
     if (should_perform_read_ahead(off_in)) {
-        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-        dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
+        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(stored_block_size);
+        dbm_read_ahead_t::perform_read_ahead(this, off_in, stored_block_size.ser_value(),
                                              ret.ser_buffer(), io_account, stats);
         // We have to fill the padding with zero, since only the first part of the
         // buf got memcpy'd into.
@@ -686,7 +867,7 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
         return ret;
     } else {
         if (divides(DEVICE_BLOCK_SIZE, off_in)) {
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(stored_block_size);
             co_read(dbfile, off_in, ret.aligned_block_size(),
                     ret.ser_buffer(), io_account);
             stats->bytes_read(ret.aligned_block_size());
@@ -696,16 +877,16 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
             return ret;
         } else {
             int64_t floor_off_in = floor_aligned(off_in, DEVICE_BLOCK_SIZE);
-            int64_t ceil_off_end = ceil_aligned(off_in + block_size.ser_value(),
+            int64_t ceil_off_end = ceil_aligned(off_in + stored_block_size.ser_value(),
                                                 DEVICE_BLOCK_SIZE);
             scoped_malloc_t<char> buf(malloc_aligned(ceil_off_end - floor_off_in,
                                                      DEVICE_BLOCK_SIZE));
             co_read(dbfile, floor_off_in, ceil_off_end - floor_off_in,
                     buf.get(), io_account);
 
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(stored_block_size);
             memcpy(ret.ser_buffer(), buf.get() + (off_in - floor_off_in),
-                   block_size.ser_value());
+                   stored_block_size.ser_value());
             stats->bytes_read(ret.aligned_block_size());
             // We have to fill the padding to zero, in this case.
             ret.fill_padding_zero();
@@ -718,15 +899,47 @@ std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
-    // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
-        = gimme_some_new_offsets(writes);
+    const block_codec_t codec = serializer->dynamic_config.block_codec;
+
+    std::vector<encoded_write_t> encoded_writes;
+    encoded_writes.reserve(writes.size());
+    std::vector<buf_ptr_t> compressed_bufs;
 
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         it->buf->ser_header.block_id = it->block_id;
+
+        buf_ptr_t compressed = compress_block(codec, it->buf, it->block_size);
+        if (compressed.has()) {
+            ++stats->pm_serializer_compressed_block_writes;
+            stats->pm_serializer_compression_saved_bytes
+                += gc_entry_t::aligned_value(it->block_size)
+                - compressed.aligned_block_size();
+            encoded_writes.push_back(encoded_write_t(
+                compressed.ser_buffer(), it->block_size, compressed.block_size(),
+                block_checksum(compressed.ser_buffer(), compressed.block_size())));
+            compressed_bufs.push_back(std::move(compressed));
+        } else {
+            encoded_writes.push_back(encoded_write_t(
+                it->buf, it->block_size, it->block_size,
+                block_checksum(it->buf, it->block_size)));
+        }
     }
 
+    return write_encoded(encoded_writes, std::move(compressed_bufs), io_account, cb,
+                         write_temperature_t::hot);
+}
+
+std::vector<counted_t<ls_block_token_pointee_t> >
+data_block_manager_t::write_encoded(const std::vector<encoded_write_t> &writes,
+                                    std::vector<buf_ptr_t> &&owned_bufs,
+                                    file_account_t *io_account,
+                                    iocallback_t *cb,
+                                    write_temperature_t temperature) {
+    // These tokens are grouped by extent.  You can do a contiguous write in each
+    // extent.
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
+        = gimme_some_new_offsets(writes, temperature);
+
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -739,9 +952,11 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        std::vector<buf_ptr_t> owned_bufs;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
+    intermediate_cb->owned_bufs = std::move(owned_bufs);
     // We add 1 for degenerate case where token_groups is empty -- we call
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
@@ -752,7 +967,7 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->stored_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -765,14 +980,15 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_stored_block_size
+                = token_groups[i][j]->stored_block_size();
             guarantee(j_offset == last_written_offset);
-            const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
+            const size_t j_aligned_size = gc_entry_t::aligned_value(j_stored_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
             // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            guarantee(writes[write_number].stored_block_size == j_stored_block_size);
 
             iovecs[j].iov_base = writes[write_number].buf;
             iovecs[j].iov_len = j_aligned_size;
@@ -933,7 +1149,7 @@ void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *tx
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->stored_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -963,7 +1179,7 @@ void data_block_manager_t::mark_garbage_tokenwise_with_offset(int64_t offset) {
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->stored_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -1014,6 +1230,63 @@ void data_block_manager_t::run_gc(gc_state_t *gc_state) {
 }
 
 void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
+    gc_entry_t *entry;
+    {
+        ASSERT_NO_CORO_WAITING;
+        advance_gc_clock();
+        guarantee(!gc_pq.empty());
+        entry = gc_pq.pop();
+        entry->our_pq_entry = NULL;
+    }
+    relocate_extent(gc_state, entry);
+}
+
+bool data_block_manager_t::compact_one_extent(int64_t min_offset) {
+    guarantee(state == state_ready);
+    gc_entry_t *entry = NULL;
+    {
+        ASSERT_NO_CORO_WAITING;
+
+        // The active extents don't get relocated, but we can stop writing to them
+        // so that the next blocks go to the free space further up front.
+        for (gc_entry_t **active : { &active_extent, &active_cold_extent }) {
+            if (*active != NULL && (*active)->extent_ref.offset() >= min_offset) {
+                retire_active_entry(active);
+            }
+        }
+
+        // Find the extent closest to the end of the file that we can relocate.
+        // Young extents will be old the next time around.
+        const uint64_t min_extent_id = static_config->extent_index(min_offset);
+        for (uint64_t extent_id = extent_manager->num_extents();
+             extent_id > min_extent_id;
+             --extent_id) {
+            gc_entry_t *candidate = entries.get(extent_id - 1);
+            if (candidate != NULL && candidate->state == gc_entry_t::state_old) {
+                entry = candidate;
+                break;
+            }
+        }
+        if (entry == NULL) {
+            return false;
+        }
+
+        gc_pq.remove(entry->our_pq_entry);
+        entry->our_pq_entry = NULL;
+        ++stats->pm_serializer_data_extents_compacted;
+    }
+
+    // Relocating the extent works just like GCing it, so it needs a `gc_state_t` in
+    // `active_gcs` for `check_and_handle_empty_extent()` to find.
+    gc_state_t *gc_state = new gc_state_t();
+    active_gcs.push_back(gc_state);
+    relocate_extent(gc_state, entry);
+    active_gcs.remove(gc_state);
+    delete gc_state;
+    return true;
+}
+
+void data_block_manager_t::relocate_extent(gc_state_t *gc_state, gc_entry_t *entry) {
     // A buffer for blocks we're transferring.
     scoped_malloc_t<char> gc_blocks;
     size_t total_bytes_read = 0;
@@ -1040,10 +1313,9 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
         ++stats->pm_serializer_data_extents_gced;
 
         /* grab the entry */
-        guarantee (!gc_pq.empty());
         guarantee(gc_state->current_entry == NULL);
-        gc_state->current_entry = gc_pq.pop();
-        gc_state->current_entry->our_pq_entry = NULL;
+        guarantee(entry->our_pq_entry == NULL);
+        gc_state->current_entry = entry;
 
         guarantee(gc_state->current_entry->state == gc_entry_t::state_old);
         gc_state->current_entry->state = gc_entry_t::state_in_gc;
@@ -1079,7 +1351,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
                 const uint32_t end
                     = gc_state->current_entry->relative_offset(i)
-                    + gc_entry_t::aligned_value(gc_state->current_entry->block_size(i));
+                    + gc_entry_t::aligned_value(gc_state->current_entry->stored_block_size(i));
 
                 if (beg <= current_interval_end) {
                     current_interval_end = end;
@@ -1092,7 +1364,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                                 gc_blocks.get() + current_interval_begin,
                                 choose_gc_io_account(),
                                 &read_cb);
-                        total_bytes_read += current_interval_end - current_interval_end;
+                        total_bytes_read += current_interval_end - current_interval_begin;
                     }
 
                     current_interval_begin = beg;
@@ -1110,7 +1382,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                 gc_blocks.get() + current_interval_begin,
                 choose_gc_io_account(),
                 &read_cb);
-        total_bytes_read += current_interval_end - current_interval_end;
+        total_bytes_read += current_interval_end - current_interval_begin;
 
         // Ok, all reads have been issued. Call `on_io_complete()` once to allow
         // `read_cb` to be pulsed (see comment above).
@@ -1130,6 +1402,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
     // 2: Rewrite the blocks that are still live
     std::vector<gc_write_t> gc_writes;
+    int64_t relocated_bytes = 0;
     {
         ASSERT_NO_CORO_WAITING;
 
@@ -1150,10 +1423,36 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
             const int64_t block_offset = gc_state->current_entry->extent_ref.offset()
                 + gc_state->current_entry->relative_offset(i);
 
+            const block_size_t stored_block_size
+                = gc_state->current_entry->stored_block_size(i);
+
+            // The block keeps the checksum it was written with, so that if it got
+            // corrupted, moving it doesn't hide that.  Blocks from older files that
+            // don't have a checksum, and blocks that only tokens refer to, get one
+            // now.
+            uint32_t checksum = NO_BLOCK_CHECKSUM;
+            if (gc_state->current_entry->block_referenced_by_index(i)) {
+                const index_block_info_t info = serializer->lba_index->get_block_info(
+                    block->ser_header.block_id);
+                guarantee(info.offset.has_value()
+                          && info.offset.get_value() == block_offset,
+                          "The block at offset %" PRIi64 " has a corrupted block id.",
+                          block_offset);
+                checksum = info.checksum;
+            }
+            if (checksum == NO_BLOCK_CHECKSUM) {
+                checksum = block_checksum(block, stored_block_size);
+            }
+
             gc_writes.push_back(gc_write_t(block, block_offset,
-                                           gc_state->current_entry->block_size(i)));
+                                           gc_state->current_entry->block_size(i),
+                                           stored_block_size, checksum));
+            relocated_bytes += gc_entry_t::aligned_value(stored_block_size);
         }
         guarantee(gc_writes.size() == num_writes);
+
+        gc_stats.relocated_block_bytes += relocated_bytes;
+        gc_stats.reclaimed_block_bytes += static_config->extent_size() - relocated_bytes;
     }
     write_gcs(gc_writes, gc_state);
 
@@ -1199,21 +1498,38 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        // The blocks are moved as they are stored, so compressed blocks stay
+        // compressed and don't get recompressed.
+        std::vector<encoded_write_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
-            old_block_tokens.push_back(serializer->generate_block_token(writes[i].old_offset,
-                                                                        writes[i].block_size));
-
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+            old_block_tokens.push_back(
+                serializer->generate_block_token(writes[i].old_offset,
+                                                 writes[i].block_size,
+                                                 writes[i].stored_block_size,
+                                                 writes[i].checksum));
+
+            the_writes.push_back(encoded_write_t(writes[i].buf,
+                                                 writes[i].block_size,
+                                                 writes[i].stored_block_size,
+                                                 writes[i].checksum));
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
-                                       &block_write_cond);
+        // Blocks that survive GC go to cold extents, away from the blocks that
+        // are getting rewritten all the time.
+        new_block_tokens = write_encoded(the_writes, std::vector<buf_ptr_t>(),
+                                         choose_gc_io_account(), &block_write_cond,
+                                         write_temperature_t::cold);
 
         guarantee(new_block_tokens.size() == writes.size());
+
+        const microtime_t victim_data_timestamp
+            = gc_state->current_entry->data_timestamp;
+        for (auto it = new_block_tokens.begin(); it != new_block_tokens.end(); ++it) {
+            gc_entry_t *entry = entries.get(static_config->extent_index((*it)->offset()));
+            guarantee(entry != NULL);
+            entry->note_relocated_data(victim_data_timestamp);
+        }
     }
 
     // Step 2: Wait on all writes to finish
@@ -1314,6 +1630,12 @@ void data_block_manager_t::actually_shutdown() {
         active_extent = NULL;
     }
 
+    if (active_cold_extent != NULL) {
+        UNUSED int64_t extent = active_cold_extent->extent_ref.release();
+        delete active_cold_extent;
+        active_cold_extent = NULL;
+    }
+
     while (gc_entry_t *entry = young_extent_queue.head()) {
         young_extent_queue.remove(entry);
         UNUSED int64_t extent = entry->extent_ref.release();
@@ -1332,43 +1654,42 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<encoded_write_t> &writes,
+                                             write_temperature_t temperature) {
     ASSERT_NO_CORO_WAITING;
 
+    gc_entry_t **const active = temperature == write_temperature_t::hot
+        ? &active_extent
+        : &active_cold_extent;
+
     // Start a new extent if necessary.
-    if (active_extent == NULL) {
-        active_extent = new gc_entry_t(this);
-        ++stats->pm_serializer_data_extents_allocated;
+    if (*active == NULL) {
+        *active = new_active_entry(temperature);
     }
 
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    guarantee((*active)->state == gc_entry_t::state_active);
 
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > ret;
 
+    const microtime_t now = current_microtime();
     std::vector<counted_t<ls_block_token_pointee_t> > tokens;
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
-            // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
-            } else {
-                active_extent->state = gc_entry_t::state_young;
-                young_extent_queue.push_back(active_extent);
-                mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
-            }
-
-            ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(it->block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+        if (!(*active)->new_offset(it->block_size, it->stored_block_size,
+                                   &relative_offset, &block_index)) {
+            // Retire the active gc_entry_t and make a new one.  (The new one has
+            // to be made first so that it doesn't get the extent back that we're
+            // about to free.)
+            gc_entry_t *old_active_extent = *active;
+            *active = new_active_entry(temperature);
+            retire_active_entry(&old_active_extent);
+
+            const bool succeeded = (*active)->new_offset(it->block_size,
+                                                         it->stored_block_size,
+                                                         &relative_offset,
+                                                         &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return vector.
@@ -1378,11 +1699,14 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = (*active)->extent_ref.offset() + relative_offset;
+        (*active)->was_written = true;
+        (*active)->mark_live_tokenwise(block_index);
+        (*active)->note_new_data(now);
 
-        tokens.push_back(serializer->generate_block_token(offset, it->block_size));
+        tokens.push_back(serializer->generate_block_token(offset, it->block_size,
+                                                          it->stored_block_size,
+                                                          it->checksum));
     }
 
     if (!tokens.empty()) {
@@ -1392,6 +1716,29 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
     return ret;
 }
 
+void data_block_manager_t::retire_active_entry(gc_entry_t **active) {
+    ASSERT_NO_CORO_WAITING;
+    guarantee((*active)->state == gc_entry_t::state_active);
+    // Move the entry to the young extent queue, or just get rid of it if it's
+    // empty.
+    if ((*active)->num_live_blocks() == 0) {
+        destroy_entry(*active);
+    } else {
+        (*active)->state = gc_entry_t::state_young;
+        young_extent_queue.push_back(*active);
+        mark_unyoung_entries();
+    }
+    *active = NULL;
+}
+
+gc_entry_t *data_block_manager_t::new_active_entry(write_temperature_t temperature) {
+    ++stats->pm_serializer_data_extents_allocated;
+    if (temperature == write_temperature_t::cold) {
+        gc_stats.cold_extents_allocated += 1;
+    }
+    return new gc_entry_t(this);
+}
+
 bool data_block_manager_t::is_gc_active() const {
     return !active_gcs.empty();
 }
@@ -1449,8 +1796,26 @@ bool data_block_manager_t::do_we_want_to_start_gcing() const {
     return garbage_ratio() > GC_START_RATIO;
 }
 
+double gc_cost_benefit(uint32_t garbage_bytes, uint32_t extent_size,
+                       microtime_t data_age) {
+    const double garbage = static_cast<double>(garbage_bytes) / extent_size;
+    const double live = std::max(1.0 - garbage, 1.0 / extent_size);
+    return garbage * (data_age + 1) / (2.0 * live);
+}
+
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
-    return x->garbage_bytes() < y->garbage_bytes();
+    return x->cost_benefit() < y->cost_benefit();
+}
+
+// Advances `gc_clock`, re-sorting `gc_pq` since the relative order of extents by
+// cost-benefit changes as they age.
+void data_block_manager_t::advance_gc_clock() {
+    ASSERT_NO_CORO_WAITING;
+    const microtime_t now = current_microtime();
+    if (now - gc_clock >= GC_COST_BENEFIT_CLOCK_INTERVAL_MICROS) {
+        gc_clock = now;
+        gc_pq.rebuild();
+    }
 }
 
 /****************
@@ -1479,4 +1844,7 @@ void data_block_manager_t::gc_stat_t::operator-=(int64_t num) {
 
 data_block_manager_t::gc_stats_t::gc_stats_t(log_serializer_stats_t *_stats)
     : old_total_block_bytes(&_stats->pm_serializer_old_total_block_bytes),
-      old_garbage_block_bytes(&_stats->pm_serializer_old_garbage_block_bytes) { }
+      old_garbage_block_bytes(&_stats->pm_serializer_old_garbage_block_bytes),
+      relocated_block_bytes(&_stats->pm_serializer_gc_relocated_block_bytes),
+      reclaimed_block_bytes(&_stats->pm_serializer_gc_reclaimed_block_bytes),
+      cold_extents_allocated(&_stats->pm_serializer_data_extents_cold_allocated) { }
@@ -14,12 +14,22 @@
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class buf_ptr_t;
 class log_serializer_t;
 class data_block_manager_t;
 class gc_entry_t;
 
+// How worthwhile it is to garbage collect an extent, as in the cost-benefit policy
+// of LFS: the space we get back, weighted by how long ago the extent's data was
+// last written (data that hasn't changed for a while probably won't change soon,
+// so its extent isn't going to free itself up), divided by the cost of reading and
+// rewriting the live blocks.  The GC collects the extent with the highest value
+// first.
+double gc_cost_benefit(uint32_t garbage_bytes, uint32_t extent_size,
+                       microtime_t data_age);
+
 struct gc_entry_less_t {
     bool operator() (const gc_entry_t *x, const gc_entry_t *y);
 };
@@ -46,8 +56,17 @@ public:
     static void prepare_initial_metablock(data_block_manager::metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, data_block_manager::metablock_mixin_t *last_metablock);
 
+    /* Reads the block at `off_in`, checking it against `checksum` and decompressing
+    it if `stored_block_size` says it is stored compressed. */
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
-                 file_account_t *io_account);
+                   block_size_t stored_block_size, uint32_t checksum,
+                   file_account_t *io_account);
+
+    // Reads the blocks of `tokens`, in that order.  Blocks that lie close to each
+    // other in the same extent are read with a single read.
+    std::vector<buf_ptr_t>
+    read_many(const std::vector<counted_t<ls_block_token_pointee_t> > &tokens,
+              file_account_t *io_account);
 
     /* exposed gc api */
     /* mark a buffer as garbage */
@@ -55,7 +74,8 @@ public:
 
     /* r{start,end}_reconstruct functions for safety */
     void start_reconstruct();
-    void mark_live(int64_t offset, block_size_t block_size);
+    void mark_live(int64_t offset, block_size_t block_size,
+                   block_size_t stored_block_size);
     void end_reconstruct();
 
     /* We must make sure that blocks which have tokens pointing to them don't
@@ -67,6 +87,12 @@ public:
     /* garbage collect the extents which meet the gc_criterion */
     void start_gc();
 
+    /* Moves the live blocks of the data extent closest to the end of the file, among
+    those that lie at or after `min_offset`, to free space further up front.  Returns
+    false if there was no extent there that could be moved right now.  Used to
+    compact the file; see `file_compactor_t`. */
+    bool compact_one_extent(int64_t min_offset);
+
     void prepare_metablock(data_block_manager::metablock_mixin_t *metablock);
     bool do_we_want_to_start_gcing() const;
 
@@ -76,17 +102,61 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    /* Compresses the blocks with the serializer's configured codec (where that
+    pays off) and writes them out. */
     std::vector<counted_t<ls_block_token_pointee_t> >
     many_writes(const std::vector<buf_write_info_t> &writes,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
-
     bool is_gc_active() const;
 
 private:
+    // Where new blocks go.  Blocks that the GC moves have survived at least one
+    // round of garbage collection, so they go to separate cold extents instead of
+    // getting mixed up with data that's frequently rewritten.
+    enum class write_temperature_t { hot, cold };
+
+    // A block as it is going to be written to disk.  `buf` has the size
+    // `stored_block_size`, which is smaller than `block_size` if it's compressed.
+    struct encoded_write_t {
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t stored_block_size;
+        uint32_t checksum;
+        encoded_write_t(ser_buffer_t *_buf, block_size_t _block_size,
+                        block_size_t _stored_block_size, uint32_t _checksum)
+            : buf(_buf), block_size(_block_size),
+              stored_block_size(_stored_block_size), checksum(_checksum) { }
+    };
+
+    // Writes blocks that are already encoded.  `owned_bufs` are kept alive until
+    // the writes have completed.
+    std::vector<counted_t<ls_block_token_pointee_t> >
+    write_encoded(const std::vector<encoded_write_t> &writes,
+                  std::vector<buf_ptr_t> &&owned_bufs,
+                  file_account_t *io_account,
+                  iocallback_t *cb,
+                  write_temperature_t temperature);
+
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
+    gimme_some_new_offsets(const std::vector<encoded_write_t> &writes,
+                           write_temperature_t temperature);
+
+    gc_entry_t *new_active_entry(write_temperature_t temperature);
+
+    // Stops writing to `*active` and sets it to NULL.
+    void retire_active_entry(gc_entry_t **active);
+
+    buf_ptr_t read_stored(int64_t off_in, block_size_t stored_block_size,
+                          file_account_t *io_account);
+
+    // Checks the checksum of a block read from `off_in` and decompresses it.
+    static buf_ptr_t decode_stored(buf_ptr_t &&stored, int64_t off_in,
+                                   block_size_t block_size,
+                                   block_size_t stored_block_size,
+                                   uint32_t checksum);
+
     void actually_shutdown();
 
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
@@ -105,10 +175,14 @@ private:
         ser_buffer_t *buf;
         int64_t old_offset;
         block_size_t block_size;
+        block_size_t stored_block_size;
+        uint32_t checksum;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
-                   block_size_t _block_size)
+                   block_size_t _block_size, block_size_t _stored_block_size,
+                   uint32_t _checksum)
             : buf(b), old_offset(_old_offset),
-              block_size(_block_size) { }
+              block_size(_block_size), stored_block_size(_stored_block_size),
+              checksum(_checksum) { }
     };
 
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
@@ -117,6 +191,10 @@ private:
 
     void gc_one_extent(gc_state_t *gc_state);
 
+    // Rewrites the live blocks of `entry`, which must be in state_old and already
+    // removed from `gc_pq`, so that the extent gets freed.
+    void relocate_extent(gc_state_t *gc_state, gc_entry_t *entry);
+
     void write_gcs(const std::vector<gc_write_t> &writes, gc_state_t *gc_state);
 
     // Determine how many GC processes should run concurrently at the moment.
@@ -146,6 +224,8 @@ private:
 
     void destroy_entry(gc_entry_t *entry);
 
+    void advance_gc_clock();
+
     bool should_perform_read_ahead(int64_t offset);
 
     log_serializer_stats_t *const stats;
@@ -178,8 +258,10 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
+    /* Contains the extents in the gc_entry_t::state_active state: the one new
+    writes go to, and the one the GC moves live blocks to. */
     gc_entry_t *active_extent;
+    gc_entry_t *active_cold_extent;
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
@@ -187,6 +269,10 @@ private:
     /* Contains every extent in the gc_entry_t::state_old state */
     priority_queue_t<gc_entry_t *, gc_entry_less_t> gc_pq;
 
+    /* The time that extent ages are measured against when ordering gc_pq.  See
+    `advance_gc_clock()`. */
+    microtime_t gc_clock;
+
     /* \brief structure to keep track of global stats about the data blocks
      */
     class gc_stat_t {
@@ -208,6 +294,11 @@ private:
     struct gc_stats_t {
         gc_stat_t old_total_block_bytes;
         gc_stat_t old_garbage_block_bytes;
+        // Bytes of live blocks the GC has rewritten, and bytes of space it got back
+        // by doing so.  Their ratio is the write amplification caused by GC.
+        gc_stat_t relocated_block_bytes;
+        gc_stat_t reclaimed_block_bytes;
+        gc_stat_t cold_extents_allocated;
         explicit gc_stats_t(log_serializer_stats_t *);
     };
 
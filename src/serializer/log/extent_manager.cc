@@ -37,8 +37,13 @@ public:
     // object.
     intptr_t extent_use_refcount;
 
+    // True if the extent is state_free and we've given its disk space back to the
+    // file system since it got freed.
+    bool punched;
+
     extent_info_t() : state_(state_unreserved),
-                      extent_use_refcount(0) { }
+                      extent_use_refcount(0),
+                      punched(false) { }
 };
 
 class extent_zone_t {
@@ -143,6 +148,33 @@ public:
         return extent_reference_t(extent);
     }
 
+    size_t num_extents() const {
+        return extents.size();
+    }
+
+    size_t punch_free_extents() {
+        size_t num_punched = 0;
+        size_t id = 0;
+        while (id < extents.size()) {
+            if (extents[id].state() != extent_info_t::state_free
+                || extents[id].punched) {
+                ++id;
+                continue;
+            }
+            // Punch one hole for each run of adjacent free extents.
+            const size_t begin = id;
+            while (id < extents.size()
+                   && extents[id].state() == extent_info_t::state_free
+                   && !extents[id].punched) {
+                extents[id].punched = true;
+                ++id;
+            }
+            dbfile->punch_hole(begin * extent_size, (id - begin) * extent_size);
+            num_punched += id - begin;
+        }
+        return num_punched;
+    }
+
     void try_shrink_file() {
         // Now potentially shrink the file.
         bool shrink_file = false;
@@ -185,6 +217,7 @@ public:
         --info->extent_use_refcount;
         if (info->extent_use_refcount == 0) {
             info->set_state(extent_info_t::state_free);
+            info->punched = false;
             free_queue.push(offset_to_id(extent));
             ++held_extents_;
             try_shrink_file();
@@ -301,3 +334,16 @@ size_t extent_manager_t::held_extents() {
     assert_thread();
     return zone->held_extents();
 }
+
+size_t extent_manager_t::num_extents() {
+    assert_thread();
+    return zone->num_extents();
+}
+
+size_t extent_manager_t::punch_free_extents() {
+    assert_thread();
+    rassert(state == state_running);
+    const size_t num_punched = zone->punch_free_extents();
+    stats->pm_serializer_punched_extents += num_punched;
+    return num_punched;
+}
@@ -133,6 +133,15 @@ public:
     /* Number of extents that have been released but not handed back out again. */
     size_t held_extents();
 
+    /* Number of extents the file is made of, in use or not. */
+    size_t num_extents();
+
+    /* Gives the disk space of the free extents back to the file system, where that
+    hasn't been done since they got freed.  Free extents at the end of the file get
+    truncated away as soon as they're released; this is for the ones that are stuck
+    in between extents that are in use.  Returns the number of extents. */
+    size_t punch_free_extents();
+
     log_serializer_stats_t *const stats;
     const uint64_t extent_size;   /* Same as static_config->extent_size */
 
@@ -4,7 +4,9 @@
 
 #include <limits.h>
 
+#include "math.hpp"
 #include "serializer/serializer.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "config/args.hpp"
 
 
@@ -64,13 +66,19 @@ struct lba_entry_t {
     // (It probably assumes that sizeof(lba_entry_t) evenly divides
     // DEVICE_BLOCK_SIZE).
 
-    // Put the zero-padding at the beginning of the LBA entry.  We could use this, or
-    // the first 16 bits, perhaps, as a version flag.
-    uint32_t zero_reserved;
+    // The block's checksum, see `block_checksum()`, or `NO_BLOCK_CHECKSUM` if the
+    // block was written without one.  This used to be padding that was always
+    // zeroed, so blocks from older files simply go unchecked.
+    uint32_t checksum;
 
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
-    uint32_t ser_block_size;
+    // Block sizes are far below 16M, so the top byte of what used to be a uint32_t
+    // is free for `compressed_device_blocks`.
+    uint32_t ser_block_size : 24;
+
+    // The number of device blocks the block takes up in the data extent, if it is
+    // stored compressed, or 0 if it is stored as-is (which is what older files have
+    // here).
+    uint32_t compressed_device_blocks : 8;
 
     block_id_t block_id;
 
@@ -80,23 +88,36 @@ struct lba_entry_t {
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint32_t ser_block_size) {
+                            flagged_off64_t offset, uint32_t ser_block_size,
+                            uint32_t compressed_block_size, uint32_t checksum) {
         guarantee(ser_block_size != 0 || !offset.has_value());
+        guarantee(ser_block_size < (1u << 24));
+        guarantee(compressed_block_size < ser_block_size || compressed_block_size == 0);
+        guarantee(divides(DEVICE_BLOCK_SIZE, compressed_block_size)
+                  && compressed_block_size / DEVICE_BLOCK_SIZE < (1u << 8));
         lba_entry_t entry;
-        entry.zero_reserved = 0;
+        entry.checksum = checksum;
         entry.ser_block_size = ser_block_size;
+        entry.compressed_device_blocks = compressed_block_size / DEVICE_BLOCK_SIZE;
         entry.block_id = block_id;
         entry.recency = recency;
         entry.offset = offset;
         return entry;
     }
 
+    // The size of the block as it is stored in the data extent, if it is stored
+    // compressed, or 0 if it is stored as-is.
+    uint32_t compressed_block_size() const {
+        return compressed_device_blocks * DEVICE_BLOCK_SIZE;
+    }
+
     static bool is_padding(const lba_entry_t *entry) {
         return entry->block_id == PADDING_BLOCK_ID  && entry->offset.is_padding();
     }
 
     static lba_entry_t make_padding_entry() {
-        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0);
+        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0, 0,
+                    NO_BLOCK_CHECKSUM);
     }
 } __attribute__((__packed__));
 
@@ -27,12 +27,14 @@ public:
         virtual void on_lba_load() = 0;
         virtual ~load_callback_t() {}
     };
-    lba_disk_structure_t(extent_manager_t *em, file_t *file, lba_shard_metablock_t *metablock);
+    lba_disk_structure_t(extent_manager_t *em, file_t *file, lba_shard_metablock_t *metablock,
+                         file_account_t *io_account);
     void set_load_callback(load_callback_t *lcb);
 
     // Put entries in an LBA and then call sync() to write to disk
     void add_entry(block_id_t block_id, repli_timestamp_t recency,
                    flagged_off64_t offset, uint32_t ser_block_size,
+                   uint32_t compressed_block_size, uint32_t checksum,
                    file_account_t *io_account,
                    extent_transaction_t *txn);
     struct sync_callback_t {
@@ -54,12 +56,13 @@ public:
                          file_account_t *io_account, extent_transaction_t *txn);
 
     // If you call read(), then the in_memory_index_t will be populated and then the read_callback_t
-    // will be called when it is done.
+    // will be called when it is done. Extents are read ahead through `io_account`
+    // up to LBA_READ_BUFFER_SIZE bytes at a time, but are applied to the index in order.
     struct read_callback_t {
         virtual void on_lba_extents_read() = 0;
         virtual ~read_callback_t() {}
     };
-    void read(in_memory_index_t *index, read_callback_t *cb);
+    void read(in_memory_index_t *index, file_account_t *io_account, read_callback_t *cb);
 
     void prepare_metablock(lba_shard_metablock_t *mb_out);
 
@@ -96,9 +96,10 @@ extent_t::~extent_t() {
     --em->stats->pm_serializer_lba_extents;
 }
 
-void extent_t::read(size_t pos, size_t length, void *buffer, read_callback_t *cb) {
+void extent_t::read(size_t pos, size_t length, void *buffer, file_account_t *io_account,
+                    read_callback_t *cb) {
     rassert(!last_block);
-    file->read_async(extent_ref.offset() + pos, length, buffer, DEFAULT_DISK_ACCOUNT, cb);
+    file->read_async(extent_ref.offset() + pos, length, buffer, io_account, cb);
 
     // Ideally we would count these stats when the io operation completes,
     // but this is more generic than doing it in each callback
@@ -24,7 +24,8 @@ public:
     private:
         void on_io_complete() { on_extent_read(); }
     };
-    void read(size_t pos, size_t length, void *buffer, read_callback_t *);
+    void read(size_t pos, size_t length, void *buffer, file_account_t *io_account,
+              read_callback_t *cb);
 
     void append(void *buffer, size_t length, file_account_t *io_account);
 
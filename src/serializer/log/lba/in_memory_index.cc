@@ -5,23 +5,40 @@
 
 #include "serializer/log/lba/disk_format.hpp"
 
-in_memory_index_t::in_memory_index_t() : end_block_id_(0) { }
+in_memory_index_t::in_memory_index_t() : end_block_id_(0) {
+    for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+        live_block_counts_[i] = 0;
+    }
+}
 
 block_id_t in_memory_index_t::end_block_id() {
     return end_block_id_;
 }
 
+int64_t in_memory_index_t::live_block_count(int shard) {
+    rassert(shard >= 0 && shard < LBA_SHARD_FACTOR);
+    return live_block_counts_[shard];
+}
+
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
     return infos_.get(id);
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
-                                       flagged_off64_t offset, uint32_t ser_block_size) {
+                                       flagged_off64_t offset, uint32_t ser_block_size,
+                                       uint32_t compressed_block_size,
+                                       uint32_t checksum) {
     if (id >= end_block_id_) {
         end_block_id_ = id + 1;
     }
 
-    index_block_info_t info(offset, recency, ser_block_size);
+    const bool was_live = infos_.get(id).offset.has_value();
+    if (was_live != offset.has_value()) {
+        live_block_counts_[id % LBA_SHARD_FACTOR] += offset.has_value() ? 1 : -1;
+    }
+
+    index_block_info_t info(offset, recency, ser_block_size, compressed_block_size,
+                            checksum);
     infos_.set(id, info);
 }
 
@@ -11,25 +11,42 @@ struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          compressed_block_size(0),
+          checksum(NO_BLOCK_CHECKSUM) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint32_t _ser_block_size)
+                       uint32_t _ser_block_size,
+                       uint32_t _compressed_block_size,
+                       uint32_t _checksum)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          compressed_block_size(_compressed_block_size),
+          checksum(_checksum) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            compressed_block_size == other.compressed_block_size &&
+            checksum == other.checksum;
+    }
+
+    // The number of bytes the block takes up in its data extent.
+    uint32_t stored_block_size() const {
+        return compressed_block_size == 0 ? ser_block_size : compressed_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
     uint32_t ser_block_size;
+    // See lba_entry_t::compressed_block_size().
+    uint32_t compressed_block_size;
+    // See lba_entry_t::checksum.
+    uint32_t checksum;
 } __attribute__((__packed__));
 
 
@@ -37,6 +54,8 @@ struct index_block_info_t {
 class in_memory_index_t {
     two_level_array_t<index_block_info_t> infos_;
     block_id_t end_block_id_;
+    // The number of blocks with an offset, for each LBA shard.
+    int64_t live_block_counts_[LBA_SHARD_FACTOR];
 
 public:
     in_memory_index_t();
@@ -44,9 +63,14 @@ public:
     // end_block_id is one greater than the max block id.
     block_id_t end_block_id();
 
+    // The number of blocks in the given LBA shard that currently have an offset, i.e.
+    // the number of entries a freshly rewritten LBA for that shard would contain.
+    int64_t live_block_count(int shard);
+
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint32_t ser_block_size);
+                        flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t compressed_block_size, uint32_t checksum);
 
 };
 
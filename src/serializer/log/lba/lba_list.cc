@@ -17,6 +17,7 @@ lba_list_t::lba_list_t(extent_manager_t *em,
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         gc_active[i] = false;
+        shard_ready[i] = false;
         disk_structures[i] = NULL;
     }
 }
@@ -50,10 +51,11 @@ void lba_list_t::prepare_metablock(metablock_mixin_t *mb_out) {
            (LBA_NUM_INLINE_ENTRIES - inline_lba_entries_count) * sizeof(lba_entry_t));
 }
 
-class lba_start_fsm_t :
-    private lba_disk_structure_t::load_callback_t,
-    private lba_disk_structure_t::read_callback_t
-{
+/* Loads the shards of the LBA independently of each other. Each shard starts reading
+its extents as soon as its superblock is in, and is handed to the ready callback as
+soon as its extents and its share of the inline entries have been applied, so that
+the serializer can reconstruct a shard while the others are still being read. */
+class lba_start_fsm_t {
 public:
     int cbs_out;
     lba_list_t *owner;
@@ -73,46 +75,72 @@ public:
                last_metablock->inline_lba_entries_count * sizeof(lba_entry_t));
 
         cbs_out = LBA_SHARD_FACTOR;
+        for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            shard_loaders[i].parent = this;
+            shard_loaders[i].shard = i;
+        }
         for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
             owner->disk_structures[i] = new lba_disk_structure_t(
                 owner->extent_manager, owner->dbfile,
-                &last_metablock->shards[i]);
-            owner->disk_structures[i]->set_load_callback(this);
+                &last_metablock->shards[i], owner->startup_io_account.get());
+            owner->disk_structures[i]->set_load_callback(&shard_loaders[i]);
         }
     }
 
-    void on_lba_load() {
-        rassert(cbs_out > 0);
-        cbs_out--;
-        if (cbs_out == 0) {
-            cbs_out = LBA_SHARD_FACTOR;
-            for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
-                owner->disk_structures[i]->read(&owner->in_memory_index, this);
-            }
+private:
+    struct shard_loader_t :
+        public lba_disk_structure_t::load_callback_t,
+        public lba_disk_structure_t::read_callback_t
+    {
+        lba_start_fsm_t *parent;
+        int shard;
+
+        void on_lba_load() {
+            parent->owner->disk_structures[shard]->read(
+                &parent->owner->in_memory_index,
+                parent->owner->startup_io_account.get(),
+                this);
         }
-    }
+        void on_lba_extents_read() {
+            parent->on_shard_read(shard);
+        }
+    };
+    shard_loader_t shard_loaders[LBA_SHARD_FACTOR];
 
-    void on_lba_extents_read() {
+    void on_shard_read(int shard) {
         rassert(cbs_out > 0);
-        cbs_out--;
-        if (cbs_out == 0) {
-            // All LBA entries from the LBA extents have been read.
-            // Now we can load the (more recent) inlined entries from
-            // the metablock into the index:
-            for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
-                lba_entry_t *e = &owner->inline_lba_entries[i];
-                owner->in_memory_index.set_block_info(
-                        e->block_id,
-                        e->recency,
-                        e->offset,
-                        e->ser_block_size);
+        // All LBA entries from the shard's LBA extents have been read.
+        // Now we can load the (more recent) inlined entries for this shard
+        // from the metablock into the index:
+        for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
+            lba_entry_t *e = &owner->inline_lba_entries[i];
+            if (e->block_id % LBA_SHARD_FACTOR != static_cast<block_id_t>(shard)) {
+                continue;
             }
+            owner->in_memory_index.set_block_info(
+                    e->block_id,
+                    e->recency,
+                    e->offset,
+                    e->ser_block_size,
+                    e->compressed_block_size(),
+                    e->checksum);
+        }
+        owner->shard_ready[shard] = true;
 
+        cbs_out--;
+        if (cbs_out > 0) {
+            if (callback) callback->on_lba_shard_ready(shard);
+        } else {
             owner->state = lba_list_t::state_ready;
-            if (callback) callback->on_lba_ready();
+            if (callback) {
+                callback->on_lba_shard_ready(shard);
+                callback->on_lba_ready();
+            }
             delete this;
         }
     }
+
+    DISABLE_COPYING(lba_start_fsm_t);
 };
 
 bool lba_list_t::start_existing(file_t *file, metablock_mixin_t *last_metablock,
@@ -121,6 +149,7 @@ bool lba_list_t::start_existing(file_t *file, metablock_mixin_t *last_metablock,
 
     dbfile = file;
     gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY));
+    startup_io_account.init(new file_account_t(dbfile, LBA_STARTUP_IO_PRIORITY));
 
     lba_start_fsm_t *starter = new lba_start_fsm_t(this, last_metablock);
     if (state == state_ready) {
@@ -131,14 +160,22 @@ bool lba_list_t::start_existing(file_t *file, metablock_mixin_t *last_metablock,
     }
 }
 
+bool lba_list_t::is_shard_ready(int shard) const {
+    rassert(shard >= 0 && shard < LBA_SHARD_FACTOR);
+    return shard_ready[shard];
+}
+
 block_id_t lba_list_t::end_block_id() {
-    rassert(state == state_ready || state == state_gc_shutting_down);
+    rassert(state == state_starting_up || state == state_ready
+            || state == state_gc_shutting_down);
 
     return in_memory_index.end_block_id();
 }
 
 index_block_info_t lba_list_t::get_block_info(block_id_t block) {
-    rassert(state == state_ready || state == state_gc_shutting_down);
+    DEBUG_VAR const int shard = block % LBA_SHARD_FACTOR;
+    rassert(state == state_ready || state == state_gc_shutting_down
+            || (state == state_starting_up && shard_ready[shard]));
     return in_memory_index.get_block_info(block);
 }
 
@@ -154,6 +191,18 @@ block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+uint32_t lba_list_t::get_compressed_block_size(block_id_t block) {
+    return get_block_info(block).compressed_block_size;
+}
+
+uint32_t lba_list_t::get_block_checksum(block_id_t block) {
+    return get_block_info(block).checksum;
+}
+
+block_size_t lba_list_t::get_stored_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).stored_block_size());
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -180,10 +229,12 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t compressed_block_size, uint32_t checksum,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   compressed_block_size, checksum);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -192,7 +243,8 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size, compressed_block_size,
+                     checksum);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -230,6 +282,8 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.compressed_block_size(),
+                e.checksum,
                 io_account,
                 txn);
     }
@@ -238,11 +292,13 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size) {
+                                flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t compressed_block_size, uint32_t checksum) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              compressed_block_size, checksum);
 }
 
 class lba_syncer_t :
@@ -323,6 +379,8 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
                                                   get_block_recency(id),
                                                   off,
                                                   ser_block_size,
+                                                  get_compressed_block_size(id),
+                                                  get_block_checksum(id),
                                                   gc_io_account.get(),
                                                   txns.back().get());
         }
@@ -426,7 +484,7 @@ bool lba_list_t::we_want_to_gc(int i) {
     // If we are not using more than N times the amount of space that we need, don't GC
     int entries_per_extent = disk_structures[i]->num_entries_that_can_fit_in_an_extent();
     int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
-    int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR;
+    int64_t entries_live = in_memory_index.live_block_count(i);
     if ((entries_live / static_cast<double>(entries_total)) > LBA_MIN_UNGARBAGE_FRACTION) {  // TODO: multiply both sides by common denominator
         return false;
     }
@@ -455,6 +513,7 @@ void lba_list_t::shutdown() {
     }
 
     gc_io_account.reset();
+    startup_io_account.reset();
 
     state = state_shut_down;
 }
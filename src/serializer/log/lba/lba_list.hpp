@@ -34,24 +34,37 @@ public:
     void prepare_metablock(metablock_mixin_t *mb_out);
 
     struct ready_callback_t {
+        // Called once for every shard as soon as that shard's entries have been read,
+        // while the other shards may still be loading. After this, `get_block_info()`
+        // and friends may be called for the shard's block ids.
+        virtual void on_lba_shard_ready(UNUSED int shard) { }
         virtual void on_lba_ready() = 0;
         virtual ~ready_callback_t() {}
     };
     bool start_existing(file_t *dbfile, metablock_mixin_t *last_metablock,
                         ready_callback_t *cb);
 
+    // Whether the given shard has been read. Shards become ready in any order while
+    // the LBA is starting up; once `on_lba_ready()` is called, they all are.
+    bool is_shard_ready(int shard) const;
+
     index_block_info_t get_block_info(block_id_t block);
 
     // These return individual fields of get_block_info.
     flagged_off64_t get_block_offset(block_id_t block);
     uint32_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    uint32_t get_compressed_block_size(block_id_t block);
+    uint32_t get_block_checksum(block_id_t block);
+    // The size the block takes up in its data extent, whether compressed or not.
+    block_size_t get_stored_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
 
     /* Returns a block ID such that all blocks that exist are guaranteed to have IDs less than
-    that block ID. */
+    that block ID. While starting up, this only covers the shards that have been read so
+    far. */
     block_id_t end_block_id();
 
 #ifndef NDEBUG
@@ -62,6 +75,7 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t compressed_block_size, uint32_t checksum,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -104,6 +118,10 @@ private:
 
     file_t *dbfile;
     scoped_ptr_t<file_account_t> gc_io_account;
+    // Used to read the LBA while starting up.
+    scoped_ptr_t<file_account_t> startup_io_account;
+
+    bool shard_ready[LBA_SHARD_FACTOR];
 
     in_memory_index_t in_memory_index;
 
@@ -116,7 +134,8 @@ private:
     bool check_inline_lba_full() const;
     void move_inline_entries_to_extents(file_account_t *io_account, extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size);
+                                flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t compressed_block_size, uint32_t checksum);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
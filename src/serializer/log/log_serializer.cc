@@ -16,7 +16,9 @@
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/compactor.hpp"
 #include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/scrubber.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
                                                io_backender_t *backender)
@@ -129,12 +131,21 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_written_bytes_total(),
       pm_extents_in_use(),
       pm_bytes_in_use(),
+      pm_serializer_punched_extents(),
       pm_serializer_lba_extents(),
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_gc_relocated_block_bytes(),
+      pm_serializer_gc_reclaimed_block_bytes(),
+      pm_serializer_data_extents_cold_allocated(),
+      pm_serializer_compressed_block_writes(),
+      pm_serializer_compression_saved_bytes(),
+      pm_serializer_data_extents_compacted(),
+      pm_serializer_scrubbed_blocks(),
+      pm_serializer_scrub_corrupt_blocks(),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
@@ -149,12 +160,21 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_written_bytes_total, "serializer_written_bytes_total",
           &pm_extents_in_use, "serializer_extents_in_use",
           &pm_bytes_in_use, "serializer_bytes_in_use",
+          &pm_serializer_punched_extents, "serializer_punched_extents",
           &pm_serializer_lba_extents, "serializer_lba_extents",
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_gc_relocated_block_bytes, "serializer_gc_relocated_block_bytes",
+          &pm_serializer_gc_reclaimed_block_bytes, "serializer_gc_reclaimed_block_bytes",
+          &pm_serializer_data_extents_cold_allocated, "serializer_data_extents_cold_allocated",
+          &pm_serializer_compressed_block_writes, "serializer_compressed_block_writes",
+          &pm_serializer_compression_saved_bytes, "serializer_compression_saved_bytes",
+          &pm_serializer_data_extents_compacted, "serializer_data_extents_compacted",
+          &pm_serializer_scrubbed_blocks, "serializer_scrubbed_blocks",
+          &pm_serializer_scrub_corrupt_blocks, "serializer_scrub_corrupt_blocks",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
@@ -199,7 +219,11 @@ struct ls_start_existing_fsm_t :
     public thread_message_t
 {
     explicit ls_start_existing_fsm_t(log_serializer_t *serializer)
-        : ser(serializer), start_existing_state(state_start) {
+        : ser(serializer), start_existing_state(state_start),
+          reconstruction_scheduled(false) {
+        for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+            next_block_to_reconstruct[i] = i;
+        }
     }
 
     ~ls_start_existing_fsm_t() {
@@ -282,6 +306,9 @@ struct ls_start_existing_fsm_t :
             // STATE G
             guarantee(metablock_found, "Could not find any valid metablock.");
 
+            // Shards get reconstructed as soon as the LBA has read them.
+            ser->data_block_manager->start_reconstruct();
+
             // STATE H
             if (ser->lba_index->start_existing(ser->dbfile, &metablock_buffer.lba_index_part, this)) {
                 start_existing_state = state_reconstruct;
@@ -295,25 +322,9 @@ struct ls_start_existing_fsm_t :
         }
 
         if (start_existing_state == state_reconstruct) {
-            ser->data_block_manager->start_reconstruct();
-            start_existing_state = state_reconstruct_ongoing;
-            num_blocks_reconstructed = 0;
-            // Fall through into state_reconstruct_ongoing
-        }
-
-        if (start_existing_state == state_reconstruct_ongoing) {
-            int batch = 0;
-            for (; num_blocks_reconstructed < ser->lba_index->end_block_id(); num_blocks_reconstructed++) {
-                flagged_off64_t offset = ser->lba_index->get_block_offset(num_blocks_reconstructed);
-                if (offset.has_value()) {
-                    ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(num_blocks_reconstructed));
-                }
-                ++batch;
-                if (batch >= LBA_RECONSTRUCTION_BATCH_SIZE) {
-                    call_later_on_this_thread(this);
-                    return false;
-                }
+            // Finish whatever we haven't reconstructed while the LBA was loading.
+            if (!reconstruct_ready_shards()) {
+                return false;
             }
             ser->data_block_manager->end_reconstruct();
             ser->data_block_manager->start_existing(ser->dbfile, &metablock_buffer.data_block_manager_part);
@@ -353,16 +364,61 @@ struct ls_start_existing_fsm_t :
         next_starting_up_step();
     }
 
+    /* Reconstructs the blocks of the LBA shards that are ready, up to
+    LBA_RECONSTRUCTION_BATCH_SIZE blocks at a time. Returns true once it has caught
+    up with them, or false if it has scheduled itself to continue later. */
+    bool reconstruct_ready_shards() {
+        rassert(!reconstruction_scheduled);
+        int batch = 0;
+        for (int shard = 0; shard < LBA_SHARD_FACTOR; ++shard) {
+            if (!ser->lba_index->is_shard_ready(shard)) {
+                continue;
+            }
+            block_id_t *id = &next_block_to_reconstruct[shard];
+            for (; *id < ser->lba_index->end_block_id(); *id += LBA_SHARD_FACTOR) {
+                if (batch >= LBA_RECONSTRUCTION_BATCH_SIZE) {
+                    reconstruction_scheduled = true;
+                    call_later_on_this_thread(this);
+                    return false;
+                }
+                flagged_off64_t offset = ser->lba_index->get_block_offset(*id);
+                if (offset.has_value()) {
+                    ser->data_block_manager->mark_live(offset.get_value(),
+                        ser->lba_index->get_block_size(*id),
+                        ser->lba_index->get_stored_block_size(*id));
+                }
+                ++batch;
+            }
+        }
+        return true;
+    }
+
+    void on_lba_shard_ready(UNUSED int shard) {
+        // This also gets called from within `lba_list_t::start_existing()`, in which
+        // case we pick the shard up once the whole LBA is ready.
+        if (start_existing_state == state_waiting_for_lba && !reconstruction_scheduled) {
+            reconstruct_ready_shards();
+        }
+    }
+
     void on_lba_ready() {
         rassert(start_existing_state == state_waiting_for_lba);
         start_existing_state = state_reconstruct;
-        next_starting_up_step();
+        if (!reconstruction_scheduled) {
+            next_starting_up_step();
+        }
     }
 
     void on_thread_switch() {
         // Continue a previously started LBA reconstruction
-        rassert(start_existing_state == state_reconstruct_ongoing);
-        next_starting_up_step();
+        rassert(reconstruction_scheduled);
+        reconstruction_scheduled = false;
+        if (start_existing_state == state_waiting_for_lba) {
+            reconstruct_ready_shards();
+        } else {
+            rassert(start_existing_state == state_reconstruct);
+            next_starting_up_step();
+        }
     }
 
     log_serializer_t *ser;
@@ -377,14 +433,14 @@ struct ls_start_existing_fsm_t :
         state_start_lba,
         state_waiting_for_lba,
         state_reconstruct,
-        state_reconstruct_ongoing,
         state_finish,
         state_done
     } start_existing_state;
 
-    // When in state_reconstruct_ongoing, we keep track of how many blocks we
-    // already have reconstructed.
-    block_id_t num_blocks_reconstructed;
+    // While reconstructing, the next block id to reconstruct in each LBA shard, and
+    // whether we have a `call_later_on_this_thread()` pending to continue.
+    block_id_t next_block_to_reconstruct[LBA_SHARD_FACTOR];
+    bool reconstruction_scheduled;
 
     bool metablock_found;
     log_serializer_t::metablock_t metablock_buffer;
@@ -414,10 +470,15 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config, serializer_
     ls_start_existing_fsm_t *s = new ls_start_existing_fsm_t(this);
     cond_t cond;
     if (!s->run(&cond, file_opener)) cond.wait();
+
+    scrubber.init(new data_scrubber_t(this));
+    compactor.init(new file_compactor_t(this));
 }
 
 log_serializer_t::~log_serializer_t() {
     assert_thread();
+    compactor.reset();
+    scrubber.reset();
     cond_t cond;
     if (!shutdown(&cond)) cond.wait();
 
@@ -426,10 +487,13 @@ log_serializer_t::~log_serializer_t() {
     rassert(active_write_count == 0);
 }
 
-file_account_t *log_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
+file_account_t *log_serializer_t::make_io_account(int priority,
+                                                  int outstanding_requests_limit,
+                                                  int64_t latency_target_us) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit,
+                              latency_target_us);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t> &token,
@@ -442,7 +506,23 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>
     stats->pm_serializer_block_reads.begin(&pm_time);
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                           io_account);
+                                             token->stored_block_size(),
+                                             token->checksum(), io_account);
+
+    stats->pm_serializer_block_reads.end(&pm_time);
+    return ret;
+}
+
+std::vector<buf_ptr_t>
+log_serializer_t::block_reads(const std::vector<counted_t<ls_block_token_pointee_t> > &tokens,
+                              file_account_t *io_account) {
+    assert_thread();
+    guarantee(state == state_ready);
+
+    ticks_t pm_time;
+    stats->pm_serializer_block_reads.begin(&pm_time);
+
+    std::vector<buf_ptr_t> ret = data_block_manager->read_many(tokens, io_account);
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -488,6 +568,9 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
             const index_write_op_t &op = *write_op_it;
             flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
             uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            uint32_t compressed_block_size
+                = lba_index->get_compressed_block_size(op.block_id);
+            uint32_t checksum = lba_index->get_block_checksum(op.block_id);
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -503,12 +586,19 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    compressed_block_size = token->is_compressed()
+                        ? token->stored_block_size().ser_value()
+                        : 0;
+                    checksum = token->checksum();
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(), token->block_size(),
+                                                  token->stored_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    compressed_block_size = 0;
+                    checksum = NO_BLOCK_CHECKSUM;
                 }
             }
 
@@ -516,7 +606,8 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 : lba_index->get_block_recency(op.block_id);
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
+                                      offset, ser_block_size, compressed_block_size,
+                                      checksum,
                                       index_writes_io_account.get(), &txn);
         }
     }
@@ -624,9 +715,13 @@ void log_serializer_t::write_metablock_sans_pipelining(const signal_t *safe_to_w
 }
 
 counted_t<ls_block_token_pointee_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t stored_block_size,
+                                       uint32_t checksum) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+        new ls_block_token_pointee_t(this, offset, block_size, stored_block_size,
+                                     checksum));
     return ret;
 }
 
@@ -740,7 +835,12 @@ bool log_serializer_t::coop_lock_and_check() {
 }
 
 bool log_serializer_t::is_gc_active() const {
-    return data_block_manager->is_gc_active() || lba_index->is_any_gc_active();
+    return data_block_manager->is_gc_active() || lba_index->is_any_gc_active()
+        || (compactor.has() && compactor->is_active());
+}
+
+bool log_serializer_t::get_scrub_progress(double *progress_out) const {
+    return scrubber.has() && scrubber->get_progress(progress_out);
 }
 
 // TODO: Should be called end_block_id I guess (or should subtract 1 frim end_block_id?
@@ -763,7 +863,10 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(info.offset.get_value(),
+                                    block_size_t::unsafe_make(info.ser_block_size),
+                                    block_size_t::unsafe_make(info.stored_block_size()),
+                                    info.checksum);
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -952,9 +1055,14 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_stored_block_size,
+                                                   uint32_t checksum)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size),
+      stored_block_size_(initial_stored_block_size),
+      checksum_(checksum),
+      offset_(initial_offset) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
@@ -24,10 +24,14 @@
 
 class cond_t;
 class data_block_manager_t;
+class data_scrubber_t;
+class file_compactor_t;
 struct block_magic_t;
 class io_backender_t;
 class log_serializer_t;
 
+namespace unittest { class log_serializer_tester_t; }
+
 namespace data_block_manager {
 struct shutdown_callback_t {
     virtual void on_datablock_manager_shutdown() = 0;
@@ -117,6 +121,9 @@ class log_serializer_t :
     friend class data_block_manager_t;
     friend class dbm_read_ahead_t;
     friend class ls_block_token_pointee_t;
+    friend class data_scrubber_t;
+    friend class file_compactor_t;
+    friend class unittest::log_serializer_tester_t;
 
 public:
     /* Serializer configuration. dynamic_config_t is everything that can be changed from run
@@ -138,7 +145,8 @@ public:
 #ifndef SEMANTIC_SERIALIZER_CHECK
     using serializer_t::make_io_account;
 #endif
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int64_t latency_target_us);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -151,6 +159,9 @@ public:
 
     buf_ptr_t block_read(const counted_t<ls_block_token_pointee_t> &token,
                        file_account_t *io_account);
+    std::vector<buf_ptr_t>
+    block_reads(const std::vector<counted_t<ls_block_token_pointee_t> > &tokens,
+                file_account_t *io_account);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::vector<index_write_op_t> &write_ops);
@@ -163,6 +174,7 @@ public:
     bool coop_lock_and_check();
 
     virtual bool is_gc_active() const;
+    virtual bool get_scrub_progress(double *progress_out) const;
 
 private:
     void register_block_token(ls_block_token_pointee_t *token, int64_t offset);
@@ -170,7 +182,9 @@ private:
     void unregister_block_token(ls_block_token_pointee_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<ls_block_token_pointee_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                             block_size_t block_size,
+                                                             block_size_t stored_block_size,
+                                                             uint32_t checksum);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -259,6 +273,9 @@ private:
     lba_list_t *lba_index;
     data_block_manager_t *data_block_manager;
 
+    scoped_ptr_t<data_scrubber_t> scrubber;
+    scoped_ptr_t<file_compactor_t> compactor;
+
     /* The running index writes organize themselves into a list so that they can be sure to
     write their metablocks in the correct order. The first element in the list
     is the oldest transaction that started but did not finish. */
@@ -0,0 +1,161 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/scrubber.hpp"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "arch/arch.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "logger.hpp"
+#include "math.hpp"
+#include "serializer/log/block_codec.hpp"
+#include "serializer/log/log_serializer.hpp"
+
+// Live blocks that are at most this far apart in the same extent are read with a
+// single read.
+const int64_t SCRUB_MAX_READ_GAP = 64 * KILOBYTE;
+
+data_scrubber_t::data_scrubber_t(log_serializer_t *serializer)
+    : serializer_(serializer),
+      io_account_(serializer->make_io_account(SCRUB_IO_PRIORITY, 1)),
+      active_(false),
+      next_block_id_(0),
+      pass_end_block_id_(0) {
+    coro_t::spawn_sometime(std::bind(&data_scrubber_t::run, this, drainer_.lock()));
+}
+
+data_scrubber_t::~data_scrubber_t() {
+    assert_thread();
+    drainer_.drain();
+}
+
+bool data_scrubber_t::get_progress(double *progress_out) const {
+    if (!active_) {
+        return false;
+    }
+    *progress_out = pass_end_block_id_ == 0
+        ? 0.0
+        : std::min(1.0, static_cast<double>(next_block_id_) / pass_end_block_id_);
+    return true;
+}
+
+void data_scrubber_t::run(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    try {
+        for (;;) {
+            nap(SCRUB_INTERVAL_MS, keepalive.get_drain_signal());
+            scrub_pass(keepalive.get_drain_signal());
+        }
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+    active_ = false;
+}
+
+void data_scrubber_t::scrub_pass(signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    int64_t corrupt_blocks = 0;
+    next_block_id_ = 0;
+    pass_end_block_id_ = serializer_->lba_index->end_block_id();
+    active_ = true;
+    while (next_block_id_ < pass_end_block_id_) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        const block_id_t end = std::min<block_id_t>(next_block_id_ + SCRUB_CHUNK_BLOCKS,
+                                                    pass_end_block_id_);
+        corrupt_blocks += scrub_block_ids(next_block_id_, end);
+        next_block_id_ = end;
+    }
+    active_ = false;
+
+    if (corrupt_blocks != 0) {
+        logERR("The scrubber found %" PRIi64 " corrupted blocks in a data file.  See "
+               "the messages above for details.", corrupt_blocks);
+    }
+}
+
+int64_t data_scrubber_t::scrub_block_ids(block_id_t begin, block_id_t end) {
+    struct live_block_t {
+        block_id_t block_id;
+        int64_t offset;
+        counted_t<ls_block_token_pointee_t> token;
+        bool operator<(const live_block_t &other) const {
+            return offset < other.offset;
+        }
+    };
+
+    // Taking the tokens right as we look the blocks up keeps their data in place
+    // until we've read it.  If the garbage collector moves a block in the meantime,
+    // its token moves with it and we skip it.
+    std::vector<live_block_t> blocks;
+    {
+        ASSERT_NO_CORO_WAITING;
+        end = std::min(end, serializer_->lba_index->end_block_id());
+        for (block_id_t block_id = begin; block_id < end; ++block_id) {
+            const index_block_info_t info
+                = serializer_->lba_index->get_block_info(block_id);
+            if (!info.offset.has_value()) {
+                continue;
+            }
+            live_block_t block;
+            block.block_id = block_id;
+            block.offset = info.offset.get_value();
+            block.token = serializer_->generate_block_token(
+                block.offset,
+                block_size_t::unsafe_make(info.ser_block_size),
+                block_size_t::unsafe_make(info.stored_block_size()),
+                info.checksum);
+            blocks.push_back(std::move(block));
+        }
+    }
+    std::sort(blocks.begin(), blocks.end());
+
+    int64_t corrupt_blocks = 0;
+    const uint64_t extent_size = serializer_->static_config.extent_size();
+    for (size_t i = 0; i < blocks.size();) {
+        // Find a run of blocks that are close to each other in the same extent.
+        size_t j = i + 1;
+        int64_t run_end = blocks[i].offset
+            + blocks[i].token->stored_block_size().ser_value();
+        while (j < blocks.size()
+               && blocks[j].offset / extent_size == blocks[i].offset / extent_size
+               && blocks[j].offset - run_end <= SCRUB_MAX_READ_GAP) {
+            run_end = std::max<int64_t>(
+                run_end,
+                blocks[j].offset + blocks[j].token->stored_block_size().ser_value());
+            ++j;
+        }
+
+        const int64_t read_offset = floor_aligned(blocks[i].offset, DEVICE_BLOCK_SIZE);
+        const int64_t read_size = ceil_aligned(run_end, DEVICE_BLOCK_SIZE) - read_offset;
+        scoped_malloc_t<char> buf(malloc_aligned(read_size, DEVICE_BLOCK_SIZE));
+        co_read(serializer_->dbfile, read_offset, read_size, buf.get(),
+                io_account_.get());
+        serializer_->stats->bytes_read(read_size);
+
+        for (; i < j; ++i) {
+            const live_block_t &block = blocks[i];
+            if (block.token->offset() != block.offset) {
+                continue;
+            }
+            const ser_buffer_t *ser_buf = reinterpret_cast<const ser_buffer_t *>(
+                buf.get() + (block.offset - read_offset));
+            ++serializer_->stats->pm_serializer_scrubbed_blocks;
+            if (ser_buf->ser_header.block_id != block.block_id
+                || !block_checksum_matches(ser_buf, block.token->stored_block_size(),
+                                           block.token->checksum())) {
+                ++serializer_->stats->pm_serializer_scrub_corrupt_blocks;
+                ++corrupt_blocks;
+                logERR("Block %" PR_BLOCK_ID " at offset %" PRIi64 " failed its "
+                       "checksum check.  The data file is corrupted.",
+                       block.block_id, block.offset);
+            }
+        }
+    }
+
+    return corrupt_blocks;
+}
@@ -0,0 +1,51 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_SCRUBBER_HPP_
+#define SERIALIZER_LOG_SCRUBBER_HPP_
+
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/interruptor.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+#include "threading.hpp"
+
+class file_account_t;
+class log_serializer_t;
+class signal_t;
+
+/* The scrubber walks over the live blocks of a log serializer's data file every now
+and then and checks their checksums, so that we find out about silently corrupted
+blocks before a query trips over them.  It reads through its own low priority file
+account, and holds block tokens for the blocks it's looking at so that the garbage
+collector can't reuse their space in the meantime.  Corrupted blocks get logged and
+counted in the serializer's stats; the scrubber doesn't try to repair them.  Blocks
+from files written before there were checksums only get their block id checked. */
+class data_scrubber_t : public home_thread_mixin_t {
+public:
+    // Must be constructed once `serializer` is ready, and destroyed before it shuts
+    // down.
+    explicit data_scrubber_t(log_serializer_t *serializer);
+    ~data_scrubber_t();
+
+    // Returns true and sets `*progress_out` to a number between 0 and 1 while a
+    // pass is running.
+    bool get_progress(double *progress_out) const;
+
+private:
+    void run(auto_drainer_t::lock_t keepalive);
+    void scrub_pass(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+    // Returns the number of corrupted blocks it found.
+    int64_t scrub_block_ids(block_id_t begin, block_id_t end);
+
+    log_serializer_t *const serializer_;
+    scoped_ptr_t<file_account_t> io_account_;
+
+    bool active_;
+    block_id_t next_block_id_;
+    block_id_t pass_end_block_id_;
+
+    auto_drainer_t drainer_;
+
+    DISABLE_COPYING(data_scrubber_t);
+};
+
+#endif  // SERIALIZER_LOG_SCRUBBER_HPP_
@@ -25,6 +25,7 @@ struct log_serializer_stats_t {
     /* used in serializer/log/extent_manager.cc */
     perfmon_counter_t pm_extents_in_use;
     perfmon_counter_t pm_bytes_in_use;
+    perfmon_counter_t pm_serializer_punched_extents;
 
     /* used in serializer/log/lba/extent.cc */
     perfmon_counter_t pm_serializer_lba_extents;
@@ -35,6 +36,16 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_gc_relocated_block_bytes;
+    perfmon_counter_t pm_serializer_gc_reclaimed_block_bytes;
+    perfmon_counter_t pm_serializer_data_extents_cold_allocated;
+    perfmon_counter_t pm_serializer_compressed_block_writes;
+    perfmon_counter_t pm_serializer_compression_saved_bytes;
+    perfmon_counter_t pm_serializer_data_extents_compacted;
+
+    /* used in serializer/log/scrubber.cc */
+    perfmon_counter_t pm_serializer_scrubbed_blocks;
+    perfmon_counter_t pm_serializer_scrub_corrupt_blocks;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
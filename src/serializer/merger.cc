@@ -6,21 +6,162 @@
 #include "errors.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/wait_any.hpp"
 #include "config/args.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         int _max_active_block_writes,
+                                         int64_t _group_commit_window_ms,
+                                         perfmon_collection_t *perfmon_collection) :
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
+    outstanding_index_write_count(0),
+    group_commit_window_ms(_group_commit_window_ms),
+    last_batch_size(0),
+    group_complete(NULL),
+    pm_group_commit_batch_size(secs_to_ticks(1), false),
+    stats_membership(perfmon_collection,
+        &pm_group_commit_batch_size, "group_commit_batch_size",
+        &pm_group_commit_batches_1, "group_commit_batches_1",
+        &pm_group_commit_batches_2_3, "group_commit_batches_2_3",
+        &pm_group_commit_batches_4_7, "group_commit_batches_4_7",
+        &pm_group_commit_batches_8_15, "group_commit_batches_8_15",
+        &pm_group_commit_batches_16_plus, "group_commit_batches_16_plus",
+        &pm_block_write_batches, "block_write_batches"),
     write_committer(std::bind(&merger_serializer_t::do_index_write, this),
-                    _max_active_writes) { }
+                    _max_active_writes,
+                    std::bind(&merger_serializer_t::wait_for_group_commit_window,
+                              this)),
+    pending_block_write_bytes(0),
+    num_active_block_writes(0),
+    max_active_block_writes(_max_active_block_writes) {
+    guarantee(max_active_block_writes > 0);
+}
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
+    drainer.drain();
     rassert(outstanding_index_write_ops.empty());
+    rassert(pending_block_writes.empty());
+}
+
+// The block writes of one block_writes() call that wait for the next batch
+struct merger_serializer_t::pending_block_writes_t {
+    const std::vector<buf_write_info_t> *write_infos;
+    iocallback_t *cb;
+    std::vector<counted_t<standard_block_token_t> > tokens;
+    cond_t written;
+};
+
+// Calls the callbacks of all the block_writes() calls in a batch once it has
+// been written.
+class merger_serializer_t::block_write_batch_t : public iocallback_t {
+public:
+    block_write_batch_t(merger_serializer_t *_parent, std::vector<iocallback_t *> &&_cbs)
+        : parent(_parent), cbs(std::move(_cbs)), keepalive(_parent->drainer.lock()) { }
+
+    void on_io_complete() {
+        for (iocallback_t *cb : cbs) {
+            cb->on_io_complete();
+        }
+        parent->on_block_write_batch_complete();
+        delete this;
+    }
+
+private:
+    merger_serializer_t *const parent;
+    const std::vector<iocallback_t *> cbs;
+    auto_drainer_t::lock_t keepalive;
+};
+
+std::vector<counted_t<standard_block_token_t> >
+merger_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
+                                  UNUSED file_account_t *io_account,
+                                  iocallback_t *cb) {
+    assert_thread();
+    // We use a common file account for all block writes, which reduces random disk
+    // seeks that would arise from trying to interleave writes from the individual
+    // accounts further down in the i/o layer.
+
+    if (num_active_block_writes < max_active_block_writes
+        && pending_block_writes.empty()) {
+        // Nothing to merge with, don't keep the caller waiting.
+        ++num_active_block_writes;
+        ++pm_block_write_batches;
+        return inner->block_writes(write_infos, block_writes_io_account.get(),
+                                   new block_write_batch_t(this, { cb }));
+    }
+
+    rassert(coro_t::self() != NULL);
+    pending_block_writes_t pending;
+    pending.write_infos = &write_infos;
+    pending.cb = cb;
+    pending_block_writes.push_back(&pending);
+    for (const buf_write_info_t &info : write_infos) {
+        pending_block_write_bytes += info.block_size.ser_value();
+    }
+    if (pending_block_write_bytes >= MERGER_SERIALIZER_BLOCK_WRITE_BATCH_SIZE) {
+        // The batch is big enough to be worth writing on its own.
+        ++num_active_block_writes;
+        write_pending_blocks();
+    }
+    pending.written.wait_lazily_unordered();
+    return std::move(pending.tokens);
+}
+
+void merger_serializer_t::write_pending_blocks() {
+    assert_thread();
+    ASSERT_FINITE_CORO_WAITING;
+
+    std::vector<pending_block_writes_t *> batch;
+    batch.swap(pending_block_writes);
+    pending_block_write_bytes = 0;
+
+    std::vector<buf_write_info_t> write_infos;
+    std::vector<iocallback_t *> cbs;
+    cbs.reserve(batch.size());
+    for (pending_block_writes_t *pending : batch) {
+        write_infos.insert(write_infos.end(),
+                           pending->write_infos->begin(), pending->write_infos->end());
+        cbs.push_back(pending->cb);
+    }
+
+    ++pm_block_write_batches;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = inner->block_writes(write_infos, block_writes_io_account.get(),
+                              new block_write_batch_t(this, std::move(cbs)));
+    guarantee(tokens.size() == write_infos.size());
+
+    auto token_it = tokens.begin();
+    for (pending_block_writes_t *pending : batch) {
+        const size_t count = pending->write_infos->size();
+        pending->tokens.assign(std::make_move_iterator(token_it),
+                               std::make_move_iterator(token_it + count));
+        token_it += count;
+        pending->written.pulse();
+    }
+}
+
+void merger_serializer_t::on_block_write_batch_complete() {
+    assert_thread();
+    --num_active_block_writes;
+    if (!pending_block_writes.empty()
+        && num_active_block_writes < max_active_block_writes) {
+        ++num_active_block_writes;
+        // We might be in an I/O callback here, so we write the next batch from a
+        // coroutine.
+        auto_drainer_t::lock_t keepalive(&drainer);
+        coro_t::spawn_sometime([this, keepalive]() {
+            write_pending_blocks();
+        });
+    }
 }
 
 void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
@@ -32,6 +173,10 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
         push_index_write_op(*op);
     }
+    ++outstanding_index_write_count;
+    if (group_complete != NULL && outstanding_index_write_count >= last_batch_size) {
+        group_complete->pulse_if_not_already_pulsed();
+    }
 
     // The caller is definitely "in line" for this merger serializer -- subsequent
     // index_write calls will get logically committed after ours.
@@ -56,13 +201,53 @@ void merger_serializer_t::do_index_write() {
             write_ops.push_back(op_pair->second);
         }
         outstanding_index_write_ops.clear();
+        last_batch_size = outstanding_index_write_count;
+        outstanding_index_write_count = 0;
     }
+    record_batch_size(last_batch_size);
 
     new_mutex_in_line_t mutex_acq(&inner_index_write_mutex);
     mutex_acq.acq_signal()->wait();
     inner->index_write(&mutex_acq, write_ops);
 }
 
+void merger_serializer_t::wait_for_group_commit_window() {
+    assert_thread();
+    if (group_commit_window_ms <= 0 || last_batch_size <= 1
+        || outstanding_index_write_count >= last_batch_size) {
+        return;
+    }
+    // We expect about as many index writes as last time, so we stop waiting as soon
+    // as they are in.
+    cond_t complete;
+    signal_timer_t window;
+    window.start(group_commit_window_ms);
+    group_complete = &complete;
+    wait_any_t waiter(&complete, &window);
+    waiter.wait_lazily_unordered();
+    group_complete = NULL;
+}
+
+void merger_serializer_t::record_batch_size(int64_t batch_size) {
+    if (batch_size == 0) {
+        // The committer can start a commit for syncs that an earlier commit
+        // already took care of.
+        return;
+    }
+    pm_group_commit_batch_size.record(batch_size);
+    if (batch_size == 1) {
+        ++pm_group_commit_batches_1;
+    } else if (batch_size < 4) {
+        ++pm_group_commit_batches_2_3;
+    } else if (batch_size < 8) {
+        ++pm_group_commit_batches_4_7;
+    } else if (batch_size < 16) {
+        ++pm_group_commit_batches_8_15;
+    } else {
+        ++pm_group_commit_batches_16_plus;
+    }
+}
+
 void merger_serializer_t::merge_index_write_op(const index_write_op_t &to_be_merged,
                                                index_write_op_t *into_out) const {
     rassert(to_be_merged.block_id == into_out->block_id);
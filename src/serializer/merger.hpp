@@ -7,9 +7,12 @@
 #include <memory>
 
 #include "buffer_cache/types.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/throttled_committer.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/serializer.hpp"
 
@@ -22,6 +25,18 @@
  * hash shards) can be merged together, improving efficiency and significantly
  * reducing the number of disk seeks on rotational drives.
  *
+ * Once index writes are coming in concurrently (that is, the last commit merged
+ * more than one of them), the merger also holds each commit back until as many
+ * index writes have come in as the last commit merged, or for at most
+ * `group_commit_window_ms` milliseconds, so that index writes which arrive right
+ * after each other share one metablock write and fsync instead of each paying for
+ * their own.  A lone index write is committed right away.
+ *
+ * Block writes get the same treatment: while `max_active_block_writes` batches
+ * of block writes are being written, new block writes (from all the hash shards
+ * and secondary indexes sharing the file) are collected into the next batch, which
+ * the inner serializer writes out as one contiguous run per extent.
+ *
  * As an additional optimization, merger_serializer_t uses a common file account
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
@@ -30,15 +45,20 @@
 
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes,
+                        int _max_active_block_writes,
+                        int64_t _group_commit_window_ms,
+                        perfmon_collection_t *perfmon_collection);
     ~merger_serializer_t();
 
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int64_t latency_target_us) {
+        return inner->make_io_account(priority, outstanding_requests_limit,
+                                      latency_target_us);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -59,6 +79,12 @@ public:
         return inner->block_read(token, io_account);
     }
 
+    std::vector<buf_ptr_t>
+    block_reads(const std::vector<counted_t<standard_block_token_t> > &tokens,
+                file_account_t *io_account) {
+        return inner->block_reads(tokens, io_account);
+    }
+
     /* The index stores three pieces of information for each ID:
      * 1. A pointer to a data block on disk (which may be NULL)
      * 2. A repli_timestamp_t, called the "recency"
@@ -92,16 +118,14 @@ public:
                      const std::vector<index_write_op_t> &write_ops);
 
     // Returns block tokens in the same order as write_infos.
+    /* This merges block writes that come in while `max_active_block_writes`
+    batches are already being written into one batch, so that the inner
+    serializer can lay them out next to each other and write them with a few large
+    writes. */
     std::vector<counted_t<standard_block_token_t> >
     block_writes(const std::vector<buf_write_info_t> &write_infos,
-                 UNUSED file_account_t *io_account,
-                 iocallback_t *cb) {
-        // Currently, we do not merge block writes, only index writes.
-        // However we do use a common file account for all of them, which
-        // reduces random disk seeks that would arise from trying to interleave
-        // writes from the individual accounts further down in the i/o layer.
-        return inner->block_writes(write_infos, block_writes_io_account.get(), cb);
-    }
+                 file_account_t *io_account,
+                 iocallback_t *cb);
 
     /* The size, in bytes, of each serializer block */
     max_block_size_t max_block_size() const { return inner->max_block_size(); }
@@ -114,6 +138,10 @@ public:
         return inner->is_gc_active();
     }
 
+    bool get_scrub_progress(double *progress_out) const {
+        return inner->get_scrub_progress(progress_out);
+    }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
@@ -124,6 +152,19 @@ private:
 
     void do_index_write();
 
+    // Gives concurrent index writes `group_commit_window_ms` to catch up with the
+    // commit that's about to start, if the last commit merged several of them.
+    void wait_for_group_commit_window();
+
+    void record_batch_size(int64_t batch_size);
+
+    class block_write_batch_t;
+    struct pending_block_writes_t;
+
+    // Sends the pending block writes to the inner serializer as one batch.
+    void write_pending_blocks();
+    void on_block_write_batch_complete();
+
     const scoped_ptr_t<serializer_t> inner;
     const scoped_ptr_t<file_account_t> block_writes_io_account;
 
@@ -133,9 +174,39 @@ private:
 
     // A map of outstanding index write operations, indexed by block id
     std::map<block_id_t, index_write_op_t> outstanding_index_write_ops;
+    // The number of index_write calls that `outstanding_index_write_ops` came from
+    int64_t outstanding_index_write_count;
+
+    const int64_t group_commit_window_ms;
+    // The number of index_write calls that the last commit merged
+    int64_t last_batch_size;
+    // Pulsed once as many index writes are outstanding as the last commit merged,
+    // while `wait_for_group_commit_window()` waits for that
+    cond_t *group_complete;
+
+    // How many index_write calls each commit merged, as a distribution of batch
+    // sizes and as a histogram with power of two buckets
+    perfmon_sampler_t pm_group_commit_batch_size;
+    perfmon_counter_t pm_group_commit_batches_1;
+    perfmon_counter_t pm_group_commit_batches_2_3;
+    perfmon_counter_t pm_group_commit_batches_4_7;
+    perfmon_counter_t pm_group_commit_batches_8_15;
+    perfmon_counter_t pm_group_commit_batches_16_plus;
+    // How many block_writes calls we've made on the inner serializer
+    perfmon_counter_t pm_block_write_batches;
+    perfmon_multi_membership_t stats_membership;
 
     throttled_committer_t write_committer;
 
+    // Block writes that wait for the next batch, and their total size in bytes
+    std::vector<pending_block_writes_t *> pending_block_writes;
+    int64_t pending_block_write_bytes;
+    int num_active_block_writes;
+    const int max_active_block_writes;
+
+    // Keeps us alive until the block write batches in flight have completed.
+    auto_drainer_t drainer;
+
     DISABLE_COPYING(merger_serializer_t);
 };
 
@@ -50,7 +50,8 @@ public:
     ~semantic_checking_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int64_t latency_target_us);
     counted_t< scs_block_token_t<inner_serializer_t> > index_read(block_id_t block_id);
 
     buf_ptr_t block_read(const counted_t< scs_block_token_t<inner_serializer_t> > &_token,
@@ -62,8 +62,9 @@ template<class inner_serializer_t>
 semantic_checking_serializer_t<inner_serializer_t>::~semantic_checking_serializer_t() { }
 
 template<class inner_serializer_t>
-file_account_t *semantic_checking_serializer_t<inner_serializer_t>::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner_serializer.make_io_account(priority, outstanding_requests_limit);
+file_account_t *semantic_checking_serializer_t<inner_serializer_t>::make_io_account(int priority, int outstanding_requests_limit, int64_t latency_target_us) {
+    return inner_serializer.make_io_account(priority, outstanding_requests_limit,
+                                            latency_target_us);
 }
 
 template<class inner_serializer_t>
@@ -4,6 +4,7 @@
 #include "arch/arch.hpp"
 #include "boost_utils.hpp"
 #include "math.hpp"
+#include "serializer/buf_ptr.hpp"
 
 void debug_print(printf_buffer_t *buf, const index_write_op_t &write_op) {
     buf->appendf("iwop{id=%" PRIu64 ", token=", write_op.block_id);
@@ -18,6 +19,23 @@ file_account_t *serializer_t::make_io_account(int priority) {
     return make_io_account(priority, UNLIMITED_OUTSTANDING_REQUESTS);
 }
 
+file_account_t *serializer_t::make_io_account(int priority,
+                                              int outstanding_requests_limit) {
+    assert_thread();
+    return make_io_account(priority, outstanding_requests_limit, NO_IO_LATENCY_TARGET);
+}
+
+std::vector<buf_ptr_t>
+serializer_t::block_reads(const std::vector<counted_t<standard_block_token_t> > &tokens,
+                          file_account_t *io_account) {
+    std::vector<buf_ptr_t> ret;
+    ret.reserve(tokens.size());
+    for (const auto &token : tokens) {
+        ret.push_back(block_read(token, io_account));
+    }
+    return ret;
+}
+
 ser_buffer_t *convert_buffer_cache_buf_to_ser_buffer(const void *buf) {
     return static_cast<ser_buffer_t *>(const_cast<void *>(buf)) - 1;
 }
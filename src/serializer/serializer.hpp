@@ -49,9 +49,11 @@ public:
     virtual ~serializer_t() { }
 
     /* Allocates a new io account for the underlying file.
-    Use delete to free it. */
+    Use delete to free it.  See `file_account_t` for `latency_target_us`. */
     file_account_t *make_io_account(int priority);
-    virtual file_account_t *make_io_account(int priority, int outstanding_requests_limit) = 0;
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    virtual file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                            int64_t latency_target_us) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
     This is supported through a serializer_read_ahead_callback_t which gets called whenever the serializer has read-ahead some buf.
@@ -64,6 +66,13 @@ public:
     virtual buf_ptr_t block_read(const counted_t<standard_block_token_t> &token,
                                file_account_t *io_account) = 0;
 
+    // Reads several blocks, returning them in the same order as `tokens`.  Serializers
+    // that can read blocks which lie next to each other on disk with a single read
+    // override this.  Blocks the coroutine.
+    virtual std::vector<buf_ptr_t>
+    block_reads(const std::vector<counted_t<standard_block_token_t> > &tokens,
+                file_account_t *io_account);
+
     /* The index stores three pieces of information for each ID:
      * 1. A pointer to a data block on disk (which may be NULL)
      * 2. A repli_timestamp_t, called the "recency"
@@ -120,6 +129,10 @@ public:
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Return true and set `*progress_out` (between 0 and 1) if the scrubber is
+    checking the blocks' checksums */
+    virtual bool get_scrub_progress(double *progress_out) const = 0;
+
 private:
     DISABLE_COPYING(serializer_t);
 };
@@ -220,8 +220,11 @@ translator_serializer_t::translator_serializer_t(serializer_t *_inner, int _mod_
     rassert(mod_id < mod_count);
 }
 
-file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner->make_io_account(priority, outstanding_requests_limit);
+file_account_t *translator_serializer_t::make_io_account(int priority,
+                                                         int outstanding_requests_limit,
+                                                         int64_t latency_target_us) {
+    return inner->make_io_account(priority, outstanding_requests_limit,
+                                  latency_target_us);
 }
 
 void translator_serializer_t::index_write(
@@ -254,6 +257,12 @@ buf_ptr_t translator_serializer_t::block_read(const counted_t<standard_block_tok
     return inner->block_read(token, io_account);
 }
 
+std::vector<buf_ptr_t> translator_serializer_t::block_reads(
+        const std::vector<counted_t<standard_block_token_t> > &tokens,
+        file_account_t *io_account) {
+    return inner->block_reads(tokens, io_account);
+}
+
 counted_t<standard_block_token_t> translator_serializer_t::index_read(block_id_t block_id) {
     return inner->index_read(translate_block_id(block_id));
 }
@@ -270,6 +279,10 @@ bool translator_serializer_t::is_gc_active() const {
     return inner->is_gc_active();
 }
 
+bool translator_serializer_t::get_scrub_progress(double *progress_out) const {
+    return inner->get_scrub_progress(progress_out);
+}
+
 block_id_t translator_serializer_t::max_block_id() {
     int64_t x = inner->max_block_id() - cfgid.subsequent_ser_id();
     if (x <= 0) {
@@ -111,7 +111,8 @@ public:
     translator_serializer_t(serializer_t *inner, int mod_count, int mod_id, config_block_id_t cfgid);
 
     /* Allocates a new io account for the underlying file */
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    int64_t latency_target_us);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::vector<index_write_op_t> &write_ops);
@@ -125,6 +126,8 @@ public:
 
     bool is_gc_active() const;
 
+    bool get_scrub_progress(double *progress_out) const;
+
     // Returns the first never-used block id.  Every block with id
     // less than this has been created, and possibly deleted.  Every
     // block with id greater than or equal to this has never been
@@ -138,6 +141,9 @@ public:
 
     buf_ptr_t block_read(const counted_t<standard_block_token_t> &token,
                        file_account_t *io_account);
+    std::vector<buf_ptr_t>
+    block_reads(const std::vector<counted_t<standard_block_token_t> > &tokens,
+                file_account_t *io_account);
     counted_t<standard_block_token_t> index_read(block_id_t block_id);
 
 public:
@@ -121,6 +121,12 @@ class ls_block_token_pointee_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // The size the block takes up on disk.  It's smaller than block_size() if the
+    // block is stored compressed.
+    block_size_t stored_block_size() const { return stored_block_size_; }
+    bool is_compressed() const { return stored_block_size_ != block_size_; }
+    // The checksum of the block as it's stored on disk, see `block_checksum()`.
+    uint32_t checksum() const { return checksum_; }
 
 private:
     friend class log_serializer_t;
@@ -131,7 +137,9 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_stored_block_size,
+                             uint32_t checksum);
 
     log_serializer_t *serializer_;
     intptr_t ref_count_;
@@ -139,6 +147,12 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The block's size on disk.
+    block_size_t stored_block_size_;
+
+    // The block's checksum, which doesn't change when GC moves the block.
+    uint32_t checksum_;
+
     // The block's offset on disk.
     int64_t offset_;
 
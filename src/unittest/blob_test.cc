@@ -1,4 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "buffer_cache/cache_balancer.hpp"
@@ -130,6 +133,19 @@ public:
         check(txn);
     }
 
+    // Returns whether `read_in_one_piece()` could read the value, checking that it
+    // read the right bytes if it could.
+    bool check_one_piece(txn_t *txn) {
+        bool called = false;
+        const bool read = blob_.read_in_one_piece(buf_parent_t(txn),
+            [&](const char *buf, int64_t size) {
+                called = true;
+                EXPECT_EQ(expected_, std::string(buf, size));
+            });
+        EXPECT_EQ(read, called);
+        return read;
+    }
+
     size_t refsize(max_block_size_t block_size) const {
         return blob_.refsize(block_size);
     }
@@ -297,4 +313,78 @@ TPTEST(BlobTest, all_tests) {
     run_tests(&cache);
 }
 
+// Reads a blob back through a fresh cache, which loads the leaves of each subtree
+// as a group with a single serializer call.
+TPTEST(BlobTest, LargeValueReadsBackIntoColdCache) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(
+            &file_opener,
+            standard_serializer_t::static_config_t());
+    standard_serializer_t log_serializer(
+            standard_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    blob_tracker_t tk(251);
+    {
+        cache_t cache(&log_serializer, &balancer, &get_global_perfmon_collection());
+        cache_conn_t cache_conn(&cache);
+        txn_t txn(&cache_conn, write_durability_t::HARD,
+                  repli_timestamp_t::distant_past, 0);
+        std::string value;
+        for (int i = 0; value.size() < 200 * KILOBYTE; ++i) {
+            value += strprintf("%d,", i);
+        }
+        tk.append(&txn, value);
+    }
+
+    cache_t cache(&log_serializer, &balancer, &get_global_perfmon_collection());
+    cache_conn_t cache_conn(&cache);
+    txn_t txn(&cache_conn, read_access_t::read);
+    tk.check(&txn);
+}
+
+// Values that are stored in the blob ref or in a single leaf get read without
+// setting up a buffer group, also when the leaf has to come from disk.
+TPTEST(BlobTest, ReadsSmallValuesInOnePiece) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(
+            &file_opener,
+            standard_serializer_t::static_config_t());
+    standard_serializer_t log_serializer(
+            standard_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    const std::vector<int64_t> sizes = { 0, 1, 250, 251, size_after_magic,
+                                         size_after_magic + 1, 3 * size_after_magic };
+    std::vector<scoped_ptr_t<blob_tracker_t> > trackers;
+    {
+        cache_t cache(&log_serializer, &balancer, &get_global_perfmon_collection());
+        cache_conn_t cache_conn(&cache);
+        txn_t txn(&cache_conn, write_durability_t::HARD,
+                  repli_timestamp_t::distant_past, 0);
+        for (int64_t size : sizes) {
+            std::string value;
+            for (int64_t i = 0; i < size; ++i) {
+                value.push_back('a' + i % 23);
+            }
+            trackers.push_back(make_scoped<blob_tracker_t>(251));
+            trackers.back()->append(&txn, value);
+        }
+    }
+
+    cache_t cache(&log_serializer, &balancer, &get_global_perfmon_collection());
+    cache_conn_t cache_conn(&cache);
+    txn_t txn(&cache_conn, read_access_t::read);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        SCOPED_TRACE(strprintf("size %" PRIi64, sizes[i]));
+        EXPECT_EQ(sizes[i] <= size_after_magic, trackers[i]->check_one_piece(&txn));
+        // The blocks are in the cache now, which makes no difference.
+        EXPECT_EQ(sizes[i] <= size_after_magic, trackers[i]->check_one_piece(&txn));
+    }
+}
+
 }  // namespace unittest
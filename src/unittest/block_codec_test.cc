@@ -0,0 +1,129 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "config/args.hpp"
+#include "serializer/log/block_codec.hpp"
+
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+buf_ptr_t make_block(block_id_t block_id, bool compressible) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(
+        block_size_t::make_from_cache(DEFAULT_BTREE_BLOCK_SIZE - sizeof(ls_buf_data_t)));
+    buf.ser_buffer()->ser_header.block_id = block_id;
+    char *data = reinterpret_cast<char *>(buf.cache_data());
+    uint32_t state = 12345;
+    for (uint32_t i = 0; i < buf.block_size().value(); ++i) {
+        if (compressible) {
+            data[i] = 'a' + (i / 64) % 4;
+        } else {
+            state = state * 1103515245 + 12345;
+            data[i] = static_cast<char>(state >> 16);
+        }
+    }
+    return buf;
+}
+
+void check_round_trip(block_codec_t codec) {
+    buf_ptr_t block = make_block(17, true);
+
+    buf_ptr_t compressed = compress_block(codec, block.ser_buffer(), block.block_size());
+    ASSERT_TRUE(compressed.has());
+    EXPECT_LT(compressed.aligned_block_size(), block.aligned_block_size());
+    // The LBA only records whole device blocks.
+    EXPECT_EQ(0u, compressed.block_size().ser_value() % DEVICE_BLOCK_SIZE);
+    // The block id stays readable for the garbage collector and read-ahead.
+    EXPECT_EQ(17u, compressed.ser_buffer()->ser_header.block_id);
+    compressed.assert_padding_zero();
+
+    buf_ptr_t decompressed = decompress_block(compressed.ser_buffer(),
+                                              compressed.block_size(),
+                                              block.block_size());
+    ASSERT_EQ(block.block_size(), decompressed.block_size());
+    EXPECT_EQ(0, memcmp(block.ser_buffer(), decompressed.ser_buffer(),
+                        block.block_size().ser_value()));
+}
+
+TEST(BlockCodecTest, ZlibFastRoundTrip) {
+    check_round_trip(block_codec_t::zlib_fast);
+}
+
+TEST(BlockCodecTest, ZlibBestRoundTrip) {
+    check_round_trip(block_codec_t::zlib_best);
+}
+
+TEST(BlockCodecTest, NoneDoesNotCompress) {
+    buf_ptr_t block = make_block(1, true);
+    EXPECT_FALSE(compress_block(block_codec_t::none, block.ser_buffer(),
+                                block.block_size()).has());
+}
+
+TEST(BlockCodecTest, IncompressibleIsStoredAsIs) {
+    buf_ptr_t block = make_block(1, false);
+    EXPECT_FALSE(compress_block(block_codec_t::zlib_best, block.ser_buffer(),
+                                block.block_size()).has());
+}
+
+TEST(BlockCodecTest, Crc32cKnownValues) {
+    EXPECT_EQ(0u, crc32c(0, "", 0));
+    EXPECT_EQ(0xe3069283u, crc32c(0, "123456789", 9));
+    // Checksumming in pieces gives the same result, whatever the alignment.
+    EXPECT_EQ(0xe3069283u, crc32c(crc32c(0, "1234", 4), "56789", 5));
+    char zeros[32] = { 0 };
+    EXPECT_EQ(0x8a9136aau, crc32c(0, zeros, sizeof(zeros)));
+}
+
+TEST(BlockCodecTest, ChecksumDetectsCorruption) {
+    for (bool compressible : { true, false }) {
+        buf_ptr_t block = make_block(5, compressible);
+        const uint32_t checksum = block_checksum(block.ser_buffer(), block.block_size());
+        EXPECT_NE(NO_BLOCK_CHECKSUM, checksum);
+        EXPECT_TRUE(block_checksum_matches(block.ser_buffer(), block.block_size(),
+                                           checksum));
+
+        block.ser_buffer()->cache_data[100] ^= 1;
+        EXPECT_FALSE(block_checksum_matches(block.ser_buffer(), block.block_size(),
+                                            checksum));
+        block.ser_buffer()->cache_data[100] ^= 1;
+
+        block.ser_buffer()->ser_header.block_id = 6;
+        EXPECT_FALSE(block_checksum_matches(block.ser_buffer(), block.block_size(),
+                                            checksum));
+    }
+}
+
+TEST(BlockCodecTest, ChecksumCoversCompressedPayload) {
+    buf_ptr_t block = make_block(17, true);
+    buf_ptr_t compressed = compress_block(block_codec_t::zlib_fast, block.ser_buffer(),
+                                          block.block_size());
+    ASSERT_TRUE(compressed.has());
+    const uint32_t checksum = block_checksum(compressed.ser_buffer(),
+                                             compressed.block_size());
+    EXPECT_TRUE(block_checksum_matches(compressed.ser_buffer(),
+                                       compressed.block_size(), checksum));
+    compressed.ser_buffer()->cache_data[sizeof(compressed_block_header_t)] ^= 0x10;
+    EXPECT_FALSE(block_checksum_matches(compressed.ser_buffer(),
+                                        compressed.block_size(), checksum));
+}
+
+TEST(BlockCodecTest, BlocksWithoutChecksumAreUnchecked) {
+    // That's what blocks from files written before there were checksums have.
+    buf_ptr_t block = make_block(3, false);
+    EXPECT_TRUE(block_checksum_matches(block.ser_buffer(), block.block_size(),
+                                       NO_BLOCK_CHECKSUM));
+}
+
+TEST(BlockCodecTest, CodecNames) {
+    block_codec_t codec = block_codec_t::none;
+    ASSERT_TRUE(block_codec_from_name("zlib-fast", &codec));
+    EXPECT_EQ(block_codec_t::zlib_fast, codec);
+    ASSERT_TRUE(block_codec_from_name("zlib-best", &codec));
+    EXPECT_EQ(block_codec_t::zlib_best, codec);
+    ASSERT_TRUE(block_codec_from_name("none", &codec));
+    EXPECT_EQ(block_codec_t::none, codec);
+    EXPECT_FALSE(block_codec_from_name("zlib", &codec));
+    EXPECT_FALSE(block_codec_from_name("zlib_fast", &codec));
+}
+
+}  // namespace unittest
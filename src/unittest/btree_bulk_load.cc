@@ -0,0 +1,277 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "btree/bulk_load.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "btree/slice.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "serializer/config.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Values are a length byte followed by that many bytes.
+class bulk_load_value_sizer_t : public value_sizer_t {
+public:
+    explicit bulk_load_value_sizer_t(max_block_size_t bs) : block_size_(bs) { }
+
+    int size(const void *value) const {
+        return 1 + *static_cast<const uint8_t *>(value);
+    }
+    bool fits(const void *value, int length_available) const {
+        return length_available > 0 && size(value) <= length_available;
+    }
+    int max_possible_size() const { return 256; }
+    block_magic_t btree_leaf_magic() const {
+        block_magic_t magic = { { 'b', 'l', 'L', 'F' } };
+        return magic;
+    }
+    max_block_size_t block_size() const { return block_size_; }
+
+private:
+    max_block_size_t block_size_;
+};
+
+std::vector<char> bulk_load_value(int i) {
+    std::string str = strprintf("value %d", i);
+    std::vector<char> ret(1, str.size());
+    ret.insert(ret.end(), str.begin(), str.end());
+    return ret;
+}
+
+store_key_t bulk_load_key(int i) {
+    return store_key_t(strprintf("key %08d", i));
+}
+
+// Checks the node and its subtree, and appends its keys to `keys_out`.
+void check_bulk_loaded_node(value_sizer_t *sizer, buf_parent_t parent,
+                            block_id_t block_id,
+                            std::vector<store_key_t> *keys_out) {
+    buf_lock_t lock(parent, block_id, access_t::read);
+    buf_read_t read(&lock);
+    const node_t *node = static_cast<const node_t *>(read.get_data_read());
+    node::validate(sizer, node);
+    if (node::is_leaf(node)) {
+        const leaf_node_t *leaf_node = reinterpret_cast<const leaf_node_t *>(node);
+        for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
+            keys_out->push_back(store_key_t((*it).first));
+        }
+        return;
+    }
+
+    const internal_node_t *internal_node
+        = reinterpret_cast<const internal_node_t *>(node);
+    ASSERT_GE(internal_node->npairs, 2);
+    for (int i = 0; i < internal_node->npairs; ++i) {
+        const btree_internal_pair *pair
+            = internal_node::get_pair_by_index(internal_node, i);
+        check_bulk_loaded_node(sizer, buf_parent_t(&lock), pair->lnode, keys_out);
+        if (i != internal_node->npairs - 1) {
+            // Every key in the subtree is at most the pair's key.
+            ASSERT_FALSE(keys_out->empty());
+            EXPECT_LE(keys_out->back(), store_key_t(&pair->key));
+        }
+    }
+}
+
+// Creates a btree and bulk loads the first `num_keys` keys into it, appending them
+// over many transactions.
+void bulk_load_test_keys(cache_conn_t *cache_conn, value_sizer_t *sizer,
+                         int num_keys) {
+    {
+        txn_t txn(cache_conn, write_durability_t::HARD,
+                  repli_timestamp_t::distant_past, 1);
+        buf_lock_t superblock(&txn, SUPERBLOCK_ID, alt_create_t::create);
+        buf_write_t sb_write(&superblock);
+        btree_slice_t::init_superblock(&superblock,
+                                       std::vector<char>(), binary_blob_t());
+    }
+
+    btree_bulk_loader_t loader(sizer);
+    for (int i = 0; i < num_keys;) {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn(cache_conn, write_access_t::write, 1,
+                                     repli_timestamp_t::distant_past,
+                                     write_durability_t::SOFT,
+                                     &superblock, &txn);
+        for (int end = std::min(num_keys, i + 777); i < end; ++i) {
+            loader.append(superblock.get(), bulk_load_key(i).btree_key(),
+                          bulk_load_value(i).data(),
+                          repli_timestamp_t::distant_past);
+        }
+        loader.finish_chunk(superblock.get());
+    }
+}
+
+TPTEST(BTreeBulkLoad, LoadAndLookUp) {
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    cache_t cache(&serializer, &balancer, &get_global_perfmon_collection());
+    cache_conn_t cache_conn(&cache);
+
+    bulk_load_value_sizer_t sizer(cache.max_block_size());
+    // Enough keys for a tree of height three.
+    const int num_keys = 50000;
+    bulk_load_test_keys(&cache_conn, &sizer, num_keys);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(&cache_conn, CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+
+    std::vector<store_key_t> keys;
+    check_bulk_loaded_node(&sizer, superblock->expose_buf(),
+                           superblock->get_root_block_id(), &keys);
+    ASSERT_EQ(static_cast<size_t>(num_keys), keys.size());
+    for (int i = 0; i < num_keys; ++i) {
+        EXPECT_EQ(bulk_load_key(i), keys[i]);
+    }
+
+    btree_stats_t stats(NULL, "bulk_load", index_type_t::PRIMARY);
+    for (int i = 0; i < num_keys; i += 97) {
+        keyvalue_location_t kv_location;
+        find_keyvalue_location_for_read(&sizer, superblock.get(),
+                                        bulk_load_key(i).btree_key(), &kv_location,
+                                        &stats, NULL);
+        ASSERT_TRUE(kv_location.value.has());
+        const std::vector<char> expected = bulk_load_value(i);
+        EXPECT_EQ(0, memcmp(expected.data(), kv_location.value.get(),
+                            expected.size()));
+    }
+}
+
+// Checks that a scan sees every key, in order, with the right value.
+class bulk_load_scan_checker_t : public depth_first_traversal_callback_t {
+public:
+    bulk_load_scan_checker_t(int num_keys, direction_t direction)
+        : num_keys_(num_keys), direction_(direction), count_(0) { }
+
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        const int i = direction_ == FORWARD ? count_ : num_keys_ - 1 - count_;
+        ++count_;
+        EXPECT_EQ(bulk_load_key(i), store_key_t(keyvalue.key()));
+        const std::vector<char> expected = bulk_load_value(i);
+        EXPECT_EQ(0, memcmp(expected.data(), keyvalue.value(), expected.size()));
+        // A real scan has work to do for each row, which gives the leaves it
+        // prefetched time to load.
+        coro_t::yield();
+        return done_traversing_t::NO;
+    }
+
+    int count() const { return count_; }
+
+private:
+    const int num_keys_;
+    const direction_t direction_;
+    int count_;
+};
+
+int64_t cache_stat(perfmon_collection_t *stats, const char *name) {
+    void *ctx = stats->begin_stats();
+    stats->visit_stats(ctx);
+    return stats->end_stats(ctx).get_field("cache").get_field(name).as_int();
+}
+
+// Scans the tree through a cold cache, once in each direction.  The scans load the
+// leaves ahead of themselves, so hardly any leaf is missing once they get to it.
+TPTEST(BTreeBulkLoad, ScanPrefetchesLeaves) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    const int num_keys = 50000;
+    {
+        cache_t cache(&serializer, &balancer, &get_global_perfmon_collection());
+        cache_conn_t cache_conn(&cache);
+        bulk_load_value_sizer_t sizer(cache.max_block_size());
+        bulk_load_test_keys(&cache_conn, &sizer, num_keys);
+    }
+
+    for (direction_t direction : { FORWARD, BACKWARD }) {
+        SCOPED_TRACE(direction == FORWARD ? "forward" : "backward");
+        perfmon_collection_t stats;
+        cache_t cache(&serializer, &balancer, &stats);
+        cache_conn_t cache_conn(&cache);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn_for_reading(&cache_conn, CACHE_SNAPSHOTTED_NO,
+                                                 &superblock, &txn);
+
+        bulk_load_scan_checker_t checker(num_keys, direction);
+        EXPECT_TRUE(btree_depth_first_traversal(superblock.get(),
+                                                key_range_t::universe(), &checker,
+                                                direction,
+                                                release_superblock_t::RELEASE));
+        EXPECT_EQ(num_keys, checker.count());
+
+        // Every block of the tree is in the cache now.
+        const int64_t blocks_loaded = cache_stat(&stats, "in_use_bytes")
+            / cache.max_block_size().ser_value();
+        ASSERT_GT(blocks_loaded, 100);
+        EXPECT_LT(cache_stat(&stats, "misses") * 4, blocks_loaded);
+    }
+}
+
+TPTEST(BTreeBulkLoad, SortAcrossRuns) {
+    temp_directory_t temp_directory;
+    recreate_temporary_directory(temp_directory.path());
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    // A tiny memory limit, so that the pairs get spilled into many runs, which get
+    // merged in between as well as in the end.
+    bulk_load_sorter_t sorter(&io_backender, temp_directory.path(),
+                              "bulk_load_sort_test", &get_global_perfmon_collection(),
+                              64 * KILOBYTE);
+    const int num_pairs = 20000;
+    std::vector<int> order;
+    for (int i = 0; i < num_pairs; ++i) {
+        order.push_back(i);
+    }
+    std::random_shuffle(order.begin(), order.end());
+    for (int i : order) {
+        sorter.push(std::make_pair(bulk_load_key(i), bulk_load_value(i)));
+    }
+
+    bulk_load_pair_t pair;
+    for (int i = 0; i < num_pairs; ++i) {
+        ASSERT_TRUE(sorter.pop(&pair));
+        EXPECT_EQ(bulk_load_key(i), pair.first);
+        EXPECT_EQ(bulk_load_value(i), pair.second);
+    }
+    EXPECT_FALSE(sorter.pop(&pair));
+}
+
+}  // namespace unittest
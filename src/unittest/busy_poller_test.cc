@@ -0,0 +1,35 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/runtime/busy_poller.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(BusyPollerTest, DisabledByDefault) {
+    busy_poller_t poller;
+    EXPECT_FALSE(poller.enabled());
+    int calls = 0;
+    EXPECT_EQ(0, poller.spin([&]() { ++calls; return 1; }));
+    EXPECT_EQ(0, calls);
+}
+
+TEST(BusyPollerTest, SpinsUntilHit) {
+    set_busy_poll_limit(MAX_BUSY_POLL_LIMIT_US);
+    busy_poller_t poller;
+    set_busy_poll_limit(0);
+    ASSERT_TRUE(poller.enabled());
+
+    // The poll finds something on its third try.
+    int calls = 0;
+    EXPECT_EQ(5, poller.spin([&]() { return ++calls == 3 ? 5 : 0; }));
+    EXPECT_EQ(3, calls);
+
+    // Nothing ever shows up, so it gives up eventually.
+    EXPECT_EQ(0, poller.spin([]() { return 0; }));
+
+    EXPECT_EQ(2, poller.get_stats().spins);
+    EXPECT_EQ(1, poller.get_stats().hits);
+    EXPECT_GT(poller.get_stats().spin_ticks, 0);
+}
+
+}  // namespace unittest
@@ -0,0 +1,79 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "buffer_cache/cache_warmer.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const uint64_t WARM_LIST_TEST_IDENTITY = 1234;
+
+max_block_size_t warm_list_block_size(uint32_t size) {
+    return max_block_size_t::unsafe_make(size);
+}
+
+TEST(CacheWarmer, ListRoundTrip) {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path();
+    std::vector<block_id_t> block_ids;
+    for (block_id_t i = 0; i < 1000; ++i) {
+        block_ids.push_back(i * 7 + 3);
+    }
+    ASSERT_TRUE(cache_warmer_t::write_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096), block_ids));
+    // The temporary file got moved into place.
+    EXPECT_EQ(-1, ::access((path + ".tmp").c_str(), F_OK));
+
+    std::vector<block_id_t> read_back;
+    ASSERT_TRUE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY,
+                                          warm_list_block_size(4096), &read_back));
+    EXPECT_EQ(block_ids, read_back);
+
+    // An empty list is still a valid list.
+    ASSERT_TRUE(cache_warmer_t::write_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096),
+                                           std::vector<block_id_t>()));
+    ASSERT_TRUE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY,
+                                          warm_list_block_size(4096), &read_back));
+    EXPECT_TRUE(read_back.empty());
+
+    cache_warmer_t::remove_file(path);
+    EXPECT_FALSE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096), &read_back));
+}
+
+TEST(CacheWarmer, IgnoresListsOfOtherFiles) {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path();
+    ASSERT_TRUE(cache_warmer_t::write_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096),
+                                           std::vector<block_id_t>(10, 5)));
+
+    std::vector<block_id_t> read_back;
+    EXPECT_FALSE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY + 1,
+                                           warm_list_block_size(4096), &read_back));
+    EXPECT_FALSE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(8192), &read_back));
+}
+
+TEST(CacheWarmer, IgnoresGarbledLists) {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path();
+    ASSERT_TRUE(cache_warmer_t::write_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096),
+                                           std::vector<block_id_t>(10, 5)));
+
+    // Cut off part of the last block id.
+    struct stat st;
+    ASSERT_EQ(0, ::stat(path.c_str(), &st));
+    ASSERT_EQ(0, ::truncate(path.c_str(), st.st_size - 1));
+    std::vector<block_id_t> read_back;
+    EXPECT_FALSE(cache_warmer_t::read_file(path, WARM_LIST_TEST_IDENTITY,
+                                           warm_list_block_size(4096), &read_back));
+}
+
+}  // namespace unittest
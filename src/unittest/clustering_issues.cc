@@ -104,6 +104,7 @@ namespace_id_t add_table(issues_environment_t *env,
         new_table.name.set(name_string_t::guarantee_valid(name.c_str()));
         new_table.database.set(db);
         new_table.primary_key.set("dummy");
+        new_table.block_size.set(0);
         *namespaces_change.get()->namespaces[new_table_id].get_mutable() = new_table;
     }
     view->join(metadata);
@@ -0,0 +1,141 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "serializer/config.hpp"
+#include "serializer/log/compactor.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Gets at the parts of a log serializer that compaction works on.
+class log_serializer_tester_t {
+public:
+    log_serializer_tester_t() {
+        standard_serializer_t::create(&file_opener,
+                                      standard_serializer_t::static_config_t());
+        ser.init(new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
+                                           &file_opener, &stats));
+        account.init(ser->make_io_account(1));
+    }
+
+    int64_t blocks_per_extent() {
+        return ser->static_config.extent_size() / ser->max_block_size().ser_value();
+    }
+
+    // Writes the blocks with ids in [first, first + count), `blocks_per_extent()` of
+    // them at a time, so that each batch fills one extent.
+    void write_blocks(block_id_t first, int64_t count) {
+        for (int64_t done = 0; done < count; done += blocks_per_extent()) {
+            const int64_t batch_size = std::min(blocks_per_extent(), count - done);
+            write_test_blocks(ser.get(), account.get(), first + done, batch_size);
+        }
+    }
+
+    void delete_blocks(block_id_t first, int64_t count) {
+        std::vector<index_write_op_t> write_ops;
+        for (int64_t i = 0; i < count; ++i) {
+            write_ops.push_back(index_write_op_t(first + i,
+                                                 counted_t<standard_block_token_t>()));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser->index_write(&dummy_acq, write_ops);
+    }
+
+    void check_blocks(block_id_t first, int64_t count) {
+        check_test_blocks(ser.get(), account.get(), first, count);
+    }
+
+    // Lets the extents written so far grow old, which they need to be for the
+    // compactor to move them.  Extents only age when the active extent gets retired,
+    // so this writes one more block after waiting.
+    void age_extents(block_id_t spare_block_id) {
+        nap(200);
+        write_blocks(spare_block_id, 1);
+    }
+
+    void compact() {
+        cond_t non_interruptor;
+        ser->compactor->compact(&non_interruptor);
+    }
+
+    size_t num_extents() { return ser->extent_manager->num_extents(); }
+    size_t held_extents() { return ser->extent_manager->held_extents(); }
+    size_t punch_free_extents() { return ser->extent_manager->punch_free_extents(); }
+    int64_t file_size() { return ser->dbfile->get_file_size(); }
+
+    int64_t stat(const char *name) { return get_serializer_stat(&stats, name); }
+
+private:
+    mock_file_opener_t file_opener;
+    perfmon_collection_t stats;
+    scoped_ptr_t<standard_serializer_t> ser;
+    scoped_ptr_t<file_account_t> account;
+};
+
+TPTEST(Compactor, PunchesFreeExtentsOnce) {
+    log_serializer_tester_t tester;
+    const int64_t per_extent = tester.blocks_per_extent();
+    tester.write_blocks(0, 12 * per_extent);
+
+    // The extents at the start of the file are stuck in front of the ones still in
+    // use, so they don't get truncated away.
+    tester.delete_blocks(0, 8 * per_extent);
+    const size_t held = tester.held_extents();
+    ASSERT_GE(held, 6u);
+    const int64_t size_before = tester.file_size();
+    EXPECT_EQ(held, tester.punch_free_extents());
+    EXPECT_EQ(static_cast<int64_t>(held), tester.stat("serializer_punched_extents"));
+    // Punching holes leaves the file size alone.
+    EXPECT_EQ(size_before, tester.file_size());
+
+    // Extents that already are holes don't get punched again...
+    EXPECT_EQ(0u, tester.punch_free_extents());
+
+    // ... but the ones that get freed later do.
+    tester.delete_blocks(8 * per_extent, 2 * per_extent);
+    const size_t newly_held = tester.held_extents() - held;
+    ASSERT_GE(newly_held, 1u);
+    EXPECT_EQ(newly_held, tester.punch_free_extents());
+    EXPECT_EQ(static_cast<int64_t>(held + newly_held),
+              tester.stat("serializer_punched_extents"));
+
+    tester.check_blocks(10 * per_extent, 2 * per_extent);
+}
+
+TPTEST(Compactor, MovesExtentsOffTheEnd) {
+    log_serializer_tester_t tester;
+    const int64_t per_extent = tester.blocks_per_extent();
+    const int64_t num_blocks = 24 * per_extent;
+    tester.write_blocks(0, num_blocks);
+
+    // Free the start of the file, so that the data at its end can move there.
+    const int64_t num_deleted = 20 * per_extent;
+    tester.delete_blocks(0, num_deleted);
+    tester.age_extents(num_blocks);
+
+    const size_t extents_before = tester.num_extents();
+    const int64_t size_before = tester.file_size();
+    tester.compact();
+
+    EXPECT_GT(tester.stat("serializer_data_extents_compacted"), 0);
+    EXPECT_GT(tester.stat("serializer_gc_relocated_block_bytes"), 0);
+    EXPECT_LE(tester.num_extents(), extents_before);
+    EXPECT_LE(tester.file_size(), size_before);
+    // The relocated blocks took up free extents further up front, and the extents
+    // they came from were freed.  Any of those that couldn't be truncated away got
+    // punched out of the file, so every free extent left is a hole.
+    EXPECT_EQ(static_cast<int64_t>(tester.held_extents()),
+              tester.stat("serializer_punched_extents"));
+    EXPECT_EQ(0u, tester.punch_free_extents());
+
+    tester.check_blocks(num_deleted, num_blocks - num_deleted + 1);
+}
+
+}  // namespace unittest
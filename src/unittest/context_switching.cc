@@ -1,7 +1,11 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "arch/runtime/context_switching.hpp"
 
+#include <unistd.h>
+
+#include <set>
 #include <stdexcept>
+#include <vector>
 
 #include "containers/scoped.hpp"
 #include "unittest/gtest.hpp"
@@ -104,4 +108,30 @@ TEST(ContextSwitchingTest, UncaughtException) {
     EXPECT_DEATH(throw_exception_from_coroutine(), "This is a test exception");
 }
 
+#ifndef THREADED_COROUTINES
+TEST(ContextSwitchingTest, StackPoolReusesStacks) {
+    coro_stack_pool_t pool;
+    const size_t stack_size = 16 * getpagesize();
+    const int num_stacks = 100;
+
+    std::set<void *> bounds;
+    {
+        std::vector<scoped_ptr_t<artificial_stack_t> > stacks;
+        for (int i = 0; i < num_stacks; ++i) {
+            stacks.push_back(make_scoped<artificial_stack_t>(&noop, stack_size));
+            bounds.insert(stacks.back()->get_stack_bound());
+            EXPECT_FALSE(stacks.back()->context.is_nil());
+        }
+    }
+    ASSERT_EQ(static_cast<size_t>(num_stacks), bounds.size());
+
+    // All of them were in use recently, so the pool hands the same ones out again.
+    std::vector<scoped_ptr_t<artificial_stack_t> > stacks;
+    for (int i = 0; i < num_stacks; ++i) {
+        stacks.push_back(make_scoped<artificial_stack_t>(&noop, stack_size));
+        EXPECT_EQ(1u, bounds.count(stacks.back()->get_stack_bound()));
+    }
+}
+#endif
+
 }   /* namespace unittest */
@@ -0,0 +1,151 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/io/disk/accounting.hpp"
+#include "perfmon/perfmon.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static const int IRRELEVANT_DEFAULT_FD = 0;
+
+// Runs the accounting on a fake clock, which only moves when `advance()` says so.
+struct accounting_test_t {
+    accounting_test_t()
+        : now(secs_to_ticks(1)),
+          accounter(1, &stats),
+          background(&accounter, 100, UNLIMITED_OUTSTANDING_REQUESTS,
+                     NO_IO_LATENCY_TARGET) {
+        accounter.done_fun = [](accounting_diskmgr_action_t *) { };
+        accounter.now_fun = [this]() { return now; };
+    }
+
+    void advance(int64_t microseconds) {
+        now += microseconds * THOUSAND;
+    }
+
+    void submit(accounting_diskmgr_action_t *action,
+                accounting_diskmgr_account_t *account) {
+        action->make_read(IRRELEVANT_DEFAULT_FD, NULL, 0, 0);
+        action->account = account;
+        accounter.submit(action);
+    }
+
+    // Hands the next action to the "disk" and completes it right away.
+    accounting_payload_t *dispatch() {
+        EXPECT_TRUE(accounter.producer->available->get());
+        accounting_payload_t *payload = accounter.producer->pop();
+        accounter.done(payload);
+        return payload;
+    }
+
+    ticks_t now;
+    perfmon_collection_t stats;
+    accounting_diskmgr_t accounter;
+    accounting_diskmgr_account_t background;
+};
+
+TPTEST(DiskAccounting, SharesWithinLatencyTarget) {
+    accounting_test_t test;
+    accounting_diskmgr_account_t foreground(&test.accounter, 1,
+                                            UNLIMITED_OUTSTANDING_REQUESTS,
+                                            10 * MILLION);
+
+    accounting_diskmgr_action_t background_actions[3];
+    for (size_t i = 0; i < 3; ++i) {
+        test.submit(&background_actions[i], &test.background);
+    }
+    accounting_diskmgr_action_t foreground_action;
+    test.submit(&foreground_action, &foreground);
+
+    // The foreground read is within its latency target, so the background
+    // account's much larger share wins.
+    test.advance(MILLION);
+    EXPECT_EQ(&background_actions[0], test.dispatch());
+    for (size_t i = 0; i < 3; ++i) {
+        test.dispatch();
+    }
+    EXPECT_FALSE(test.accounter.producer->available->get());
+}
+
+TPTEST(DiskAccounting, OverdueRequestsGoFirst) {
+    accounting_test_t test;
+    accounting_diskmgr_account_t foreground(&test.accounter, 1,
+                                            UNLIMITED_OUTSTANDING_REQUESTS,
+                                            THOUSAND);
+
+    accounting_diskmgr_action_t background_actions[3];
+    for (size_t i = 0; i < 3; ++i) {
+        test.submit(&background_actions[i], &test.background);
+    }
+    accounting_diskmgr_action_t foreground_action;
+    test.submit(&foreground_action, &foreground);
+
+    // Let the foreground read miss its latency target of one millisecond.
+    test.advance(THOUSAND + 1);
+
+    EXPECT_EQ(&foreground_action, test.dispatch());
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(&background_actions[i], test.dispatch());
+    }
+    EXPECT_FALSE(test.accounter.producer->available->get());
+}
+
+TPTEST(DiskAccounting, RequestAtTheLatencyTargetWaits) {
+    accounting_test_t test;
+    accounting_diskmgr_account_t foreground(&test.accounter, 1,
+                                            UNLIMITED_OUTSTANDING_REQUESTS,
+                                            THOUSAND);
+
+    accounting_diskmgr_action_t background_action;
+    test.submit(&background_action, &test.background);
+    accounting_diskmgr_action_t foreground_action;
+    test.submit(&foreground_action, &foreground);
+
+    // Exactly at its deadline, the foreground read hasn't missed it yet.
+    test.advance(THOUSAND);
+    EXPECT_EQ(&background_action, test.dispatch());
+    EXPECT_EQ(&foreground_action, test.dispatch());
+}
+
+TPTEST(DiskAccounting, EarliestDeadlineGoesFirst) {
+    accounting_test_t test;
+    accounting_diskmgr_account_t slow(&test.accounter, 1,
+                                      UNLIMITED_OUTSTANDING_REQUESTS,
+                                      10 * THOUSAND);
+    accounting_diskmgr_account_t fast(&test.accounter, 1,
+                                      UNLIMITED_OUTSTANDING_REQUESTS,
+                                      THOUSAND);
+
+    accounting_diskmgr_action_t background_actions[2];
+    for (size_t i = 0; i < 2; ++i) {
+        test.submit(&background_actions[i], &test.background);
+    }
+    // The slow account's requests come in first, but its deadlines are later.
+    accounting_diskmgr_action_t slow_actions[2];
+    for (size_t i = 0; i < 2; ++i) {
+        test.submit(&slow_actions[i], &slow);
+        test.advance(100);
+    }
+    accounting_diskmgr_action_t fast_actions[2];
+    for (size_t i = 0; i < 2; ++i) {
+        test.submit(&fast_actions[i], &fast);
+        test.advance(100);
+    }
+
+    // Only the fast account's requests are overdue, oldest first.
+    test.advance(5 * THOUSAND);
+    EXPECT_EQ(&fast_actions[0], test.dispatch());
+    EXPECT_EQ(&fast_actions[1], test.dispatch());
+
+    // Now the slow account's ones are overdue too, and nothing else is.
+    test.advance(10 * THOUSAND);
+    EXPECT_EQ(&slow_actions[0], test.dispatch());
+    EXPECT_EQ(&slow_actions[1], test.dispatch());
+
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(&background_actions[i], test.dispatch());
+    }
+    EXPECT_FALSE(test.accounter.producer->available->get());
+}
+
+}  // namespace unittest
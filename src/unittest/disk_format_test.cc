@@ -1,4 +1,6 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string.h>
+
 #include "math.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "serializer/log/log_serializer.hpp"
@@ -55,8 +57,9 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 }
 
 TEST(DiskFormatTest, LbaEntryT) {
-    EXPECT_EQ(0u, offsetof(lba_entry_t, zero_reserved));
-    EXPECT_EQ(4u, offsetof(lba_entry_t, ser_block_size));
+    EXPECT_EQ(0u, offsetof(lba_entry_t, checksum));
+    // (The block size and compressed size share the uint32_t at offset 4, see
+    // LbaEntryFromOlderFiles.)
     EXPECT_EQ(8u, offsetof(lba_entry_t, block_id));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
     EXPECT_EQ(24u, offsetof(lba_entry_t, offset));
@@ -68,14 +71,40 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 0, 0x1234abcd);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 0, NO_BLOCK_CHECKSUM);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
+TEST(DiskFormatTest, LbaEntryFromOlderFiles) {
+    // Entries from before checksums and compression had zero padding in place of the
+    // checksum, followed by the block size as a whole uint32_t.
+    char raw[sizeof(lba_entry_t)] = { 0 };
+    const uint32_t old_ser_block_size = 4096;
+    memcpy(raw + 4, &old_ser_block_size, sizeof(old_ser_block_size));
+    lba_entry_t ent;
+    memcpy(&ent, raw, sizeof(ent));
+    EXPECT_EQ(NO_BLOCK_CHECKSUM, ent.checksum);
+    EXPECT_EQ(4096u, ent.ser_block_size);
+    EXPECT_EQ(0u, ent.compressed_block_size());
+
+    // And new entries for uncompressed blocks still look like that.
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, flagged_off64_t::make(0),
+                            4096, 0, 77);
+    uint32_t size_word;
+    memcpy(&size_word, reinterpret_cast<const char *>(&ent) + 4, sizeof(size_word));
+    EXPECT_EQ(4096u, size_word);
+
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, flagged_off64_t::make(0),
+                            4096, 3 * DEVICE_BLOCK_SIZE, 77);
+    EXPECT_EQ(4096u, ent.ser_block_size);
+    EXPECT_EQ(3u * DEVICE_BLOCK_SIZE, ent.compressed_block_size());
+    EXPECT_EQ(77u, ent.checksum);
+}
+
 TEST(DiskFormatTest, LbaExtentT) {
     EXPECT_EQ(32u, sizeof(lba_extent_t::header_t));
 
@@ -0,0 +1,45 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "buffer_cache/eviction_bag.hpp"
+
+namespace unittest {
+
+TEST(GhostListTest, RemembersRecentIds) {
+    alt::ghost_list_t ghosts;
+    for (block_id_t i = 0; i < 10; ++i) {
+        ghosts.add(i, 4);
+    }
+    EXPECT_EQ(4u, ghosts.size());
+    for (block_id_t i = 0; i < 6; ++i) {
+        EXPECT_FALSE(ghosts.remove(i));
+    }
+    EXPECT_TRUE(ghosts.remove(7));
+    EXPECT_FALSE(ghosts.remove(7));
+    EXPECT_EQ(3u, ghosts.size());
+}
+
+TEST(GhostListTest, ReAddingRefreshesPosition) {
+    alt::ghost_list_t ghosts;
+    ghosts.add(1, 3);
+    ghosts.add(2, 3);
+    ghosts.add(3, 3);
+    // 1 is now the newest entry, so adding 4 and 5 pushes out 2 and 3 instead.
+    ghosts.add(1, 3);
+    ghosts.add(4, 3);
+    ghosts.add(5, 3);
+    EXPECT_TRUE(ghosts.remove(1));
+    EXPECT_FALSE(ghosts.remove(2));
+    EXPECT_FALSE(ghosts.remove(3));
+    EXPECT_TRUE(ghosts.remove(4));
+    EXPECT_TRUE(ghosts.remove(5));
+}
+
+TEST(GhostListTest, ZeroCapacity) {
+    alt::ghost_list_t ghosts;
+    ghosts.add(1, 0);
+    EXPECT_EQ(0u, ghosts.size());
+    EXPECT_FALSE(ghosts.remove(1));
+}
+
+}  // namespace unittest
@@ -6,6 +6,8 @@
 
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
+#include "containers/scoped.hpp"
+#include "utils.hpp"
 
 namespace unittest {
 
@@ -61,6 +63,35 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+TEST(InternalNodeTest, OffsetIndexWithSharedPrefix) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> node(block_size.value());
+    internal_node::init(block_size, node.get());
+
+    std::vector<store_key_t> keys;
+    for (int i = 0; i < 30; ++i) {
+        keys.push_back(store_key_t(strprintf("5f1a0c3e-2b4d-4e6f-8a9b-%012d", i * 2)));
+        ASSERT_TRUE(internal_node::insert(node.get(), keys.back().btree_key(), i, i + 1));
+    }
+    verify(block_size, node.get());
+
+    std::vector<store_key_t> probes = keys;
+    for (int i = 0; i < 30; ++i) {
+        probes.push_back(store_key_t(strprintf("5f1a0c3e-2b4d-4e6f-8a9b-%012d", i * 2 + 1)));
+    }
+    probes.push_back(store_key_t(""));
+    probes.push_back(store_key_t("5f1a0c3e"));
+    probes.push_back(store_key_t("5f1a0c3e-2b4d-4e6f-8a9b-"));
+    probes.push_back(store_key_t("0"));
+    probes.push_back(store_key_t("6"));
+
+    for (auto probe = probes.begin(); probe != probes.end(); ++probe) {
+        // The index of the first key that is not less than the probe.
+        int expected = std::lower_bound(keys.begin(), keys.end(), *probe) - keys.begin();
+        EXPECT_EQ(expected, internal_node::get_offset_index(node.get(), probe->btree_key()));
+    }
+}
+
 
 }  // namespace unittest
 
@@ -216,6 +216,15 @@ public:
         return leaf::is_full(&sizer_, node(), key.btree_key(), value_buf.data());
     }
 
+    bool Lookup(const store_key_t& key, std::string *value_out) {
+        short_value_buffer_t value_buf("");
+        if (!leaf::lookup(&sizer_, node(), key.btree_key(), value_buf.data())) {
+            return false;
+        }
+        *value_out = value_buf.as_str();
+        return true;
+    }
+
     bool ShouldHave(const store_key_t& key) {
         return kv_.end() != kv_.find(key);
     }
@@ -618,4 +627,31 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+TEST(LeafNodeTest, SharedPrefixLookups) {
+    // Keys that look like UUIDs and share most of their prefix, as primary keys in
+    // the same leaf tend to.
+    LeafNodeTracker node;
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(node.Insert(store_key_t(strprintf("5f1a0c3e-2b4d-4e6f-8a9b-%012d", i * 2)),
+                                strprintf("%d", i)));
+    }
+
+    std::string value;
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(node.Lookup(store_key_t(strprintf("5f1a0c3e-2b4d-4e6f-8a9b-%012d", i * 2)),
+                                &value));
+        EXPECT_EQ(strprintf("%d", i), value);
+        EXPECT_FALSE(node.Lookup(
+            store_key_t(strprintf("5f1a0c3e-2b4d-4e6f-8a9b-%012d", i * 2 + 1)), &value));
+    }
+
+    // Keys that are a prefix of the node's keys, or diverge from them early or late.
+    EXPECT_FALSE(node.Lookup(store_key_t("5f1a0c3e-2b4d"), &value));
+    EXPECT_FALSE(node.Lookup(store_key_t(""), &value));
+    EXPECT_FALSE(node.Lookup(store_key_t("5f1a0c3e-2b4d-4e6f-8a9b-"), &value));
+    EXPECT_FALSE(node.Lookup(store_key_t("5f1a0c3e-2b4d-4e6f-8a9b-000000000000-"), &value));
+    EXPECT_FALSE(node.Lookup(store_key_t("0"), &value));
+    EXPECT_FALSE(node.Lookup(store_key_t("6"), &value));
+}
+
 }  // namespace unittest
@@ -0,0 +1,141 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "concurrency/pmap.hpp"
+#include "serializer/config.hpp"
+#include "serializer/merger.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// A merger serializer on top of a log serializer in a mock file, with its own stats.
+class merger_test_t {
+public:
+    explicit merger_test_t(int64_t group_commit_window_ms,
+                           int max_active_block_writes
+                               = MERGER_SERIALIZER_MAX_ACTIVE_BLOCK_WRITES) {
+        standard_serializer_t::create(&file_opener,
+                                      standard_serializer_t::static_config_t());
+        scoped_ptr_t<serializer_t> inner(
+            new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
+                                      &file_opener, &stats));
+        merger.init(new merger_serializer_t(std::move(inner),
+                                            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                            max_active_block_writes,
+                                            group_commit_window_ms, &stats));
+        account.init(merger->make_io_account(1));
+    }
+
+    // Writes a block with the given id, and then points the index at it.
+    void write_block(block_id_t block_id) {
+        write_test_blocks(merger.get(), account.get(), block_id, 1);
+    }
+
+    // Writes `count` blocks from as many coroutines at once.
+    void write_blocks_concurrently(int64_t first, int64_t count) {
+        pmap(count, [&](int64_t i) { write_block(first + i); });
+    }
+
+    int64_t stat(const char *name) {
+        return get_int_stat(&stats, name);
+    }
+
+    int64_t serializer_stat(const char *name) {
+        return get_serializer_stat(&stats, name);
+    }
+
+    int64_t num_commits() {
+        return stat("group_commit_batches_1") + stat("group_commit_batches_2_3")
+            + stat("group_commit_batches_4_7") + stat("group_commit_batches_8_15")
+            + stat("group_commit_batches_16_plus");
+    }
+
+    void check_blocks(int64_t count) {
+        check_test_blocks(merger.get(), account.get(), 0, count);
+    }
+
+    mock_file_opener_t file_opener;
+    perfmon_collection_t stats;
+    scoped_ptr_t<merger_serializer_t> merger;
+    scoped_ptr_t<file_account_t> account;
+};
+
+TPTEST(MergerSerializer, SequentialWritesCommitAlone) {
+    merger_test_t test(MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS);
+    const int64_t num_blocks = 20;
+    for (int64_t i = 0; i < num_blocks; ++i) {
+        test.write_block(i);
+    }
+    // Nothing ran concurrently, so there was nothing to wait for either.
+    EXPECT_EQ(num_blocks, test.stat("group_commit_batches_1"));
+    EXPECT_EQ(num_blocks, test.num_commits());
+    test.check_blocks(num_blocks);
+}
+
+TPTEST(MergerSerializer, ConcurrentWritesShareCommits) {
+    merger_test_t test(MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS);
+    const int64_t round_size = 16;
+    test.write_blocks_concurrently(0, round_size);
+    const int64_t first_round_commits = test.num_commits();
+    // The first index write gets a commit to itself, but the others pile up behind
+    // it and get merged.
+    EXPECT_LT(first_round_commits, round_size);
+    EXPECT_LT(test.stat("group_commit_batches_1"), round_size);
+
+    // The last commit merged several index writes, so the next one waits for about
+    // as many of them to come in.  If it didn't stop waiting once they are in, the
+    // round would take the whole (one second) window.
+    const ticks_t start = get_ticks();
+    test.write_blocks_concurrently(round_size, round_size);
+    EXPECT_LT(get_ticks() - start,
+              static_cast<ticks_t>(MERGER_SERIALIZER_MAX_GROUP_COMMIT_WINDOW_MS) * MILLION);
+    EXPECT_LT(test.num_commits() - first_round_commits, round_size);
+    test.check_blocks(2 * round_size);
+}
+
+TPTEST(MergerSerializer, NoWindowStillMerges) {
+    merger_test_t test(0);
+    const int64_t round_size = 16;
+    test.write_blocks_concurrently(0, round_size);
+    // Index writes that queue up behind an active commit get merged regardless.
+    EXPECT_LT(test.num_commits(), round_size);
+    test.check_blocks(round_size);
+}
+
+TPTEST(MergerSerializer, LoneBlockWritesGoStraightThrough) {
+    merger_test_t test(0, 1);
+    const int64_t num_blocks = 20;
+    for (int64_t i = 0; i < num_blocks; ++i) {
+        test.write_block(i);
+    }
+    EXPECT_EQ(num_blocks, test.stat("block_write_batches"));
+    test.check_blocks(num_blocks);
+}
+
+TPTEST(MergerSerializer, ConcurrentBlockWritesShareBatches) {
+    merger_test_t test(0, 1);
+    const int64_t num_blocks = 16;
+    test.write_blocks_concurrently(0, num_blocks);
+    // The first block write goes straight through, and all the others pile up
+    // behind it and get written as a single batch.
+    EXPECT_EQ(2, test.stat("block_write_batches"));
+    EXPECT_EQ(num_blocks, test.serializer_stat("serializer_block_writes"));
+    test.check_blocks(num_blocks);
+}
+
+TPTEST(MergerSerializer, FullBlockWriteBatchesGoOutEarly) {
+    merger_test_t test(0, 1);
+    const int64_t blocks_per_batch = MERGER_SERIALIZER_BLOCK_WRITE_BATCH_SIZE
+        / test.merger->max_block_size().ser_value();
+    const int64_t num_blocks = 2 * blocks_per_batch + 1;
+    test.write_blocks_concurrently(0, num_blocks);
+    // The first block write goes straight through.  The others come in while it is
+    // being written, but they don't wait for it once they fill a batch.
+    EXPECT_EQ(3, test.stat("block_write_batches"));
+    test.check_blocks(num_blocks);
+}
+
+}  // namespace unittest
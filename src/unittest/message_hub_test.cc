@@ -0,0 +1,117 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const int MESSAGES_PER_THREAD = 10000;
+
+// Receives the messages on thread zero, and checks that the ordered ones from each
+// thread arrive in the order they were sent in.
+class message_receiver_t {
+public:
+    explicit message_receiver_t(int num_messages)
+        : next_ordered(get_num_threads(), 0), remaining(num_messages) { }
+
+    void receive(int source, bool ordered, int seq) {
+        ASSERT_EQ(0, get_thread_id().threadnum);
+        if (ordered) {
+            EXPECT_EQ(next_ordered[source], seq);
+            next_ordered[source] = seq + 1;
+        }
+        if (--remaining == 0) {
+            done.pulse();
+        }
+    }
+
+    std::vector<int> next_ordered;
+    int remaining;
+    cond_t done;
+};
+
+class test_message_t : public thread_message_t {
+public:
+    test_message_t(message_receiver_t *_receiver, int _source, bool _ordered, int _seq)
+        : thread_message_t(_ordered
+                           ? MESSAGE_SCHEDULER_DEFAULT_PRIORITY
+                           : MESSAGE_SCHEDULER_MIN_PRIORITY
+                             + _seq % (MESSAGE_SCHEDULER_MAX_PRIORITY
+                                       - MESSAGE_SCHEDULER_MIN_PRIORITY + 1)),
+          receiver(_receiver), source(_source), ordered(_ordered), seq(_seq) { }
+
+    void on_thread_switch() {
+        receiver->receive(source, ordered, seq);
+    }
+
+    message_receiver_t *receiver;
+    int source;
+    bool ordered;
+    int seq;
+};
+
+void send_messages(message_receiver_t *receiver,
+                   std::vector<scoped_ptr_t<test_message_t> > *messages,
+                   int source) {
+    if (source == 0) {
+        return;
+    }
+    on_thread_t thread_switcher((threadnum_t(source)));
+    linux_message_hub_t *hub = &linux_thread_pool_t::get_thread()->message_hub;
+    for (int i = 0; i < MESSAGES_PER_THREAD; ++i) {
+        // Half of them are ordered, and the others have all kinds of priorities.
+        const bool ordered = i % 2 == 0;
+        messages[source][i].init(new test_message_t(receiver, source, ordered, i / 2));
+        if (ordered) {
+            hub->store_message_ordered(threadnum_t(0), messages[source][i].get());
+        } else {
+            hub->store_message_sometime(threadnum_t(0), messages[source][i].get());
+        }
+        // Let the hub push some of them before we're done.
+        if (i % 1000 == 0) {
+            coro_t::yield();
+        }
+    }
+}
+
+TPTEST(MessageHub, DeliversFromAllThreads, 8) {
+    const int num_threads = get_num_threads();
+    message_receiver_t receiver((num_threads - 1) * MESSAGES_PER_THREAD);
+    std::vector<std::vector<scoped_ptr_t<test_message_t> > > messages(num_threads);
+    for (auto &thread_messages : messages) {
+        thread_messages.resize(MESSAGES_PER_THREAD);
+    }
+
+    pmap(num_threads, [&](int source) {
+        send_messages(&receiver, messages.data(), source);
+    });
+    receiver.done.wait();
+    EXPECT_EQ(0, receiver.remaining);
+}
+
+TPTEST(MessageHub, IdleThreadsHaveNoBacklog, 4) {
+    // Keep the other threads busy for a while...
+    pmap(get_num_threads(), [](int i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        for (int j = 0; j < 1000; ++j) {
+            coro_t::yield();
+        }
+    });
+
+    // ... and once they are done, they don't look busy anymore.
+    for (int i = 1; i < get_num_threads(); ++i) {
+        for (int j = 0; j < 100 && get_thread_backlog(threadnum_t(i)) != 0; ++j) {
+            nap(10);
+        }
+        EXPECT_EQ(0u, get_thread_backlog(threadnum_t(i)));
+    }
+}
+
+}  // namespace unittest
@@ -30,6 +30,13 @@ void mock_file_t::set_file_size_at_least(int64_t size) {
     }
 }
 
+void mock_file_t::punch_hole(int64_t offset, int64_t length) {
+    guarantee(mode_ & mode_write);
+    guarantee(0 <= offset && 0 <= length
+              && static_cast<uint64_t>(offset + length) <= data_->size());
+    memset(data_->data() + offset, 0, length);
+}
+
 void mock_file_t::read_async(int64_t offset, size_t length, void *buf,
                              UNUSED file_account_t *account, linux_iocallback_t *cb) {
     guarantee(mode_ & mode_read);
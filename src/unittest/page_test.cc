@@ -1,4 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
 #include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
 #include "buffer_cache/page_cache.hpp"
@@ -52,8 +55,9 @@ class test_cache_t : public page_cache_t {
 public:
     test_cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler)
-        : page_cache_t(serializer, balancer, throttler),
+                 alt_txn_throttler_t *throttler,
+                 alt::eviction_policy_t policy = alt::eviction_policy_t::sampled_2q)
+        : page_cache_t(serializer, balancer, throttler, policy),
           throttler_(throttler) { }
 
     void flush(scoped_ptr_t<test_txn_t> txn) {
@@ -315,6 +319,71 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
+// Creates `count` blocks, each holding a string made from its block id.
+std::vector<block_id_t> create_scan_test_blocks(test_cache_t *cache, size_t count) {
+    std::vector<block_id_t> block_ids;
+    auto txn = make_scoped<test_txn_t>(cache);
+    for (size_t i = 0; i < count; ++i) {
+        current_test_acq_t acq(txn.get(), alt_create_t::create);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), cache);
+        const std::string value = strprintf("block %" PRIu64, acq.block_id());
+        memcpy(page_acq.get_buf_write(), value.c_str(), value.size() + 1);
+        block_ids.push_back(acq.block_id());
+    }
+    cache->flush(std::move(txn));
+    return block_ids;
+}
+
+void read_scan_test_blocks(test_cache_t *cache, const std::vector<block_id_t> &ids) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    for (block_id_t block_id : ids) {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), cache);
+        EXPECT_EQ(strprintf("block %" PRIu64, block_id),
+                  std::string(static_cast<const char *>(page_acq.get_buf_read())));
+    }
+    cache->flush(std::move(txn));
+}
+
+// Reads a small hot set a few times, then scans through many more blocks once, and
+// returns how many times the hot set missed the cache when we read it again.
+uint64_t hot_set_misses_after_scan(alt::eviction_policy_t policy,
+                                   uint64_t *protected_hits_out) {
+    mock_ser_t mock;
+    // The cache has room for 32 blocks, the hot set takes up 8 of them.
+    dummy_cache_balancer_t balancer(32 * 4096);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get(), policy);
+    const std::vector<block_id_t> hot = create_scan_test_blocks(&page_cache, 8);
+    const std::vector<block_id_t> cold = create_scan_test_blocks(&page_cache, 400);
+
+    for (int i = 0; i < 3; ++i) {
+        read_scan_test_blocks(&page_cache, hot);
+    }
+    read_scan_test_blocks(&page_cache, cold);
+
+    const uint64_t misses = page_cache.evicter().miss_count();
+    const uint64_t protected_hits = page_cache.evicter().protected_hits();
+    read_scan_test_blocks(&page_cache, hot);
+    *protected_hits_out = page_cache.evicter().protected_hits() - protected_hits;
+    return page_cache.evicter().miss_count() - misses;
+}
+
+TPTEST(PageTest, ScanDoesNotEvictHotPages, 4) {
+    uint64_t protected_hits;
+    EXPECT_EQ(0u, hot_set_misses_after_scan(alt::eviction_policy_t::sampled_2q,
+                                            &protected_hits));
+    EXPECT_EQ(8u, protected_hits);
+
+    // Plain LRU throws (nearly) the whole hot set out for the scan.  This is how
+    // we know that the scan above was big enough to matter.
+    EXPECT_GT(hot_set_misses_after_scan(alt::eviction_policy_t::sampled_lru,
+                                        &protected_hits),
+              0u);
+    EXPECT_EQ(0u, protected_hits);
+}
+
 class bigger_test_t {
 public:
     explicit bigger_test_t(uint64_t _memory_limit)
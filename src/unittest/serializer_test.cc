@@ -4,6 +4,7 @@
 #include "concurrency/new_mutex.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/config.hpp"
+#include "serializer/log/data_block_manager.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +91,229 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+TPTEST(SerializerTest, CompressedBlocksReadBack, 4) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.block_codec = block_codec_t::zlib_fast;
+    standard_serializer_t ser(dynamic_config,
+                              &file_opener,
+                              &get_global_perfmon_collection());
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    const block_id_t num_blocks = 100;
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+        // Every other block is easily compressible.
+        char *data = reinterpret_cast<char *>(buf.cache_data());
+        for (uint32_t j = 0; j < buf.block_size().value(); ++j) {
+            data[j] = i % 2 == 0 ? static_cast<char>(i) : static_cast<char>(i * j + j / 3);
+        }
+        infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), i));
+        bufs.push_back(std::move(buf));
+    }
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser.block_writes(infos, account.get(), &cb);
+    cb.wait();
+
+    {
+        std::vector<index_write_op_t> write_ops;
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            write_ops.push_back(index_write_op_t(i, tokens[i],
+                                                 repli_timestamp_t::distant_past));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, write_ops);
+    }
+    tokens.clear();
+
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        counted_t<standard_block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(bufs[i].block_size(), token->block_size());
+        buf_ptr_t read = ser.block_read(token, account.get());
+        ASSERT_EQ(bufs[i].block_size(), read.block_size());
+        EXPECT_EQ(0, memcmp(bufs[i].ser_buffer(), read.ser_buffer(),
+                            read.block_size().ser_value()));
+    }
+}
+
+TPTEST(SerializerTest, LargeBlockSize, 4) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::static_config_t static_config;
+    static_config.block_size_ = MAX_BTREE_BLOCK_SIZE;
+    standard_serializer_t::create(&file_opener, static_config);
+    standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                              &file_opener,
+                              &get_global_perfmon_collection());
+    ASSERT_EQ(static_cast<uint32_t>(MAX_BTREE_BLOCK_SIZE), ser.max_block_size().ser_value());
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    char *data = reinterpret_cast<char *>(buf.cache_data());
+    for (uint32_t i = 0; i < buf.block_size().value(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), 0));
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser.block_writes(infos, account.get(), &cb);
+    cb.wait();
+
+    buf_ptr_t read = ser.block_read(tokens[0], account.get());
+    ASSERT_EQ(buf.block_size(), read.block_size());
+    EXPECT_EQ(0, memcmp(buf.cache_data(), read.cache_data(), buf.block_size().value()));
+}
+
+// Reads blocks of varying stored sizes, spread over several extents, with a single
+// block_reads() call.  The serializer reads runs of nearby blocks with one read each,
+// which has to hand back the same blocks as reading them one at a time.
+TPTEST(SerializerTest, BlockReadsMatchBlockRead, 4) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.block_codec = block_codec_t::zlib_fast;
+    standard_serializer_t ser(dynamic_config,
+                              &file_opener,
+                              &get_global_perfmon_collection());
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    const block_id_t num_blocks = 1500;
+    const block_id_t blocks_per_write = 100;
+    std::vector<counted_t<standard_block_token_t> > tokens;
+    for (block_id_t first = 0; first < num_blocks; first += blocks_per_write) {
+        std::vector<buf_ptr_t> bufs;
+        std::vector<buf_write_info_t> infos;
+        for (block_id_t i = first; i < first + blocks_per_write; ++i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+            // Every third block compresses, so the blocks don't all take up the
+            // same space on disk.
+            char *data = reinterpret_cast<char *>(buf.cache_data());
+            for (uint32_t j = 0; j < buf.block_size().value(); ++j) {
+                data[j] = i % 3 == 0
+                    ? static_cast<char>(i)
+                    : static_cast<char>(i * j + j / 3);
+            }
+            infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), i));
+            bufs.push_back(std::move(buf));
+        }
+
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<standard_block_token_t> > written
+            = ser.block_writes(infos, account.get(), &cb);
+        cb.wait();
+        tokens.insert(tokens.end(), written.begin(), written.end());
+    }
+
+    // Leave out some blocks, so that some runs have gaps in them, and ask for the
+    // rest in reverse, with one of them twice.
+    std::vector<counted_t<standard_block_token_t> > wanted;
+    for (block_id_t i = num_blocks; i-- > 0;) {
+        if (i % 7 != 0) {
+            wanted.push_back(tokens[i]);
+        }
+    }
+    wanted.push_back(tokens[num_blocks / 2]);
+
+    std::vector<buf_ptr_t> reads = ser.block_reads(wanted, account.get());
+    ASSERT_EQ(wanted.size(), reads.size());
+    for (size_t i = 0; i < wanted.size(); ++i) {
+        buf_ptr_t expected = ser.block_read(wanted[i], account.get());
+        ASSERT_EQ(expected.block_size(), reads[i].block_size());
+        EXPECT_EQ(0, memcmp(expected.ser_buffer(), reads[i].ser_buffer(),
+                            expected.block_size().ser_value()));
+    }
+}
+
+// Writes enough blocks to spill the inline LBA entries into every LBA shard, then
+// checks that a freshly started serializer sees all of them.
+TPTEST(SerializerTest, ReopenReadsAllShards, 4) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+
+    const block_id_t num_blocks = 1000;
+    {
+        standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                                  &file_opener,
+                                  &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+            *reinterpret_cast<block_id_t *>(buf.cache_data()) = i;
+            std::vector<buf_write_info_t> infos;
+            infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), i));
+
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<standard_block_token_t> > tokens
+                = ser.block_writes(infos, account.get(), &cb);
+            cb.wait();
+
+            std::vector<index_write_op_t> write_ops;
+            write_ops.push_back(index_write_op_t(i, tokens[0],
+                                                 repli_timestamp_t::distant_past));
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, write_ops);
+        }
+    }
+
+    standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                              &file_opener,
+                              &get_global_perfmon_collection());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    ASSERT_EQ(num_blocks, ser.max_block_id());
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        counted_t<standard_block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        buf_ptr_t read = ser.block_read(token, account.get());
+        EXPECT_EQ(i, *reinterpret_cast<const block_id_t *>(read.cache_data()));
+    }
+}
+
+// The GC would rather collect an extent whose data hasn't changed in a long time,
+// even if it has less garbage than one that's still getting written to.
+TEST(SerializerTest, GcPrefersColdExtents) {
+    const uint32_t extent_size = DEFAULT_EXTENT_SIZE;
+    const microtime_t second = 1000000;
+    // 60% garbage, last written an hour ago.
+    const double cold = gc_cost_benefit(extent_size / 10 * 6, extent_size,
+                                        3600 * second);
+    // 95% garbage, last written two seconds ago.
+    const double young = gc_cost_benefit(extent_size / 20 * 19, extent_size,
+                                         2 * second);
+    EXPECT_GT(cold, young);
+
+    // Between extents of the same age, the one with more garbage goes first.
+    EXPECT_GT(gc_cost_benefit(extent_size / 2, extent_size, 2 * second),
+              gc_cost_benefit(extent_size / 4, extent_size, 2 * second));
+
+    // There's nothing to gain from collecting an extent without garbage.
+    EXPECT_EQ(0, gc_cost_benefit(0, extent_size, 3600 * second));
+}
 
 }  // namespace unittest
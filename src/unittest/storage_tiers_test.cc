@@ -0,0 +1,257 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clustering/administration/issues/local_issue_aggregator.hpp"
+#include "clustering/administration/main/command_line.hpp"
+#include "clustering/administration/main/file_based_svs_by_namespace.hpp"
+#include "clustering/administration/main/storage_tiers.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+storage_tiers_t parse_tier_options(const std::vector<std::string> &args) {
+    std::vector<options::option_t> options;
+    get_storage_tier_options(&options);
+    std::vector<const char *> argv;
+    for (const std::string &arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    const std::map<std::string, options::values_t> opts
+        = options::merge(options::parse_command_line(argv.size(), argv.data(), options),
+                         options::default_values_map(options));
+    return parse_storage_tier_options(opts);
+}
+
+void write_test_file(const std::string &path, const std::string &contents) {
+    FILE *file = fopen(path.c_str(), "w");
+    ASSERT_TRUE(file != NULL);
+    ASSERT_EQ(contents.size(), fwrite(contents.data(), 1, contents.size(), file));
+    ASSERT_EQ(0, fclose(file));
+}
+
+bool test_file_exists(const std::string &path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+// Big enough that copying it takes a few chunks.
+std::string make_test_file_contents() {
+    std::string contents;
+    for (size_t i = 0; contents.size() < 3 * MEGABYTE + 12345; ++i) {
+        contents += strprintf("%zu,", i);
+    }
+    return contents;
+}
+
+TEST(StorageTiers, ParsesOptions) {
+    temp_directory_t data_directory, fast, slow;
+    const namespace_id_t assigned_table = generate_uuid();
+    storage_tiers_t tiers = parse_tier_options(
+        { "--storage-tier", "fast=" + fast.path().path(),
+          "--storage-tier", "slow=" + slow.path().path(),
+          "--table-tier", uuid_to_str(assigned_table) + "=slow" });
+
+    std::vector<base_path_t> directories = tiers.all_directories(data_directory.path());
+    ASSERT_EQ(3u, directories.size());
+    EXPECT_EQ(data_directory.path().path(), directories[0].path());
+    EXPECT_EQ(fast.path().path(), directories[1].path());
+    EXPECT_EQ(slow.path().path(), directories[2].path());
+
+    boost::optional<base_path_t> assigned
+        = tiers.assigned_directory(assigned_table, data_directory.path());
+    ASSERT_TRUE(static_cast<bool>(assigned));
+    EXPECT_EQ(slow.path().path(), assigned->path());
+    EXPECT_FALSE(static_cast<bool>(
+        tiers.assigned_directory(generate_uuid(), data_directory.path())));
+
+    // By default, new tables go into the data directory.
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(data_directory.path().path(),
+                  tiers.new_table_directory(generate_uuid(),
+                                            data_directory.path()).path());
+    }
+    EXPECT_EQ(slow.path().path(),
+              tiers.new_table_directory(assigned_table, data_directory.path()).path());
+}
+
+TEST(StorageTiers, SpreadsNewTables) {
+    temp_directory_t data_directory, tier;
+    storage_tiers_t tiers = parse_tier_options(
+        { "--storage-tier", "other=" + tier.path().path(),
+          "--table-placement", "spread" });
+
+    std::map<std::string, int> tables_per_directory;
+    for (int i = 0; i < 100; ++i) {
+        const namespace_id_t table_id = generate_uuid();
+        const std::string directory
+            = tiers.new_table_directory(table_id, data_directory.path()).path();
+        // The same table always goes to the same place.
+        EXPECT_EQ(directory,
+                  tiers.new_table_directory(table_id, data_directory.path()).path());
+        ++tables_per_directory[directory];
+    }
+    EXPECT_EQ(2u, tables_per_directory.size());
+    EXPECT_GT(tables_per_directory[data_directory.path().path()], 0);
+    EXPECT_GT(tables_per_directory[tier.path().path()], 0);
+}
+
+TEST(StorageTiers, RejectsBadOptions) {
+    temp_directory_t tier;
+    const std::string table = uuid_to_str(generate_uuid());
+    const std::vector<std::vector<std::string> > bad_args = {
+        { "--storage-tier", tier.path().path() },
+        { "--storage-tier", "=" + tier.path().path() },
+        { "--storage-tier", "default=" + tier.path().path() },
+        { "--storage-tier", "a=" + tier.path().path(),
+          "--storage-tier", "a=" + tier.path().path() },
+        { "--storage-tier", "a=" + tier.path().path() + "/missing" },
+        { "--table-placement", "everywhere" },
+        { "--table-tier", "not-a-uuid=default" },
+        { "--table-tier", table + "=missing" } };
+    for (const std::vector<std::string> &args : bad_args) {
+        EXPECT_THROW(parse_tier_options(args), std::runtime_error) << args[1];
+    }
+
+    // The data directory is always there.
+    EXPECT_NO_THROW(parse_tier_options({ "--table-tier", table + "=default" }));
+}
+
+TPTEST(StorageTiers, FileNameForPlacement) {
+    temp_directory_t data_directory, tier;
+    const namespace_id_t assigned_table = generate_uuid();
+    const namespace_id_t moved_table = generate_uuid();
+    storage_tiers_t tiers = parse_tier_options(
+        { "--storage-tier", "other=" + tier.path().path(),
+          "--table-tier", uuid_to_str(assigned_table) + "=other" });
+
+    local_issue_aggregator_t local_issue_aggregator;
+    file_based_svs_by_namespace_t svs(nullptr, nullptr, data_directory.path(), tiers,
+                                      log_serializer_dynamic_config_t(), 0,
+                                      &local_issue_aggregator);
+    auto file_name = [&](namespace_id_t table_id) {
+        return svs.file_name_for(table_id).permanent_path();
+    };
+    auto path_in = [](const base_path_t &directory, namespace_id_t table_id) {
+        return serializer_filepath_t(directory, uuid_to_str(table_id)).permanent_path();
+    };
+
+    // New tables go where they're assigned, or into the data directory.
+    EXPECT_EQ(path_in(tier.path(), assigned_table), file_name(assigned_table));
+    EXPECT_EQ(path_in(data_directory.path(), moved_table), file_name(moved_table));
+
+    // A table that isn't assigned anywhere stays in whatever tier it is in.
+    write_test_file(path_in(tier.path(), moved_table), "table");
+    EXPECT_EQ(path_in(tier.path(), moved_table), file_name(moved_table));
+
+    // If a table's file couldn't be moved into its tier, we keep using it where it is.
+    write_test_file(path_in(data_directory.path(), assigned_table), "table");
+    EXPECT_EQ(path_in(data_directory.path(), assigned_table), file_name(assigned_table));
+
+    // Having a file in more than one place is an error, because we can't tell which
+    // one to use.
+    EXPECT_NO_THROW(tiers.check_for_duplicate_table_files(data_directory.path()));
+    write_test_file(path_in(data_directory.path(), moved_table), "table");
+    EXPECT_THROW(tiers.check_for_duplicate_table_files(data_directory.path()),
+                 std::runtime_error);
+}
+
+TEST(StorageTiers, MovesFileOnSameDevice) {
+    temp_directory_t directory;
+    const std::string from = directory.path().path() + "/from";
+    const std::string to = directory.path().path() + "/to";
+    const std::string contents = make_test_file_contents();
+    write_test_file(from, contents);
+
+    std::string error;
+    EXPECT_EQ(move_file_result_t::moved,
+              move_file_blocking(from, to, directory.path().path() + "/temp", &error));
+    EXPECT_FALSE(test_file_exists(from));
+    EXPECT_EQ(contents, blocking_read_file(to.c_str()));
+
+    // There's nothing left to move.
+    EXPECT_EQ(move_file_result_t::failed,
+              move_file_blocking(from, to, directory.path().path() + "/temp", &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_EQ(contents, blocking_read_file(to.c_str()));
+}
+
+// We can't count on having two file systems, so these tests call the part of
+// `move_file_blocking` that copies the file directly.
+TEST(StorageTiers, CopiesFileToOtherDevice) {
+    temp_directory_t source, target;
+    const std::string from = source.path().path() + "/table";
+    const std::string to = target.path().path() + "/table";
+    const std::string temporary_path = target.path().path() + "/table.create";
+    const std::string contents = make_test_file_contents();
+    write_test_file(from, contents);
+
+    std::string error;
+    EXPECT_EQ(move_file_result_t::moved,
+              copy_file_to_device_blocking(from, to, temporary_path, &error));
+    EXPECT_FALSE(test_file_exists(from));
+    EXPECT_FALSE(test_file_exists(temporary_path));
+    EXPECT_EQ(contents, blocking_read_file(to.c_str()));
+}
+
+TEST(StorageTiers, FailedCopyLeavesOriginal) {
+    temp_directory_t source, target;
+    const std::string from = source.path().path() + "/table";
+    const std::string to = target.path().path() + "/table";
+    const std::string contents = make_test_file_contents();
+
+    // There is nothing to copy.
+    std::string error;
+    EXPECT_EQ(move_file_result_t::failed,
+              copy_file_to_device_blocking(from, to, target.path().path() + "/temp",
+                                           &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(test_file_exists(to));
+
+    // The temporary file can't be created.
+    write_test_file(from, contents);
+    error.clear();
+    EXPECT_EQ(move_file_result_t::failed,
+              copy_file_to_device_blocking(from, to,
+                                           target.path().path() + "/missing/temp",
+                                           &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(test_file_exists(to));
+    EXPECT_EQ(contents, blocking_read_file(from.c_str()));
+
+    // The temporary file can't be renamed into place, because a directory is in the
+    // way.
+    ASSERT_EQ(0, mkdir(to.c_str(), 0755));
+    write_test_file(to + "/blocker", "blocker");
+    const std::string temporary_path = target.path().path() + "/temp";
+    error.clear();
+    EXPECT_EQ(move_file_result_t::failed,
+              copy_file_to_device_blocking(from, to, temporary_path, &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(test_file_exists(temporary_path));
+    EXPECT_EQ(contents, blocking_read_file(from.c_str()));
+}
+
+TEST(StorageTiers, CopyKeepsOriginalItCannotRemove) {
+    // Nobody can remove files from /proc, not even root.
+    const std::string from = "/proc/version";
+    const std::string contents = blocking_read_file(from.c_str());
+    temp_directory_t target;
+    const std::string to = target.path().path() + "/table";
+
+    std::string error;
+    EXPECT_EQ(move_file_result_t::original_remains,
+              copy_file_to_device_blocking(from, to, target.path().path() + "/temp",
+                                           &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_TRUE(test_file_exists(from));
+    EXPECT_EQ(contents, blocking_read_file(to.c_str()));
+}
+
+}  // namespace unittest
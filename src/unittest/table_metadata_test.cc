@@ -0,0 +1,118 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clustering/administration/tables/table_metadata.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "containers/archive/versioned.hpp"
+#include "rpc/serialize_macros.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+namespace_semilattice_metadata_t make_table_metadata() {
+    table_replication_info_t replication_info;
+    replication_info.config.write_ack_config.mode = write_ack_config_t::mode_t::majority;
+    replication_info.config.durability = write_durability_t::HARD;
+    replication_info.shard_scheme = table_shard_scheme_t::one_shard();
+
+    namespace_semilattice_metadata_t md;
+    md.name = versioned_t<name_string_t>(name_string_t::guarantee_valid("foo"));
+    md.database = versioned_t<database_id_t>(generate_uuid());
+    md.primary_key = versioned_t<std::string>("id");
+    md.block_size = versioned_t<uint32_t>(16 * KILOBYTE);
+    md.block_codec = versioned_t<boost::optional<block_codec_t> >(
+        boost::optional<block_codec_t>(block_codec_t::zlib_best));
+    md.replication_info = versioned_t<table_replication_info_t>(replication_info);
+    return md;
+}
+
+// This is how v1.16 wrote a table's config, without a cache share.
+class v1_16_table_config_t {
+public:
+    explicit v1_16_table_config_t(const table_config_t &config)
+        : shards(config.shards),
+          write_ack_config(config.write_ack_config),
+          durability(config.durability) { }
+    std::vector<table_config_t::shard_t> shards;
+    write_ack_config_t write_ack_config;
+    write_durability_t durability;
+    RDB_MAKE_ME_SERIALIZABLE_3(v1_16_table_config_t,
+                               shards, write_ack_config, durability);
+};
+
+class v1_16_table_replication_info_t {
+public:
+    explicit v1_16_table_replication_info_t(const table_replication_info_t &info)
+        : config(info.config), shard_scheme(info.shard_scheme) { }
+    v1_16_table_config_t config;
+    table_shard_scheme_t shard_scheme;
+    RDB_MAKE_ME_SERIALIZABLE_2(v1_16_table_replication_info_t, config, shard_scheme);
+};
+
+template <cluster_version_t W, class T>
+void deserialize_message(write_message_t *wm, T *out) {
+    string_stream_t write_stream;
+    ASSERT_EQ(0, send_write_message(&write_stream, wm));
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ASSERT_EQ(archive_result_t::SUCCESS, deserialize<W>(&read_stream, out));
+}
+
+TEST(TableMetadata, RoundTripsBlockSize) {
+    namespace_semilattice_metadata_t md = make_table_metadata();
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, md);
+
+    namespace_semilattice_metadata_t read_md;
+    deserialize_message<cluster_version_t::LATEST_DISK>(&wm, &read_md);
+    EXPECT_TRUE(md == read_md);
+}
+
+TEST(TableMetadata, V1_16TablesUseTheDefaultBlockSize) {
+    // This is how v1.16 wrote a table, without a block size or codec.
+    namespace_semilattice_metadata_t md = make_table_metadata();
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, md.name);
+    serialize<cluster_version_t::LATEST_DISK>(&wm, md.database);
+    serialize<cluster_version_t::LATEST_DISK>(&wm, md.primary_key);
+    serialize<cluster_version_t::LATEST_DISK>(&wm,
+        versioned_t<v1_16_table_replication_info_t>(
+            v1_16_table_replication_info_t(md.replication_info.get_ref())));
+
+    namespace_semilattice_metadata_t read_md;
+    deserialize_message<cluster_version_t::v1_16>(&wm, &read_md);
+    EXPECT_TRUE(md.name == read_md.name);
+    EXPECT_TRUE(md.database == read_md.database);
+    EXPECT_TRUE(md.primary_key == read_md.primary_key);
+    EXPECT_EQ(0u, read_md.block_size.get_ref());
+    EXPECT_FALSE(static_cast<bool>(read_md.block_codec.get_ref()));
+    EXPECT_TRUE(md.replication_info.get_ref() == read_md.replication_info.get_ref());
+}
+
+TEST(TableMetadata, RoundTripsCacheShare) {
+    table_config_t config = make_table_metadata().replication_info.get_ref().config;
+    config.cache_share.min = 0.25;
+    config.cache_share.max = 0.5;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, config);
+
+    table_config_t read_config;
+    deserialize_message<cluster_version_t::LATEST_DISK>(&wm, &read_config);
+    EXPECT_TRUE(config == read_config);
+}
+
+TEST(TableMetadata, V1_16TablesUseTheDefaultCacheShare) {
+    table_config_t config = make_table_metadata().replication_info.get_ref().config;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, v1_16_table_config_t(config));
+
+    table_config_t read_config;
+    read_config.cache_share.min = 0.25;
+    read_config.cache_share.max = 0.5;
+    deserialize_message<cluster_version_t::v1_16>(&wm, &read_config);
+    EXPECT_TRUE(config == read_config);
+    EXPECT_TRUE(cache_share_config_t() == read_config.cache_share);
+}
+
+}  // namespace unittest
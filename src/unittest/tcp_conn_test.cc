@@ -0,0 +1,153 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Gets at the parts of a connection that the tests look at.
+class tcp_conn_tester_t {
+public:
+    // Makes connections for both ends of a Unix socket pair, with send buffers small
+    // enough that most `writev()` calls only get part of the data out.
+    static void make_socket_pair(scoped_ptr_t<linux_tcp_conn_t> *writer_out,
+                                 scoped_ptr_t<linux_tcp_conn_t> *reader_out) {
+        fd_t fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        const int buffer_size = 4096;
+        ASSERT_EQ(0, setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF,
+                                &buffer_size, sizeof(buffer_size)));
+        ASSERT_EQ(0, setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF,
+                                &buffer_size, sizeof(buffer_size)));
+        writer_out->init(new linux_tcp_conn_t(fds[0]));
+        reader_out->init(new linux_tcp_conn_t(fds[1]));
+    }
+
+    static bool is_corked(linux_tcp_conn_t *conn) {
+        return conn->is_corked;
+    }
+
+    static bool cork_failed(linux_tcp_conn_t *conn) {
+        return conn->cork_failed;
+    }
+
+    // Asks the kernel whether the socket holds back partial segments.
+    static int socket_cork(linux_tcp_conn_t *conn) {
+        int optval = -1;
+        socklen_t optlen = sizeof(optval);
+        int res = getsockopt(conn->sock.get(), IPPROTO_TCP, TCP_CORK, &optval, &optlen);
+        EXPECT_EQ(0, res);
+        return optval;
+    }
+};
+
+char tcp_test_byte(size_t offset) {
+    return static_cast<char>((offset * 7 + offset / 251) & 0xFF);
+}
+
+// Writes `total` bytes in writes of all kinds of sizes, some of them big enough not to
+// get copied, without waiting for them until the end.  The write queue fills up
+// while the socket is full, so the write coroutine takes several writes at a time.
+void write_test_bytes(linux_tcp_conn_t *conn, size_t total) {
+    cond_t non_closer;
+    std::vector<char> buf;
+    size_t offset = 0;
+    for (size_t i = 0; offset < total; ++i) {
+        const size_t size = std::min(total - offset,
+                                     i % 10 == 9
+                                     ? static_cast<size_t>(70 * KILOBYTE)
+                                     : (i * 997) % 9000 + 1);
+        buf.resize(size);
+        for (size_t j = 0; j < size; ++j) {
+            buf[j] = tcp_test_byte(offset + j);
+        }
+        conn->write_buffered(buf.data(), size, &non_closer);
+        offset += size;
+    }
+    conn->flush_buffer(&non_closer);
+}
+
+// Reads `total` bytes in small pieces, letting the writer get ahead in between, and
+// checks that they came through in order.  Reads all of them even if some are wrong,
+// so that the writer doesn't get stuck.
+void read_test_bytes(linux_tcp_conn_t *conn, size_t total) {
+    cond_t non_closer;
+    char buf[777];
+    size_t offset = 0;
+    size_t first_wrong = total;
+    while (offset < total) {
+        const size_t size = std::min(total - offset, sizeof(buf));
+        conn->read(buf, size, &non_closer);
+        for (size_t j = 0; j < size && first_wrong == total; ++j) {
+            if (buf[j] != tcp_test_byte(offset + j)) {
+                first_wrong = offset + j;
+            }
+        }
+        offset += size;
+        coro_t::yield();
+    }
+    EXPECT_EQ(total, first_wrong);
+}
+
+void write_and_read(linux_tcp_conn_t *writer, linux_tcp_conn_t *reader, size_t total) {
+    pmap(2, [&](int i) {
+        if (i == 0) {
+            write_test_bytes(writer, total);
+        } else {
+            read_test_bytes(reader, total);
+        }
+    });
+}
+
+TPTEST(TcpConn, ShortWritesArriveInOrder) {
+    scoped_ptr_t<linux_tcp_conn_t> writer, reader;
+    tcp_conn_tester_t::make_socket_pair(&writer, &reader);
+    write_and_read(writer.get(), reader.get(), 4 * MEGABYTE);
+
+    // A Unix socket can't be corked.  The first batch that had more writes behind
+    // it found that out, and we didn't try again.
+    EXPECT_TRUE(tcp_conn_tester_t::cork_failed(writer.get()));
+    EXPECT_FALSE(tcp_conn_tester_t::is_corked(writer.get()));
+
+    // The connection still works after all that.
+    write_and_read(writer.get(), reader.get(), 100);
+}
+
+TPTEST(TcpConn, UncorksWhenTheQueueRunsDry) {
+    std::set<ip_address_t> addresses;
+    addresses.insert(ip_address_t("127.0.0.1"));
+    scoped_ptr_t<linux_tcp_conn_t> reader;
+    cond_t accepted;
+    linux_tcp_listener_t listener(
+        addresses, ANY_PORT,
+        [&](scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn) {
+            nconn->make_overcomplicated(&reader);
+            accepted.pulse();
+        });
+    cond_t non_interruptor;
+    linux_tcp_conn_t writer(ip_address_t("127.0.0.1"), listener.get_port(),
+                            &non_interruptor);
+    accepted.wait();
+
+    for (int round = 0; round < 3; ++round) {
+        write_and_read(&writer, reader.get(), 4 * MEGABYTE);
+        // Once everything is written, nothing may be held back anymore.
+        EXPECT_FALSE(tcp_conn_tester_t::cork_failed(&writer));
+        EXPECT_FALSE(tcp_conn_tester_t::is_corked(&writer));
+        EXPECT_EQ(0, tcp_conn_tester_t::socket_cork(&writer));
+    }
+}
+
+}  // namespace unittest
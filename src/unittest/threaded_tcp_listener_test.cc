@@ -0,0 +1,100 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
+#include "protob/protob.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+std::set<ip_address_t> listener_test_addresses() {
+    std::set<ip_address_t> addresses;
+    addresses.insert(ip_address_t("127.0.0.1"));
+    return addresses;
+}
+
+// Counts the connections a listener accepted, on any thread.
+class accept_counter_t {
+public:
+    accept_counter_t() : total(0) { }
+
+    void on_connection(scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn,
+                       auto_drainer_t::lock_t) {
+        scoped_ptr_t<linux_tcp_conn_t> conn;
+        nconn->make_overcomplicated(&conn);
+        __sync_fetch_and_add(&total, 1);
+    }
+
+    // Gives up after about five seconds.
+    void wait_for(int count) {
+        for (int i = 0; i < 500 && __sync_fetch_and_add(&total, 0) < count; ++i) {
+            nap(10);
+        }
+    }
+
+    int total;
+};
+
+TPTEST(ThreadedTcpListener, PortIsNotShared, 4) {
+    accept_counter_t counter;
+    threaded_tcp_listener_t listener(
+        listener_test_addresses(), ANY_PORT,
+        std::bind(&accept_counter_t::on_connection, &counter, ph::_1, ph::_2));
+    const int port = listener.get_port();
+
+    // Nobody else gets to listen on the port, not even another listener of ours.
+    EXPECT_THROW(threaded_tcp_listener_t(
+                     listener_test_addresses(), port,
+                     std::bind(&accept_counter_t::on_connection, &counter,
+                               ph::_1, ph::_2)),
+                 address_in_use_exc_t);
+    EXPECT_THROW(linux_tcp_bound_socket_t(listener_test_addresses(), port),
+                 address_in_use_exc_t);
+}
+
+TPTEST(ThreadedTcpListener, AcceptsAllConnections, 4) {
+    accept_counter_t counter;
+    threaded_tcp_listener_t listener(
+        listener_test_addresses(), ANY_PORT,
+        std::bind(&accept_counter_t::on_connection, &counter, ph::_1, ph::_2));
+
+    // Connect from several threads at once, so that connections come in while the
+    // accepting threads are busy with others.
+    const int num_conns = 64;
+    pmap(num_conns, [&](int i) {
+        on_thread_t thread_switcher(threadnum_t(i % get_num_threads()));
+        cond_t non_interruptor;
+        linux_tcp_conn_t conn(ip_address_t("127.0.0.1"), listener.get_port(),
+                              &non_interruptor);
+    });
+
+    counter.wait_for(num_conns);
+    EXPECT_EQ(num_conns, counter.total);
+}
+
+TEST(ThreadedTcpListener, PlacesOnLeastLoadedThread) {
+    std::vector<size_t> loads = { 3, 1, 4, 1, 5 };
+    const int num_threads = loads.size();
+    auto load = [&](int thread) { return loads[thread]; };
+
+    // The first of the least loaded threads from `start` on wins.
+    EXPECT_EQ(1, choose_least_loaded_thread(num_threads, 0, load).threadnum);
+    EXPECT_EQ(3, choose_least_loaded_thread(num_threads, 2, load).threadnum);
+    EXPECT_EQ(1, choose_least_loaded_thread(num_threads, 4, load).threadnum);
+
+    // When all of them are idle, it's whichever one we start at.
+    loads.assign(num_threads, 0);
+    for (int start = 0; start < num_threads; ++start) {
+        EXPECT_EQ(start, choose_least_loaded_thread(num_threads, start, load).threadnum);
+    }
+}
+
+}  // namespace unittest
@@ -4,11 +4,17 @@
 #include <stdlib.h>
 
 #include <functional>
+#include <vector>
 
 #include "arch/timing.hpp"
 #include "arch/runtime/starter.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/serializer.hpp"
 #include "unittest/gtest.hpp"
 #include "utils.hpp"
 
@@ -51,6 +57,57 @@ read_t make_sindex_read(
     return make_sindex_read_t::make_sindex_read(key, id);
 }
 
+void write_test_blocks(serializer_t *ser, file_account_t *account,
+                       block_id_t first, int64_t count) {
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t block_id = first; block_id < first + count; ++block_id) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+        *static_cast<block_id_t *>(buf.cache_data()) = block_id;
+        infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id));
+        bufs.push_back(std::move(buf));
+    }
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser->block_writes(infos, account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (int64_t i = 0; i < count; ++i) {
+        write_ops.push_back(index_write_op_t(first + i, tokens[i],
+                                             repli_timestamp_t::distant_past));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, write_ops);
+}
+
+void check_test_blocks(serializer_t *ser, file_account_t *account,
+                       block_id_t first, int64_t count) {
+    for (block_id_t block_id = first; block_id < first + count; ++block_id) {
+        counted_t<standard_block_token_t> token = ser->index_read(block_id);
+        ASSERT_TRUE(token.has());
+        buf_ptr_t read = ser->block_read(token, account);
+        EXPECT_EQ(block_id, *static_cast<const block_id_t *>(read.cache_data()));
+    }
+}
+
+int64_t get_int_stat(perfmon_collection_t *stats, const char *name) {
+    void *ctx = stats->begin_stats();
+    stats->visit_stats(ctx);
+    return stats->end_stats(ctx).get_field(name).as_int();
+}
+
+int64_t get_serializer_stat(perfmon_collection_t *stats, const char *name) {
+    void *ctx = stats->begin_stats();
+    stats->visit_stats(ctx);
+    return stats->end_stats(ctx).get_field("serializer").get_field(name).as_int();
+}
+
 serializer_filepath_t manual_serializer_filepath(const std::string &permanent_path,
                                                  const std::string &temporary_path) {
 
@@ -91,6 +148,21 @@ serializer_filepath_t temp_file_t::name() const {
     return manual_serializer_filepath(filename, filename + temp_file_create_suffix);
 }
 
+temp_directory_t::temp_directory_t() {
+    char tmpl[] = "/tmp/rdb_unittest.XXXXXX";
+    const char *res = mkdtemp(tmpl);
+    guarantee_err(res != NULL, "Couldn't create a temporary directory");
+    directory = tmpl;
+}
+
+temp_directory_t::~temp_directory_t() {
+    remove_directory_recursive(directory.c_str());
+}
+
+base_path_t temp_directory_t::path() const {
+    return base_path_t(directory);
+}
+
 
 void let_stuff_happen() {
 #ifdef VALGRIND
@@ -11,6 +11,10 @@
 #include "rdb_protocol/protocol.hpp"
 #include "rpc/serialize_macros.hpp"
 
+class file_account_t;
+class perfmon_collection_t;
+class serializer_t;
+
 namespace unittest {
 
 std::string rand_string(int len);
@@ -30,6 +34,20 @@ private:
     DISABLE_COPYING(temp_file_t);
 };
 
+// A fresh directory under /tmp, which gets removed with everything in it at
+// destruction.
+class temp_directory_t {
+public:
+    temp_directory_t();
+    ~temp_directory_t();
+    base_path_t path() const;
+
+private:
+    std::string directory;
+
+    DISABLE_COPYING(temp_directory_t);
+};
+
 void let_stuff_happen();
 
 std::set<ip_address_t> get_unittest_addresses();
@@ -39,6 +57,23 @@ void run_in_thread_pool(const std::function<void()> &fun, int num_workers = 1);
 read_t make_sindex_read(
     ql::datum_t key, const std::string &id);
 
+// Writes the blocks with ids in [first, first + count) with a single
+// `block_writes()` call, each block holding its own id, and then points the index
+// at them.
+void write_test_blocks(serializer_t *ser, file_account_t *account,
+                       block_id_t first, int64_t count);
+
+// Checks that the index points the blocks with ids in [first, first + count) at what
+// `write_test_blocks()` wrote for them.
+void check_test_blocks(serializer_t *ser, file_account_t *account,
+                       block_id_t first, int64_t count);
+
+// Returns the integer stat `name` from `stats`.
+int64_t get_int_stat(perfmon_collection_t *stats, const char *name);
+
+// The log serializer keeps its stats in a collection of its own, inside `stats`.
+int64_t get_serializer_stat(perfmon_collection_t *stats, const char *name);
+
 }  // namespace unittest
 
 
@@ -0,0 +1,118 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "arch/io/disk/uring.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+typedef uring_diskmgr_t::action_t uring_action_t;
+
+const size_t URING_TEST_BLOCK_SIZE = 4096;
+
+// Feeds actions to a `uring_diskmgr_t` and waits for them to complete.
+class uring_driver_t {
+public:
+    explicit uring_driver_t(int queue_depth) : expected(0), num_done(0), done(NULL) {
+        diskmgr.init(new uring_diskmgr_t(&linux_thread_pool_t::get_thread()->queue,
+                                         &source, queue_depth));
+        diskmgr->done_fun = [this](uring_action_t *) {
+            ++num_done;
+            if (num_done == expected) {
+                done->pulse();
+            }
+        };
+    }
+
+    void run(const std::vector<uring_action_t *> &actions) {
+        cond_t all_done;
+        done = &all_done;
+        expected = actions.size();
+        num_done = 0;
+        for (uring_action_t *a : actions) {
+            source.push(a);
+        }
+        all_done.wait();
+        done = NULL;
+    }
+
+private:
+    size_t expected;
+    size_t num_done;
+    cond_t *done;
+
+    // `diskmgr` watches `source`, so it has to go away first.
+    unlimited_fifo_queue_t<uring_action_t *> source;
+    scoped_ptr_t<uring_diskmgr_t> diskmgr;
+};
+
+TPTEST(UringDiskmgr, WriteResizeRead) {
+    // Kernels that are too old, and seccomp policies like Docker's default one, don't
+    // let us set up a ring.  There is nothing to test then.
+    if (!uring_diskmgr_t::is_supported()) {
+        return;
+    }
+
+    temp_file_t temp_file;
+    scoped_fd_t fd(::open(temp_file.name().permanent_path().c_str(),
+                          O_RDWR | O_CREAT, 0644));
+    ASSERT_NE(INVALID_FD, fd.get());
+
+    // Many more actions than the queue depth, so that some of them have to wait for
+    // others to complete.  Every fourth write is wrapped in datasyncs and goes to the
+    // blocker pool instead of the ring.
+    const int num_blocks = 64;
+    uring_driver_t driver(8);
+
+    std::vector<std::vector<char> > contents(num_blocks);
+    scoped_array_t<uring_action_t> writes(num_blocks);
+    std::vector<uring_action_t *> actions;
+    for (int i = 0; i < num_blocks; ++i) {
+        contents[i].assign(URING_TEST_BLOCK_SIZE, static_cast<char>('a' + i % 26));
+        writes[i].make_write(fd.get(), contents[i].data(), URING_TEST_BLOCK_SIZE,
+                             i * URING_TEST_BLOCK_SIZE, i % 4 == 0);
+        actions.push_back(&writes[i]);
+    }
+    driver.run(actions);
+    for (int i = 0; i < num_blocks; ++i) {
+        EXPECT_TRUE(writes[i].get_succeeded());
+    }
+
+    // Resizes never go through the ring.
+    const int remaining_blocks = num_blocks / 2;
+    uring_action_t resize;
+    resize.make_resize(fd.get(), remaining_blocks * URING_TEST_BLOCK_SIZE, false);
+    driver.run(std::vector<uring_action_t *>(1, &resize));
+    EXPECT_TRUE(resize.get_succeeded());
+    struct stat st;
+    ASSERT_EQ(0, fstat(fd.get(), &st));
+    EXPECT_EQ(static_cast<off_t>(remaining_blocks * URING_TEST_BLOCK_SIZE), st.st_size);
+
+    std::vector<std::vector<char> > read_back(remaining_blocks);
+    scoped_array_t<uring_action_t> reads(remaining_blocks);
+    actions.clear();
+    for (int i = 0; i < remaining_blocks; ++i) {
+        read_back[i].resize(URING_TEST_BLOCK_SIZE);
+        reads[i].make_read(fd.get(), read_back[i].data(), URING_TEST_BLOCK_SIZE,
+                           i * URING_TEST_BLOCK_SIZE);
+        actions.push_back(&reads[i]);
+    }
+    driver.run(actions);
+    for (int i = 0; i < remaining_blocks; ++i) {
+        EXPECT_TRUE(reads[i].get_succeeded());
+        EXPECT_EQ(contents[i], read_back[i]);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,98 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/work_stealing.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Runs a job of `num_chunks` chunks, and collects the chunks that each thread took, in
+// the order it took them.
+std::vector<std::vector<size_t> > steal_chunks(size_t num_chunks) {
+    std::vector<std::vector<size_t> > chunks_per_thread(get_num_threads());
+    cond_t non_interruptor;
+    steal_work(num_chunks, &non_interruptor,
+               [&](chunk_dispenser_t *chunks, signal_t *) {
+        // Every thread has its own list, so this doesn't need a lock.
+        std::vector<size_t> *taken = &chunks_per_thread[get_thread_id().threadnum];
+        size_t chunk;
+        while (chunks->take(&chunk)) {
+            taken->push_back(chunk);
+            // Let the other threads take some as well.
+            coro_t::yield();
+        }
+    });
+    return chunks_per_thread;
+}
+
+TPTEST(WorkStealing, HandsOutEveryChunkOnceInOrder, 4) {
+    const size_t num_chunks = 1000;
+    std::vector<std::vector<size_t> > chunks_per_thread = steal_chunks(num_chunks);
+
+    std::vector<int> times_taken(num_chunks, 0);
+    for (const auto &taken : chunks_per_thread) {
+        for (size_t i = 0; i < taken.size(); ++i) {
+            if (i > 0) {
+                EXPECT_LT(taken[i - 1], taken[i]);
+            }
+            ASSERT_LT(taken[i], num_chunks);
+            ++times_taken[taken[i]];
+        }
+    }
+    EXPECT_EQ(std::vector<int>(num_chunks, 1), times_taken);
+}
+
+TPTEST(WorkStealing, RethrowsLowestFailedChunk, 4) {
+    cond_t non_interruptor;
+    // Chunk 5 may or may not get handed out and fail, but chunk 3 always comes first.
+    try {
+        steal_work(100, &non_interruptor, [](chunk_dispenser_t *chunks, signal_t *) {
+            size_t chunk;
+            while (chunks->take(&chunk)) {
+                if (chunk == 3 || chunk == 5) {
+                    throw std::runtime_error(std::to_string(chunk));
+                }
+                coro_t::yield();
+            }
+        });
+        ADD_FAILURE() << "steal_work() didn't rethrow";
+    } catch (const std::runtime_error &e) {
+        EXPECT_EQ(std::string("3"), e.what());
+    }
+}
+
+TPTEST(WorkStealing, RunsAloneWithoutHelpers) {
+    // With a single thread, there's nobody to help.
+    std::vector<std::vector<size_t> > chunks_per_thread = steal_chunks(10);
+    ASSERT_EQ(1u, chunks_per_thread.size());
+    EXPECT_EQ(10u, chunks_per_thread[0].size());
+}
+
+TPTEST(WorkStealing, SingleChunkStaysHome, 4) {
+    // There is nothing to share, so no other thread gets asked.
+    const int home_thread = get_thread_id().threadnum;
+    for (size_t num_chunks = 0; num_chunks <= 1; ++num_chunks) {
+        std::vector<size_t> taken;
+        int workers = 0;
+        cond_t non_interruptor;
+        steal_work(num_chunks, &non_interruptor,
+                   [&](chunk_dispenser_t *chunks, signal_t *) {
+            EXPECT_EQ(home_thread, get_thread_id().threadnum);
+            ++workers;
+            size_t chunk;
+            while (chunks->take(&chunk)) {
+                taken.push_back(chunk);
+            }
+        });
+        EXPECT_EQ(1, workers);
+        EXPECT_EQ(num_chunks, taken.size());
+    }
+}
+
+}  // namespace unittest